@@ -0,0 +1,212 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Batched frame generator.
+
+#include "dsp/dsp_batch_generator.h"
+
+#include <string.h>
+
+#define BATCH_GENERATOR_PREROLL_BLOCK_SIZE 64
+
+// Samples of one channel gathered at once for its phasor bank, or of the ZC
+// sequence before being copied to all the channels.
+#define BATCH_GENERATOR_SCRATCH_SIZE 256
+
+static inline size_t dsp_batch_generator_min(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+static void dsp_batch_generator_rrc(
+        batch_generator_state_t* state,
+        iq_sample_t* out,
+        size_t size) {
+    rrc_filter_batch_state_t* rrc = &state->rrc_filter;
+    const size_t num_channels = state->num_channels;
+    size_t count = (size_t)(((uint64_t)rrc->phase +
+        (uint64_t)rrc->phase_increment * size) >> 32);
+
+    size_t num_random = 0;
+    if (state->symbols_generated < state->num_symbols) {
+        num_random = dsp_batch_generator_min(
+            count, state->num_symbols - state->symbols_generated);
+    }
+    dsp_rng_generate_icdf_batch(
+        state->rng, num_channels, state->symbols, num_random);
+    memset(
+        state->symbols + num_random * num_channels,
+        0,
+        (count - num_random) * num_channels * sizeof(iq_sample_t));
+    state->symbols_generated += count;
+
+    dsp_rrc_filter_batch_process(rrc, state->symbols, out, size);
+}
+
+// The tones differ between the channels: each one goes through its own
+// phasor bank, on a contiguous copy of its samples.
+static void dsp_batch_generator_phasor_bank(
+        batch_generator_state_t* state,
+        iq_sample_t* out,
+        size_t size) {
+    const size_t num_channels = state->num_channels;
+    iq_sample_t scratch[BATCH_GENERATOR_SCRATCH_SIZE];
+    while (size) {
+        size_t n = dsp_batch_generator_min(size, BATCH_GENERATOR_SCRATCH_SIZE);
+        for (size_t c = 0; c < num_channels; ++c) {
+            for (size_t i = 0; i < n; ++i) {
+                scratch[i] = out[i * num_channels + c];
+            }
+            dsp_phasor_bank_process(&state->phasor_bank[c], scratch, n);
+            for (size_t i = 0; i < n; ++i) {
+                out[i * num_channels + c] = scratch[i];
+            }
+        }
+        out += n * num_channels;
+        size -= n;
+    }
+}
+
+static void dsp_batch_generator_zc(
+        batch_generator_state_t* state,
+        iq_sample_t* out,
+        size_t size) {
+    const size_t num_channels = state->num_channels;
+    iq_sample_t scratch[BATCH_GENERATOR_SCRATCH_SIZE];
+    while (size) {
+        size_t n = dsp_batch_generator_min(size, BATCH_GENERATOR_SCRATCH_SIZE);
+        dsp_zc_generator_process(&state->zc_generator, scratch, n);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t c = 0; c < num_channels; ++c) {
+                *out++ = scratch[i];
+            }
+        }
+        size -= n;
+    }
+}
+
+bool dsp_batch_generator_compatible(
+        const dsp_parameter_t* a,
+        const dsp_parameter_t* b) {
+    return a->sample_rate == b->sample_rate &&
+        a->symbol_rate == b->symbol_rate &&
+        a->zc_rate == b->zc_rate &&
+        a->num_symbols == b->num_symbols &&
+        a->num_null_symbols == b->num_null_symbols &&
+        a->zc_length == b->zc_length &&
+        a->zc_root == b->zc_root &&
+        a->zc_shift == b->zc_shift &&
+        a->rrc_roll_off == b->rrc_roll_off;
+}
+
+void dsp_batch_generator_init(
+        batch_generator_state_t* state,
+        const dsp_parameter_t* parameters,
+        const uint32_t* seeds,
+        size_t num_channels,
+        const iq_sample_t* lut_phasor,
+        const sample_t* lut_rrc,
+        iq_sample_t* symbols,
+        size_t block_size) {
+    const dsp_parameter_t* p = &parameters[0];
+    const uint32_t sr = p->sample_rate;
+    const uint64_t samples_per_symbol = sr / p->symbol_rate;
+
+    state->num_channels = num_channels;
+    state->num_samples_zc = p->zc_length * (uint64_t)(sr / p->zc_rate);
+    state->num_samples_qd = p->num_symbols * samples_per_symbol;
+    state->num_samples = state->num_samples_zc + state->num_samples_qd +
+        p->num_null_symbols * samples_per_symbol;
+    state->position = 0;
+
+    state->num_symbols = p->num_symbols;
+    state->symbols_generated = 0;
+    state->symbols = symbols;
+    state->block_size = block_size;
+
+    for (size_t c = 0; c < num_channels; ++c) {
+        const dsp_parameter_t* channel = &parameters[c];
+        dsp_rng_init(
+            &state->rng[c],
+            channel->symbol_scale,
+            channel->symbol_max_value,
+            channel->symbol_clamp,
+            seeds[c],
+            0);
+
+        uint32_t frequency[NUM_PHASORS] = {
+            channel->shift_frequency,
+            channel->pilot_frequency[0],
+            channel->pilot_frequency[1] };
+        float amplitude[NUM_PHASORS] = {
+            0.70710678118f,
+            channel->pilot_amplitude[0],
+            channel->pilot_amplitude[1] };
+        dsp_phasor_bank_init(
+            &state->phasor_bank[c],
+            lut_phasor,
+            PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS,
+            frequency,
+            amplitude,
+            sr);
+    }
+
+    dsp_rrc_filter_batch_init(
+        &state->rrc_filter, lut_rrc, num_channels, p->symbol_rate, sr);
+
+    dsp_zc_generator_init(
+        &state->zc_generator,
+        lut_phasor,
+        p->zc_length,
+        p->zc_root,
+        p->zc_shift,
+        p->zc_rate,
+        sr);
+
+    iq_sample_t preroll[
+        BATCH_GENERATOR_PREROLL_BLOCK_SIZE * DSP_BATCH_MAX_CHANNELS];
+    size_t preroll_size = sr / p->symbol_rate * 25 / 4;
+    while (preroll_size) {
+        size_t n = dsp_batch_generator_min(
+            preroll_size, dsp_batch_generator_min(
+                BATCH_GENERATOR_PREROLL_BLOCK_SIZE, block_size));
+        dsp_batch_generator_rrc(state, preroll, n);
+        preroll_size -= n;
+    }
+}
+
+size_t dsp_batch_generator_process(
+        batch_generator_state_t* state,
+        iq_sample_t* out,
+        size_t size) {
+    const size_t num_channels = state->num_channels;
+    const size_t zc_end = state->num_samples_zc;
+    const size_t qd_end = zc_end + state->num_samples_qd;
+
+    size_t written = 0;
+    while (size && state->position < state->num_samples) {
+        size_t position = state->position;
+        size_t n;
+        if (position < zc_end) {
+            n = dsp_batch_generator_min(size, zc_end - position);
+            dsp_batch_generator_zc(state, out, n);
+        } else {
+            if (position < qd_end) {
+                n = dsp_batch_generator_min(
+                    dsp_batch_generator_min(size, qd_end - position),
+                    state->block_size);
+                dsp_batch_generator_rrc(state, out, n);
+            } else {
+                n = dsp_batch_generator_min(
+                    size, state->num_samples - position);
+                memset(out, 0, n * num_channels * sizeof(iq_sample_t));
+            }
+            dsp_batch_generator_phasor_bank(state, out, n);
+        }
+        out += n * num_channels;
+        size -= n;
+        written += n;
+        state->position += n;
+    }
+    return written;
+}
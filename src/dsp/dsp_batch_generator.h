@@ -0,0 +1,79 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Batched frame generator: produces the frames of up to
+// DSP_BATCH_MAX_CHANNELS independent transmitter channels at once, with
+// channel-interleaved samples (sample n of channel c at n * num_channels + c).
+//
+// The channels share the frame layout and timing (rates, number of symbols,
+// ZC sequence, RRC roll-off), hence the symbol clock, the ZC samples and the
+// LUTs. They can differ in their seed, symbol distribution (scale, maximum
+// value, clamping), frequency shift and pilots. The RNGs and the RRC filter
+// process all the channels together, one lane per channel; each channel then
+// goes through its own phasor bank.
+//
+// The samples of each channel are identical to those of the single-channel
+// generator (dsp_frame_generator.h).
+
+#ifndef DSP_DSP_BATCH_GENERATOR_H_
+#define DSP_DSP_BATCH_GENERATOR_H_
+
+#include "dsp/dsp_parameters.h"
+#include "dsp/dsp_phasor_bank.h"
+#include "dsp/dsp_rng.h"
+#include "dsp/dsp_rrc_filter.h"
+#include "dsp/dsp_types.h"
+#include "dsp/dsp_zc_generator.h"
+
+typedef struct {
+    size_t num_channels;
+
+    // Frame layout, in samples (of each channel).
+    size_t num_samples_zc;
+    size_t num_samples_qd;
+    size_t num_samples;
+    size_t position;
+
+    uint32_t num_symbols;
+    uint32_t symbols_generated;
+
+    rng_state_t rng[DSP_BATCH_MAX_CHANNELS];
+    rrc_filter_batch_state_t rrc_filter;
+    phasor_bank_state_t phasor_bank[DSP_BATCH_MAX_CHANNELS];
+    zc_generator_state_t zc_generator;
+
+    // Channel-interleaved symbols consumed by the RRC filter while generating
+    // one block.
+    iq_sample_t* symbols;
+    size_t block_size;
+} batch_generator_state_t;
+
+// Returns true if two channels can be generated in the same batch.
+bool dsp_batch_generator_compatible(
+    const dsp_parameter_t* a,
+    const dsp_parameter_t* b);
+
+// parameters and seeds hold num_channels entries (1 to
+// DSP_BATCH_MAX_CHANNELS), which must be compatible. The LUTs are those of
+// dsp_frame_generator_init.
+//
+// symbols must hold num_channels * DSP_PLAN_SYMBOLS_PER_BLOCK(block_size,
+// symbol_rate, sample_rate) symbols.
+void dsp_batch_generator_init(
+    batch_generator_state_t* state,
+    const dsp_parameter_t* parameters,
+    const uint32_t* seeds,
+    size_t num_channels,
+    const iq_sample_t* lut_phasor,
+    const sample_t* lut_rrc,
+    iq_sample_t* symbols,
+    size_t block_size);
+
+// Writes the next size samples of all the channels (size * num_channels I/Q
+// pairs) to out. Returns the number of samples written per channel, smaller
+// than size once the end of the frame is reached.
+size_t dsp_batch_generator_process(
+    batch_generator_state_t* state, iq_sample_t* out, size_t size);
+
+#endif  // DSP_DSP_BATCH_GENERATOR_H_
@@ -0,0 +1,286 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Streaming frame generator.
+
+#include "dsp/dsp_frame_generator.h"
+
+#include <string.h>
+
+// Size of the scratch buffer receiving the first samples of the RRC filter,
+// which are discarded.
+#define FRAME_GENERATOR_PREROLL_BLOCK_SIZE 64
+
+// Amplitude of the frequency shift.
+#define FRAME_GENERATOR_SHIFT_AMPLITUDE 0.70710678118f
+
+#define FRAME_GENERATOR_SNAPSHOT_MAGIC 0x50534145  // "EASP"
+
+// Build options changing the state or the samples.
+#define FRAME_GENERATOR_FEATURE_STATISTICS 1
+#define FRAME_GENERATOR_FEATURE_LEGACY_RNG 2
+
+typedef struct {
+    uint32_t magic;
+    uint32_t state_size;
+    uint32_t features;
+    uint32_t reserved;
+} frame_generator_snapshot_header_t;
+
+static inline size_t dsp_frame_generator_min(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+// Generates the symbols consumed by the RRC filter during the next size
+// samples: one per wrap of its symbol clock.
+static void dsp_frame_generator_rrc(
+        frame_generator_state_t* state,
+        iq_sample_t* out,
+        size_t size) {
+    rrc_filter_state_t* rrc = &state->rrc_filter;
+    size_t count = (size_t)(((uint64_t)rrc->phase +
+        (uint64_t)rrc->phase_increment * size) >> 32);
+
+    size_t num_random = 0;
+    if (state->symbols_generated < state->num_symbols) {
+        num_random = dsp_frame_generator_min(
+            count, state->num_symbols - state->symbols_generated);
+    }
+    dsp_rng_generate_icdf(&state->rng, state->symbols, num_random);
+    for (size_t i = num_random; i < count; ++i) {
+        state->symbols[i] = (iq_sample_t) { .i = 0, .q = 0 };
+    }
+    state->symbols_generated += count;
+
+    dsp_rrc_filter_process(rrc, state->symbols, out, size);
+}
+
+#ifdef DSP_STATISTICS
+// Moves the statistics of the phasor bank output to the region it belongs to.
+static void dsp_frame_generator_collect(
+        frame_generator_state_t* state,
+        dsp_frame_region_t region) {
+    dsp_signal_statistics_merge(
+        &state->statistics.region[region], &state->phasor_bank.statistics);
+    dsp_signal_statistics_reset(&state->phasor_bank.statistics);
+}
+#endif  // DSP_STATISTICS
+
+void dsp_frame_generator_init(
+        frame_generator_state_t* state,
+        const dsp_parameter_t* parameters,
+        uint32_t seed,
+        const iq_sample_t* lut_phasor,
+        const sample_t* lut_rrc,
+        iq_sample_t* symbols,
+        size_t block_size) {
+    const uint32_t sr = parameters->sample_rate;
+    const uint64_t samples_per_symbol = sr / parameters->symbol_rate;
+
+    state->num_samples_zc = parameters->zc_length *
+        (uint64_t)(sr / parameters->zc_rate);
+    state->num_samples_qd = parameters->num_symbols * samples_per_symbol;
+    state->num_samples = state->num_samples_zc + state->num_samples_qd +
+        parameters->num_null_symbols * samples_per_symbol;
+    state->position = 0;
+
+    state->num_symbols = parameters->num_symbols;
+    state->symbols_generated = 0;
+    state->symbols = symbols;
+    state->block_size = block_size;
+    DSP_STATISTICS_ONLY(dsp_frame_statistics_reset(&state->statistics);)
+
+    dsp_rng_init(
+        &state->rng,
+        parameters->symbol_scale,
+        parameters->symbol_max_value,
+        parameters->symbol_clamp,
+        seed,
+        0);
+
+    dsp_rrc_filter_init_with_lut(
+        &state->rrc_filter, lut_rrc, parameters->symbol_rate, sr);
+
+    // The LUT is already filled, so it is not written to.
+    uint32_t frequency[NUM_PHASORS] = {
+        parameters->shift_frequency,
+        parameters->pilot_frequency[0],
+        parameters->pilot_frequency[1] };
+    float amplitude[NUM_PHASORS] = {
+        FRAME_GENERATOR_SHIFT_AMPLITUDE,
+        parameters->pilot_amplitude[0],
+        parameters->pilot_amplitude[1] };
+    dsp_phasor_bank_init(
+        &state->phasor_bank,
+        lut_phasor,
+        PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS,
+        frequency,
+        amplitude,
+        sr);
+
+    dsp_zc_generator_init(
+        &state->zc_generator,
+        lut_phasor,
+        parameters->zc_length,
+        parameters->zc_root,
+        parameters->zc_shift,
+        parameters->zc_rate,
+        sr);
+
+    // The first samples of the RRC filter, before the peak of the impulse
+    // response of the first symbol, are not transmitted.
+    iq_sample_t preroll[FRAME_GENERATOR_PREROLL_BLOCK_SIZE];
+    size_t preroll_size = sr / parameters->symbol_rate * 25 / 4;
+    while (preroll_size) {
+        size_t n = dsp_frame_generator_min(
+            preroll_size, dsp_frame_generator_min(
+                FRAME_GENERATOR_PREROLL_BLOCK_SIZE, block_size));
+        dsp_frame_generator_rrc(state, preroll, n);
+        preroll_size -= n;
+    }
+}
+
+size_t dsp_frame_generator_process(
+        frame_generator_state_t* state,
+        iq_sample_t* out,
+        size_t size) {
+    const size_t zc_end = state->num_samples_zc;
+    const size_t qd_end = zc_end + state->num_samples_qd;
+
+    size_t written = 0;
+    while (size && state->position < state->num_samples) {
+        size_t position = state->position;
+        size_t n;
+        if (position < zc_end) {
+            n = dsp_frame_generator_min(size, zc_end - position);
+            dsp_zc_generator_process(&state->zc_generator, out, n);
+        } else {
+            if (position < qd_end) {
+                n = dsp_frame_generator_min(
+                    dsp_frame_generator_min(size, qd_end - position),
+                    state->block_size);
+                dsp_frame_generator_rrc(state, out, n);
+            } else {
+                // The tail only contains the pilots.
+                n = dsp_frame_generator_min(
+                    size, state->num_samples - position);
+                memset(out, 0, n * sizeof(iq_sample_t));
+            }
+            dsp_phasor_bank_process(&state->phasor_bank, out, n);
+            DSP_STATISTICS_ONLY(dsp_frame_generator_collect(
+                state, position < qd_end
+                    ? DSP_FRAME_REGION_QD
+                    : DSP_FRAME_REGION_TAIL);)
+        }
+        out += n;
+        size -= n;
+        written += n;
+        state->position += n;
+    }
+    return written;
+}
+
+void dsp_frame_generator_retune(
+        frame_generator_state_t* state,
+        uint32_t shift_frequency,
+        const uint32_t* pilot_frequency,
+        const float* pilot_amplitude,
+        size_t position,
+        size_t ramp_size) {
+    uint32_t frequency[NUM_PHASORS] = {
+        shift_frequency,
+        pilot_frequency[0],
+        pilot_frequency[1] };
+    float amplitude[NUM_PHASORS] = {
+        FRAME_GENERATOR_SHIFT_AMPLITUDE,
+        pilot_amplitude[0],
+        pilot_amplitude[1] };
+
+    // The phasor bank only runs after the ZC sequence.
+    size_t zc_end = state->num_samples_zc;
+    dsp_phasor_bank_retune(
+        &state->phasor_bank,
+        frequency,
+        amplitude,
+        position > zc_end ? position - zc_end : 0,
+        ramp_size);
+}
+
+static uint32_t dsp_frame_generator_features(void) {
+    uint32_t features = 0;
+#ifdef DSP_STATISTICS
+    features |= FRAME_GENERATOR_FEATURE_STATISTICS;
+#endif  // DSP_STATISTICS
+#ifdef USE_LEGACY_RNG
+    features |= FRAME_GENERATOR_FEATURE_LEGACY_RNG;
+#endif  // USE_LEGACY_RNG
+    return features;
+}
+
+size_t dsp_frame_generator_snapshot_size(void) {
+    return sizeof(frame_generator_snapshot_header_t) +
+        sizeof(frame_generator_state_t);
+}
+
+void dsp_frame_generator_save(
+        const frame_generator_state_t* state,
+        void* snapshot) {
+    frame_generator_snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FRAME_GENERATOR_SNAPSHOT_MAGIC;
+    header.state_size = (uint32_t)sizeof(frame_generator_state_t);
+    header.features = dsp_frame_generator_features();
+
+    // The pointers are only valid in this process.
+    frame_generator_state_t copy = *state;
+    copy.rrc_filter.lut_rrc = NULL;
+    copy.phasor_bank.lut_phasor = NULL;
+    copy.zc_generator.lut_phasor = NULL;
+    copy.symbols = NULL;
+
+    uint8_t* p = (uint8_t*)snapshot;
+    memcpy(p, &header, sizeof(header));
+    memcpy(p + sizeof(header), &copy, sizeof(copy));
+}
+
+bool dsp_frame_generator_restore(
+        frame_generator_state_t* state,
+        const void* snapshot) {
+    const uint8_t* p = (const uint8_t*)snapshot;
+    frame_generator_snapshot_header_t header;
+    memcpy(&header, p, sizeof(header));
+    if (header.magic != FRAME_GENERATOR_SNAPSHOT_MAGIC ||
+            header.state_size != sizeof(frame_generator_state_t) ||
+            header.features != dsp_frame_generator_features()) {
+        return false;
+    }
+
+    frame_generator_state_t saved;
+    memcpy(&saved, p + sizeof(header), sizeof(saved));
+    if (saved.num_samples_zc != state->num_samples_zc ||
+            saved.num_samples_qd != state->num_samples_qd ||
+            saved.num_samples != state->num_samples ||
+            saved.num_symbols != state->num_symbols ||
+            saved.block_size != state->block_size ||
+            saved.position > saved.num_samples) {
+        return false;
+    }
+    saved.rrc_filter.lut_rrc = state->rrc_filter.lut_rrc;
+    saved.phasor_bank.lut_phasor = state->phasor_bank.lut_phasor;
+    saved.zc_generator.lut_phasor = state->zc_generator.lut_phasor;
+    saved.symbols = state->symbols;
+    *state = saved;
+    return true;
+}
+
+#ifdef DSP_STATISTICS
+void dsp_frame_generator_get_statistics(
+        const frame_generator_state_t* state,
+        dsp_frame_statistics_t* statistics) {
+    *statistics = state->statistics;
+    statistics->symbols = state->rng.statistics;
+    statistics->region[DSP_FRAME_REGION_ZC] = state->zc_generator.statistics;
+    statistics->num_wrapped = state->phasor_bank.num_wrapped;
+}
+#endif  // DSP_STATISTICS
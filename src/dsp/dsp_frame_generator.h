@@ -0,0 +1,115 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Streaming frame generator: chains the RNG, RRC filter, phasor bank and ZC
+// generator to produce a complete QOSST-compatible frame (ZC sync sequence,
+// quantum data, null tail) by blocks of arbitrary size, with bounded memory.
+//
+// The samples are identical to those of the whole-frame generation of the
+// command line tool.
+//
+// The state can be saved to a snapshot between two calls to
+// dsp_frame_generator_process, and restored later, possibly in another
+// process, to continue the frame with the same samples. A snapshot is a copy
+// of the state, without its pointers, preceded by a header identifying the
+// layout of the state: it can only be restored by the same build of the
+// library, on a machine of the same endianness.
+
+#ifndef DSP_DSP_FRAME_GENERATOR_H_
+#define DSP_DSP_FRAME_GENERATOR_H_
+
+#include "dsp/dsp_parameters.h"
+#include "dsp/dsp_phasor_bank.h"
+#include "dsp/dsp_rng.h"
+#include "dsp/dsp_rrc_filter.h"
+#include "dsp/dsp_statistics.h"
+#include "dsp/dsp_types.h"
+#include "dsp/dsp_zc_generator.h"
+
+typedef struct {
+    // Frame layout, in samples.
+    size_t num_samples_zc;
+    size_t num_samples_qd;
+    size_t num_samples;
+    size_t position;
+
+    // Random symbols in the frame, and symbols fed to the RRC filter so far
+    // (followed by zeros once all random symbols have been used).
+    uint32_t num_symbols;
+    uint32_t symbols_generated;
+
+    rng_state_t rng;
+    rrc_filter_state_t rrc_filter;
+    phasor_bank_state_t phasor_bank;
+    zc_generator_state_t zc_generator;
+
+    // Buffer for the symbols consumed by the RRC filter while generating
+    // one block.
+    iq_sample_t* symbols;
+    size_t block_size;
+
+#ifdef DSP_STATISTICS
+    // Output of the phasor bank, split between the quantum data and tail
+    // regions. The other figures are read from the blocks.
+    dsp_frame_statistics_t statistics;
+#endif  // DSP_STATISTICS
+} frame_generator_state_t;
+
+// The LUTs must have been obtained from dsp_phasor_bank_get_lut and
+// dsp_rrc_filter_get_lut, or from the registry (dsp/dsp_lut_registry.h);
+// they are not modified and can be shared.
+//
+// symbols must hold DSP_PLAN_SYMBOLS_PER_BLOCK(block_size, symbol_rate,
+// sample_rate) symbols (see dsp_memory_plan_streaming). Blocks larger than
+// block_size are processed in several passes.
+void dsp_frame_generator_init(
+    frame_generator_state_t* state,
+    const dsp_parameter_t* parameters,
+    uint32_t seed,
+    const iq_sample_t* lut_phasor,
+    const sample_t* lut_rrc,
+    iq_sample_t* symbols,
+    size_t block_size);
+
+// Writes the next samples of the frame to out. Returns the number of samples
+// written, smaller than size once the end of the frame is reached (position
+// is then equal to num_samples).
+size_t dsp_frame_generator_process(
+    frame_generator_state_t* state, iq_sample_t* out, size_t size);
+
+// Changes the frequency shift and the pilots from sample position of the
+// frame on (see dsp_phasor_bank_retune): the tones stay phase-continuous, and
+// the amplitudes of the pilots are ramped over ramp_size samples. A position
+// within the ZC sequence is the start of the quantum data, where the tones
+// start. Reinitializing the generator restores the parameters.
+void dsp_frame_generator_retune(
+    frame_generator_state_t* state,
+    uint32_t shift_frequency,
+    const uint32_t* pilot_frequency,
+    const float* pilot_amplitude,
+    size_t position,
+    size_t ramp_size);
+
+// Size of a snapshot, in bytes.
+size_t dsp_frame_generator_snapshot_size(void);
+
+// Writes dsp_frame_generator_snapshot_size() bytes to snapshot.
+void dsp_frame_generator_save(
+    const frame_generator_state_t* state, void* snapshot);
+
+// state must have been initialized with the parameters, seed, LUTs and block
+// size of the saved generator, and is then set to the saved state (its LUTs
+// and symbols buffer are kept). Returns false, leaving state untouched, if
+// the snapshot was not made by this build or for this frame layout and
+// block size.
+bool dsp_frame_generator_restore(
+    frame_generator_state_t* state, const void* snapshot);
+
+#ifdef DSP_STATISTICS
+// Statistics of the symbols and samples generated so far.
+void dsp_frame_generator_get_statistics(
+    const frame_generator_state_t* state, dsp_frame_statistics_t* statistics);
+#endif  // DSP_STATISTICS
+
+#endif  // DSP_DSP_FRAME_GENERATOR_H_
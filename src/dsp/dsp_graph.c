@@ -0,0 +1,350 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Dataflow graph runtime.
+
+#include "dsp/dsp_graph.h"
+
+#include <string.h>
+
+#include "dsp/dsp_memory_plan.h"
+
+static inline size_t dsp_graph_min(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+void dsp_graph_init(dsp_graph_t* graph, size_t chunk_size) {
+    memset(graph, 0, sizeof(*graph));
+    graph->chunk_size = chunk_size ? chunk_size : DSP_GRAPH_DEFAULT_CHUNK_SIZE;
+}
+
+// Adds a 1:1 node reading from num_inputs nodes.
+static int dsp_graph_add_node(
+        dsp_graph_t* graph,
+        dsp_graph_node_type_t type,
+        const int* inputs,
+        size_t num_inputs,
+        void* state) {
+    if (graph->num_nodes == DSP_GRAPH_MAX_NODES ||
+            num_inputs > DSP_GRAPH_MAX_INPUTS) {
+        return DSP_GRAPH_INVALID_NODE;
+    }
+    // The inputs have been added before, so the graph has no cycle.
+    for (size_t i = 0; i < num_inputs; ++i) {
+        if (inputs[i] < 0 || (size_t)inputs[i] >= graph->num_nodes ||
+                graph->node[inputs[i]].consumed) {
+            return DSP_GRAPH_INVALID_NODE;
+        }
+        for (size_t j = 0; j < i; ++j) {
+            if (inputs[j] == inputs[i]) {
+                return DSP_GRAPH_INVALID_NODE;
+            }
+        }
+    }
+
+    int index = (int)graph->num_nodes++;
+    dsp_graph_node_t* node = &graph->node[index];
+    memset(node, 0, sizeof(*node));
+    node->type = type;
+    node->num_inputs = num_inputs;
+    for (size_t i = 0; i < num_inputs; ++i) {
+        node->input[i] = inputs[i];
+        graph->node[inputs[i]].consumed = true;
+    }
+    node->rate_in = 1;
+    node->rate_out = 1;
+    node->state = state;
+    return index;
+}
+
+int dsp_graph_add_zeros(dsp_graph_t* graph) {
+    return dsp_graph_add_node(graph, DSP_GRAPH_NODE_ZEROS, NULL, 0, NULL);
+}
+
+int dsp_graph_add_rng(dsp_graph_t* graph, rng_state_t* rng) {
+    return dsp_graph_add_node(graph, DSP_GRAPH_NODE_RNG, NULL, 0, rng);
+}
+
+int dsp_graph_add_symbol_mapper(
+        dsp_graph_t* graph, const symbol_mapper_t* mapper, rng_state_t* rng) {
+    int index = dsp_graph_add_node(
+        graph, DSP_GRAPH_NODE_MAPPER, NULL, 0, rng);
+    if (index != DSP_GRAPH_INVALID_NODE) {
+        graph->node[index].table = mapper;
+    }
+    return index;
+}
+
+int dsp_graph_add_zc(dsp_graph_t* graph, zc_generator_state_t* zc_generator) {
+    return dsp_graph_add_node(
+        graph, DSP_GRAPH_NODE_ZC, NULL, 0, zc_generator);
+}
+
+int dsp_graph_add_concat(
+        dsp_graph_t* graph,
+        const int* inputs,
+        const size_t* lengths,
+        size_t num_inputs) {
+    int index = dsp_graph_add_node(
+        graph, DSP_GRAPH_NODE_CONCAT, inputs, num_inputs, NULL);
+    if (index != DSP_GRAPH_INVALID_NODE) {
+        for (size_t i = 0; i < num_inputs; ++i) {
+            graph->node[index].length[i] = lengths[i];
+        }
+    }
+    return index;
+}
+
+int dsp_graph_add_rrc(
+        dsp_graph_t* graph,
+        int input,
+        rrc_filter_state_t* rrc_filter,
+        uint32_t symbol_rate,
+        uint32_t sample_rate) {
+    int index = dsp_graph_add_node(
+        graph, DSP_GRAPH_NODE_RRC, &input, 1, rrc_filter);
+    if (index != DSP_GRAPH_INVALID_NODE) {
+        graph->node[index].rate_in = symbol_rate;
+        graph->node[index].rate_out = sample_rate;
+    }
+    return index;
+}
+
+int dsp_graph_add_half_band(
+        dsp_graph_t* graph, int input, half_band_state_t* half_band) {
+    int index = dsp_graph_add_node(
+        graph, DSP_GRAPH_NODE_HALF_BAND, &input, 1, half_band);
+    if (index != DSP_GRAPH_INVALID_NODE) {
+        graph->node[index].rate_out = 2;
+    }
+    return index;
+}
+
+int dsp_graph_add_phasor_bank(
+        dsp_graph_t* graph, int input, phasor_bank_state_t* phasor_bank) {
+    return dsp_graph_add_node(
+        graph, DSP_GRAPH_NODE_PHASOR_BANK, &input, 1, phasor_bank);
+}
+
+int dsp_graph_add_skip(dsp_graph_t* graph, int input, size_t count) {
+    int index = dsp_graph_add_node(
+        graph, DSP_GRAPH_NODE_SKIP, &input, 1, NULL);
+    if (index != DSP_GRAPH_INVALID_NODE) {
+        graph->node[index].length[0] = count;
+    }
+    return index;
+}
+
+int dsp_graph_add_tap(
+        dsp_graph_t* graph, int input, iq_sample_t* buffer, size_t size) {
+    int index = dsp_graph_add_node(
+        graph, DSP_GRAPH_NODE_TAP, &input, 1, NULL);
+    if (index != DSP_GRAPH_INVALID_NODE) {
+        graph->node[index].buffer = buffer;
+        graph->node[index].length[0] = size;
+    }
+    return index;
+}
+
+int dsp_graph_add_queue(dsp_graph_t* graph, int input, size_t capacity) {
+    if (!capacity) {
+        return DSP_GRAPH_INVALID_NODE;
+    }
+    int index = dsp_graph_add_node(
+        graph, DSP_GRAPH_NODE_QUEUE, &input, 1, NULL);
+    if (index != DSP_GRAPH_INVALID_NODE) {
+        graph->node[index].buffer_size = capacity;
+    }
+    return index;
+}
+
+// Items of the buffer carved for a node: the input items needed for a chunk,
+// for the nodes changing the rate, or the ring of a queue.
+static size_t dsp_graph_buffer_size(
+        const dsp_graph_t* graph, const dsp_graph_node_t* node) {
+    if (node->type == DSP_GRAPH_NODE_QUEUE) {
+        return node->buffer_size;
+    } else if (node->rate_in != node->rate_out) {
+        return DSP_PLAN_SYMBOLS_PER_BLOCK(
+            graph->chunk_size, node->rate_in, node->rate_out);
+    }
+    return 0;
+}
+
+size_t dsp_graph_memory_size(const dsp_graph_t* graph) {
+    size_t size = 0;
+    for (size_t i = 0; i < graph->num_nodes; ++i) {
+        size += DSP_PLAN_ALIGN(sizeof(iq_sample_t) * dsp_graph_buffer_size(
+            graph, &graph->node[i]));
+    }
+    return size;
+}
+
+void dsp_graph_assign(dsp_graph_t* graph, void* memory) {
+    uint8_t* p = (uint8_t*)memory;
+    for (size_t i = 0; i < graph->num_nodes; ++i) {
+        dsp_graph_node_t* node = &graph->node[i];
+        size_t size = dsp_graph_buffer_size(graph, node);
+        if (size) {
+            node->buffer = (iq_sample_t*)p;
+            node->buffer_size = size;
+            p += DSP_PLAN_ALIGN(sizeof(iq_sample_t) * size);
+        }
+    }
+}
+
+static inline void dsp_graph_wait(const dsp_graph_t* graph) {
+    if (graph->wait) {
+        graph->wait();
+    }
+}
+
+// Writes size items (at most chunk_size) of a node to out.
+static void dsp_graph_pull(
+        dsp_graph_t* graph, int index, iq_sample_t* out, size_t size) {
+    dsp_graph_node_t* node = &graph->node[index];
+    switch (node->type) {
+        case DSP_GRAPH_NODE_ZEROS:
+            memset(out, 0, size * sizeof(iq_sample_t));
+            break;
+
+        case DSP_GRAPH_NODE_RNG:
+            dsp_rng_generate_icdf((rng_state_t*)node->state, out, size);
+            break;
+
+        case DSP_GRAPH_NODE_MAPPER:
+            dsp_symbol_mapper_process(
+                (const symbol_mapper_t*)node->table,
+                (rng_state_t*)node->state,
+                out,
+                size);
+            break;
+
+        case DSP_GRAPH_NODE_ZC:
+            dsp_zc_generator_process(
+                (zc_generator_state_t*)node->state, out, size);
+            break;
+
+        case DSP_GRAPH_NODE_CONCAT:
+            while (size) {
+                if (node->current == node->num_inputs) {
+                    memset(out, 0, size * sizeof(iq_sample_t));
+                    break;
+                }
+                size_t n = dsp_graph_min(
+                    size, node->length[node->current] - node->position);
+                dsp_graph_pull(graph, node->input[node->current], out, n);
+                node->position += n;
+                if (node->position == node->length[node->current]) {
+                    ++node->current;
+                    node->position = 0;
+                }
+                out += n;
+                size -= n;
+            }
+            break;
+
+        case DSP_GRAPH_NODE_RRC:
+            {
+                // One symbol per wrap of the symbol clock.
+                rrc_filter_state_t* rrc = (rrc_filter_state_t*)node->state;
+                size_t count = (size_t)(((uint64_t)rrc->phase +
+                    (uint64_t)rrc->phase_increment * size) >> 32);
+                dsp_graph_pull(graph, node->input[0], node->buffer, count);
+                dsp_rrc_filter_process(rrc, node->buffer, out, size);
+            }
+            break;
+
+        case DSP_GRAPH_NODE_HALF_BAND:
+            {
+                half_band_state_t* half_band =
+                    (half_band_state_t*)node->state;
+                size_t count = dsp_half_band_num_inputs(half_band, size);
+                dsp_graph_pull(graph, node->input[0], node->buffer, count);
+                dsp_half_band_process(half_band, node->buffer, out, size);
+            }
+            break;
+
+        case DSP_GRAPH_NODE_PHASOR_BANK:
+            dsp_graph_pull(graph, node->input[0], out, size);
+            dsp_phasor_bank_process(
+                (phasor_bank_state_t*)node->state, out, size);
+            break;
+
+        case DSP_GRAPH_NODE_SKIP:
+            // The discarded items go through out.
+            while (node->position < node->length[0]) {
+                size_t n = dsp_graph_min(
+                    size, node->length[0] - node->position);
+                dsp_graph_pull(graph, node->input[0], out, n);
+                node->position += n;
+            }
+            dsp_graph_pull(graph, node->input[0], out, size);
+            break;
+
+        case DSP_GRAPH_NODE_TAP:
+            dsp_graph_pull(graph, node->input[0], out, size);
+            if (node->position < node->length[0]) {
+                size_t n = dsp_graph_min(
+                    size, node->length[0] - node->position);
+                memcpy(&node->buffer[node->position], out,
+                       n * sizeof(iq_sample_t));
+                node->position += n;
+            }
+            break;
+
+        case DSP_GRAPH_NODE_QUEUE:
+            while (size) {
+                uint64_t read = node->num_read;
+                uint64_t written = __atomic_load_n(
+                    &node->num_written, __ATOMIC_ACQUIRE);
+                if (written == read) {
+                    dsp_graph_wait(graph);
+                    continue;
+                }
+                size_t start = (size_t)(read % node->buffer_size);
+                size_t n = dsp_graph_min(
+                    dsp_graph_min(size, (size_t)(written - read)),
+                    node->buffer_size - start);
+                memcpy(out, &node->buffer[start], n * sizeof(iq_sample_t));
+                __atomic_store_n(
+                    &node->num_read, read + n, __ATOMIC_RELEASE);
+                out += n;
+                size -= n;
+            }
+            break;
+    }
+}
+
+void dsp_graph_process(
+        dsp_graph_t* graph, int node, iq_sample_t* out, size_t size) {
+    while (size) {
+        size_t n = dsp_graph_min(size, graph->chunk_size);
+        dsp_graph_pull(graph, node, out, n);
+        out += n;
+        size -= n;
+    }
+}
+
+void dsp_graph_fill_queue(dsp_graph_t* graph, int queue, size_t size) {
+    dsp_graph_node_t* node = &graph->node[queue];
+    const size_t capacity = node->buffer_size;
+    while (size) {
+        uint64_t written = node->num_written;
+        uint64_t read = __atomic_load_n(&node->num_read, __ATOMIC_ACQUIRE);
+        size_t space = capacity - (size_t)(written - read);
+        if (!space) {
+            dsp_graph_wait(graph);
+            continue;
+        }
+        // Items are pulled directly into the ring, without wrapping around.
+        size_t start = (size_t)(written % capacity);
+        size_t n = dsp_graph_min(
+            dsp_graph_min(dsp_graph_min(size, space), capacity - start),
+            graph->chunk_size);
+        dsp_graph_pull(graph, node->input[0], &node->buffer[start], n);
+        __atomic_store_n(&node->num_written, written + n, __ATOMIC_RELEASE);
+        size -= n;
+    }
+}
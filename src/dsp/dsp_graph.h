@@ -0,0 +1,181 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Dataflow graph runtime: the blocks (sources, RRC filter, phasor bank...)
+// are declared as the nodes of a graph, connected by their inputs, and the
+// samples are pulled from any node by chunks of a fixed size, so that the
+// data of a chunk stays in the cache from one block to the next.
+//
+// Each node produces a stream of I/Q pairs (samples or symbols). Pulling n
+// items from a node pulls exactly the items it needs from its inputs: n for
+// the 1:1 nodes, which work in place in the buffer of their consumer, and
+// the number given by their rate ratio for the others (the RRC and half-band
+// filters), into a buffer sized from this ratio and the chunk size. Each node
+// has a single consumer.
+//
+// A QUEUE node splits the graph in two stages which can run on different
+// threads: a producer fills it with dsp_graph_fill_queue, while the consumer
+// pulls from it. It is a single-producer single-consumer ring buffer; a full
+// or empty queue is waited for by calling the wait function of the graph.
+//
+// The block states are owned by the caller; the graph only refers to them.
+// Once all the nodes are added, the buffers are carved from a memory area of
+// dsp_graph_memory_size bytes by dsp_graph_assign.
+
+#ifndef DSP_DSP_GRAPH_H_
+#define DSP_DSP_GRAPH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/dsp_interpolator.h"
+#include "dsp/dsp_phasor_bank.h"
+#include "dsp/dsp_rng.h"
+#include "dsp/dsp_rrc_filter.h"
+#include "dsp/dsp_symbol_mapper.h"
+#include "dsp/dsp_types.h"
+#include "dsp/dsp_zc_generator.h"
+
+#define DSP_GRAPH_MAX_NODES 20
+#define DSP_GRAPH_MAX_INPUTS 4
+
+// Returned by the functions adding a node when the graph is full or an
+// input is invalid or already consumed.
+#define DSP_GRAPH_INVALID_NODE -1
+
+// Length of the last input of a CONCAT node which never ends.
+#define DSP_GRAPH_UNLIMITED SIZE_MAX
+
+// 4096 samples and the symbols they need fit in the L1 or L2 cache.
+#define DSP_GRAPH_DEFAULT_CHUNK_SIZE 4096
+
+typedef enum {
+    // Sources.
+    DSP_GRAPH_NODE_ZEROS,
+    DSP_GRAPH_NODE_RNG,
+    DSP_GRAPH_NODE_MAPPER,
+    DSP_GRAPH_NODE_ZC,
+
+    // Inputs read one after the other.
+    DSP_GRAPH_NODE_CONCAT,
+
+    // Blocks.
+    DSP_GRAPH_NODE_RRC,
+    DSP_GRAPH_NODE_HALF_BAND,
+    DSP_GRAPH_NODE_PHASOR_BANK,
+
+    // Discards the first items of its input.
+    DSP_GRAPH_NODE_SKIP,
+
+    // Sink: copies the first items passing through to a buffer.
+    DSP_GRAPH_NODE_TAP,
+
+    // Stage boundary.
+    DSP_GRAPH_NODE_QUEUE
+} dsp_graph_node_type_t;
+
+typedef struct {
+    dsp_graph_node_type_t type;
+    size_t num_inputs;
+    int input[DSP_GRAPH_MAX_INPUTS];
+    bool consumed;
+
+    // rate_out items are produced for rate_in items read from the input.
+    uint32_t rate_in;
+    uint32_t rate_out;
+
+    // Block state, owned by the caller.
+    void* state;
+
+    // Read-only data of the block, owned by the caller (MAPPER: the symbol
+    // mapper, state being its RNG).
+    const void* table;
+
+    // CONCAT: items read from each input. SKIP: items discarded. TAP:
+    // capacity of the buffer.
+    size_t length[DSP_GRAPH_MAX_INPUTS];
+
+    // CONCAT: input being read, and items read from it. SKIP, TAP: items
+    // which went through.
+    size_t current;
+    size_t position;
+
+    // Input items (nodes changing the rate), ring (QUEUE), or destination
+    // (TAP).
+    iq_sample_t* buffer;
+    size_t buffer_size;
+
+    // QUEUE: items written and read since the start, shared between the
+    // producer and consumer threads.
+    uint64_t num_written;
+    uint64_t num_read;
+} dsp_graph_node_t;
+
+typedef struct {
+    size_t num_nodes;
+    size_t chunk_size;
+    dsp_graph_node_t node[DSP_GRAPH_MAX_NODES];
+
+    // Called while waiting for a queue. NULL: spin.
+    void (*wait)(void);
+} dsp_graph_t;
+
+// chunk_size: maximum number of items pulled at once from any node.
+void dsp_graph_init(dsp_graph_t* graph, size_t chunk_size);
+
+int dsp_graph_add_zeros(dsp_graph_t* graph);
+int dsp_graph_add_rng(dsp_graph_t* graph, rng_state_t* rng);
+
+// Discrete-modulation symbols, drawn with rng.
+int dsp_graph_add_symbol_mapper(
+    dsp_graph_t* graph, const symbol_mapper_t* mapper, rng_state_t* rng);
+int dsp_graph_add_zc(dsp_graph_t* graph, zc_generator_state_t* zc_generator);
+
+// Reads lengths[0] items of inputs[0], then lengths[1] items of inputs[1]...
+// Zeros follow the last input, unless its length is DSP_GRAPH_UNLIMITED.
+int dsp_graph_add_concat(
+    dsp_graph_t* graph,
+    const int* inputs,
+    const size_t* lengths,
+    size_t num_inputs);
+
+// Symbols in, samples out.
+int dsp_graph_add_rrc(
+    dsp_graph_t* graph,
+    int input,
+    rrc_filter_state_t* rrc_filter,
+    uint32_t symbol_rate,
+    uint32_t sample_rate);
+
+// Doubles the rate: a stage of a multistage interpolator.
+int dsp_graph_add_half_band(
+    dsp_graph_t* graph, int input, half_band_state_t* half_band);
+
+int dsp_graph_add_phasor_bank(
+    dsp_graph_t* graph, int input, phasor_bank_state_t* phasor_bank);
+
+int dsp_graph_add_skip(dsp_graph_t* graph, int input, size_t count);
+
+// The first size items are copied to buffer.
+int dsp_graph_add_tap(
+    dsp_graph_t* graph, int input, iq_sample_t* buffer, size_t size);
+
+int dsp_graph_add_queue(dsp_graph_t* graph, int input, size_t capacity);
+
+// Size of the memory area holding the buffers of the nodes.
+size_t dsp_graph_memory_size(const dsp_graph_t* graph);
+
+// Carves the buffers from memory, aligned on DSP_PLAN_ALIGNMENT bytes.
+void dsp_graph_assign(dsp_graph_t* graph, void* memory);
+
+// Pulls size items from a node. When the graph has queues, only the thread
+// consuming them may call this on the nodes downstream of them.
+void dsp_graph_process(
+    dsp_graph_t* graph, int node, iq_sample_t* out, size_t size);
+
+// Producer side of a queue: pulls size items from its input, and writes them
+// to the queue as space becomes available.
+void dsp_graph_fill_queue(dsp_graph_t* graph, int queue, size_t size);
+
+#endif  // DSP_DSP_GRAPH_H_
@@ -0,0 +1,282 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Multistage interpolation.
+
+#include "dsp/dsp_interpolator.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif  // M_PI
+
+// Inputs processed at once.
+#define HALF_BAND_CHUNK_SIZE 256
+
+// Modified Bessel function of the first kind, order 0.
+static double dsp_bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+void dsp_half_band_init(
+        half_band_state_t* state, float pass_band, float attenuation_db) {
+    // Length given by Kaiser's formula for the transition band between the
+    // signal and its image.
+    const double attenuation = attenuation_db;
+    const double transition = 0.5 - 2.0 * pass_band;
+    size_t num_pairs = HALF_BAND_MAX_PAIRS;
+    if (transition > 0.0) {
+        double order = (attenuation - 8.0) / (2.285 * 2.0 * M_PI * transition);
+        num_pairs = (size_t)ceil((order + 2.0) / 4.0);
+    }
+    num_pairs = num_pairs < 1 ? 1 : num_pairs;
+    num_pairs = num_pairs > HALF_BAND_MAX_PAIRS
+        ? HALF_BAND_MAX_PAIRS
+        : num_pairs;
+
+    double beta = 0.0;
+    if (attenuation > 50.0) {
+        beta = 0.1102 * (attenuation - 8.7);
+    } else if (attenuation > 21.0) {
+        beta = 0.5842 * pow(attenuation - 21.0, 0.4) +
+            0.07886 * (attenuation - 21.0);
+    }
+
+    // Taps at the odd distances 2j + 1 from the center, normalized so that
+    // the odd outputs have a unit gain at DC, like the even ones.
+    double coefficient[HALF_BAND_MAX_PAIRS];
+    double sum = 0.0;
+    const double half_length = (double)(2 * num_pairs - 1);
+    for (size_t j = 0; j < num_pairs; ++j) {
+        double n = (double)(2 * j + 1);
+        double x = n / half_length;
+        double window = dsp_bessel_i0(beta * sqrt(1.0 - x * x)) /
+            dsp_bessel_i0(beta);
+        coefficient[j] = sin(M_PI * n / 2.0) / (M_PI * n / 2.0) * window;
+        sum += 2.0 * coefficient[j];
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->num_pairs = num_pairs;
+    for (size_t j = 0; j < num_pairs; ++j) {
+        state->coefficient[j] = (sample_t)lround(
+            coefficient[j] / sum * (double)(1 << HALF_BAND_SHIFT));
+    }
+    dsp_half_band_reset(state);
+}
+
+void dsp_half_band_reset(half_band_state_t* state) {
+    state->odd = false;
+    memset(state->past_i, 0, sizeof(state->past_i));
+    memset(state->past_q, 0, sizeof(state->past_q));
+}
+
+size_t dsp_half_band_num_inputs(const half_band_state_t* state, size_t size) {
+    return (size + 1 - (state->odd ? 1 : 0)) / 2;
+}
+
+static inline sample_t dsp_half_band_saturate(accumulator_t x) {
+    x >>= HALF_BAND_SHIFT;
+    return x > SAMPLE_MAX ? SAMPLE_MAX : (x < -SAMPLE_MAX - 1
+        ? -SAMPLE_MAX - 1
+        : (sample_t)x);
+}
+
+// Kernel shared by both layouts: sample n of a buffer is at index n * stride
+// of its I and Q pointers.
+//
+// The delay line (the last 2 * num_pairs inputs, oldest first) is followed by
+// a chunk of inputs in a linear buffer. Input r of the chunk is at index
+// 2 * num_pairs + r, and the pending odd output of a previous call is that of
+// input -1. The even output of input r is the central tap, and its odd
+// output the sum over j of the coefficient j times the pair of inputs at
+// num_pairs + r - j and num_pairs + r + 1 + j. The odd outputs of a chunk are
+// accumulated coefficient by coefficient, so that the loop over the inputs
+// has no dependency and is vectorized.
+static inline size_t dsp_half_band_process_strided(
+        half_band_state_t* state,
+        const sample_t* in_i,
+        const sample_t* in_q,
+        size_t in_stride,
+        sample_t* out_i,
+        sample_t* out_q,
+        size_t out_stride,
+        size_t size) {
+    const size_t num_pairs = state->num_pairs;
+    const size_t num_taps = 2 * num_pairs;
+    sample_t line_i[2 * HALF_BAND_MAX_PAIRS + HALF_BAND_CHUNK_SIZE];
+    sample_t line_q[2 * HALF_BAND_MAX_PAIRS + HALF_BAND_CHUNK_SIZE];
+    accumulator_t acc_i[HALF_BAND_CHUNK_SIZE + 1];
+    accumulator_t acc_q[HALF_BAND_CHUNK_SIZE + 1];
+    memcpy(line_i, state->past_i, num_taps * sizeof(sample_t));
+    memcpy(line_q, state->past_q, num_taps * sizeof(sample_t));
+
+    size_t consumed = 0;
+    bool odd = state->odd;
+    while (size) {
+        const size_t pending = odd ? 1 : 0;
+        size_t num_inputs = (size + 1 - pending) / 2;
+        num_inputs = num_inputs > HALF_BAND_CHUNK_SIZE
+            ? HALF_BAND_CHUNK_SIZE
+            : num_inputs;
+        size_t num_outputs = pending + 2 * num_inputs;
+        num_outputs = num_outputs > size ? size : num_outputs;
+
+        for (size_t r = 0; r < num_inputs; ++r) {
+            line_i[num_taps + r] = *in_i;
+            line_q[num_taps + r] = *in_q;
+            in_i += in_stride;
+            in_q += in_stride;
+        }
+
+        // acc[b] is the odd output of input b - 1.
+        const size_t first = 1 - pending;
+        for (size_t b = first; b <= num_inputs; ++b) {
+            acc_i[b] = 1 << (HALF_BAND_SHIFT - 1);
+            acc_q[b] = 1 << (HALF_BAND_SHIFT - 1);
+        }
+        for (size_t j = 0; j < num_pairs; ++j) {
+            const accumulator_t c = state->coefficient[j];
+            const sample_t* older_i = &line_i[num_pairs - 1 - j];
+            const sample_t* older_q = &line_q[num_pairs - 1 - j];
+            const sample_t* newer_i = &line_i[num_pairs + j];
+            const sample_t* newer_q = &line_q[num_pairs + j];
+            for (size_t b = first; b <= num_inputs; ++b) {
+                acc_i[b] += c *
+                    ((accumulator_t)older_i[b] + (accumulator_t)newer_i[b]);
+                acc_q[b] += c *
+                    ((accumulator_t)older_q[b] + (accumulator_t)newer_q[b]);
+            }
+        }
+
+        size_t n = 0;
+        if (pending) {
+            *out_i = dsp_half_band_saturate(acc_i[0]);
+            *out_q = dsp_half_band_saturate(acc_q[0]);
+            out_i += out_stride;
+            out_q += out_stride;
+            ++n;
+            odd = false;
+        }
+        for (size_t r = 0; n < num_outputs; ++r) {
+            *out_i = line_i[num_pairs + r];
+            *out_q = line_q[num_pairs + r];
+            out_i += out_stride;
+            out_q += out_stride;
+            odd = true;
+            if (++n == num_outputs) {
+                break;
+            }
+            *out_i = dsp_half_band_saturate(acc_i[r + 1]);
+            *out_q = dsp_half_band_saturate(acc_q[r + 1]);
+            out_i += out_stride;
+            out_q += out_stride;
+            odd = false;
+            ++n;
+        }
+
+        memmove(line_i, &line_i[num_inputs], num_taps * sizeof(sample_t));
+        memmove(line_q, &line_q[num_inputs], num_taps * sizeof(sample_t));
+        consumed += num_inputs;
+        size -= num_outputs;
+    }
+
+    memcpy(state->past_i, line_i, num_taps * sizeof(sample_t));
+    memcpy(state->past_q, line_q, num_taps * sizeof(sample_t));
+    state->odd = odd;
+    return consumed;
+}
+
+size_t dsp_half_band_process(
+        half_band_state_t* state,
+        const iq_sample_t* in,
+        iq_sample_t* out,
+        size_t size) {
+    return dsp_half_band_process_strided(
+        state, (const sample_t*)in, (const sample_t*)in + 1, 2,
+        (sample_t*)out, (sample_t*)out + 1, 2, size);
+}
+
+size_t dsp_half_band_process_planar(
+        half_band_state_t* state,
+        const sample_t* in_i,
+        const sample_t* in_q,
+        sample_t* out_i,
+        sample_t* out_q,
+        size_t size) {
+    return dsp_half_band_process_strided(
+        state, in_i, in_q, 1, out_i, out_q, 1, size);
+}
+
+bool dsp_interpolator_init(
+        interpolator_state_t* state,
+        size_t num_stages,
+        float roll_off,
+        uint32_t symbol_rate,
+        uint32_t sample_rate) {
+    if (num_stages > INTERPOLATOR_MAX_STAGES) {
+        return false;
+    }
+    if (num_stages && (sample_rate % (1u << num_stages) ||
+            (uint64_t)(sample_rate >> num_stages) < 2 * (uint64_t)symbol_rate)) {
+        return false;
+    }
+    state->num_stages = num_stages;
+    const float band = 0.5f * (float)symbol_rate * (1.0f + roll_off);
+    for (size_t s = 0; s < num_stages; ++s) {
+        uint32_t output_rate = sample_rate >> (num_stages - 1 - s);
+        dsp_half_band_init(
+            &state->stage[s],
+            band / (float)output_rate,
+            HALF_BAND_ATTENUATION_DB);
+    }
+    return true;
+}
+
+void dsp_interpolator_reset(interpolator_state_t* state) {
+    for (size_t s = 0; s < state->num_stages; ++s) {
+        dsp_half_band_reset(&state->stage[s]);
+    }
+}
+
+void dsp_interpolator_init_rrc(
+        const interpolator_state_t* state,
+        rrc_filter_state_t* rrc_filter,
+        const sample_t* lut_rrc,
+        uint32_t symbol_rate,
+        uint32_t sample_rate) {
+    const size_t num_stages = state->num_stages;
+    dsp_rrc_filter_init_with_lut(
+        rrc_filter, lut_rrc, symbol_rate, sample_rate >> num_stages);
+    rrc_filter->phase_increment =
+        dsp_phase_increment(symbol_rate, sample_rate) << num_stages;
+}
+
+size_t dsp_interpolator_delay(const interpolator_state_t* state) {
+    // 2 * num_pairs samples at the output rate of each stage.
+    size_t delay = 0;
+    for (size_t s = 0; s < state->num_stages; ++s) {
+        delay += (2 * state->stage[s].num_pairs) <<
+            (state->num_stages - 1 - s);
+    }
+    return delay;
+}
+
+float dsp_interpolator_multiplies(const interpolator_state_t* state) {
+    const size_t num_stages = state->num_stages;
+    float multiplies = (float)LUT_RRC_NUM_SYMBOLS / (float)(1 << num_stages);
+    for (size_t s = 0; s < num_stages; ++s) {
+        multiplies += 0.5f * (float)state->stage[s].num_pairs /
+            (float)(1 << (num_stages - 1 - s));
+    }
+    return multiplies;
+}
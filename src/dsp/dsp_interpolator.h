@@ -0,0 +1,112 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Multistage interpolation: the RRC filter runs at sample_rate >> num_stages,
+// and a cascade of num_stages half-band filters doubles the rate up to
+// sample_rate.
+//
+// A half-band filter interpolating by 2 has every other tap null, except the
+// central one: the even outputs are copies of the input, and the odd ones a
+// dot product of num_pairs coefficients with the sums of symmetric pairs of
+// inputs, so num_pairs / 2 multiplies per output sample. The signal occupies
+// a smaller fraction of the band at each stage, so that the later stages,
+// which run at the highest rates, are the shortest. With 3 stages at 20
+// samples per symbol, the cascade costs less than half the multiplies of the
+// direct filter.
+//
+// The filters are windowed sincs (Kaiser window), designed for the bandwidth
+// of the RRC pulse and an attenuation of the images of
+// HALF_BAND_ATTENUATION_DB, with their coefficients in Q14.
+
+#ifndef DSP_DSP_INTERPOLATOR_H_
+#define DSP_DSP_INTERPOLATOR_H_
+
+#include <stddef.h>
+
+#include "dsp/dsp_rrc_filter.h"
+#include "dsp/dsp_types.h"
+
+#define INTERPOLATOR_MAX_STAGES 4
+#define HALF_BAND_MAX_PAIRS 16
+#define HALF_BAND_ATTENUATION_DB 70.0f
+
+// Fractional bits of the coefficients: the sum of their magnitudes exceeds 1,
+// Q15 could overflow the accumulators.
+#define HALF_BAND_SHIFT 14
+
+typedef struct {
+    size_t num_pairs;
+    sample_t coefficient[HALF_BAND_MAX_PAIRS];
+
+    // The next output is an odd one, between the last two inputs.
+    bool odd;
+
+    // I and Q planes of the delay line, most recent input first.
+    sample_t past_i[2 * HALF_BAND_MAX_PAIRS];
+    sample_t past_q[2 * HALF_BAND_MAX_PAIRS];
+} half_band_state_t;
+
+typedef struct {
+    size_t num_stages;
+    half_band_state_t stage[INTERPOLATOR_MAX_STAGES];
+} interpolator_state_t;
+
+// pass_band: highest frequency of the signal, relative to the output rate
+// (below 0.25).
+void dsp_half_band_init(
+    half_band_state_t* state, float pass_band, float attenuation_db);
+
+void dsp_half_band_reset(half_band_state_t* state);
+
+// Inputs read to produce size outputs.
+size_t dsp_half_band_num_inputs(const half_band_state_t* state, size_t size);
+
+// Produces size samples. Returns the number of inputs consumed.
+size_t dsp_half_band_process(
+    half_band_state_t* state,
+    const iq_sample_t* in,
+    iq_sample_t* out,
+    size_t size);
+
+// Same as above, with the inputs and outputs as separate I and Q planes.
+size_t dsp_half_band_process_planar(
+    half_band_state_t* state,
+    const sample_t* in_i,
+    const sample_t* in_q,
+    sample_t* out_i,
+    sample_t* out_q,
+    size_t size);
+
+// Designs the stages for an RRC pulse. Returns false if num_stages exceeds
+// INTERPOLATOR_MAX_STAGES, if sample_rate is not a multiple of
+// 1 << num_stages, or if the RRC filter would run at less than twice the
+// symbol rate. 0 stages is the direct filter.
+bool dsp_interpolator_init(
+    interpolator_state_t* state,
+    size_t num_stages,
+    float roll_off,
+    uint32_t symbol_rate,
+    uint32_t sample_rate);
+
+void dsp_interpolator_reset(interpolator_state_t* state);
+
+// Initializes the RRC filter feeding the first stage, at
+// sample_rate >> num_stages. Its symbol clock advances by 1 << num_stages
+// times the increment of the direct filter: its output n is exactly the
+// output n << num_stages of the direct filter.
+void dsp_interpolator_init_rrc(
+    const interpolator_state_t* state,
+    rrc_filter_state_t* rrc_filter,
+    const sample_t* lut_rrc,
+    uint32_t symbol_rate,
+    uint32_t sample_rate);
+
+// Delay of the cascade, in samples at sample_rate: output n + delay matches
+// output n of the direct filter.
+size_t dsp_interpolator_delay(const interpolator_state_t* state);
+
+// Multiplies per output sample and component, RRC filter included.
+float dsp_interpolator_multiplies(const interpolator_state_t* state);
+
+#endif  // DSP_DSP_INTERPOLATOR_H_
@@ -0,0 +1,142 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Registry of the read-only LUTs.
+
+#include "dsp/dsp_lut_registry.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "dsp/dsp_phasor_bank.h"
+#include "dsp/dsp_rrc_filter.h"
+
+typedef struct {
+    dsp_lut_type_t type;
+    float parameter;
+    size_t num_references;  // 0 for a free entry.
+
+    const void* table;
+    void* memory;  // NULL for a precomputed table.
+} dsp_lut_entry_t;
+
+static dsp_lut_entry_t dsp_lut_registry_entry[DSP_LUT_REGISTRY_SIZE];
+
+// Guards the entries. Held while a table is built, so that concurrent
+// acquisitions of a table wait for its construction.
+static pthread_mutex_t dsp_lut_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// With the lock held.
+static void dsp_lut_registry_unref(dsp_lut_entry_t* entry) {
+    if (!--entry->num_references) {
+        free(entry->memory);
+        entry->memory = NULL;
+        entry->table = NULL;
+    }
+}
+
+static size_t dsp_lut_registry_table_size(dsp_lut_type_t type) {
+    return type == DSP_LUT_PHASOR
+        ? LUT_PHASOR_SIZE * sizeof(iq_sample_t)
+        : LUT_RRC_SIZE * sizeof(sample_t);
+}
+
+// Builds the table of an entry, with the lock held.
+static void dsp_lut_registry_build(dsp_lut_entry_t* entry) {
+    entry->table = NULL;
+    entry->memory = NULL;
+#ifdef DSP_PRECOMPUTED_LUTS
+    if (entry->type == DSP_LUT_PHASOR) {
+        entry->table = dsp_phasor_bank_get_lut(NULL);
+        return;
+    }
+#endif  // DSP_PRECOMPUTED_LUTS
+
+    size_t size = dsp_lut_registry_table_size(entry->type);
+    size = (size + DSP_LUT_ALIGNMENT - 1) / DSP_LUT_ALIGNMENT *
+        DSP_LUT_ALIGNMENT;
+    void* memory = aligned_alloc(DSP_LUT_ALIGNMENT, size);
+    if (!memory) {
+        return;
+    }
+    const void* table = entry->type == DSP_LUT_PHASOR
+        ? (const void*)dsp_phasor_bank_get_lut((iq_sample_t*)memory)
+        : (const void*)dsp_rrc_filter_get_lut(
+            (sample_t*)memory, entry->parameter);
+    if (table != memory) {
+        // Precomputed.
+        free(memory);
+        memory = NULL;
+    }
+    entry->table = table;
+    entry->memory = memory;
+}
+
+const void* dsp_lut_registry_acquire(dsp_lut_type_t type, float parameter) {
+    if (type == DSP_LUT_PHASOR) {
+        parameter = 0.0f;
+    }
+
+    pthread_mutex_lock(&dsp_lut_registry_mutex);
+    dsp_lut_entry_t* entry = NULL;
+    dsp_lut_entry_t* free_entry = NULL;
+    for (size_t i = 0; i < DSP_LUT_REGISTRY_SIZE; ++i) {
+        dsp_lut_entry_t* e = &dsp_lut_registry_entry[i];
+        if (!e->num_references) {
+            free_entry = free_entry ? free_entry : e;
+        } else if (e->type == type && e->parameter == parameter) {
+            entry = e;
+            break;
+        }
+    }
+    if (!entry && free_entry) {
+        entry = free_entry;
+        entry->type = type;
+        entry->parameter = parameter;
+        dsp_lut_registry_build(entry);
+        if (!entry->table) {
+            entry = NULL;
+        }
+    }
+    const void* table = NULL;
+    if (entry) {
+        ++entry->num_references;
+        table = entry->table;
+    }
+    pthread_mutex_unlock(&dsp_lut_registry_mutex);
+    return table;
+}
+
+const iq_sample_t* dsp_lut_registry_acquire_phasor(void) {
+    return (const iq_sample_t*)dsp_lut_registry_acquire(DSP_LUT_PHASOR, 0.0f);
+}
+
+const sample_t* dsp_lut_registry_acquire_rrc(float roll_off) {
+    return (const sample_t*)dsp_lut_registry_acquire(DSP_LUT_RRC, roll_off);
+}
+
+void dsp_lut_registry_release(const void* table) {
+    if (!table) {
+        return;
+    }
+    pthread_mutex_lock(&dsp_lut_registry_mutex);
+    for (size_t i = 0; i < DSP_LUT_REGISTRY_SIZE; ++i) {
+        dsp_lut_entry_t* e = &dsp_lut_registry_entry[i];
+        if (e->num_references && e->table == table) {
+            dsp_lut_registry_unref(e);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&dsp_lut_registry_mutex);
+}
+
+size_t dsp_lut_registry_size(void) {
+    size_t size = 0;
+    pthread_mutex_lock(&dsp_lut_registry_mutex);
+    for (size_t i = 0; i < DSP_LUT_REGISTRY_SIZE; ++i) {
+        size += dsp_lut_registry_entry[i].num_references != 0;
+    }
+    pthread_mutex_unlock(&dsp_lut_registry_mutex);
+    return size;
+}
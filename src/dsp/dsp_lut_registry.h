@@ -0,0 +1,50 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Process-wide registry of the read-only LUTs, shared by any number of blocks
+// on any number of threads.
+//
+// A table is identified by its type and parameter (the roll-off of an RRC
+// filter). The first acquisition builds it, in a buffer aligned on
+// DSP_LUT_ALIGNMENT bytes; concurrent acquisitions of the same table wait for
+// this construction, and later ones get the same table. Each acquisition
+// takes a reference, and the table is freed when the last one is released.
+// The tables precomputed at build time are returned as is.
+//
+// Unlike dsp_phasor_bank_fill_lut and dsp_rrc_filter_fill_lut, which must
+// not be called on a table in use, the registry never writes a table which
+// has been handed out.
+
+#ifndef DSP_DSP_LUT_REGISTRY_H_
+#define DSP_DSP_LUT_REGISTRY_H_
+
+#include <stddef.h>
+
+#include "dsp/dsp_types.h"
+
+// Distinct tables alive at once.
+#define DSP_LUT_REGISTRY_SIZE 32
+
+#define DSP_LUT_ALIGNMENT 64
+
+typedef enum {
+    DSP_LUT_PHASOR,
+    DSP_LUT_RRC,
+} dsp_lut_type_t;
+
+// Returns the table (LUT_PHASOR_SIZE phasors, or LUT_RRC_SIZE coefficients),
+// or NULL if the registry is full or out of memory. parameter: the roll-off
+// of an RRC table, ignored for the phasor table.
+const void* dsp_lut_registry_acquire(dsp_lut_type_t type, float parameter);
+
+const iq_sample_t* dsp_lut_registry_acquire_phasor(void);
+const sample_t* dsp_lut_registry_acquire_rrc(float roll_off);
+
+// Releases a reference taken by an acquisition. NULL is ignored.
+void dsp_lut_registry_release(const void* table);
+
+// Number of tables currently held.
+size_t dsp_lut_registry_size(void);
+
+#endif  // DSP_DSP_LUT_REGISTRY_H_
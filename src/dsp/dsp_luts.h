@@ -0,0 +1,47 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// LUTs precomputed at build time by tools/dsp_lut_generator.c, and stored as
+// read-only data. They are only available when DSP_PRECOMPUTED_LUTS is
+// defined; otherwise the LUTs are computed at runtime by the *_init functions.
+
+#ifndef DSP_DSP_LUTS_H_
+#define DSP_DSP_LUTS_H_
+
+#include <math.h>
+
+#include "dsp/dsp_phasor_bank.h"
+#include "dsp/dsp_rrc_filter.h"
+#include "dsp/dsp_types.h"
+
+#ifdef DSP_PRECOMPUTED_LUTS
+
+extern const iq_sample_t lut_phasor_precomputed[LUT_PHASOR_SIZE];
+
+// One RRC impulse response for each of the roll-off factors configured at
+// build time (DSP_PRECOMPUTED_RRC_ROLL_OFFS).
+extern const size_t lut_rrc_precomputed_count;
+extern const float lut_rrc_precomputed_roll_off[];
+extern const sample_t lut_rrc_precomputed[][LUT_RRC_SIZE];
+
+// Roll-off factors this close to a precomputed one use its LUT, so that a
+// roll-off obtained by a computation (0.1f + 0.2f) or parsed from another
+// decimal representation still finds it. The LUTs of two such roll-offs
+// would differ by far less than one LSB.
+#define DSP_LUT_ROLL_OFF_TOLERANCE 1e-6f
+
+// Index of the precomputed RRC LUT of a roll-off factor, or -1.
+static inline int dsp_luts_find_rrc(float roll_off) {
+    for (size_t i = 0; i < lut_rrc_precomputed_count; ++i) {
+        if (fabsf(lut_rrc_precomputed_roll_off[i] - roll_off) <=
+                DSP_LUT_ROLL_OFF_TOLERANCE) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+#endif  // DSP_PRECOMPUTED_LUTS
+
+#endif  // DSP_DSP_LUTS_H_
@@ -0,0 +1,99 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Static memory planner.
+
+#include "dsp/dsp_memory_plan.h"
+
+#include "dsp/dsp_luts.h"
+
+static bool dsp_memory_plan_has_precomputed_rrc(float roll_off) {
+#ifdef DSP_PRECOMPUTED_LUTS
+    return dsp_luts_find_rrc(roll_off) >= 0;
+#else
+    (void)roll_off;
+    return false;
+#endif  // DSP_PRECOMPUTED_LUTS
+}
+
+static void dsp_memory_plan_common(
+        dsp_memory_plan_t* plan,
+        const dsp_parameter_t* parameters) {
+    const uint32_t sr = parameters->sample_rate;
+    const uint64_t samples_per_symbol = sr / parameters->symbol_rate;
+
+    plan->num_samples_zc = parameters->zc_length *
+        (uint64_t)(sr / parameters->zc_rate);
+    plan->num_samples_qd = parameters->num_symbols * samples_per_symbol;
+    plan->num_samples_tail = parameters->num_null_symbols * samples_per_symbol;
+    plan->num_samples = plan->num_samples_zc + plan->num_samples_qd +
+        plan->num_samples_tail;
+    plan->num_symbols = (size_t)parameters->num_symbols + LUT_RRC_NUM_SYMBOLS;
+
+    plan->lut_phasor_bytes = DSP_PLAN_LUT_PHASOR_BYTES;
+    plan->lut_rrc_bytes = dsp_memory_plan_has_precomputed_rrc(
+        parameters->rrc_roll_off) ? 0 : DSP_PLAN_LUT_RRC_BYTES;
+    plan->state_bytes = DSP_PLAN_STATE_BYTES;
+}
+
+static void dsp_memory_plan_total(dsp_memory_plan_t* plan) {
+    plan->total_bytes = plan->lut_phasor_bytes + plan->lut_rrc_bytes +
+        plan->state_bytes + plan->symbol_buffer_bytes +
+        plan->sample_buffer_bytes;
+}
+
+void dsp_memory_plan_streaming(
+        dsp_memory_plan_t* plan,
+        const dsp_parameter_t* parameters,
+        size_t block_size) {
+    dsp_memory_plan_common(plan, parameters);
+    plan->block_size = block_size;
+    plan->symbols_per_block = DSP_PLAN_SYMBOLS_PER_BLOCK(
+        block_size, parameters->symbol_rate, parameters->sample_rate);
+    plan->symbol_buffer_bytes = DSP_PLAN_ALIGN(
+        sizeof(iq_sample_t) * plan->symbols_per_block);
+    plan->sample_buffer_bytes = DSP_PLAN_SAMPLE_BUFFER_BYTES(block_size);
+    dsp_memory_plan_total(plan);
+}
+
+void dsp_memory_plan_frame(
+        dsp_memory_plan_t* plan,
+        const dsp_parameter_t* parameters) {
+    dsp_memory_plan_common(plan, parameters);
+    plan->block_size = plan->num_samples;
+    plan->symbols_per_block = plan->num_symbols;
+    plan->symbol_buffer_bytes = DSP_PLAN_ALIGN(
+        sizeof(iq_sample_t) * plan->num_symbols);
+    plan->sample_buffer_bytes = DSP_PLAN_SAMPLE_BUFFER_BYTES(
+        plan->num_samples);
+    dsp_memory_plan_total(plan);
+}
+
+static void* dsp_memory_plan_take(uint8_t** memory, size_t size) {
+    if (!size) {
+        return NULL;
+    }
+    void* region = *memory;
+    *memory += size;
+    return region;
+}
+
+void dsp_memory_plan_assign(
+        const dsp_memory_plan_t* plan,
+        void* memory,
+        dsp_memory_t* regions) {
+    uint8_t* p = (uint8_t*)memory;
+    regions->lut_phasor = dsp_memory_plan_take(&p, plan->lut_phasor_bytes);
+    regions->lut_rrc = dsp_memory_plan_take(&p, plan->lut_rrc_bytes);
+    regions->rng = dsp_memory_plan_take(
+        &p, DSP_PLAN_ALIGN(sizeof(rng_state_t)));
+    regions->rrc_filter = dsp_memory_plan_take(
+        &p, DSP_PLAN_ALIGN(sizeof(rrc_filter_state_t)));
+    regions->phasor_bank = dsp_memory_plan_take(
+        &p, DSP_PLAN_ALIGN(sizeof(phasor_bank_state_t)));
+    regions->zc_generator = dsp_memory_plan_take(
+        &p, DSP_PLAN_ALIGN(sizeof(zc_generator_state_t)));
+    regions->symbols = dsp_memory_plan_take(&p, plan->symbol_buffer_bytes);
+    regions->samples = dsp_memory_plan_take(&p, plan->sample_buffer_bytes);
+}
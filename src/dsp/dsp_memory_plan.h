@@ -0,0 +1,121 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Static memory planner: computes the exact memory requirements (LUTs, block
+// states, block buffers) of the generation pipeline, for a whole frame or for
+// streaming processing by blocks of a fixed number of samples, so that all
+// buffers can be carved from a single statically allocated area.
+//
+// The DSP_PLAN_* macros give the same figures as compile-time constants, to
+// size static arrays. They can't know whether the RRC roll-off factor has a
+// precomputed LUT, so they always account for the RRC LUT.
+
+#ifndef DSP_DSP_MEMORY_PLAN_H_
+#define DSP_DSP_MEMORY_PLAN_H_
+
+#include "dsp/dsp_parameters.h"
+#include "dsp/dsp_phasor_bank.h"
+#include "dsp/dsp_rng.h"
+#include "dsp/dsp_rrc_filter.h"
+#include "dsp/dsp_types.h"
+#include "dsp/dsp_zc_generator.h"
+
+// All the regions are aligned on a cache line.
+#define DSP_PLAN_ALIGNMENT 64
+#define DSP_PLAN_ALIGN(size) \
+    (((size_t)(size) + DSP_PLAN_ALIGNMENT - 1) & \
+     ~(size_t)(DSP_PLAN_ALIGNMENT - 1))
+
+// Maximum number of symbols consumed by the RRC filter while producing
+// block_size samples: the number of wraps of its symbol clock.
+#define DSP_PLAN_SYMBOLS_PER_BLOCK(block_size, symbol_rate, sample_rate) \
+    ((size_t)(((((uint64_t)(symbol_rate) << 32) / (sample_rate)) * \
+                (uint64_t)(block_size) + 0xffffffff) >> 32))
+
+#ifdef DSP_PRECOMPUTED_LUTS
+    #define DSP_PLAN_LUT_PHASOR_BYTES 0
+#else
+    #define DSP_PLAN_LUT_PHASOR_BYTES \
+        DSP_PLAN_ALIGN(sizeof(iq_sample_t) * LUT_PHASOR_SIZE)
+#endif  // DSP_PRECOMPUTED_LUTS
+
+#define DSP_PLAN_LUT_RRC_BYTES DSP_PLAN_ALIGN(sizeof(sample_t) * LUT_RRC_SIZE)
+
+#define DSP_PLAN_STATE_BYTES \
+    (DSP_PLAN_ALIGN(sizeof(rng_state_t)) + \
+     DSP_PLAN_ALIGN(sizeof(rrc_filter_state_t)) + \
+     DSP_PLAN_ALIGN(sizeof(phasor_bank_state_t)) + \
+     DSP_PLAN_ALIGN(sizeof(zc_generator_state_t)))
+
+#define DSP_PLAN_SYMBOL_BUFFER_BYTES(block_size, symbol_rate, sample_rate) \
+    DSP_PLAN_ALIGN(sizeof(iq_sample_t) * DSP_PLAN_SYMBOLS_PER_BLOCK( \
+        block_size, symbol_rate, sample_rate))
+
+#define DSP_PLAN_SAMPLE_BUFFER_BYTES(block_size) \
+    DSP_PLAN_ALIGN(sizeof(iq_sample_t) * (block_size))
+
+// Total size of the memory area needed for streaming processing.
+#define DSP_PLAN_STREAMING_BYTES(block_size, symbol_rate, sample_rate) \
+    (DSP_PLAN_LUT_PHASOR_BYTES + DSP_PLAN_LUT_RRC_BYTES + \
+     DSP_PLAN_STATE_BYTES + \
+     DSP_PLAN_SYMBOL_BUFFER_BYTES(block_size, symbol_rate, sample_rate) + \
+     DSP_PLAN_SAMPLE_BUFFER_BYTES(block_size))
+
+typedef struct {
+    // Layout of a frame, in samples: ZC sequence, quantum data (symbols),
+    // null tail.
+    size_t num_samples_zc;
+    size_t num_samples_qd;
+    size_t num_samples_tail;
+    size_t num_samples;
+
+    // Symbols generated for a whole frame, including the zeros flushing
+    // the RRC filter.
+    size_t num_symbols;
+
+    // Streaming processing.
+    size_t block_size;
+    size_t symbols_per_block;
+
+    // Size in bytes of each region. A LUT available as read-only data needs
+    // no memory.
+    size_t lut_phasor_bytes;
+    size_t lut_rrc_bytes;
+    size_t state_bytes;
+    size_t symbol_buffer_bytes;
+    size_t sample_buffer_bytes;
+    size_t total_bytes;
+} dsp_memory_plan_t;
+
+// Pointers to the regions of a memory area laid out by a plan.
+typedef struct {
+    iq_sample_t* lut_phasor;
+    sample_t* lut_rrc;
+    rng_state_t* rng;
+    rrc_filter_state_t* rrc_filter;
+    phasor_bank_state_t* phasor_bank;
+    zc_generator_state_t* zc_generator;
+    iq_sample_t* symbols;
+    iq_sample_t* samples;
+} dsp_memory_t;
+
+// Plans the memory for streaming processing by blocks of block_size samples.
+void dsp_memory_plan_streaming(
+    dsp_memory_plan_t* plan,
+    const dsp_parameter_t* parameters,
+    size_t block_size);
+
+// Plans the memory for the generation of a whole frame at once.
+void dsp_memory_plan_frame(
+    dsp_memory_plan_t* plan,
+    const dsp_parameter_t* parameters);
+
+// Carves the regions from a memory area of plan->total_bytes bytes, aligned
+// on DSP_PLAN_ALIGNMENT bytes. Regions of size 0 get a NULL pointer.
+void dsp_memory_plan_assign(
+    const dsp_memory_plan_t* plan,
+    void* memory,
+    dsp_memory_t* regions);
+
+#endif  // DSP_DSP_MEMORY_PLAN_H_
@@ -0,0 +1,38 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Validation of the DSP parameters.
+
+#include "dsp/dsp_parameters.h"
+
+const char* dsp_parameters_check(const dsp_parameter_t* p) {
+    if (!p->sample_rate || !p->symbol_rate || !p->zc_rate) {
+        return "null rate";
+    }
+    if (p->symbol_rate > p->sample_rate || p->zc_rate > p->sample_rate) {
+        return "symbol or ZC rate above the sample rate";
+    }
+    if (!p->zc_length) {
+        return "null ZC length";
+    }
+    if (!(p->rrc_roll_off > 0.0f) || p->rrc_roll_off > 1.0f) {
+        return "RRC roll-off factor outside of ]0, 1]";
+    }
+
+    // Each product fits on 64 bits, and so does the sum of three of them
+    // once bounded.
+    const uint64_t sr = p->sample_rate;
+    const uint64_t samples_per_symbol = sr / p->symbol_rate;
+    const uint64_t num_samples_zc = p->zc_length * (sr / p->zc_rate);
+    const uint64_t num_samples_qd = p->num_symbols * samples_per_symbol;
+    const uint64_t num_samples_tail = p->num_null_symbols * samples_per_symbol;
+    if (num_samples_zc > DSP_MAX_FRAME_SAMPLES ||
+            num_samples_qd > DSP_MAX_FRAME_SAMPLES ||
+            num_samples_tail > DSP_MAX_FRAME_SAMPLES ||
+            num_samples_zc + num_samples_qd + num_samples_tail >
+                DSP_MAX_FRAME_SAMPLES) {
+        return "frame too long";
+    }
+    return NULL;
+}
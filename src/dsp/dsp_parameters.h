@@ -34,4 +34,12 @@ typedef struct {
     float rrc_roll_off;
 } dsp_parameter_t;
 
+// Maximum number of samples of a frame, so that the sizes in bytes of its
+// samples and symbols, and their sum, can't overflow a size_t.
+#define DSP_MAX_FRAME_SAMPLES (SIZE_MAX / 4 / sizeof(iq_sample_t))
+
+// Checks that the parameters describe a frame the blocks can generate.
+// Returns NULL if they do, otherwise a description of the first problem.
+const char* dsp_parameters_check(const dsp_parameter_t* parameters);
+
 #endif  // DSP_DSP_PARAMETERS_H_
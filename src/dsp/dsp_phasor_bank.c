@@ -10,41 +10,125 @@
 
 #include <math.h>
 
+#include "dsp/dsp_luts.h"
+
 #ifndef M_PI
     #define M_PI 3.14159265358979323846
 #endif  // M_PI
 
+static size_t dsp_phasor_bank_gcd(size_t a, size_t b) {
+    while (b) {
+        size_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
 void dsp_phasor_bank_init(
         phasor_bank_state_t* state,
-        iq_sample_t* lut_phasor,
+        const iq_sample_t* lut_phasor,
         phasor_bank_algorithm_t algorithm,
         uint32_t* frequency,
         float* amplitude,
         uint32_t sample_rate) {
-    state->algorithm = algorithm;
+    dsp_phasor_bank_init_tones(
+        state, lut_phasor, algorithm, NUM_PHASORS, PHASOR_BANK_ALL_TONES,
+        frequency, amplitude, sample_rate);
+}
+
+// Computes the increments and amplitudes, and selects the kernel, from the
+// settings given at init.
+static void dsp_phasor_bank_configure(
+        phasor_bank_state_t* state,
+        const uint32_t* frequency,
+        const float* amplitude) {
+    const size_t num_phasors = state->num_phasors;
+    const uint32_t enable_mask = state->enable_mask;
+    const uint32_t sample_rate = state->sample_rate;
+    phasor_bank_algorithm_t algorithm = state->requested_algorithm;
 
     for (size_t i = 0; i < NUM_PHASORS; ++i) {
-        state->phase_increment[i] = dsp_phase_increment(
-            frequency[i], sample_rate);
-        state->amplitude[i] = (accumulator_t)(amplitude[i] * SAMPLE_MAX);
+        if (i < num_phasors) {
+            state->phase_increment[i] = dsp_phase_increment(
+                frequency[i], sample_rate);
+            state->amplitude[i] = (accumulator_t)(amplitude[i] * SAMPLE_MAX);
+        } else {
+            state->phase_increment[i] = 0;
+            state->amplitude[i] = 0;
+        }
+    }
+
+    // Phasors 1 and above are pilots, directly added to the output.
+    for (size_t i = 1; i < NUM_PHASORS; ++i) {
+        state->amplitude[i] *= DAC_OUTPUT_SCALE;
+    }
+
+    // Pilots with a null amplitude add 0 to the signal: skip them.
+    state->num_active_pilots = 0;
+    for (size_t i = 1; i < num_phasors; ++i) {
+        if ((enable_mask & (1 << i)) && state->amplitude[i] != 0) {
+            state->active_pilot[state->num_active_pilots++] = i;
+        }
+    }
+
+    // The sum of the pilots is periodic, with a period equal to the LCM of
+    // the individual periods sample_rate / gcd(frequency, sample_rate).
+    size_t period = 1;
+    for (size_t k = 0; k < state->num_active_pilots; ++k) {
+        uint32_t f = frequency[state->active_pilot[k]] % sample_rate;
+        size_t pilot_period = sample_rate / dsp_phasor_bank_gcd(
+            f, sample_rate);
+        period = period / dsp_phasor_bank_gcd(period, pilot_period) *
+            pilot_period;
+        if (period > PHASOR_BANK_PILOT_CACHE_SIZE) {
+            break;
+        }
     }
+    bool cache = state->num_active_pilots &&
+        period <= PHASOR_BANK_PILOT_CACHE_SIZE;
+    state->pilot_cache_period = cache ? period : 0;
 
     if (algorithm == PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS) {
-        state->amplitude[1] *= DAC_OUTPUT_SCALE;
-        state->amplitude[2] *= DAC_OUTPUT_SCALE;
+        bool pilots = state->num_active_pilots != 0;
+        if (num_phasors == 0 || !(enable_mask & 1)) {
+            algorithm = pilots
+                ? PHASOR_BANK_ALGORITHM_PILOTS
+                : PHASOR_BANK_ALGORITHM_BYPASS;
+        } else if (state->phase_increment[0] == 0) {
+            // A 0 Hz shift is a multiplication by a constant.
+            algorithm = pilots
+                ? PHASOR_BANK_ALGORITHM_SCALE_PILOTS
+                : PHASOR_BANK_ALGORITHM_SCALE;
+        } else {
+            algorithm = pilots
+                ? PHASOR_BANK_ALGORITHM_SHIFT_PILOTS
+                : PHASOR_BANK_ALGORITHM_SHIFT;
+        }
     }
+    state->algorithm = algorithm;
+}
 
-    dsp_phasor_bank_fill_lut(lut_phasor);
-    dsp_phasor_bank_reset(state);
+void dsp_phasor_bank_init_tones(
+        phasor_bank_state_t* state,
+        const iq_sample_t* lut_phasor,
+        phasor_bank_algorithm_t algorithm,
+        size_t num_phasors,
+        uint32_t enable_mask,
+        uint32_t* frequency,
+        float* amplitude,
+        uint32_t sample_rate) {
+    state->requested_algorithm = algorithm;
+    state->num_phasors = num_phasors > NUM_PHASORS ? NUM_PHASORS : num_phasors;
+    state->enable_mask = enable_mask;
+    state->sample_rate = sample_rate;
+    dsp_phasor_bank_configure(state, frequency, amplitude);
 
     state->lut_phasor = lut_phasor;
+    dsp_phasor_bank_reset(state);
 }
 
 void dsp_phasor_bank_fill_lut(iq_sample_t* lut_phasor) {
-    if (lut_phasor[0].i == SAMPLE_MAX && lut_phasor[0].q == 0) {
-        return;
-    }
-
     for (size_t i = 0; i < LUT_PHASOR_SIZE; ++i) {
         float angle = 2 * M_PI * (float)(i) / (float)(LUT_PHASOR_SIZE);
         lut_phasor[i] = (iq_sample_t) {
@@ -53,48 +137,503 @@ void dsp_phasor_bank_fill_lut(iq_sample_t* lut_phasor) {
     }
 }
 
+const iq_sample_t* dsp_phasor_bank_get_lut(iq_sample_t* lut_phasor) {
+#ifdef DSP_PRECOMPUTED_LUTS
+    (void)lut_phasor;
+    return lut_phasor_precomputed;
+#else
+    dsp_phasor_bank_fill_lut(lut_phasor);
+    return lut_phasor;
+#endif  // DSP_PRECOMPUTED_LUTS
+}
+
 void dsp_phasor_bank_reset(phasor_bank_state_t* state) {
     for (size_t i = 0; i < NUM_PHASORS; ++i) {
         state->phase[i] = 0;
     }
+    state->pilot_cache_index = 0;
+    state->pilot_cache_remaining = 0;
+    state->position = 0;
+    state->retune_pending = false;
+    state->ramp_remaining = 0;
+#ifdef DSP_STATISTICS
+    dsp_signal_statistics_reset(&state->statistics);
+    state->num_wrapped = 0;
+#endif  // DSP_STATISTICS
+}
+
+static inline iq_sample_t dsp_phasor_bank_phasor(
+        const iq_sample_t* lut_phasor,
+        phase_t phase,
+        accumulator_t amplitude) {
+    iq_sample_t p = lut_phasor[phase >> LUT_PHASOR_INTEGRAL_PART_SHIFT];
+    /*iq_sample_t p;
+    p.i = cosf((float)(phase >> 12) / (float)(1 << 20) * 2.0f * M_PI);
+    p.q = sinf((float)(phase >> 12) / (float)(1 << 20) * 2.0f * M_PI);*/
+    return (iq_sample_t) {
+        .i = p.i * amplitude SCALE,
+        .q = p.q * amplitude SCALE
+    };
+}
+
+static inline iq_sample_t dsp_phasor_bank_mix(iq_sample_t x, iq_sample_t y) {
+    return (iq_sample_t) {
+        .i = (x.i * y.i - x.q * y.q) SCALE,
+        .q = (x.q * y.i + x.i * y.q) SCALE
+    };
+}
+
+typedef struct {
+    size_t size;
+    phase_t phase[NUM_PHASORS - 1];
+    phase_t phase_increment[NUM_PHASORS - 1];
+    accumulator_t amplitude[NUM_PHASORS - 1];
+    const iq_sample_t* cache;
+} phasor_bank_pilots_t;
+
+#ifdef DSP_STATISTICS
+// Whether adding (i, q) to x overflows the range of a sample.
+static inline uint32_t dsp_phasor_bank_wraps(
+        iq_sample_t x, accumulator_t i, accumulator_t q) {
+    uint32_t sum_i = (uint32_t)(x.i + i + 32768);
+    uint32_t sum_q = (uint32_t)(x.q + q + 32768);
+    return (sum_i | sum_q) > 65535;
+}
+
+// Number of output samples for which the addition of the cached pilots has
+// wrapped around. Testing the sums in the kernel would slow it down; instead,
+// the pilots are subtracted back from the output: without wrapping, this
+// gives the input of the addition, otherwise a value out of the range of a
+// sample.
+static inline uint64_t dsp_phasor_bank_count_cached_wraps(
+        const sample_t* x_i,
+        const sample_t* x_q,
+        size_t stride,
+        const iq_sample_t* pilot_cache,
+        size_t size) {
+    uint64_t num_wrapped = 0;
+    for (size_t n = 0; n < size; ++n) {
+        iq_sample_t x = { x_i[n * stride], x_q[n * stride] };
+        num_wrapped += dsp_phasor_bank_wraps(
+            x, -pilot_cache[n].i, -pilot_cache[n].q);
+    }
+    return num_wrapped;
+}
+#endif  // DSP_STATISTICS
+
+// With statistics, num_wrapped counts the samples whose sum wraps around
+// (when the pilots are not read from the cache, see
+// dsp_phasor_bank_count_cached_wraps).
+static inline iq_sample_t dsp_phasor_bank_add_pilots(
+        phasor_bank_pilots_t* pilots,
+        const iq_sample_t* lut_phasor,
+        iq_sample_t x
+        DSP_STATISTICS_ONLY(, uint64_t* num_wrapped)) {
+    if (pilots->cache) {
+        iq_sample_t p = *pilots->cache++;
+        x.i += p.i;
+        x.q += p.q;
+        return x;
+    }
+    accumulator_t i = 0;
+    accumulator_t q = 0;
+    for (size_t k = 0; k < pilots->size; ++k) {
+        iq_sample_t p = dsp_phasor_bank_phasor(
+            lut_phasor, pilots->phase[k], pilots->amplitude[k]);
+        i += p.i;
+        q += p.q;
+        pilots->phase[k] += pilots->phase_increment[k];
+    }
+    DSP_STATISTICS_ONLY(*num_wrapped += dsp_phasor_bank_wraps(x, i, q);)
+    x.i += i;
+    x.q += q;
+    return x;
+}
+
+static void dsp_phasor_bank_fill_pilot_cache(phasor_bank_state_t* state) {
+    const phase_t fractional_mask = (1 << LUT_PHASOR_INTEGRAL_PART_SHIFT) - 1;
+    size_t period = state->pilot_cache_period;
+
+    // Number of additional periods for which the cache remains valid.
+    size_t valid_periods = SIZE_MAX / period - 1;
+
+    for (size_t j = 0; j < period; ++j) {
+        state->pilot_cache[j] = (iq_sample_t) { .i = 0, .q = 0 };
+    }
+
+    for (size_t k = 0; k < state->num_active_pilots; ++k) {
+        size_t index = state->active_pilot[k];
+        phase_t phase = state->phase[index];
+        phase_t increment = state->phase_increment[index];
+        accumulator_t amplitude = state->amplitude[index];
+
+        // Over one period, the phase accumulator is shifted by a small drift.
+        // The cached sample remains valid as long as the drift does not make
+        // the phase cross a LUT entry boundary.
+        int32_t drift = (int32_t)(increment * (phase_t)period);
+        for (size_t j = 0; j < period; ++j) {
+            iq_sample_t p = dsp_phasor_bank_phasor(
+                state->lut_phasor, phase, amplitude);
+            accumulator_t i = state->pilot_cache[j].i;
+            accumulator_t q = state->pilot_cache[j].q;
+            state->pilot_cache[j] = (iq_sample_t) {
+                .i = i + p.i,
+                .q = q + p.q };
+
+            phase_t fractional = phase & fractional_mask;
+            size_t margin = SIZE_MAX;
+            if (drift < 0) {
+                margin = fractional / (phase_t)(-(int64_t)drift);
+            } else if (drift > 0) {
+                margin = (fractional_mask - fractional) / (phase_t)drift;
+            }
+            if (margin < valid_periods) {
+                valid_periods = margin;
+            }
+            phase += increment;
+        }
+    }
+
+    state->pilot_cache_index = 0;
+    state->pilot_cache_remaining = (valid_periods + 1) * period;
+}
+
+// Sample n of the signal is at index n * stride of x_i and x_q.
+static inline void dsp_phasor_bank_process_chunk(
+        phasor_bank_state_t* state,
+        const iq_sample_t* pilot_cache,
+        sample_t* x_i,
+        sample_t* x_q,
+        size_t stride,
+        size_t size) {
+    const iq_sample_t* lut = state->lut_phasor;
+
+    phasor_bank_pilots_t pilots;
+    pilots.size = state->num_active_pilots;
+    pilots.cache = pilot_cache;
+    for (size_t k = 0; k < pilots.size; ++k) {
+        size_t index = state->active_pilot[k];
+        pilots.phase[k] = state->phase[index];
+        pilots.phase_increment[k] = state->phase_increment[index];
+        pilots.amplitude[k] = state->amplitude[index];
+    }
+    DSP_STATISTICS_ONLY(
+        uint64_t num_wrapped = 0;
+        const sample_t* out_i = x_i;
+        const sample_t* out_q = x_q;)
+    phase_t shift_phase = state->phase[0];
+    phase_t shift_increment = state->phase_increment[0];
+    accumulator_t shift_amplitude = state->amplitude[0];
+    iq_sample_t gain = dsp_phasor_bank_phasor(
+        lut, shift_phase, shift_amplitude);
+
+    size_t n = size;
+    switch (state->algorithm) {
+        case PHASOR_BANK_ALGORITHM_BYPASS:
+            break;
+
+        case PHASOR_BANK_ALGORITHM_PILOTS:
+            while (n--) {
+                iq_sample_t x = { *x_i, *x_q };
+                x = dsp_phasor_bank_add_pilots(
+                    &pilots, lut, x DSP_STATISTICS_ONLY(, &num_wrapped));
+                *x_i = x.i;
+                *x_q = x.q;
+                x_i += stride;
+                x_q += stride;
+            }
+            break;
+
+        case PHASOR_BANK_ALGORITHM_SCALE:
+            while (n--) {
+                iq_sample_t x = { *x_i, *x_q };
+                x = dsp_phasor_bank_mix(x, gain);
+                *x_i = x.i;
+                *x_q = x.q;
+                x_i += stride;
+                x_q += stride;
+            }
+            break;
+
+        case PHASOR_BANK_ALGORITHM_SCALE_PILOTS:
+            while (n--) {
+                iq_sample_t x = { *x_i, *x_q };
+                x = dsp_phasor_bank_add_pilots(
+                    &pilots, lut, dsp_phasor_bank_mix(x, gain)
+                    DSP_STATISTICS_ONLY(, &num_wrapped));
+                *x_i = x.i;
+                *x_q = x.q;
+                x_i += stride;
+                x_q += stride;
+            }
+            break;
+
+        case PHASOR_BANK_ALGORITHM_SHIFT:
+            while (n--) {
+                iq_sample_t y = dsp_phasor_bank_phasor(
+                    lut, shift_phase, shift_amplitude);
+                shift_phase += shift_increment;
+                iq_sample_t x = { *x_i, *x_q };
+                x = dsp_phasor_bank_mix(x, y);
+                *x_i = x.i;
+                *x_q = x.q;
+                x_i += stride;
+                x_q += stride;
+            }
+            break;
+
+        case PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS:
+        case PHASOR_BANK_ALGORITHM_SHIFT_PILOTS:
+            while (n--) {
+                // Use first phasor to modulate, then add the pilots.
+                iq_sample_t y = dsp_phasor_bank_phasor(
+                    lut, shift_phase, shift_amplitude);
+                shift_phase += shift_increment;
+                iq_sample_t x = { *x_i, *x_q };
+                x = dsp_phasor_bank_add_pilots(
+                    &pilots, lut, dsp_phasor_bank_mix(x, y)
+                    DSP_STATISTICS_ONLY(, &num_wrapped));
+                *x_i = x.i;
+                *x_q = x.q;
+                x_i += stride;
+                x_q += stride;
+            }
+            break;
+    }
+    // The statistics of the output are computed afterwards, while it is still
+    // in the cache, rather than in the kernels.
+    DSP_STATISTICS_ONLY(
+        if (pilot_cache) {
+            num_wrapped = dsp_phasor_bank_count_cached_wraps(
+                out_i, out_q, stride, pilot_cache, size);
+        }
+        state->num_wrapped += num_wrapped;
+        dsp_signal_statistics_add_strided(
+            &state->statistics, out_i, out_q, stride, size);)
+
+    // All phasors keep running, even those which have been skipped.
+    for (size_t i = 0; i < NUM_PHASORS; ++i) {
+        state->phase[i] += state->phase_increment[i] * (phase_t)size;
+    }
+}
+
+static inline void dsp_phasor_bank_process_block(
+        phasor_bank_state_t* state,
+        sample_t* x_i,
+        sample_t* x_q,
+        size_t stride,
+        size_t size) {
+    bool cache = state->pilot_cache_period &&
+        state->algorithm != PHASOR_BANK_ALGORITHM_BYPASS &&
+        state->algorithm != PHASOR_BANK_ALGORITHM_SCALE &&
+        state->algorithm != PHASOR_BANK_ALGORITHM_SHIFT;
+    if (!cache) {
+        dsp_phasor_bank_process_chunk(state, NULL, x_i, x_q, stride, size);
+        return;
+    }
+
+    while (size) {
+        if (!state->pilot_cache_remaining) {
+            dsp_phasor_bank_fill_pilot_cache(state);
+        }
+        size_t chunk = state->pilot_cache_period - state->pilot_cache_index;
+        if (chunk > state->pilot_cache_remaining) {
+            chunk = state->pilot_cache_remaining;
+        }
+        if (chunk > size) {
+            chunk = size;
+        }
+        dsp_phasor_bank_process_chunk(
+            state,
+            &state->pilot_cache[state->pilot_cache_index],
+            x_i,
+            x_q,
+            stride,
+            chunk);
+        state->pilot_cache_index += chunk;
+        if (state->pilot_cache_index == state->pilot_cache_period) {
+            state->pilot_cache_index = 0;
+        }
+        state->pilot_cache_remaining -= chunk;
+        x_i += chunk * stride;
+        x_q += chunk * stride;
+        size -= chunk;
+    }
+}
+
+// Same kernel as SHIFT_PILOTS, with amplitudes changing at each sample, and
+// all the pilots which may be active during the ramp.
+static void dsp_phasor_bank_process_ramp(
+        phasor_bank_state_t* state,
+        sample_t* x_i,
+        sample_t* x_q,
+        size_t stride,
+        size_t size) {
+    const iq_sample_t* lut = state->lut_phasor;
+    const phasor_bank_algorithm_t requested = state->requested_algorithm;
+    const bool any = requested == PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS;
+    const bool shift = (any &&
+        state->num_phasors && (state->enable_mask & 1)) ||
+        requested == PHASOR_BANK_ALGORITHM_SCALE ||
+        requested == PHASOR_BANK_ALGORITHM_SCALE_PILOTS ||
+        requested == PHASOR_BANK_ALGORITHM_SHIFT ||
+        requested == PHASOR_BANK_ALGORITHM_SHIFT_PILOTS;
+    const bool pilots = any ||
+        requested == PHASOR_BANK_ALGORITHM_PILOTS ||
+        requested == PHASOR_BANK_ALGORITHM_SCALE_PILOTS ||
+        requested == PHASOR_BANK_ALGORITHM_SHIFT_PILOTS;
+
+    size_t num_pilots = 0;
+    uint8_t pilot[NUM_PHASORS - 1];
+    for (size_t i = 1; pilots && i < state->num_phasors; ++i) {
+        if (state->enable_mask & (1 << i)) {
+            pilot[num_pilots++] = i;
+        }
+    }
+
+    phase_t phase[NUM_PHASORS];
+    int64_t amplitude[NUM_PHASORS];
+    for (size_t i = 0; i < NUM_PHASORS; ++i) {
+        phase[i] = state->phase[i];
+        amplitude[i] = state->ramp_amplitude[i];
+    }
+    DSP_STATISTICS_ONLY(
+        uint64_t num_wrapped = 0;
+        const sample_t* out_i = x_i;
+        const sample_t* out_q = x_q;)
+
+    for (size_t n = 0; n < size; ++n) {
+        iq_sample_t x = { *x_i, *x_q };
+        if (shift) {
+            x = dsp_phasor_bank_mix(x, dsp_phasor_bank_phasor(
+                lut, phase[0], (accumulator_t)(amplitude[0] >> 16)));
+        }
+        accumulator_t i = 0;
+        accumulator_t q = 0;
+        for (size_t k = 0; k < num_pilots; ++k) {
+            iq_sample_t p = dsp_phasor_bank_phasor(
+                lut,
+                phase[pilot[k]],
+                (accumulator_t)(amplitude[pilot[k]] >> 16));
+            i += p.i;
+            q += p.q;
+        }
+        DSP_STATISTICS_ONLY(num_wrapped += dsp_phasor_bank_wraps(x, i, q);)
+        *x_i = x.i + i;
+        *x_q = x.q + q;
+        x_i += stride;
+        x_q += stride;
+
+        for (size_t j = 0; j < NUM_PHASORS; ++j) {
+            phase[j] += state->phase_increment[j];
+            amplitude[j] += state->ramp_increment[j];
+        }
+    }
+    DSP_STATISTICS_ONLY(
+        state->num_wrapped += num_wrapped;
+        dsp_signal_statistics_add_strided(
+            &state->statistics, out_i, out_q, stride, size);)
+
+    for (size_t i = 0; i < NUM_PHASORS; ++i) {
+        state->phase[i] = phase[i];
+        state->ramp_amplitude[i] = amplitude[i];
+    }
+}
+
+static void dsp_phasor_bank_apply_retune(phasor_bank_state_t* state) {
+    // Amplitudes at which a ramp would start.
+    int64_t start[NUM_PHASORS];
+    for (size_t i = 0; i < NUM_PHASORS; ++i) {
+        start[i] = state->ramp_remaining
+            ? state->ramp_amplitude[i]
+            : (int64_t)state->amplitude[i] << 16;
+    }
+
+    dsp_phasor_bank_configure(
+        state, state->retune_frequency, state->retune_amplitude);
+    state->retune_pending = false;
+
+    // The cache is refilled from the accumulators, with the new increments.
+    state->pilot_cache_index = 0;
+    state->pilot_cache_remaining = 0;
+
+    const size_t ramp_size = state->retune_ramp_size;
+    bool ramp = false;
+    for (size_t i = 0; i < NUM_PHASORS; ++i) {
+        int64_t target = (int64_t)state->amplitude[i] << 16;
+        state->ramp_amplitude[i] = start[i];
+        state->ramp_increment[i] = ramp_size
+            ? (target - start[i]) / (int64_t)ramp_size
+            : 0;
+        ramp = ramp || target != start[i];
+    }
+    // Without a change of amplitude, the specialized kernels are kept.
+    state->ramp_remaining = ramp ? ramp_size : 0;
+}
+
+void dsp_phasor_bank_retune(
+        phasor_bank_state_t* state,
+        const uint32_t* frequency,
+        const float* amplitude,
+        uint64_t position,
+        size_t ramp_size) {
+    for (size_t i = 0; i < NUM_PHASORS; ++i) {
+        state->retune_frequency[i] = frequency[i];
+        state->retune_amplitude[i] = amplitude[i];
+    }
+    state->retune_position = position;
+    state->retune_ramp_size = ramp_size;
+    state->retune_pending = true;
+    if (position <= state->position) {
+        dsp_phasor_bank_apply_retune(state);
+    }
+}
+
+// Splits the signal at the pending retune and at the end of the ramp.
+static inline void dsp_phasor_bank_process_strided(
+        phasor_bank_state_t* state,
+        sample_t* x_i,
+        sample_t* x_q,
+        size_t stride,
+        size_t size) {
+    while (size) {
+        size_t n = size;
+        if (state->retune_pending &&
+                state->retune_position - state->position < n) {
+            n = (size_t)(state->retune_position - state->position);
+        }
+        if (state->ramp_remaining) {
+            if (state->ramp_remaining < n) {
+                n = state->ramp_remaining;
+            }
+            dsp_phasor_bank_process_ramp(state, x_i, x_q, stride, n);
+            state->ramp_remaining -= n;
+        } else {
+            dsp_phasor_bank_process_block(state, x_i, x_q, stride, n);
+        }
+        state->position += n;
+        if (state->retune_pending &&
+                state->position == state->retune_position) {
+            dsp_phasor_bank_apply_retune(state);
+        }
+        x_i += n * stride;
+        x_q += n * stride;
+        size -= n;
+    }
 }
 
 void dsp_phasor_bank_process(
         phasor_bank_state_t* state,
         iq_sample_t* in_out,
         size_t size) {
-    phasor_bank_state_t s = *state;
-
-    while (size--) {
-        iq_sample_t phasors[NUM_PHASORS];
-        for (size_t i = 0; i < NUM_PHASORS; ++i) {
-            accumulator_t amplitude = s.amplitude[i];
-            iq_sample_t p = s.lut_phasor[
-                s.phase[i] >> LUT_PHASOR_INTEGRAL_PART_SHIFT];
-            /*iq_sample_t p;
-            p.i = cosf((float)(s.phase[i] >> 12) / (float)(1 << 20) * 2.0f * M_PI);
-            p.q = sinf((float)(s.phase[i] >> 12) / (float)(1 << 20) * 2.0f * M_PI);*/
-            phasors[i] = (iq_sample_t) {
-                .i = p.i * amplitude SCALE,
-                .q = p.q * amplitude SCALE
-            };
-            s.phase[i] += s.phase_increment[i];
-        }
-
-        iq_sample_t x = *in_out;
-        if (s.algorithm == PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS) {
-            // Use first phasor to modulate.
-            iq_sample_t y = phasors[0];
-            x = (iq_sample_t) {
-                .i = (x.i * y.i - x.q * y.q) SCALE,
-                .q = (x.q * y.i + x.i * y.q) SCALE
-            };
-            // Add the two other phasors to the signal.
-            x.i += phasors[1].i + phasors[2].i;
-            x.q += phasors[1].q + phasors[2].q;
-        }
-        *in_out++ = x;
-    }
-
-    *state = s;
+    dsp_phasor_bank_process_strided(
+        state, (sample_t*)in_out, (sample_t*)in_out + 1, 2, size);
+}
+
+void dsp_phasor_bank_process_planar(
+        phasor_bank_state_t* state,
+        sample_t* in_out_i,
+        sample_t* in_out_q,
+        size_t size) {
+    dsp_phasor_bank_process_strided(state, in_out_i, in_out_q, 1, size);
 }
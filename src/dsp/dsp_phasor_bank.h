@@ -5,12 +5,21 @@
 // The phasor bank block manages a bank of N=3 phasors with
 // controllable frequency and amplitude and various mixing modes.
 // Default: use phasor 1 to shift and add phasors 2 & 3 as pilots.
+//
+// Tones which do not contribute to the output (0 Hz shift, pilots with a null
+// amplitude) are detected at init, and a specialized kernel is selected so
+// that they cost nothing. Periodic pilots are read from a cache.
+//
+// The frequencies and amplitudes can be changed while the bank runs, at a
+// given sample (see dsp_phasor_bank_retune): the phases are kept, so that
+// the tones stay continuous, and the amplitudes can be ramped linearly.
 
 #ifndef DSP_DSP_PHASOR_BANK_H_
 #define DSP_DSP_PHASOR_BANK_H_
 
 #include <stdint.h>
 
+#include "dsp/dsp_statistics.h"
 #include "dsp/dsp_types.h"
 
 #define NUM_PHASORS 3
@@ -20,31 +29,144 @@
 #define LUT_PHASOR_INTEGRAL_PART_SHIFT (32 - LUT_PHASOR_LOG2_SIZE)
 #define LUT_PHASOR_SIZE (1 << LUT_PHASOR_LOG2_SIZE)
 
+#define PHASOR_BANK_ALL_TONES ((1 << NUM_PHASORS) - 1)
+
+// Maximum period (in samples) of the sum of the pilots for it to be cached.
+// Sizes phasor_bank_state_t: fixed, so that all the users of this header
+// agree on its layout.
+#define PHASOR_BANK_PILOT_CACHE_SIZE 1024
+
 typedef enum {
-    PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS
+    // Use phasor 0 to shift and add the other phasors as pilots. This is the
+    // mode requested by the caller; dsp_phasor_bank_init() replaces it by one
+    // of the specialized kernels below, depending on which tones are active.
+    PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS,
+
+    // Specialized kernels.
+    PHASOR_BANK_ALGORITHM_BYPASS,        // Nothing to do.
+    PHASOR_BANK_ALGORITHM_PILOTS,        // Add the pilots only.
+    PHASOR_BANK_ALGORITHM_SCALE,         // Constant complex gain (0 Hz shift).
+    PHASOR_BANK_ALGORITHM_SCALE_PILOTS,  // Constant gain, then add pilots.
+    PHASOR_BANK_ALGORITHM_SHIFT,         // Frequency shift only.
+    PHASOR_BANK_ALGORITHM_SHIFT_PILOTS   // Frequency shift, then add pilots.
 } phasor_bank_algorithm_t;
 
 typedef struct {
     phase_t phase[NUM_PHASORS];
     phase_t phase_increment[NUM_PHASORS];
     accumulator_t amplitude[NUM_PHASORS];
-    iq_sample_t* lut_phasor;
+    const iq_sample_t* lut_phasor;
     phasor_bank_algorithm_t algorithm;
+
+    // Indices of the pilots which actually contribute to the output.
+    size_t num_active_pilots;
+    uint8_t active_pilot[NUM_PHASORS - 1];
+
+    // When all the pilot frequencies are rational multiples of the sample
+    // rate with a short period, one period of the sum of the pilots is
+    // precomputed. The truncation of the phase increments makes the phase
+    // accumulators drift slowly, so the cache is only valid for a given
+    // number of samples, after which it is refilled from the accumulators.
+    size_t pilot_cache_period;
+    size_t pilot_cache_index;
+    size_t pilot_cache_remaining;
+    iq_sample_t pilot_cache[PHASOR_BANK_PILOT_CACHE_SIZE];
+
+    // Settings given at init, from which the kernel is selected again on
+    // retune.
+    phasor_bank_algorithm_t requested_algorithm;
+    size_t num_phasors;
+    uint32_t enable_mask;
+    uint32_t sample_rate;
+
+    // Samples processed since the last reset.
+    uint64_t position;
+
+    // Pending retune, applied when position reaches retune_position.
+    bool retune_pending;
+    uint64_t retune_position;
+    size_t retune_ramp_size;
+    uint32_t retune_frequency[NUM_PHASORS];
+    float retune_amplitude[NUM_PHASORS];
+
+    // Amplitude ramp in progress: while ramp_remaining is not 0, the
+    // amplitudes (Q16) are ramp_amplitude, incremented at each sample by
+    // ramp_increment, instead of amplitude (the values reached at the end).
+    size_t ramp_remaining;
+    int64_t ramp_amplitude[NUM_PHASORS];
+    int64_t ramp_increment[NUM_PHASORS];
+
+#ifdef DSP_STATISTICS
+    // Output of the block, and samples whose pilot add wrapped around. Reset
+    // by dsp_phasor_bank_reset.
+    dsp_signal_statistics_t statistics;
+    uint64_t num_wrapped;
+#endif  // DSP_STATISTICS
 } phasor_bank_state_t;
 
+// lut_phasor: a table returned by dsp_phasor_bank_get_lut() or taken from the
+// registry (dsp/dsp_lut_registry.h). It is only read, and can be shared.
 void dsp_phasor_bank_init(
     phasor_bank_state_t* state,
-    iq_sample_t* lut_phasor,
+    const iq_sample_t* lut_phasor,
     phasor_bank_algorithm_t algorithm,
     uint32_t* frequency,
     float* amplitude,
     uint32_t sample_rate);
 
+// Same as above, with only the first num_phasors entries of frequency and
+// amplitude used, and the tones whose bit is cleared in enable_mask disabled.
+// A disabled or silent pilot is skipped; a disabled shift phasor leaves the
+// signal untouched.
+void dsp_phasor_bank_init_tones(
+    phasor_bank_state_t* state,
+    const iq_sample_t* lut_phasor,
+    phasor_bank_algorithm_t algorithm,
+    size_t num_phasors,
+    uint32_t enable_mask,
+    uint32_t* frequency,
+    float* amplitude,
+    uint32_t sample_rate);
+
+// Fills a table of LUT_PHASOR_SIZE phasors, which must not be in use.
 void dsp_phasor_bank_fill_lut(iq_sample_t* lut_phasor);
 
+// Returns the table precomputed at build time when available (lut_phasor is
+// then left untouched, and can be NULL), otherwise lut_phasor, filled by
+// dsp_phasor_bank_fill_lut(). A table shared by several threads must be
+// obtained once, before being shared, or taken from the registry
+// (dsp/dsp_lut_registry.h).
+const iq_sample_t* dsp_phasor_bank_get_lut(iq_sample_t* lut_phasor);
+
+// Sets the phases to 0, and cancels the pending retune and amplitude ramp.
+// The frequencies and amplitudes of the last retune are kept.
 void dsp_phasor_bank_reset(phasor_bank_state_t* state);
 
+// Changes the frequencies and amplitudes (NUM_PHASORS entries, of which the
+// first num_phasors given at init are used) at sample position (counted
+// since the last reset), or at once if it has already been reached. The
+// phases are kept. When ramp_size is not 0, the amplitudes go linearly from
+// their current values to the new ones over ramp_size samples; the
+// frequencies change at once. A retune replaces the pending one, if any.
+//
+// The cost does not depend on the LUT or the amplitudes: the kernel is
+// selected again, and the pilot cache, when used, is refilled by the next
+// call to process. Ramps are processed by a generic kernel.
+void dsp_phasor_bank_retune(
+    phasor_bank_state_t* state,
+    const uint32_t* frequency,
+    const float* amplitude,
+    uint64_t position,
+    size_t ramp_size);
+
 void dsp_phasor_bank_process(
     phasor_bank_state_t* state, iq_sample_t* in_out, size_t size);
 
+// Same as above, with the signal as separate I and Q planes.
+void dsp_phasor_bank_process_planar(
+    phasor_bank_state_t* state,
+    sample_t* in_out_i,
+    sample_t* in_out_q,
+    size_t size);
+
 #endif  // DSP_DSP_PHASOR_BANK_H_
@@ -0,0 +1,29 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Conversion between the interleaved and planar layouts.
+
+#include "dsp/dsp_planar.h"
+
+void dsp_planar_interleave(
+        const sample_t* in_i,
+        const sample_t* in_q,
+        iq_sample_t* out,
+        size_t size) {
+    for (size_t n = 0; n < size; ++n) {
+        out[n].i = in_i[n];
+        out[n].q = in_q[n];
+    }
+}
+
+void dsp_planar_deinterleave(
+        const iq_sample_t* in,
+        sample_t* out_i,
+        sample_t* out_q,
+        size_t size) {
+    for (size_t n = 0; n < size; ++n) {
+        out_i[n] = in[n].i;
+        out_q[n] = in[n].q;
+    }
+}
@@ -0,0 +1,30 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Conversion between the interleaved (iq_sample_t) and planar (separate I and
+// Q arrays) layouts of a complex signal.
+//
+// All the blocks of the chain (RNG, RRC filter, phasor bank, ZC generator)
+// accept both layouts and produce the same samples. In the planar layout, the
+// I and Q components are processed by identical loops over contiguous arrays,
+// without shuffles; the signal only needs to be interleaved once, for the DAC.
+
+#ifndef DSP_DSP_PLANAR_H_
+#define DSP_DSP_PLANAR_H_
+
+#include "dsp/dsp_types.h"
+
+void dsp_planar_interleave(
+    const sample_t* in_i,
+    const sample_t* in_q,
+    iq_sample_t* out,
+    size_t size);
+
+void dsp_planar_deinterleave(
+    const iq_sample_t* in,
+    sample_t* out_i,
+    sample_t* out_q,
+    size_t size);
+
+#endif  // DSP_DSP_PLANAR_H_
@@ -28,6 +28,7 @@ void dsp_rng_reset(
         uint32_t mask) {
     state->state = seed;
     state->mask = mask & RNG_RAND_MAX;
+    DSP_STATISTICS_ONLY(dsp_symbol_statistics_reset(&state->statistics);)
 }
 
 #define CLAMP(v, mag) v = v > (mag) ? (mag) : (v < -(mag) ? -(mag) : v);
@@ -52,11 +53,16 @@ void dsp_rng_generate_box_muller(
             float r = sqrtf(-2.0f * logf(norm) / norm) * scale;
             i = u * r;
             q = v * r;
+            DSP_STATISTICS_ONLY(s.statistics.num_rejected += !s.clamp &&
+                (abs(i) > s.max_magnitude || abs(q) > s.max_magnitude);)
         } while ((abs(i) > s.max_magnitude || abs(q) > s.max_magnitude) && !s.clamp);
         if (s.clamp) {
+            DSP_STATISTICS_ONLY(s.statistics.num_clamped +=
+                abs(i) > s.max_magnitude || abs(q) > s.max_magnitude;)
             CLAMP(i, (int32_t)(s.max_magnitude));
             CLAMP(q, (int32_t)(s.max_magnitude));
         }
+        DSP_STATISTICS_ONLY(dsp_symbol_statistics_add(&s.statistics, i, q);)
         *out++ = (iq_sample_t) { i, q };
     }
 
@@ -354,9 +360,11 @@ inline int32_t dsp_rng_uniform_to_gaussian(uint32_t u) {
     return (a + ((b - a) * fractional >> 12)) * sign;
 }
 
-void dsp_rng_generate_icdf(
+static inline void dsp_rng_generate_icdf_strided(
         rng_state_t* state,
-        iq_sample_t* out,
+        sample_t* out_i,
+        sample_t* out_q,
+        size_t stride,
         size_t size) {
     rng_state_t s = *state;
     int32_t scale = s.scale >> 4;
@@ -368,13 +376,90 @@ void dsp_rng_generate_icdf(
                 uint32_t u = dsp_rng_uniform_u32(&s);
                 sample = dsp_rng_uniform_to_gaussian(u);
                 sample = sample * scale >> 12;
+                DSP_STATISTICS_ONLY(s.statistics.num_rejected +=
+                    abs(sample) > s.max_magnitude && !s.clamp;)
             } while (abs(sample) > s.max_magnitude && !s.clamp);
             if (s.clamp) {
+                DSP_STATISTICS_ONLY(s.statistics.num_clamped +=
+                    abs(sample) > s.max_magnitude;)
                 CLAMP(sample, (int32_t)(s.max_magnitude));
             }
             samples[i] = sample;
         }
-        *out++ = (iq_sample_t) { samples[0], samples[1] };
+        DSP_STATISTICS_ONLY(
+            dsp_symbol_statistics_add(&s.statistics, samples[0], samples[1]);)
+        *out_i = samples[0];
+        *out_q = samples[1];
+        out_i += stride;
+        out_q += stride;
     }
     *state = s;
 }
+
+void dsp_rng_generate_icdf(
+        rng_state_t* state,
+        iq_sample_t* out,
+        size_t size) {
+    dsp_rng_generate_icdf_strided(
+        state, (sample_t*)out, (sample_t*)out + 1, 2, size);
+}
+
+void dsp_rng_generate_icdf_planar(
+        rng_state_t* state,
+        sample_t* out_i,
+        sample_t* out_q,
+        size_t size) {
+    dsp_rng_generate_icdf_strided(state, out_i, out_q, 1, size);
+}
+
+void dsp_rng_generate_icdf_batch(
+        rng_state_t* states,
+        size_t num_channels,
+        iq_sample_t* out,
+        size_t size) {
+    rng_state_t s[DSP_BATCH_MAX_CHANNELS];
+    int32_t scale[DSP_BATCH_MAX_CHANNELS];
+    for (size_t c = 0; c < num_channels; ++c) {
+        s[c] = states[c];
+        scale[c] = s[c].scale >> 4;
+    }
+    while (size--) {
+        for (int32_t i = 0; i < 2; ++i) {
+            // The LCGs of the channels are independent: one step of each.
+            uint32_t u[DSP_BATCH_MAX_CHANNELS];
+            for (size_t c = 0; c < num_channels; ++c) {
+                u[c] = dsp_rng_uniform_u32(&s[c]);
+            }
+            for (size_t c = 0; c < num_channels; ++c) {
+                int32_t sample = dsp_rng_uniform_to_gaussian(u[c]);
+                sample = sample * scale[c] >> 12;
+                // Rejections are rare, and only delay the channel concerned.
+                while (abs(sample) > s[c].max_magnitude && !s[c].clamp) {
+                    DSP_STATISTICS_ONLY(++s[c].statistics.num_rejected;)
+                    sample = dsp_rng_uniform_to_gaussian(
+                        dsp_rng_uniform_u32(&s[c]));
+                    sample = sample * scale[c] >> 12;
+                }
+                if (s[c].clamp) {
+                    DSP_STATISTICS_ONLY(s[c].statistics.num_clamped +=
+                        abs(sample) > s[c].max_magnitude;)
+                    CLAMP(sample, (int32_t)(s[c].max_magnitude));
+                }
+                if (i == 0) {
+                    out[c].i = sample;
+                } else {
+                    out[c].q = sample;
+                }
+            }
+        }
+        DSP_STATISTICS_ONLY(
+            for (size_t c = 0; c < num_channels; ++c) {
+                dsp_symbol_statistics_add(
+                    &s[c].statistics, out[c].i, out[c].q);
+            })
+        out += num_channels;
+    }
+    for (size_t c = 0; c < num_channels; ++c) {
+        states[c] = s[c];
+    }
+}
@@ -7,6 +7,7 @@
 #ifndef DSP_DSP_RNG_H_
 #define DSP_DSP_RNG_H_
 
+#include "dsp/dsp_statistics.h"
 #include "dsp/dsp_types.h"
 
 // The RNG in the early prototype is a little strange since the
@@ -22,6 +23,9 @@ typedef struct {
     uint32_t scale;
     uint32_t max_magnitude;
     bool clamp;
+#ifdef DSP_STATISTICS
+    dsp_symbol_statistics_t statistics;  // Reset by dsp_rng_reset.
+#endif  // DSP_STATISTICS
 } rng_state_t;
 
 void dsp_rng_init(
@@ -56,9 +60,12 @@ inline float dsp_rng_uniform_float(rng_state_t* state) {
 
 #define RNG_RAND_MAX 0x7fffffff
 #define RNG_SHIFT_LEFT 1
+#define RNG_MULTIPLIER 1103515245
+#define RNG_INCREMENT 12345
 
 inline uint32_t dsp_rng_rand(rng_state_t* state) {
-    state->state = (state->state * 1103515245 + 12345) & RNG_RAND_MAX;
+    state->state = (state->state * RNG_MULTIPLIER + RNG_INCREMENT) &
+        RNG_RAND_MAX;
     return state->state ^ state->mask;
 }
 
@@ -85,4 +92,15 @@ void dsp_rng_generate_box_muller(
 void dsp_rng_generate_icdf(
     rng_state_t* state, iq_sample_t* out, size_t size);
 
+// Same as above, with the I and Q components written to separate planes.
+void dsp_rng_generate_icdf_planar(
+    rng_state_t* state, sample_t* out_i, sample_t* out_q, size_t size);
+
+// Same as above, for num_channels (at most DSP_BATCH_MAX_CHANNELS)
+// independent generators, with channel-interleaved outputs: symbol n of
+// channel c is written to out[n * num_channels + c]. Each channel gets the
+// same symbols as with dsp_rng_generate_icdf.
+void dsp_rng_generate_icdf_batch(
+    rng_state_t* states, size_t num_channels, iq_sample_t* out, size_t size);
+
 #endif  // DSP_DSP_RNG_H_
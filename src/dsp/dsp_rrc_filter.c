@@ -8,6 +8,9 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
+
+#include "dsp/dsp_luts.h"
 
 #ifndef M_PI
     #define M_PI 3.14159265358979323846
@@ -19,13 +22,39 @@ void dsp_rrc_filter_init(
         float roll_off,
         uint32_t symbol_rate,
         uint32_t sample_rate) {
+    dsp_rrc_filter_init_with_lut(
+        state,
+        dsp_rrc_filter_get_lut(lut_rrc, roll_off),
+        symbol_rate,
+        sample_rate);
+}
+
+void dsp_rrc_filter_init_with_lut(
+        rrc_filter_state_t* state,
+        const sample_t* lut_rrc,
+        uint32_t symbol_rate,
+        uint32_t sample_rate) {
     state->phase_increment = dsp_phase_increment(symbol_rate, sample_rate);
+    state->lut_rrc = lut_rrc;
+    dsp_rrc_filter_reset(state);
+}
 
+const sample_t* dsp_rrc_filter_get_lut(sample_t* lut_rrc, float roll_off) {
+#ifdef DSP_PRECOMPUTED_LUTS
+    int index = dsp_luts_find_rrc(roll_off);
+    if (index >= 0) {
+        return lut_rrc_precomputed[index];
+    }
+#endif  // DSP_PRECOMPUTED_LUTS
+    dsp_rrc_filter_fill_lut(lut_rrc, roll_off);
+    return lut_rrc;
+}
+
+void dsp_rrc_filter_fill_lut(sample_t* lut_rrc, float roll_off) {
     // Compute impulse response
     float scale = SAMPLE_MAX / (1.0f + roll_off * (4.0f / M_PI - 1.0f));
     int32_t mid_point = LUT_RRC_SIZE / 2;
 
-    state->lut_rrc = lut_rrc;
     for (int32_t i = 0; i < LUT_RRC_SIZE; i++) {
         size_t symbol = i / LUT_RRC_POINTS_PER_SYMBOL;
         size_t phase = i % LUT_RRC_POINTS_PER_SYMBOL;
@@ -46,21 +75,29 @@ void dsp_rrc_filter_init(
                 (M_PI * t * (1.0f - denum_scale * denum_scale)) * scale;
         }
     }
-
-    dsp_rrc_filter_reset(state);
 }
 
 void dsp_rrc_filter_reset(rrc_filter_state_t* state) {
     state->phase = 0;
-    for (size_t i = 0; i < LUT_RRC_NUM_SYMBOLS; ++i) {
-        state->past_symbols[i] = (iq_sample_t) { .i = 0, .q = 0 };
-    }
+    memset(state->past_i, 0, sizeof(state->past_i));
+    memset(state->past_q, 0, sizeof(state->past_q));
 }
 
-size_t dsp_rrc_filter_process(
+void dsp_rrc_filter_set_symbol_rate(
+        rrc_filter_state_t* state, uint32_t symbol_rate, uint32_t sample_rate) {
+    state->phase_increment = dsp_phase_increment(symbol_rate, sample_rate);
+}
+
+// Kernel shared by both layouts: sample n of a buffer is at index n * stride
+// of its I and Q pointers.
+static inline size_t dsp_rrc_filter_process_strided(
         rrc_filter_state_t* state,
-        iq_sample_t* in,
-        iq_sample_t* out,
+        const sample_t* in_i,
+        const sample_t* in_q,
+        size_t in_stride,
+        sample_t* out_i,
+        sample_t* out_q,
+        size_t out_stride,
         size_t size) {
     rrc_filter_state_t s = *state;
 
@@ -69,17 +106,20 @@ size_t dsp_rrc_filter_process(
 
     while (size--) {
         //sample_t* coeff = s.lut_rrc + (s.phase >> 24) * LUT_RRC_NUM_SYMBOLS;
-        sample_t* coeff = s.lut_rrc + (s.phase >> 24) * LUT_RRC_PHASE_FACTOR;
+        const sample_t* coeff = s.lut_rrc +
+            (s.phase >> 24) * LUT_RRC_PHASE_FACTOR;
 
         accumulator_t acc_i = 0;
         accumulator_t acc_q = 0;
         for (size_t k = 0; k < LUT_RRC_NUM_SYMBOLS; ++k) {
-            iq_sample_t symbol = s.past_symbols[k];
-            acc_i += ((accumulator_t)*coeff * (accumulator_t)symbol.i);
-            acc_q += ((accumulator_t)*coeff * (accumulator_t)symbol.q);
+            acc_i += ((accumulator_t)*coeff * (accumulator_t)s.past_i[k]);
+            acc_q += ((accumulator_t)*coeff * (accumulator_t)s.past_q[k]);
             coeff += LUT_RRC_SYMBOL_FACTOR;
         }
-        *out++ = (iq_sample_t) { .i = acc_i SCALE, .q = acc_q SCALE };
+        *out_i = acc_i SCALE;
+        *out_q = acc_q SCALE;
+        out_i += out_stride;
+        out_q += out_stride;
 
         // Advance the symbol clock.
         phase_t previous_phase = s.phase;
@@ -88,9 +128,104 @@ size_t dsp_rrc_filter_process(
         // Phase wrap: it's time to push a new symbol.
         if (s.phase < previous_phase) {
             for (size_t k = LUT_RRC_NUM_SYMBOLS - 1; k >= 1; --k) {
-                s.past_symbols[k] = s.past_symbols[k - 1];
+                s.past_i[k] = s.past_i[k - 1];
+                s.past_q[k] = s.past_q[k - 1];
+            }
+            s.past_i[0] = *in_i;
+            s.past_q[0] = *in_q;
+            in_i += in_stride;
+            in_q += in_stride;
+            consumed++;
+        }
+    }
+
+    *state = s;
+
+    return consumed;
+}
+
+size_t dsp_rrc_filter_process(
+        rrc_filter_state_t* state,
+        iq_sample_t* in,
+        iq_sample_t* out,
+        size_t size) {
+    return dsp_rrc_filter_process_strided(
+        state, (const sample_t*)in, (const sample_t*)in + 1, 2,
+        (sample_t*)out, (sample_t*)out + 1, 2, size);
+}
+
+size_t dsp_rrc_filter_process_planar(
+        rrc_filter_state_t* state,
+        const sample_t* in_i,
+        const sample_t* in_q,
+        sample_t* out_i,
+        sample_t* out_q,
+        size_t size) {
+    return dsp_rrc_filter_process_strided(
+        state, in_i, in_q, 1, out_i, out_q, 1, size);
+}
+
+void dsp_rrc_filter_batch_init(
+        rrc_filter_batch_state_t* state,
+        const sample_t* lut_rrc,
+        size_t num_channels,
+        uint32_t symbol_rate,
+        uint32_t sample_rate) {
+    state->phase_increment = dsp_phase_increment(symbol_rate, sample_rate);
+    state->num_channels = num_channels;
+    state->lut_rrc = lut_rrc;
+    dsp_rrc_filter_batch_reset(state);
+}
+
+void dsp_rrc_filter_batch_reset(rrc_filter_batch_state_t* state) {
+    state->phase = 0;
+    memset(state->past_symbols, 0, sizeof(state->past_symbols));
+}
+
+size_t dsp_rrc_filter_batch_process(
+        rrc_filter_batch_state_t* state,
+        const iq_sample_t* in,
+        iq_sample_t* out,
+        size_t size) {
+    rrc_filter_batch_state_t s = *state;
+    const size_t num_channels = s.num_channels;
+
+    size_t consumed = 0;
+
+    while (size--) {
+        const sample_t* coeff = s.lut_rrc +
+            (s.phase >> 24) * LUT_RRC_PHASE_FACTOR;
+
+        // All the lanes are computed, the unused ones hold zeros: the loops
+        // have a constant number of iterations.
+        accumulator_t acc[2 * DSP_BATCH_MAX_CHANNELS] = { 0 };
+        for (size_t k = 0; k < LUT_RRC_NUM_SYMBOLS; ++k) {
+            sample_t c = *coeff;
+            // Not unrolled, so that it is vectorized along the lanes.
+            #pragma GCC unroll 1
+            for (size_t l = 0; l < 2 * DSP_BATCH_MAX_CHANNELS; ++l) {
+                acc[l] += (accumulator_t)c *
+                    (accumulator_t)s.past_symbols[k][l];
+            }
+            coeff += LUT_RRC_SYMBOL_FACTOR;
+        }
+        for (size_t l = 0; l < num_channels; ++l) {
+            *out++ = (iq_sample_t) {
+                .i = acc[l] SCALE,
+                .q = acc[DSP_BATCH_MAX_CHANNELS + l] SCALE };
+        }
+
+        phase_t previous_phase = s.phase;
+        s.phase += s.phase_increment;
+
+        if (s.phase < previous_phase) {
+            memmove(s.past_symbols[1], s.past_symbols[0],
+                    sizeof(s.past_symbols) - sizeof(s.past_symbols[0]));
+            for (size_t l = 0; l < num_channels; ++l) {
+                s.past_symbols[0][l] = in[l].i;
+                s.past_symbols[0][DSP_BATCH_MAX_CHANNELS + l] = in[l].q;
             }
-            s.past_symbols[0] = *in++;
+            in += num_channels;
             consumed++;
         }
     }
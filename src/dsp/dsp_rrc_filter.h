@@ -25,11 +25,28 @@ typedef struct {
     phase_t phase;
     phase_t phase_increment;
 
-    iq_sample_t past_symbols[LUT_RRC_NUM_SYMBOLS];
+    // I and Q planes of the delay line.
+    sample_t past_i[LUT_RRC_NUM_SYMBOLS];
+    sample_t past_q[LUT_RRC_NUM_SYMBOLS];
 
-    sample_t* lut_rrc;
+    const sample_t* lut_rrc;
 }  rrc_filter_state_t;
 
+// Batched filter: num_channels signals filtered at once, sharing the symbol
+// clock and the LUT. Samples and symbols are channel-interleaved (sample n of
+// channel c at index n * num_channels + c), and the delay line holds one lane
+// per channel, so that each coefficient is loaded once for all the channels.
+typedef struct {
+    phase_t phase;
+    phase_t phase_increment;
+    size_t num_channels;
+
+    // I components of the channels, then Q components.
+    sample_t past_symbols[LUT_RRC_NUM_SYMBOLS][2 * DSP_BATCH_MAX_CHANNELS];
+
+    const sample_t* lut_rrc;
+} rrc_filter_batch_state_t;
+
 void dsp_rrc_filter_init(
     rrc_filter_state_t* state,
     sample_t* lut_rrc,
@@ -37,12 +54,59 @@ void dsp_rrc_filter_init(
     uint32_t symbol_rate,
     uint32_t sample_rate);
 
+// Same as above, with a LUT already filled by dsp_rrc_filter_get_lut. The LUT
+// is not modified, and can be shared by several filters.
+void dsp_rrc_filter_init_with_lut(
+    rrc_filter_state_t* state,
+    const sample_t* lut_rrc,
+    uint32_t symbol_rate,
+    uint32_t sample_rate);
+
+// Computes the impulse response for the given roll-off factor.
+void dsp_rrc_filter_fill_lut(sample_t* lut_rrc, float roll_off);
+
+// Returns the table precomputed at build time for this roll-off factor when
+// available (lut_rrc is then left untouched), otherwise lut_rrc, filled by
+// dsp_rrc_filter_fill_lut().
+const sample_t* dsp_rrc_filter_get_lut(sample_t* lut_rrc, float roll_off);
+
 void dsp_rrc_filter_reset(rrc_filter_state_t* state);
 
+// Changes the symbol rate, from the next sample on. The delay line and the
+// position in the current symbol are kept.
+void dsp_rrc_filter_set_symbol_rate(
+    rrc_filter_state_t* state, uint32_t symbol_rate, uint32_t sample_rate);
+
 size_t dsp_rrc_filter_process(
     rrc_filter_state_t* state,
     iq_sample_t* in,
     iq_sample_t* out,
     size_t size);
 
+// Same as above, with the symbols and samples as separate I and Q planes.
+size_t dsp_rrc_filter_process_planar(
+    rrc_filter_state_t* state,
+    const sample_t* in_i,
+    const sample_t* in_q,
+    sample_t* out_i,
+    sample_t* out_q,
+    size_t size);
+
+void dsp_rrc_filter_batch_init(
+    rrc_filter_batch_state_t* state,
+    const sample_t* lut_rrc,
+    size_t num_channels,
+    uint32_t symbol_rate,
+    uint32_t sample_rate);
+
+void dsp_rrc_filter_batch_reset(rrc_filter_batch_state_t* state);
+
+// Produces size samples of each channel. Returns the number of symbols
+// consumed from each channel.
+size_t dsp_rrc_filter_batch_process(
+    rrc_filter_batch_state_t* state,
+    const iq_sample_t* in,
+    iq_sample_t* out,
+    size_t size);
+
 #endif  // DSP_DSP_RRC_FILTER_H_
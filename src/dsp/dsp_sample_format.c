@@ -0,0 +1,214 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Conversion of the samples to the formats of their consumers.
+
+#include "dsp/dsp_sample_format.h"
+
+#include <string.h>
+
+// Samples quantized at once before being packed. Even, so that the chunks
+// of PACKED14 end on a byte boundary.
+#define SAMPLE_FORMAT_CHUNK_SIZE 256
+
+static int32_t dsp_sample_format_bits(dsp_sample_format_t format) {
+    switch (format) {
+        case DSP_SAMPLE_FORMAT_PACKED14:
+            return 14;
+        case DSP_SAMPLE_FORMAT_PACKED12:
+            return 12;
+        default:
+            return 16;
+    }
+}
+
+void dsp_sample_format_init(
+        sample_format_state_t* state,
+        dsp_sample_format_t format,
+        float scale,
+        int32_t saturation) {
+    if (!(scale > 0.0f)) {
+        scale = 0.0f;
+    } else if (scale > SAMPLE_FORMAT_MAX_SCALE) {
+        scale = SAMPLE_FORMAT_MAX_SCALE;
+    }
+    if (saturation < 0) {
+        saturation = 0;
+    }
+
+    state->format = format;
+
+    // |x * gain| stays below 2^31.
+    int32_t gain = (int32_t)(scale * (float)(1 << SAMPLE_FORMAT_GAIN_SHIFT) +
+        0.5f);
+    state->gain = gain > 65535 ? 65535 : gain;
+
+    int32_t bits = dsp_sample_format_bits(format);
+    state->shift = SAMPLE_FORMAT_GAIN_SHIFT + 16 - bits;
+    state->round = 1 << (state->shift - 1);
+
+    int32_t limit = saturation >> (16 - bits);
+    int32_t max = (1 << (bits - 1)) - 1;
+    state->high = limit < max ? limit : max;
+    state->low = -limit > -max - 1 ? -limit : -max - 1;
+
+    state->float_gain = scale / 32768.0f;
+}
+
+size_t dsp_sample_format_size(dsp_sample_format_t format, size_t size) {
+    switch (format) {
+        case DSP_SAMPLE_FORMAT_PACKED14:
+            return (size * 28 + 7) / 8;
+        case DSP_SAMPLE_FORMAT_PACKED12:
+            return size * 3;
+        case DSP_SAMPLE_FORMAT_CF32:
+            return size * 2 * sizeof(float);
+        default:
+            return size * 2 * sizeof(int16_t);
+    }
+}
+
+// Over the size components (not samples) of in.
+static void dsp_sample_format_quantize(
+        const sample_format_state_t* state,
+        const sample_t* in,
+        int16_t* out,
+        size_t size) {
+    const int32_t gain = state->gain;
+    const int32_t round = state->round;
+    const int32_t shift = state->shift;
+    const int32_t low = state->low;
+    const int32_t high = state->high;
+    for (size_t n = 0; n < size; ++n) {
+        int32_t y = (in[n] * gain + round) >> shift;
+        y = y < low ? low : y;
+        y = y > high ? high : y;
+        out[n] = (int16_t)y;
+    }
+}
+
+static void dsp_sample_format_pack14(
+        const int16_t* in,
+        uint8_t* out,
+        size_t size) {
+    const uint64_t mask = 0x3fff;
+    for (; size >= 2; size -= 2) {
+        uint64_t word = ((uint64_t)in[0] & mask) |
+            ((uint64_t)in[1] & mask) << 14 |
+            ((uint64_t)in[2] & mask) << 28 |
+            ((uint64_t)in[3] & mask) << 42;
+        for (size_t i = 0; i < 7; ++i) {
+            out[i] = (uint8_t)(word >> (8 * i));
+        }
+        in += 4;
+        out += 7;
+    }
+    if (size) {
+        uint32_t word = ((uint32_t)in[0] & mask) |
+            ((uint32_t)in[1] & mask) << 14;
+        for (size_t i = 0; i < 4; ++i) {
+            out[i] = (uint8_t)(word >> (8 * i));
+        }
+    }
+}
+
+static void dsp_sample_format_pack12(
+        const int16_t* in,
+        uint8_t* out,
+        size_t size) {
+    const uint32_t mask = 0xfff;
+    while (size--) {
+        uint32_t word = ((uint32_t)in[0] & mask) |
+            ((uint32_t)in[1] & mask) << 12;
+        out[0] = (uint8_t)word;
+        out[1] = (uint8_t)(word >> 8);
+        out[2] = (uint8_t)(word >> 16);
+        in += 2;
+        out += 3;
+    }
+}
+
+// Rounds to the nearest half, ties to even. The values out of the range of
+// half-precision floats become infinite (there are no NaNs here). Without
+// branches, so that the loops calling it are vectorized.
+static inline uint16_t dsp_sample_format_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    bits &= 0x7fffffff;
+
+    // Normal numbers: rebias the exponent, and round the mantissa.
+    uint32_t normal = (bits + ((uint32_t)(15 - 127) << 23) + 0xfff +
+        ((bits >> 13) & 1)) >> 13;
+
+    // Subnormal numbers: adding 0.5 aligns the mantissa, and the FPU rounds
+    // it.
+    float magnitude;
+    memcpy(&magnitude, &bits, sizeof(magnitude));
+    magnitude += 0.5f;
+    uint32_t subnormal;
+    memcpy(&subnormal, &magnitude, sizeof(subnormal));
+    subnormal -= (uint32_t)126 << 23;
+
+    uint32_t is_subnormal = -(uint32_t)(bits < ((uint32_t)113 << 23));
+    uint32_t is_infinite = -(uint32_t)(bits >= ((uint32_t)143 << 23));
+    uint32_t half = (subnormal & is_subnormal) | (normal & ~is_subnormal);
+    half = (0x7c00 & is_infinite) | (half & ~is_infinite);
+    return (uint16_t)(sign | half);
+}
+
+void dsp_sample_format_process(
+        const sample_format_state_t* state,
+        const iq_sample_t* in,
+        void* out,
+        size_t size) {
+    const sample_t* x = (const sample_t*)in;
+    const float gain = state->float_gain;
+
+    switch (state->format) {
+        case DSP_SAMPLE_FORMAT_PACKED14:
+        case DSP_SAMPLE_FORMAT_PACKED12:
+            {
+                uint8_t* bytes = (uint8_t*)out;
+                int16_t buffer[2 * SAMPLE_FORMAT_CHUNK_SIZE];
+                while (size) {
+                    size_t n = size < SAMPLE_FORMAT_CHUNK_SIZE
+                        ? size
+                        : SAMPLE_FORMAT_CHUNK_SIZE;
+                    dsp_sample_format_quantize(state, x, buffer, 2 * n);
+                    if (state->format == DSP_SAMPLE_FORMAT_PACKED14) {
+                        dsp_sample_format_pack14(buffer, bytes, n);
+                    } else {
+                        dsp_sample_format_pack12(buffer, bytes, n);
+                    }
+                    x += 2 * n;
+                    bytes += dsp_sample_format_size(state->format, n);
+                    size -= n;
+                }
+            }
+            break;
+
+        case DSP_SAMPLE_FORMAT_CF32:
+            {
+                float* y = (float*)out;
+                for (size_t n = 0; n < 2 * size; ++n) {
+                    y[n] = (float)x[n] * gain;
+                }
+            }
+            break;
+
+        case DSP_SAMPLE_FORMAT_CF16:
+            {
+                uint16_t* y = (uint16_t*)out;
+                for (size_t n = 0; n < 2 * size; ++n) {
+                    y[n] = dsp_sample_format_half((float)x[n] * gain);
+                }
+            }
+            break;
+
+        default:
+            dsp_sample_format_quantize(state, x, (int16_t*)out, 2 * size);
+            break;
+    }
+}
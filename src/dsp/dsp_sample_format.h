@@ -0,0 +1,78 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Conversion of the samples to the formats of their consumers:
+// - INT16: interleaved int16, as produced by the chain.
+// - PACKED14, PACKED12: two's complement samples of the DAC resolution,
+//   packed without padding, I before Q, as a little-endian bit stream (2
+//   samples in 7 bytes, or 1 sample in 3 bytes). A trailing odd sample of
+//   PACKED14 takes 4 bytes.
+// - CF32: complex float32, 1.0 being the full scale.
+// - CF16: complex IEEE 754 half-precision floats, 1.0 being the full scale.
+//
+// The samples are multiplied by a gain (Q12, up to 16) before conversion.
+// The integer formats round them to their resolution, then saturate them at
+// a configurable magnitude (in int16 units) and at the limits of the format.
+// With the default settings (gain 1, saturation 32768), INT16 is a copy.
+//
+// The samples are converted by chunks: a vectorizable quantization loop over
+// the components writes a small buffer, which is then packed, so that the
+// conversion runs in a single pass over the data.
+
+#ifndef DSP_DSP_SAMPLE_FORMAT_H_
+#define DSP_DSP_SAMPLE_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/dsp_types.h"
+
+#define SAMPLE_FORMAT_GAIN_SHIFT 12
+#define SAMPLE_FORMAT_MAX_SCALE 16.0f
+#define SAMPLE_FORMAT_NO_SATURATION 32768
+
+typedef enum {
+    DSP_SAMPLE_FORMAT_INT16,
+    DSP_SAMPLE_FORMAT_PACKED14,
+    DSP_SAMPLE_FORMAT_PACKED12,
+    DSP_SAMPLE_FORMAT_CF32,
+    DSP_SAMPLE_FORMAT_CF16,
+    DSP_NUM_SAMPLE_FORMATS
+} dsp_sample_format_t;
+
+typedef struct {
+    dsp_sample_format_t format;
+
+    // Integer formats: y = clamp((x * gain + round) >> shift, low, high).
+    int32_t gain;
+    int32_t round;
+    int32_t shift;
+    int32_t low;
+    int32_t high;
+
+    // Float formats: y = x * float_gain.
+    float float_gain;
+} sample_format_state_t;
+
+// scale is clipped to [0, SAMPLE_FORMAT_MAX_SCALE]. saturation is the
+// maximum magnitude of the integer formats, in int16 units.
+void dsp_sample_format_init(
+    sample_format_state_t* state,
+    dsp_sample_format_t format,
+    float scale,
+    int32_t saturation);
+
+// Number of bytes taken by size samples.
+size_t dsp_sample_format_size(dsp_sample_format_t format, size_t size);
+
+// Writes dsp_sample_format_size(format, size) bytes to out. To convert a
+// signal by blocks in PACKED14, all blocks but the last must have an even
+// size.
+void dsp_sample_format_process(
+    const sample_format_state_t* state,
+    const iq_sample_t* in,
+    void* out,
+    size_t size);
+
+#endif  // DSP_DSP_SAMPLE_FORMAT_H_
@@ -0,0 +1,105 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Signal-quality statistics.
+
+#include "dsp/dsp_statistics.h"
+
+#include <math.h>
+#include <string.h>
+
+static inline void dsp_signal_statistics_add_block(
+        dsp_signal_statistics_t* statistics,
+        const sample_t* i,
+        const sample_t* q,
+        size_t stride,
+        size_t size) {
+    uint64_t energy = 0;
+    uint32_t peak = statistics->peak;
+    for (size_t n = 0; n < size; ++n) {
+        int32_t x_i = i[n * stride];
+        int32_t x_q = q[n * stride];
+        uint32_t e = (uint32_t)(x_i * x_i) + (uint32_t)(x_q * x_q);
+        energy += e;
+        peak = e > peak ? e : peak;
+    }
+    statistics->num_samples += size;
+    statistics->energy += energy;
+    statistics->peak = peak;
+}
+
+void dsp_signal_statistics_add_strided(
+        dsp_signal_statistics_t* statistics,
+        const sample_t* i,
+        const sample_t* q,
+        size_t stride,
+        size_t size) {
+    // The interleaved and planar layouts get their own loops, with a constant
+    // stride.
+    if (stride == 2) {
+        dsp_signal_statistics_add_block(statistics, i, q, 2, size);
+    } else if (stride == 1) {
+        dsp_signal_statistics_add_block(statistics, i, q, 1, size);
+    } else {
+        dsp_signal_statistics_add_block(statistics, i, q, stride, size);
+    }
+}
+
+void dsp_signal_statistics_reset(dsp_signal_statistics_t* statistics) {
+    memset(statistics, 0, sizeof(*statistics));
+}
+
+void dsp_symbol_statistics_reset(dsp_symbol_statistics_t* statistics) {
+    memset(statistics, 0, sizeof(*statistics));
+}
+
+void dsp_frame_statistics_reset(dsp_frame_statistics_t* statistics) {
+    memset(statistics, 0, sizeof(*statistics));
+}
+
+void dsp_signal_statistics_merge(
+        dsp_signal_statistics_t* destination,
+        const dsp_signal_statistics_t* source) {
+    destination->num_samples += source->num_samples;
+    destination->energy += source->energy;
+    if (source->peak > destination->peak) {
+        destination->peak = source->peak;
+    }
+}
+
+void dsp_symbol_statistics_merge(
+        dsp_symbol_statistics_t* destination,
+        const dsp_symbol_statistics_t* source) {
+    destination->num_symbols += source->num_symbols;
+    for (int i = 0; i < 2; ++i) {
+        destination->sum[i] += source->sum[i];
+        destination->sum_squares[i] += source->sum_squares[i];
+    }
+    destination->num_rejected += source->num_rejected;
+    destination->num_clamped += source->num_clamped;
+}
+
+double dsp_signal_statistics_mean_power(
+        const dsp_signal_statistics_t* statistics) {
+    if (!statistics->num_samples) {
+        return 0.0;
+    }
+    return (double)statistics->energy / (double)statistics->num_samples /
+        ((double)SAMPLE_MAX * (double)SAMPLE_MAX);
+}
+
+double dsp_signal_statistics_peak_magnitude(
+        const dsp_signal_statistics_t* statistics) {
+    return sqrt((double)statistics->peak) / (double)SAMPLE_MAX;
+}
+
+double dsp_symbol_statistics_variance(
+        const dsp_symbol_statistics_t* statistics, int component) {
+    if (!statistics->num_symbols) {
+        return 0.0;
+    }
+    double n = (double)statistics->num_symbols;
+    double mean = (double)statistics->sum[component] / n;
+    return (double)statistics->sum_squares[component] / n - mean * mean;
+}
@@ -0,0 +1,109 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Signal-quality statistics, accumulated by the blocks while they process:
+// - the RNG counts the symbols it draws, their sums and sums of squares (for
+//   the variance), and the draws above max_magnitude which were rejected or
+//   clamped;
+// - the phasor bank and ZC generator measure the energy and peak magnitude
+//   of their output, and the phasor bank counts the samples whose int16
+//   pilot add wrapped around.
+//
+// This is a compile-time option (DSP_STATISTICS, set by the CMake option of
+// the same name): without it, the counters are absent from the states of the
+// blocks, and the kernels are unchanged.
+
+#ifndef DSP_DSP_STATISTICS_H_
+#define DSP_DSP_STATISTICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/dsp_types.h"
+
+#ifdef DSP_STATISTICS
+    #define DSP_STATISTICS_ONLY(...) __VA_ARGS__
+#else
+    #define DSP_STATISTICS_ONLY(...)
+#endif  // DSP_STATISTICS
+
+typedef struct {
+    uint64_t num_samples;
+    uint64_t energy;  // Sum of i^2 + q^2.
+    uint32_t peak;    // Maximum of i^2 + q^2.
+} dsp_signal_statistics_t;
+
+typedef struct {
+    uint64_t num_symbols;
+    int64_t sum[2];  // I, Q.
+    uint64_t sum_squares[2];
+
+    // Draws above max_magnitude, drawn again or clamped.
+    uint64_t num_rejected;
+    uint64_t num_clamped;
+} dsp_symbol_statistics_t;
+
+typedef enum {
+    DSP_FRAME_REGION_ZC,
+    DSP_FRAME_REGION_QD,
+    DSP_FRAME_REGION_TAIL,
+    DSP_FRAME_NUM_REGIONS
+} dsp_frame_region_t;
+
+typedef struct {
+    dsp_symbol_statistics_t symbols;
+    dsp_signal_statistics_t region[DSP_FRAME_NUM_REGIONS];
+    uint64_t num_wrapped;  // Samples whose pilot add wrapped around.
+} dsp_frame_statistics_t;
+
+static inline void dsp_signal_statistics_add(
+        dsp_signal_statistics_t* statistics, int32_t i, int32_t q) {
+    uint32_t energy = (uint32_t)(i * i) + (uint32_t)(q * q);
+    ++statistics->num_samples;
+    statistics->energy += energy;
+    if (energy > statistics->peak) {
+        statistics->peak = energy;
+    }
+}
+
+static inline void dsp_symbol_statistics_add(
+        dsp_symbol_statistics_t* statistics, int32_t i, int32_t q) {
+    ++statistics->num_symbols;
+    statistics->sum[0] += i;
+    statistics->sum[1] += q;
+    statistics->sum_squares[0] += (uint32_t)(i * i);
+    statistics->sum_squares[1] += (uint32_t)(q * q);
+}
+
+// Adds size samples, sample n being at index n * stride of i and q.
+void dsp_signal_statistics_add_strided(
+    dsp_signal_statistics_t* statistics,
+    const sample_t* i,
+    const sample_t* q,
+    size_t stride,
+    size_t size);
+
+void dsp_signal_statistics_reset(dsp_signal_statistics_t* statistics);
+void dsp_symbol_statistics_reset(dsp_symbol_statistics_t* statistics);
+void dsp_frame_statistics_reset(dsp_frame_statistics_t* statistics);
+
+// Adds the counters of source to destination.
+void dsp_signal_statistics_merge(
+    dsp_signal_statistics_t* destination,
+    const dsp_signal_statistics_t* source);
+void dsp_symbol_statistics_merge(
+    dsp_symbol_statistics_t* destination,
+    const dsp_symbol_statistics_t* source);
+
+// Mean power and peak magnitude, relative to full scale (SAMPLE_MAX).
+double dsp_signal_statistics_mean_power(
+    const dsp_signal_statistics_t* statistics);
+double dsp_signal_statistics_peak_magnitude(
+    const dsp_signal_statistics_t* statistics);
+
+// Variance of the I (component 0) or Q (component 1) part of the symbols.
+double dsp_symbol_statistics_variance(
+    const dsp_symbol_statistics_t* statistics, int component);
+
+#endif  // DSP_DSP_STATISTICS_H_
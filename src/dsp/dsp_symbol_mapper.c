@@ -0,0 +1,258 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Symbol mapper.
+
+#include "dsp/dsp_symbol_mapper.h"
+
+#include <math.h>
+#include <string.h>
+
+// Symbols drawn at once.
+#define SYMBOL_MAPPER_CHUNK_SIZE 256
+
+// Accepts any fraction: the draws have at least one trailing zero bit.
+#define SYMBOL_MAPPER_ALWAYS 0xffffffff
+
+static bool dsp_symbol_mapper_points(
+        dsp_modulation_t modulation,
+        size_t order,
+        double* x,
+        double* y) {
+    if (modulation == DSP_MODULATION_PSK) {
+        if (order < 2 || order > SYMBOL_MAPPER_MAX_POINTS) {
+            return false;
+        }
+        for (size_t m = 0; m < order; ++m) {
+            double angle = M_PI * (double)(2 * m + 1) / (double)order;
+            x[m] = cos(angle);
+            y[m] = sin(angle);
+        }
+        return true;
+    } else if (modulation == DSP_MODULATION_QAM) {
+        size_t side = 2;
+        while (side * side < order) {
+            side *= 2;
+        }
+        if (side * side != order || order > SYMBOL_MAPPER_MAX_POINTS) {
+            return false;
+        }
+        for (size_t m = 0; m < order; ++m) {
+            x[m] = (double)(2 * (m % side)) - (double)(side - 1);
+            y[m] = (double)(2 * (m / side)) - (double)(side - 1);
+        }
+        return true;
+    }
+    return false;
+}
+
+// Walker's alias method, as arranged by Vose.
+static void dsp_symbol_mapper_build_alias_table(symbol_mapper_t* mapper) {
+    uint32_t bits = 1;
+    while (((size_t)1 << bits) < mapper->num_points) {
+        ++bits;
+    }
+    const size_t size = (size_t)1 << bits;
+    mapper->table_bits = bits;
+
+    double q[SYMBOL_MAPPER_MAX_POINTS];
+    size_t small[SYMBOL_MAPPER_MAX_POINTS];
+    size_t large[SYMBOL_MAPPER_MAX_POINTS];
+    size_t num_small = 0;
+    size_t num_large = 0;
+    for (size_t j = 0; j < size; ++j) {
+        q[j] = j < mapper->num_points
+            ? (double)mapper->probability[j] * (double)size
+            : 0.0;
+        if (q[j] < 1.0) {
+            small[num_small++] = j;
+        } else {
+            large[num_large++] = j;
+        }
+    }
+    while (num_small && num_large) {
+        size_t s = small[--num_small];
+        size_t l = large[num_large - 1];
+        mapper->threshold[s] = (uint32_t)(q[s] * 4294967296.0);
+        mapper->alias[s] = (uint32_t)l;
+        q[l] -= 1.0 - q[s];
+        if (q[l] < 1.0) {
+            --num_large;
+            small[num_small++] = l;
+        }
+    }
+    // The rest have a probability of 1, up to rounding errors.
+    while (num_large) {
+        size_t l = large[--num_large];
+        mapper->threshold[l] = SYMBOL_MAPPER_ALWAYS;
+        mapper->alias[l] = (uint32_t)l;
+    }
+    while (num_small) {
+        size_t s = small[--num_small];
+        mapper->threshold[s] = SYMBOL_MAPPER_ALWAYS;
+        mapper->alias[s] = (uint32_t)s;
+    }
+}
+
+bool dsp_symbol_mapper_init(
+        symbol_mapper_t* mapper,
+        dsp_modulation_t modulation,
+        size_t order,
+        float shaping,
+        uint32_t scale,
+        uint32_t max_magnitude) {
+    double x[SYMBOL_MAPPER_MAX_POINTS];
+    double y[SYMBOL_MAPPER_MAX_POINTS];
+    if (!(shaping >= 0.0f) ||
+            !dsp_symbol_mapper_points(modulation, order, x, y)) {
+        return false;
+    }
+    memset(mapper, 0, sizeof(*mapper));
+    mapper->num_points = order;
+
+    // Maxwell-Boltzmann distribution, over the points normalized to a unit
+    // mean energy when they are equiprobable.
+    double energy = 0.0;
+    for (size_t m = 0; m < order; ++m) {
+        energy += x[m] * x[m] + y[m] * y[m];
+    }
+    energy /= (double)order;
+    double weight[SYMBOL_MAPPER_MAX_POINTS];
+    double total_weight = 0.0;
+    for (size_t m = 0; m < order; ++m) {
+        weight[m] = exp(-(double)shaping * (x[m] * x[m] + y[m] * y[m]) /
+            energy);
+        total_weight += weight[m];
+    }
+
+    double shaped_energy = 0.0;
+    for (size_t m = 0; m < order; ++m) {
+        double p = weight[m] / total_weight;
+        mapper->probability[m] = (float)p;
+        shaped_energy += p * (x[m] * x[m] + y[m] * y[m]);
+    }
+
+    const double gain = (double)scale * sqrt(2.0 / shaped_energy);
+    const double limit = (double)max_magnitude;
+    for (size_t m = 0; m < order; ++m) {
+        double i = round(x[m] * gain);
+        double q = round(y[m] * gain);
+        i = i > limit ? limit : (i < -limit ? -limit : i);
+        q = q > limit ? limit : (q < -limit ? -limit : q);
+        mapper->constellation[m] = (iq_sample_t) {
+            .i = (sample_t)i, .q = (sample_t)q };
+    }
+
+    dsp_symbol_mapper_build_alias_table(mapper);
+    return true;
+}
+
+// Writes size draws of dsp_rng_uniform_u32 to u.
+static void dsp_symbol_mapper_draw(
+        rng_state_t* rng, uint32_t* u, size_t size) {
+#ifdef USE_LEGACY_RNG
+    for (size_t n = 0; n < size; ++n) {
+        u[n] = dsp_rng_uniform_u32(rng);
+    }
+#else
+    // Lane l holds the state of draw n + l; all of them jump by
+    // SYMBOL_MAPPER_NUM_LANES steps at once: x -> a_n * x + c_n.
+    uint32_t a_n = 1;
+    uint32_t c_n = 0;
+    uint32_t lane[SYMBOL_MAPPER_NUM_LANES];
+    uint32_t x = rng->state;
+    for (size_t l = 0; l < SYMBOL_MAPPER_NUM_LANES; ++l) {
+        a_n *= RNG_MULTIPLIER;
+        c_n = c_n * RNG_MULTIPLIER + RNG_INCREMENT;
+        x = (x * RNG_MULTIPLIER + RNG_INCREMENT) & RNG_RAND_MAX;
+        lane[l] = x;
+    }
+
+    const uint32_t mask = rng->mask;
+    size_t n = 0;
+    uint32_t last = rng->state;
+    for (; n + SYMBOL_MAPPER_NUM_LANES <= size;
+            n += SYMBOL_MAPPER_NUM_LANES) {
+        for (size_t l = 0; l < SYMBOL_MAPPER_NUM_LANES; ++l) {
+            u[n + l] = (lane[l] ^ mask) << RNG_SHIFT_LEFT;
+        }
+        last = lane[SYMBOL_MAPPER_NUM_LANES - 1];
+        for (size_t l = 0; l < SYMBOL_MAPPER_NUM_LANES; ++l) {
+            lane[l] = (lane[l] * a_n + c_n) & RNG_RAND_MAX;
+        }
+    }
+    for (size_t l = 0; n < size; ++n, ++l) {
+        u[n] = (lane[l] ^ mask) << RNG_SHIFT_LEFT;
+        last = lane[l];
+    }
+    rng->state = last;
+#endif  // USE_LEGACY_RNG
+}
+
+// Replaces the draws by the indices of the points.
+static void dsp_symbol_mapper_select(
+        const symbol_mapper_t* mapper, uint32_t* index, size_t size) {
+    const uint32_t bits = mapper->table_bits;
+    const uint32_t* threshold = mapper->threshold;
+    const uint32_t* alias = mapper->alias;
+    for (size_t n = 0; n < size; ++n) {
+        uint32_t j = index[n] >> (32 - bits);
+        uint32_t fraction = index[n] << bits;
+        index[n] = fraction < threshold[j] ? j : alias[j];
+    }
+}
+
+void dsp_symbol_mapper_process(
+        const symbol_mapper_t* mapper,
+        rng_state_t* rng,
+        iq_sample_t* out,
+        size_t size) {
+    uint32_t index[SYMBOL_MAPPER_CHUNK_SIZE];
+    const iq_sample_t* constellation = mapper->constellation;
+    while (size) {
+        size_t n = size < SYMBOL_MAPPER_CHUNK_SIZE
+            ? size
+            : SYMBOL_MAPPER_CHUNK_SIZE;
+        dsp_symbol_mapper_draw(rng, index, n);
+        dsp_symbol_mapper_select(mapper, index, n);
+        for (size_t k = 0; k < n; ++k) {
+            out[k] = constellation[index[k]];
+        }
+        DSP_STATISTICS_ONLY(
+            for (size_t k = 0; k < n; ++k) {
+                dsp_symbol_statistics_add(
+                    &rng->statistics, out[k].i, out[k].q);
+            })
+        out += n;
+        size -= n;
+    }
+}
+
+void dsp_symbol_mapper_process_planar(
+        const symbol_mapper_t* mapper,
+        rng_state_t* rng,
+        sample_t* out_i,
+        sample_t* out_q,
+        size_t size) {
+    uint32_t index[SYMBOL_MAPPER_CHUNK_SIZE];
+    const iq_sample_t* constellation = mapper->constellation;
+    while (size) {
+        size_t n = size < SYMBOL_MAPPER_CHUNK_SIZE
+            ? size
+            : SYMBOL_MAPPER_CHUNK_SIZE;
+        dsp_symbol_mapper_draw(rng, index, n);
+        dsp_symbol_mapper_select(mapper, index, n);
+        for (size_t k = 0; k < n; ++k) {
+            out_i[k] = constellation[index[k]].i;
+            out_q[k] = constellation[index[k]].q;
+        }
+        DSP_STATISTICS_ONLY(
+            for (size_t k = 0; k < n; ++k) {
+                dsp_symbol_statistics_add(&rng->statistics, out_i[k], out_q[k]);
+            })
+        out_i += n;
+        out_q += n;
+        size -= n;
+    }
+}
@@ -0,0 +1,95 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Symbol mapper: discrete-modulation symbols (M-PSK, square M-QAM, and
+// probabilistically shaped QAM), a drop-in replacement for the Gaussian
+// symbols of dsp_rng_generate_icdf.
+//
+// Each symbol takes a single draw of the RNG. Its top bits select an entry of
+// an alias table (Walker's method), and the following bits choose between
+// this entry and its alias, which gives any distribution over the points of
+// the constellation at the cost of a uniform one. The symbols are then read
+// from the constellation LUT.
+//
+// The draws are made by chunks: the LCG runs as SYMBOL_MAPPER_NUM_LANES
+// interleaved lanes, each one jumping as many steps at once, and the alias
+// selection and LUT reads (gathers) are separate loops without dependencies
+// between symbols, so that all of them are vectorized. The sequence of draws
+// is the one of dsp_rng_uniform_u32.
+//
+// The points are scaled so that their mean energy, under their distribution,
+// is that of the Gaussian symbols of the same scale (2 * scale^2), then
+// clamped at max_magnitude.
+
+#ifndef DSP_DSP_SYMBOL_MAPPER_H_
+#define DSP_DSP_SYMBOL_MAPPER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dsp/dsp_rng.h"
+#include "dsp/dsp_types.h"
+
+#define SYMBOL_MAPPER_MAX_POINTS 256
+#define SYMBOL_MAPPER_NUM_LANES 8
+
+typedef enum {
+    // dsp_rng_generate_icdf; no mapper.
+    DSP_MODULATION_GAUSSIAN,
+
+    // order points on a circle, the first one at pi / order (QPSK is the
+    // +-1 +-j square).
+    DSP_MODULATION_PSK,
+
+    // Square grid of order points (4, 16, 64 or 256), with a
+    // Maxwell-Boltzmann distribution p(x) ~ exp(-shaping |x|^2), |x| being
+    // normalized to a unit mean energy of the uniform constellation. shaping
+    // = 0 gives a uniform M-QAM.
+    DSP_MODULATION_QAM,
+
+    DSP_NUM_MODULATIONS
+} dsp_modulation_t;
+
+// Read-only once initialized: can be shared by any number of mappers.
+typedef struct {
+    size_t num_points;
+    iq_sample_t constellation[SYMBOL_MAPPER_MAX_POINTS];
+    float probability[SYMBOL_MAPPER_MAX_POINTS];
+
+    // Alias table of 1 << table_bits entries: entry j is kept if the next
+    // bits of the draw, as a Q32 fraction, are below threshold[j], otherwise
+    // replaced by alias[j].
+    uint32_t table_bits;
+    uint32_t threshold[SYMBOL_MAPPER_MAX_POINTS];
+    uint32_t alias[SYMBOL_MAPPER_MAX_POINTS];
+} symbol_mapper_t;
+
+// Returns false if the order is not supported by the modulation (PSK: 2 to
+// SYMBOL_MAPPER_MAX_POINTS; QAM: a square power of 4 up to
+// SYMBOL_MAPPER_MAX_POINTS) or if shaping is negative.
+bool dsp_symbol_mapper_init(
+    symbol_mapper_t* mapper,
+    dsp_modulation_t modulation,
+    size_t order,
+    float shaping,
+    uint32_t scale,
+    uint32_t max_magnitude);
+
+// Draws size symbols with rng, whose scale and clamping settings are not
+// used. With DSP_STATISTICS, the symbols are added to its statistics.
+void dsp_symbol_mapper_process(
+    const symbol_mapper_t* mapper,
+    rng_state_t* rng,
+    iq_sample_t* out,
+    size_t size);
+
+// Same as above, with the I and Q components written to separate planes.
+void dsp_symbol_mapper_process_planar(
+    const symbol_mapper_t* mapper,
+    rng_state_t* rng,
+    sample_t* out_i,
+    sample_t* out_q,
+    size_t size);
+
+#endif  // DSP_DSP_SYMBOL_MAPPER_H_
@@ -39,8 +39,24 @@ typedef struct {
     sample_t q;
 } iq_sample_t;
 
+// The interleaved processing functions view an array of iq_sample_t as an
+// array of sample_t, I and Q alternating, and run their strided variants on
+// it with a stride of 2.
+#ifdef __cplusplus
+    static_assert(sizeof(iq_sample_t) == 2 * sizeof(sample_t),
+                  "iq_sample_t must hold two packed samples");
+#else
+    _Static_assert(sizeof(iq_sample_t) == 2 * sizeof(sample_t),
+                   "iq_sample_t must hold two packed samples");
+#endif  // __cplusplus
+
 typedef uint32_t phase_t;
 
+// Maximum number of channels processed at once by the batched blocks. Their
+// states hold one lane per channel, so that the loops over the channels have
+// a fixed number of iterations and map to SIMD registers.
+#define DSP_BATCH_MAX_CHANNELS 8
+
 // Computes frequency / sample_rate * (1 << 32) to get a phase increment
 // for a 32-bit phase counter.
 
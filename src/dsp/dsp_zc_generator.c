@@ -10,7 +10,7 @@
 
 void dsp_zc_generator_init(
         zc_generator_state_t* state,
-        iq_sample_t* lut_phasor,
+        const iq_sample_t* lut_phasor,
         uint32_t length,
         uint32_t root,
         uint32_t shift,
@@ -22,7 +22,6 @@ void dsp_zc_generator_init(
     state->shift = shift;
     state->phase_increment = dsp_phase_increment(rate, sample_rate);
 
-    dsp_phasor_bank_fill_lut(lut_phasor);
     dsp_zc_generator_reset(state);
 }
 
@@ -30,13 +29,25 @@ void dsp_zc_generator_reset(zc_generator_state_t* state) {
     state->phase = -1;
     state->n = -1;
     state->value = (iq_sample_t) { .i = 0, .q = 0 };
+    DSP_STATISTICS_ONLY(dsp_signal_statistics_reset(&state->statistics);)
 }
 
-void dsp_zc_generator_process(
+void dsp_zc_generator_set_rate(
+        zc_generator_state_t* state, uint32_t rate, uint32_t sample_rate) {
+    state->phase_increment = dsp_phase_increment(rate, sample_rate);
+}
+
+static inline void dsp_zc_generator_process_strided(
         zc_generator_state_t* state,
-        iq_sample_t* out,
+        sample_t* out_i,
+        sample_t* out_q,
+        size_t stride,
         size_t size) {
     zc_generator_state_t s = *state;
+    DSP_STATISTICS_ONLY(
+        const sample_t* begin_i = out_i;
+        const sample_t* begin_q = out_q;
+        const size_t count = size;)
     while (size--) {
         phase_t previous_phase = s.phase;
         s.phase += s.phase_increment;
@@ -56,7 +67,29 @@ void dsp_zc_generator_process(
                 .i = cosf(t) * SAMPLE_MAX,
                 .q = sinf(t) * SAMPLE_MAX };*/
         }
-        *out++ = s.value;
+        *out_i = s.value.i;
+        *out_q = s.value.q;
+        out_i += stride;
+        out_q += stride;
     }
+    DSP_STATISTICS_ONLY(
+        dsp_signal_statistics_add_strided(
+            &s.statistics, begin_i, begin_q, stride, count);)
     *state = s;
 }
+
+void dsp_zc_generator_process(
+        zc_generator_state_t* state,
+        iq_sample_t* out,
+        size_t size) {
+    dsp_zc_generator_process_strided(
+        state, (sample_t*)out, (sample_t*)out + 1, 2, size);
+}
+
+void dsp_zc_generator_process_planar(
+        zc_generator_state_t* state,
+        sample_t* out_i,
+        sample_t* out_q,
+        size_t size) {
+    dsp_zc_generator_process_strided(state, out_i, out_q, 1, size);
+}
@@ -4,8 +4,9 @@
 //
 // Zadoff-Chu sync sequence generator.
 //
-// Note that this block requires a precomputed LUT for the phasor. In a typical
-// use case, this LUT has been initiailized by the phasor bank.
+// Note that this block requires the phasor LUT of the phasor bank, returned by
+// dsp_phasor_bank_get_lut() or taken from the LUT registry
+// (dsp/dsp_lut_registry.h). It is only read.
 
 #ifndef DSP_DSP_ZC_GENERATOR_H_
 #define DSP_DSP_ZC_GENERATOR_H_
@@ -13,6 +14,7 @@
 #include <stdint.h>
 
 #include "dsp/dsp_phasor_bank.h"
+#include "dsp/dsp_statistics.h"
 #include "dsp/dsp_types.h"
 
 typedef struct {
@@ -23,12 +25,15 @@ typedef struct {
     phase_t phase_increment;
     phase_t n;
     iq_sample_t value;
-    iq_sample_t* lut_phasor;
+    const iq_sample_t* lut_phasor;
+#ifdef DSP_STATISTICS
+    dsp_signal_statistics_t statistics;  // Reset by dsp_zc_generator_reset.
+#endif  // DSP_STATISTICS
 } zc_generator_state_t;
 
 void dsp_zc_generator_init(
     zc_generator_state_t* state,
-    iq_sample_t* lut_phasor,
+    const iq_sample_t* lut_phasor,
     uint32_t length,
     uint32_t root,
     uint32_t shift,
@@ -37,7 +42,19 @@ void dsp_zc_generator_init(
 
 void dsp_zc_generator_reset(zc_generator_state_t* state);
 
+// Changes the chip rate, from the next sample on. The position in the
+// sequence and in the current chip are kept.
+void dsp_zc_generator_set_rate(
+    zc_generator_state_t* state, uint32_t rate, uint32_t sample_rate);
+
 void dsp_zc_generator_process(
     zc_generator_state_t* state, iq_sample_t* out, size_t size);
 
+// Same as above, with the I and Q components written to separate planes.
+void dsp_zc_generator_process_planar(
+    zc_generator_state_t* state,
+    sample_t* out_i,
+    sample_t* out_q,
+    size_t size);
+
 #endif  // DSP_DSP_ZC_GENERATOR_H_
@@ -0,0 +1,334 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// C API of the shared library.
+
+#include "embedded_alice.h"
+
+#include <string.h>
+
+#include "dsp/dsp_batch_generator.h"
+#include "dsp/dsp_frame_generator.h"
+#include "dsp/dsp_lut_registry.h"
+#include "dsp/dsp_memory_plan.h"
+
+#ifndef FIXED_POINT
+    #error "The C API exposes int16 samples and requires FIXED_POINT"
+#endif  // FIXED_POINT
+
+// Block size of the whole-frame generation.
+#define EA_FRAME_BLOCK_SIZE 4096
+
+struct ea_stream {
+    dsp_parameter_t parameters;
+    uint32_t seed;
+    size_t block_size;
+
+    frame_generator_state_t generator;
+    iq_sample_t* symbols;
+
+    // Shared with the other streams and batches (see dsp/dsp_lut_registry.h).
+    const iq_sample_t* lut_phasor;
+    const sample_t* lut_rrc;
+};
+
+struct ea_batch {
+    batch_generator_state_t generator;
+    iq_sample_t* symbols;
+    const iq_sample_t* lut_phasor;
+    const sample_t* lut_rrc;
+};
+
+static int ea_convert_parameters(
+        const ea_parameters_t* p,
+        dsp_parameter_t* parameters) {
+    if (!p || p->struct_size != sizeof(ea_parameters_t)) {
+        return EA_ERROR_INVALID_ARGUMENT;
+    }
+    parameters->sample_rate = p->sample_rate;
+    parameters->symbol_rate = p->symbol_rate;
+    parameters->zc_rate = p->zc_rate;
+    parameters->num_symbols = p->num_symbols;
+    parameters->num_null_symbols = p->num_null_symbols;
+    parameters->zc_length = p->zc_length;
+    parameters->zc_root = p->zc_root;
+    parameters->zc_shift = p->zc_shift;
+    parameters->shift_frequency = p->shift_frequency;
+    parameters->symbol_scale = p->symbol_scale;
+    parameters->symbol_max_value = p->symbol_max_value;
+    parameters->symbol_clamp = p->symbol_clamp != 0;
+    for (size_t i = 0; i < NUM_PILOTS; ++i) {
+        parameters->pilot_frequency[i] = p->pilot_frequency[i];
+        parameters->pilot_amplitude[i] = p->pilot_amplitude[i];
+    }
+    parameters->rrc_roll_off = p->rrc_roll_off;
+    return dsp_parameters_check(parameters) ? EA_ERROR_INVALID_ARGUMENT
+                                            : EA_OK;
+}
+
+uint32_t ea_api_version(void) {
+    return EA_API_VERSION;
+}
+
+void ea_parameters_init(ea_parameters_t* parameters) {
+    memset(parameters, 0, sizeof(ea_parameters_t));
+    parameters->struct_size = sizeof(ea_parameters_t);
+    parameters->sample_rate = 2000000000;
+    parameters->symbol_rate = 100000000;
+    parameters->zc_rate = 50000000;
+    parameters->num_symbols = 1000000;
+    parameters->num_null_symbols = 10;
+    parameters->zc_length = 3989;
+    parameters->zc_root = 5;
+    parameters->zc_shift = 0;
+    parameters->shift_frequency = 0;
+    parameters->symbol_scale = 7500;
+    parameters->symbol_max_value = 0x5fff;
+    parameters->symbol_clamp = 0;
+    parameters->pilot_frequency[0] = 200000000;
+    parameters->pilot_frequency[1] = 220000000;
+    parameters->pilot_amplitude[0] = 0.16f;
+    parameters->pilot_amplitude[1] = 0.16f;
+    parameters->rrc_roll_off = 0.3f;
+    parameters->seed = 1;
+}
+
+int ea_frame_layout(
+        const ea_parameters_t* parameters,
+        ea_frame_layout_t* layout) {
+    dsp_parameter_t dsp_parameters;
+    int status = ea_convert_parameters(parameters, &dsp_parameters);
+    if (status != EA_OK || !layout) {
+        return status != EA_OK ? status : EA_ERROR_INVALID_ARGUMENT;
+    }
+    dsp_memory_plan_t plan;
+    dsp_memory_plan_frame(&plan, &dsp_parameters);
+    layout->num_samples_zc = plan.num_samples_zc;
+    layout->num_samples_qd = plan.num_samples_qd;
+    layout->num_samples_tail = plan.num_samples_tail;
+    layout->num_samples = plan.num_samples;
+    layout->num_symbols = plan.num_symbols;
+    return EA_OK;
+}
+
+int ea_generate_frame(
+        const ea_parameters_t* parameters,
+        int16_t* samples,
+        size_t num_samples,
+        int16_t* symbols,
+        size_t num_symbols) {
+    ea_frame_layout_t layout;
+    int status = ea_frame_layout(parameters, &layout);
+    if (status != EA_OK) {
+        return status;
+    }
+    if (!samples) {
+        return EA_ERROR_INVALID_ARGUMENT;
+    }
+    if (num_samples < layout.num_samples ||
+        (symbols && num_symbols < layout.num_symbols)) {
+        return EA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    if (symbols) {
+        // The same sequence as the one fed to the RRC filter.
+        rng_state_t rng;
+        dsp_rng_init(
+            &rng,
+            parameters->symbol_scale,
+            parameters->symbol_max_value,
+            parameters->symbol_clamp != 0,
+            parameters->seed,
+            0);
+        iq_sample_t* s = (iq_sample_t*)symbols;
+        dsp_rng_generate_icdf(&rng, s, parameters->num_symbols);
+        for (size_t i = parameters->num_symbols; i < layout.num_symbols;
+             ++i) {
+            s[i] = (iq_sample_t) { .i = 0, .q = 0 };
+        }
+    }
+
+    ea_stream_t* stream;
+    status = ea_stream_create(parameters, EA_FRAME_BLOCK_SIZE, &stream);
+    if (status != EA_OK) {
+        return status;
+    }
+    ea_stream_read(stream, samples, layout.num_samples);
+    ea_stream_destroy(stream);
+    return EA_OK;
+}
+
+int ea_stream_create(
+        const ea_parameters_t* parameters,
+        size_t block_size,
+        ea_stream_t** stream) {
+    dsp_parameter_t dsp_parameters;
+    int status = ea_convert_parameters(parameters, &dsp_parameters);
+    if (status != EA_OK) {
+        return status;
+    }
+    if (!block_size || !stream) {
+        return EA_ERROR_INVALID_ARGUMENT;
+    }
+
+    ea_stream_t* s = (ea_stream_t*)malloc(sizeof(ea_stream_t));
+    if (!s) {
+        return EA_ERROR_OUT_OF_MEMORY;
+    }
+    dsp_memory_plan_t plan;
+    dsp_memory_plan_streaming(&plan, &dsp_parameters, block_size);
+    s->symbols = (iq_sample_t*)malloc(
+        plan.symbols_per_block * sizeof(iq_sample_t));
+    if (!s->symbols) {
+        free(s);
+        return EA_ERROR_OUT_OF_MEMORY;
+    }
+
+    s->parameters = dsp_parameters;
+    s->seed = parameters->seed;
+    s->block_size = block_size;
+    s->lut_phasor = dsp_lut_registry_acquire_phasor();
+    s->lut_rrc = dsp_lut_registry_acquire_rrc(dsp_parameters.rrc_roll_off);
+    if (!s->lut_phasor || !s->lut_rrc) {
+        ea_stream_destroy(s);
+        return EA_ERROR_OUT_OF_MEMORY;
+    }
+
+    ea_stream_rewind(s);
+    *stream = s;
+    return EA_OK;
+}
+
+size_t ea_stream_read(
+        ea_stream_t* stream,
+        int16_t* samples,
+        size_t num_samples) {
+    return dsp_frame_generator_process(
+        &stream->generator, (iq_sample_t*)samples, num_samples);
+}
+
+uint64_t ea_stream_position(const ea_stream_t* stream) {
+    return stream->generator.position;
+}
+
+int ea_stream_retune(
+        ea_stream_t* stream,
+        uint32_t shift_frequency,
+        const uint32_t pilot_frequency[2],
+        const float pilot_amplitude[2],
+        uint64_t position,
+        uint32_t ramp_size) {
+    if (!stream || !pilot_frequency || !pilot_amplitude) {
+        return EA_ERROR_INVALID_ARGUMENT;
+    }
+    if (position > stream->generator.num_samples) {
+        position = stream->generator.num_samples;
+    }
+    dsp_frame_generator_retune(
+        &stream->generator,
+        shift_frequency,
+        pilot_frequency,
+        pilot_amplitude,
+        (size_t)position,
+        ramp_size);
+    return EA_OK;
+}
+
+void ea_stream_rewind(ea_stream_t* stream) {
+    dsp_frame_generator_init(
+        &stream->generator,
+        &stream->parameters,
+        stream->seed,
+        stream->lut_phasor,
+        stream->lut_rrc,
+        stream->symbols,
+        stream->block_size);
+}
+
+void ea_stream_destroy(ea_stream_t* stream) {
+    if (stream) {
+        dsp_lut_registry_release(stream->lut_phasor);
+        dsp_lut_registry_release(stream->lut_rrc);
+        free(stream->symbols);
+        free(stream);
+    }
+}
+
+int ea_batch_create(
+        const ea_parameters_t* parameters,
+        size_t num_channels,
+        size_t block_size,
+        ea_batch_t** batch) {
+    if (!parameters || !num_channels ||
+        num_channels > EA_BATCH_MAX_CHANNELS || !block_size || !batch) {
+        return EA_ERROR_INVALID_ARGUMENT;
+    }
+    dsp_parameter_t dsp_parameters[EA_BATCH_MAX_CHANNELS];
+    uint32_t seeds[EA_BATCH_MAX_CHANNELS];
+    for (size_t c = 0; c < num_channels; ++c) {
+        int status = ea_convert_parameters(
+            &parameters[c], &dsp_parameters[c]);
+        if (status != EA_OK) {
+            return status;
+        }
+        if (!dsp_batch_generator_compatible(
+                &dsp_parameters[0], &dsp_parameters[c])) {
+            return EA_ERROR_INVALID_ARGUMENT;
+        }
+        seeds[c] = parameters[c].seed;
+    }
+
+    ea_batch_t* b = (ea_batch_t*)malloc(sizeof(ea_batch_t));
+    if (!b) {
+        return EA_ERROR_OUT_OF_MEMORY;
+    }
+    dsp_memory_plan_t plan;
+    dsp_memory_plan_streaming(&plan, &dsp_parameters[0], block_size);
+    b->symbols = (iq_sample_t*)malloc(
+        num_channels * plan.symbols_per_block * sizeof(iq_sample_t));
+    if (!b->symbols) {
+        free(b);
+        return EA_ERROR_OUT_OF_MEMORY;
+    }
+
+    b->lut_phasor = dsp_lut_registry_acquire_phasor();
+    b->lut_rrc = dsp_lut_registry_acquire_rrc(dsp_parameters[0].rrc_roll_off);
+    if (!b->lut_phasor || !b->lut_rrc) {
+        ea_batch_destroy(b);
+        return EA_ERROR_OUT_OF_MEMORY;
+    }
+
+    dsp_batch_generator_init(
+        &b->generator,
+        dsp_parameters,
+        seeds,
+        num_channels,
+        b->lut_phasor,
+        b->lut_rrc,
+        b->symbols,
+        block_size);
+    *batch = b;
+    return EA_OK;
+}
+
+size_t ea_batch_read(
+        ea_batch_t* batch,
+        int16_t* samples,
+        size_t num_samples) {
+    return dsp_batch_generator_process(
+        &batch->generator, (iq_sample_t*)samples, num_samples);
+}
+
+uint64_t ea_batch_position(const ea_batch_t* batch) {
+    return batch->generator.position;
+}
+
+void ea_batch_destroy(ea_batch_t* batch) {
+    if (batch) {
+        dsp_lut_registry_release(batch->lut_phasor);
+        dsp_lut_registry_release(batch->lut_rrc);
+        free(batch->symbols);
+        free(batch);
+    }
+}
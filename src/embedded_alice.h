@@ -0,0 +1,171 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// C API of the shared library (libembedded_alice), for use from other
+// languages, e.g. Python with ctypes (see tools/embedded_alice.py).
+//
+// The caller owns all the sample buffers, which are filled in place: I/Q
+// samples and symbols are interleaved int16 pairs, the layout of a numpy
+// int16 array of shape (n, 2). Only plain integer and float types cross the
+// API, and the handles are opaque, so that the ABI stays stable as the
+// library evolves. EA_API_VERSION is increased on incompatible changes.
+//
+// All functions are thread-safe, except for concurrent calls on the same
+// stream.
+
+#ifndef EMBEDDED_ALICE_H_
+#define EMBEDDED_ALICE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EA_API_VERSION 1
+
+#if defined(EMBEDDED_ALICE_SHARED) && defined(__GNUC__)
+    #define EA_API __attribute__((visibility("default")))
+#else
+    #define EA_API
+#endif
+
+// Status codes.
+#define EA_OK 0
+#define EA_ERROR_INVALID_ARGUMENT -1
+#define EA_ERROR_BUFFER_TOO_SMALL -2
+#define EA_ERROR_OUT_OF_MEMORY -3
+
+// Frame parameters. All fields are 32 bits wide. Initialize with
+// ea_parameters_init, which sets struct_size and the defaults of the command
+// line tool.
+typedef struct {
+    uint32_t struct_size;
+
+    uint32_t sample_rate;
+    uint32_t symbol_rate;
+    uint32_t zc_rate;
+    uint32_t num_symbols;
+    uint32_t num_null_symbols;
+
+    uint32_t zc_length;
+    uint32_t zc_root;
+    uint32_t zc_shift;
+
+    uint32_t shift_frequency;
+
+    uint32_t symbol_scale;
+    uint32_t symbol_max_value;
+    uint32_t symbol_clamp;
+
+    uint32_t pilot_frequency[2];
+    float pilot_amplitude[2];
+
+    float rrc_roll_off;
+
+    uint32_t seed;
+} ea_parameters_t;
+
+typedef struct {
+    // ZC sequence, quantum data, null tail.
+    uint64_t num_samples_zc;
+    uint64_t num_samples_qd;
+    uint64_t num_samples_tail;
+    uint64_t num_samples;
+
+    // Random symbols, followed by the zeros flushing the RRC filter.
+    uint64_t num_symbols;
+} ea_frame_layout_t;
+
+typedef struct ea_stream ea_stream_t;
+typedef struct ea_batch ea_batch_t;
+
+EA_API uint32_t ea_api_version(void);
+
+EA_API void ea_parameters_init(ea_parameters_t* parameters);
+
+EA_API int ea_frame_layout(
+    const ea_parameters_t* parameters,
+    ea_frame_layout_t* layout);
+
+// Generates a whole frame: num_samples I/Q pairs in samples, and, when
+// symbols is not NULL, num_symbols symbols. The buffers may be larger than
+// the frame (see ea_frame_layout); the rest is left untouched.
+EA_API int ea_generate_frame(
+    const ea_parameters_t* parameters,
+    int16_t* samples,
+    size_t num_samples,
+    int16_t* symbols,
+    size_t num_symbols);
+
+// Streaming generation of a frame, with a working memory bounded by
+// block_size (the number of samples generated at once; any number of samples
+// can be read).
+EA_API int ea_stream_create(
+    const ea_parameters_t* parameters,
+    size_t block_size,
+    ea_stream_t** stream);
+
+// Writes the next samples of the frame. Returns the number of I/Q pairs
+// written, smaller than num_samples at the end of the frame.
+EA_API size_t ea_stream_read(
+    ea_stream_t* stream,
+    int16_t* samples,
+    size_t num_samples);
+
+// Position in the frame, in samples.
+EA_API uint64_t ea_stream_position(const ea_stream_t* stream);
+
+// Changes the frequency shift and the pilots of the stream from sample
+// position of the frame on, without discontinuity: the phases of the tones
+// are kept, and the pilot amplitudes go linearly to their new values over
+// ramp_size samples. A position already reached takes effect at once. Only
+// the last pending change is kept.
+EA_API int ea_stream_retune(
+    ea_stream_t* stream,
+    uint32_t shift_frequency,
+    const uint32_t pilot_frequency[2],
+    const float pilot_amplitude[2],
+    uint64_t position,
+    uint32_t ramp_size);
+
+// Starts the frame over, with the parameters given at creation.
+EA_API void ea_stream_rewind(ea_stream_t* stream);
+
+EA_API void ea_stream_destroy(ea_stream_t* stream);
+
+// Maximum number of channels of a batch.
+#define EA_BATCH_MAX_CHANNELS 8
+
+// Streaming generation of the frames of several channels at once, faster
+// than one stream per channel. parameters holds num_channels entries, which
+// may only differ in their seed, symbol distribution (scale, maximum value,
+// clamping), frequency shift and pilots. Each channel gets the samples of
+// its own stream.
+EA_API int ea_batch_create(
+    const ea_parameters_t* parameters,
+    size_t num_channels,
+    size_t block_size,
+    ea_batch_t** batch);
+
+// Writes the next num_samples samples of every channel, channel-interleaved:
+// num_samples * num_channels I/Q pairs, the layout of a numpy int16 array of
+// shape (num_samples, num_channels, 2). Returns the number of samples
+// written per channel.
+EA_API size_t ea_batch_read(
+    ea_batch_t* batch,
+    int16_t* samples,
+    size_t num_samples);
+
+// Position in the frames, in samples.
+EA_API uint64_t ea_batch_position(const ea_batch_t* batch);
+
+EA_API void ea_batch_destroy(ea_batch_t* batch);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // EMBEDDED_ALICE_H_
@@ -0,0 +1,257 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Execution plan and autotuning.
+
+#include "execution_plan.h"
+
+extern "C" {
+#include "dsp/dsp_frame_generator.h"
+}
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include "absl/strings/numbers.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const char* AlgorithmName(phasor_bank_algorithm_t algorithm) {
+    switch (algorithm) {
+        case PHASOR_BANK_ALGORITHM_BYPASS:
+            return "bypass";
+        case PHASOR_BANK_ALGORITHM_PILOTS:
+            return "pilots";
+        case PHASOR_BANK_ALGORITHM_SCALE:
+            return "scale";
+        case PHASOR_BANK_ALGORITHM_SCALE_PILOTS:
+            return "scale_pilots";
+        case PHASOR_BANK_ALGORITHM_SHIFT:
+            return "shift";
+        case PHASOR_BANK_ALGORITHM_SHIFT_PILOTS:
+            return "shift_pilots";
+        default:
+            return "shift_two_pilots";
+    }
+}
+
+// Best duration of repetitions runs of a function, in seconds.
+template <typename F>
+double BestTime(size_t repetitions, F f) {
+    double best = 0.0;
+    for (size_t i = 0; i < std::max<size_t>(repetitions, 1); ++i) {
+        Clock::time_point begin = Clock::now();
+        f();
+        double elapsed =
+            std::chrono::duration<double>(Clock::now() - begin).count();
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+bool Wisdom::Load(const std::string& file_name, std::string* error) {
+    std::ifstream in(file_name);
+    if (!in) {
+        return true;
+    }
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key) || key[0] == '#') {
+            continue;
+        }
+        ExecutionChoices choices;
+        std::string field;
+        while (fields >> field) {
+            size_t separator = field.find('=');
+            std::string name = field.substr(0, separator);
+            std::string value = separator == std::string::npos
+                                    ? std::string()
+                                    : field.substr(separator + 1);
+            bool valid = false;
+            if (name == "planar") {
+                valid = absl::SimpleAtob(value, &choices.planar);
+            } else if (name == "chunk_size") {
+                valid = absl::SimpleAtoi(value, &choices.chunk_size) &&
+                        choices.chunk_size > 0;
+            } else if (name == "block_size") {
+                valid = absl::SimpleAtoi(value, &choices.block_size) &&
+                        choices.block_size > 0;
+            }
+            if (separator == std::string::npos || !valid) {
+                *error = file_name + ": line " + std::to_string(line_number) +
+                         ": invalid setting \"" + field + "\"";
+                return false;
+            }
+        }
+        entries_[key] = choices;
+    }
+    return true;
+}
+
+bool Wisdom::Save(const std::string& file_name) const {
+    // Replaces the file at once, so that a concurrent reader never sees a
+    // partial file.
+    const std::string temporary = file_name + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << "# embedded_alice wisdom: fastest execution choices on this "
+               "machine.\n";
+        for (const auto& entry : entries_) {
+            out << entry.first << " planar=" << entry.second.planar
+                << " chunk_size=" << entry.second.chunk_size
+                << " block_size=" << entry.second.block_size << '\n';
+        }
+        if (!out.flush()) {
+            return false;
+        }
+    }
+    return rename(temporary.c_str(), file_name.c_str()) == 0;
+}
+
+bool Wisdom::Lookup(const std::string& key, ExecutionChoices* choices) const {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        return false;
+    }
+    *choices = it->second;
+    return true;
+}
+
+void Wisdom::Store(const std::string& key, const ExecutionChoices& choices) {
+    entries_[key] = choices;
+}
+
+std::unique_ptr<ExecutionPlan> ExecutionPlan::Create(
+    const dsp_parameter_t& parameters, LutCache* luts, std::string* error) {
+    const char* failure = dsp_parameters_check(&parameters);
+    if (failure) {
+        *error = failure;
+        return nullptr;
+    }
+
+    std::unique_ptr<ExecutionPlan> plan(new ExecutionPlan);
+    plan->parameters_ = parameters;
+    dsp_memory_plan_frame(&plan->frame_plan_, &parameters);
+    plan->luts_ = luts;
+    plan->lut_phasor_ = luts->phasor();
+    plan->lut_rrc_ = luts->rrc(parameters.rrc_roll_off);
+    plan->samples_per_symbol_ = parameters.sample_rate / parameters.symbol_rate;
+
+    // The kernel and pilot cache the phasor bank selects for these tones.
+    std::unique_ptr<phasor_bank_state_t> phasor_bank(new phasor_bank_state_t);
+    uint32_t frequencies[3] = {parameters.shift_frequency,
+                               parameters.pilot_frequency[0],
+                               parameters.pilot_frequency[1]};
+    float amplitudes[3] = {0.70710678118f, parameters.pilot_amplitude[0],
+                           parameters.pilot_amplitude[1]};
+    dsp_phasor_bank_init(phasor_bank.get(), luts->phasor(),
+                         PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, frequencies,
+                         amplitudes, parameters.sample_rate);
+    plan->phasor_bank_algorithm_ = phasor_bank->algorithm;
+    plan->pilot_cache_period_ = phasor_bank->pilot_cache_period;
+    return plan;
+}
+
+dsp_memory_plan_t ExecutionPlan::streaming_plan() const {
+    dsp_memory_plan_t plan;
+    dsp_memory_plan_streaming(&plan, &parameters_, choices_.block_size);
+    return plan;
+}
+
+std::string ExecutionPlan::wisdom_key() const {
+    return "sps=" + std::to_string(samples_per_symbol_) +
+           ",tones=" + AlgorithmName(phasor_bank_algorithm_) +
+           ",pilot_cache=" + (pilot_cache_period_ ? "1" : "0");
+}
+
+bool ExecutionPlan::ApplyWisdom(const Wisdom& wisdom) {
+    if (!wisdom.Lookup(wisdom_key(), &choices_)) {
+        return false;
+    }
+    tuned_ = true;
+    return true;
+}
+
+void ExecutionPlan::Tune(const TuneOptions& options, Wisdom* wisdom) {
+    // A shorter frame, with the same oversampling and tones.
+    FrameConfig config;
+    config.parameters = parameters_;
+    config.parameters.num_symbols =
+        std::min(parameters_.num_symbols, options.num_symbols);
+
+    FrameBufferArena arena(HugePages::kNone, false);
+    double best_time = 0.0;
+    for (bool planar : {false, true}) {
+        config.planar = planar;
+        double time = BestTime(options.repetitions, [&] {
+            GenerateFrame(config, luts_, &arena, false);
+        });
+        if (!planar || time < best_time) {
+            best_time = time;
+            choices_.planar = planar;
+        }
+    }
+
+    // The chunk size of the graph, with the chosen layout.
+    config.planar = choices_.planar;
+    bool first = true;
+    for (size_t chunk_size : options.chunk_sizes) {
+        config.chunk_size = chunk_size;
+        double time = BestTime(options.repetitions, [&] {
+            GenerateFrame(config, luts_, &arena, false);
+        });
+        if (first || time < best_time) {
+            best_time = time;
+            choices_.chunk_size = chunk_size;
+            first = false;
+        }
+    }
+
+    first = true;
+    for (size_t block_size : options.block_sizes) {
+        dsp_memory_plan_t plan;
+        dsp_memory_plan_streaming(&plan, &config.parameters, block_size);
+        std::vector<iq_sample_t> symbols(plan.symbols_per_block);
+        std::vector<iq_sample_t> block(block_size);
+        std::unique_ptr<frame_generator_state_t> state(
+            new frame_generator_state_t);
+        double time = BestTime(options.repetitions, [&] {
+            dsp_frame_generator_init(state.get(), &config.parameters,
+                                     config.seed, lut_phasor_, lut_rrc_,
+                                     symbols.data(), block_size);
+            while (dsp_frame_generator_process(state.get(), block.data(),
+                                               block_size) == block_size) {
+            }
+        });
+        if (first || time < best_time) {
+            best_time = time;
+            choices_.block_size = block_size;
+            first = false;
+        }
+    }
+
+    tuned_ = true;
+    if (wisdom) {
+        wisdom->Store(wisdom_key(), choices_);
+    }
+}
+
+void ExecutionPlan::Apply(FrameConfig* config) const {
+    config->planar = choices_.planar;
+    config->chunk_size = choices_.chunk_size;
+}
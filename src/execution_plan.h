@@ -0,0 +1,148 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Execution plan: the validated parameters of a frame, with everything
+// derived from them (frame layout, LUTs, phasor bank kernel), and the
+// execution choices which are fastest on this machine: the layout and chunk
+// size of the whole-frame pipeline (interleaved or planar), and the block
+// size of the streaming generator.
+//
+// The best choices depend on the oversampling ratio, on the active tones, and
+// on the host (cache sizes, SIMD units). Tune() times the candidates on the
+// current machine and records the winners in a Wisdom, which can be saved to
+// a local file; later plans with the same oversampling ratio and tones pick
+// them up with ApplyWisdom() instead of being tuned again.
+//
+// A wisdom file holds one entry per line:
+//   sps=20,tones=pilots,pilot_cache=0 planar=0 chunk_size=8192 block_size=4096
+// The first field identifies the configurations sharing the same choices
+// (see ExecutionPlan::wisdom_key()). Empty lines and lines starting with #
+// are ignored.
+
+#ifndef EXECUTION_PLAN_H_
+#define EXECUTION_PLAN_H_
+
+extern "C" {
+#include "dsp/dsp_memory_plan.h"
+#include "dsp/dsp_parameters.h"
+#include "dsp/dsp_phasor_bank.h"
+#include "dsp/dsp_types.h"
+}
+
+#include <stddef.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frame_generator.h"
+
+struct ExecutionChoices {
+    // Layout of the whole-frame pipeline.
+    bool planar = false;
+
+    // Chunk size of the graph of the whole-frame pipeline.
+    size_t chunk_size = DSP_GRAPH_DEFAULT_CHUNK_SIZE;
+
+    // Block size of the streaming generator.
+    size_t block_size = 4096;
+};
+
+class Wisdom {
+   public:
+    Wisdom() = default;
+
+    // Merges the entries of a wisdom file. A missing file is not an error (it
+    // is created by the first tuning). On failure, returns false and sets
+    // error.
+    bool Load(const std::string& file_name, std::string* error);
+    bool Save(const std::string& file_name) const;
+
+    bool Lookup(const std::string& key, ExecutionChoices* choices) const;
+    void Store(const std::string& key, const ExecutionChoices& choices);
+
+    size_t size() const { return entries_.size(); }
+
+   private:
+    std::map<std::string, ExecutionChoices> entries_;
+};
+
+struct TuneOptions {
+    // Symbols of the frame generated to time each candidate (capped to the
+    // number of symbols of the frame).
+    uint32_t num_symbols = 1 << 16;
+
+    // Each candidate keeps its best time over this number of runs.
+    size_t repetitions = 3;
+
+    // Candidate chunk sizes of the whole-frame pipeline.
+    std::vector<size_t> chunk_sizes = {1024, 2048, 4096, 8192, 16384, 32768};
+
+    // Candidate block sizes of the streaming generator.
+    std::vector<size_t> block_sizes = {256,  512,   1024,  2048, 4096,
+                                       8192, 16384, 32768, 65536};
+};
+
+class ExecutionPlan {
+   public:
+    // Validates the parameters and builds the LUTs (in luts, which must
+    // outlive the plan). Returns nullptr and sets error if the parameters are
+    // invalid.
+    static std::unique_ptr<ExecutionPlan> Create(
+        const dsp_parameter_t& parameters, LutCache* luts, std::string* error);
+
+    ExecutionPlan(const ExecutionPlan&) = delete;
+    ExecutionPlan& operator=(const ExecutionPlan&) = delete;
+
+    const dsp_parameter_t& parameters() const { return parameters_; }
+    const dsp_memory_plan_t& frame_plan() const { return frame_plan_; }
+    const iq_sample_t* lut_phasor() const { return lut_phasor_; }
+    const sample_t* lut_rrc() const { return lut_rrc_; }
+    uint32_t samples_per_symbol() const { return samples_per_symbol_; }
+    phasor_bank_algorithm_t phasor_bank_algorithm() const {
+        return phasor_bank_algorithm_;
+    }
+    size_t pilot_cache_period() const { return pilot_cache_period_; }
+
+    // Memory plan of the streaming generator, with the chosen block size.
+    dsp_memory_plan_t streaming_plan() const;
+
+    // Identifies the configurations for which the same choices are best.
+    std::string wisdom_key() const;
+
+    // The defaults until the plan is tuned or finds its wisdom.
+    const ExecutionChoices& choices() const { return choices_; }
+    bool tuned() const { return tuned_; }
+
+    // Adopts the choices recorded for this configuration, if any. Returns
+    // true if there were.
+    bool ApplyWisdom(const Wisdom& wisdom);
+
+    // Times the candidate choices, adopts the fastest ones, and records them
+    // in wisdom (when not null).
+    void Tune(const TuneOptions& options, Wisdom* wisdom);
+
+    // Sets the execution options of a frame configuration with the same
+    // parameters.
+    void Apply(FrameConfig* config) const;
+
+   private:
+    ExecutionPlan() = default;
+
+    dsp_parameter_t parameters_;
+    dsp_memory_plan_t frame_plan_;
+    LutCache* luts_ = nullptr;
+    const iq_sample_t* lut_phasor_ = nullptr;
+    const sample_t* lut_rrc_ = nullptr;
+    uint32_t samples_per_symbol_ = 0;
+    phasor_bank_algorithm_t phasor_bank_algorithm_ =
+        PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS;
+    size_t pilot_cache_period_ = 0;
+
+    ExecutionChoices choices_;
+    bool tuned_ = false;
+};
+
+#endif  // EXECUTION_PLAN_H_
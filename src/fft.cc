@@ -0,0 +1,85 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Complex FFT.
+
+#include "fft.h"
+
+#include <math.h>
+
+#include <utility>
+
+Fft::Fft(size_t size)
+    : size_(size), bit_reversed_(size), twiddle_(size > 1 ? size - 1 : 0) {
+    size_t num_bits = 0;
+    while ((size_t(1) << num_bits) < size) {
+        ++num_bits;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        size_t r = 0;
+        for (size_t b = 0; b < num_bits; ++b) {
+            r |= ((i >> b) & 1) << (num_bits - 1 - b);
+        }
+        bit_reversed_[i] = r;
+    }
+    // The twiddles of the stage combining blocks of half values are at
+    // offset half - 1, so that each stage reads them contiguously.
+    for (size_t half = 1; half < size; half *= 2) {
+        for (size_t k = 0; k < half; ++k) {
+            double t = -M_PI * static_cast<double>(k) / half;
+            twiddle_[half - 1 + k] = std::complex<float>(cos(t), sin(t));
+        }
+    }
+}
+
+size_t Fft::SizeFor(size_t size) {
+    size_t n = 1;
+    while (n < size) {
+        n *= 2;
+    }
+    return n;
+}
+
+void Fft::Transform(std::complex<float>* data) const {
+    for (size_t i = 0; i < size_; ++i) {
+        size_t j = bit_reversed_[i];
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+    for (size_t half = 1; half < size_; half *= 2) {
+        const std::complex<float>* w = &twiddle_[half - 1];
+        for (size_t start = 0; start < size_; start += 2 * half) {
+            std::complex<float>* a = data + start;
+            std::complex<float>* b = a + half;
+            for (size_t k = 0; k < half; ++k) {
+                // Spelled out: std::complex multiplication handles infinities
+                // and NaNs, and is much slower.
+                const float re =
+                    b[k].real() * w[k].real() - b[k].imag() * w[k].imag();
+                const float im =
+                    b[k].real() * w[k].imag() + b[k].imag() * w[k].real();
+                const std::complex<float> t(re, im);
+                b[k] = a[k] - t;
+                a[k] += t;
+            }
+        }
+    }
+}
+
+void Fft::Forward(std::complex<float>* data) const {
+    Transform(data);
+}
+
+void Fft::Inverse(std::complex<float>* data) const {
+    // IFFT(x) = conj(FFT(conj(x))) / size.
+    for (size_t i = 0; i < size_; ++i) {
+        data[i] = std::conj(data[i]);
+    }
+    Transform(data);
+    const float scale = 1.0f / static_cast<float>(size_);
+    for (size_t i = 0; i < size_; ++i) {
+        data[i] = std::conj(data[i]) * scale;
+    }
+}
@@ -0,0 +1,38 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Dependency-free complex FFT (iterative radix-2, single precision), for the
+// correlations of the frame verifier.
+
+#ifndef FFT_H_
+#define FFT_H_
+
+#include <stddef.h>
+
+#include <complex>
+#include <vector>
+
+class Fft {
+   public:
+    // size must be a power of two.
+    explicit Fft(size_t size);
+
+    size_t size() const { return size_; }
+
+    // In place. Inverse() includes the 1/size normalization.
+    void Forward(std::complex<float>* data) const;
+    void Inverse(std::complex<float>* data) const;
+
+    // Smallest power of two greater than or equal to size.
+    static size_t SizeFor(size_t size);
+
+   private:
+    void Transform(std::complex<float>* data) const;
+
+    size_t size_;
+    std::vector<size_t> bit_reversed_;
+    std::vector<std::complex<float>> twiddle_;
+};
+
+#endif  // FFT_H_
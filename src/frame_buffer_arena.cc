@@ -0,0 +1,182 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Arena for the large per-frame buffers of the command line tool.
+
+#include "frame_buffer_arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // __linux__
+
+#include "absl/log/log.h"
+
+#ifdef __linux__
+
+namespace {
+
+const size_t kHugePageSize = 2 << 20;
+
+// From <numaif.h>, to avoid depending on libnuma.
+const int kMemoryPolicyPreferred = 1;
+
+size_t RoundUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// Binds the pages to the NUMA node of the calling thread. The pages are not
+// touched yet, so this only sets the policy used when they are faulted in.
+void BindToLocalNode(void* data, size_t size) {
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return;
+    }
+    unsigned long node_mask[16] = {};
+    const size_t bits_per_word = 8 * sizeof(node_mask[0]);
+    if (node >= bits_per_word * 16) {
+        return;
+    }
+    node_mask[node / bits_per_word] = 1UL << (node % bits_per_word);
+    if (syscall(SYS_mbind, data, size, kMemoryPolicyPreferred, node_mask,
+                bits_per_word * 16 + 1, 0) != 0) {
+        LOG(WARNING) << "Failed to bind frame buffer to NUMA node " << node;
+    }
+}
+
+}  // namespace
+
+#endif  // __linux__
+
+bool ParseHugePages(const std::string& text, HugePages* huge_pages) {
+    if (text == "none") {
+        *huge_pages = HugePages::kNone;
+    } else if (text == "transparent") {
+        *huge_pages = HugePages::kTransparent;
+    } else if (text == "explicit") {
+        *huge_pages = HugePages::kExplicit;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+FrameBufferArena::FrameBufferArena(HugePages huge_pages, bool numa_local)
+    : huge_pages_(huge_pages), numa_local_(numa_local) {}
+
+FrameBufferArena::~FrameBufferArena() { Release(); }
+
+void* FrameBufferArena::Get(size_t slot, size_t size) {
+    if (slot >= buffers_.size()) {
+        buffers_.resize(slot + 1);
+    }
+    Buffer* buffer = &buffers_[slot];
+    if (buffer->data && buffer->capacity >= size) {
+        return buffer->data;
+    }
+    Free(buffer);
+    Allocate(buffer, size ? size : 1);
+    return buffer->data;
+}
+
+void FrameBufferArena::Release() {
+    for (Buffer& buffer : buffers_) {
+        Free(&buffer);
+    }
+    buffers_.clear();
+}
+
+size_t FrameBufferArena::capacity() const {
+    size_t total = 0;
+    for (const Buffer& buffer : buffers_) {
+        total += buffer.capacity;
+    }
+    return total;
+}
+
+void FrameBufferArena::Allocate(Buffer* buffer, size_t size) {
+#ifdef __linux__
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void* data = MAP_FAILED;
+    size_t mapped_size = 0;
+
+    if (huge_pages_ == HugePages::kExplicit) {
+        // Without MAP_NORESERVE, this fails right away (rather than at the
+        // first page fault) if not enough huge pages are reserved.
+        mapped_size = RoundUp(size, kHugePageSize);
+        data = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                    flags | MAP_HUGETLB, -1, 0);
+        if (data == MAP_FAILED) {
+            LOG(WARNING) << "No explicit huge pages available for a "
+                         << mapped_size << " bytes buffer, using "
+                         << "transparent huge pages instead";
+        }
+    }
+
+    if (data == MAP_FAILED && huge_pages_ != HugePages::kNone) {
+        // Transparent huge pages require 2 MB aligned regions: over-allocate
+        // and trim.
+        mapped_size = RoundUp(size, kHugePageSize);
+        void* region = mmap(nullptr, mapped_size + kHugePageSize,
+                            PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (region != MAP_FAILED) {
+            char* start = static_cast<char*>(region);
+            char* aligned = reinterpret_cast<char*>(RoundUp(
+                reinterpret_cast<uintptr_t>(start), kHugePageSize));
+            if (aligned != start) {
+                munmap(start, aligned - start);
+            }
+            munmap(aligned + mapped_size, start + kHugePageSize - aligned);
+            data = aligned;
+            madvise(data, mapped_size, MADV_HUGEPAGE);
+        }
+    }
+
+    if (data == MAP_FAILED) {
+        size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        mapped_size = RoundUp(size, page_size);
+        data = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, flags, -1,
+                    0);
+        if (data == MAP_FAILED) {
+            LOG(FATAL) << "Failed to allocate a " << mapped_size
+                       << " bytes frame buffer";
+        }
+    }
+
+    if (numa_local_) {
+        BindToLocalNode(data, mapped_size);
+    }
+
+    buffer->data = data;
+    buffer->capacity = mapped_size;
+    buffer->mapped_size = mapped_size;
+#else
+    size_t aligned_size = (size + kAlignment - 1) / kAlignment * kAlignment;
+    void* data = nullptr;
+    if (posix_memalign(&data, kAlignment, aligned_size) != 0) {
+        LOG(FATAL) << "Failed to allocate a " << aligned_size
+                   << " bytes frame buffer";
+    }
+    buffer->data = data;
+    buffer->capacity = aligned_size;
+    buffer->mapped_size = 0;
+#endif  // __linux__
+}
+
+void FrameBufferArena::Free(Buffer* buffer) {
+    if (!buffer->data) {
+        return;
+    }
+#ifdef __linux__
+    munmap(buffer->data, buffer->mapped_size);
+#else
+    free(buffer->data);
+#endif  // __linux__
+    *buffer = Buffer();
+}
@@ -0,0 +1,67 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Arena for the large per-frame buffers of the command line tool.
+//
+// Buffers are uninitialized (the DSP blocks overwrite them anyway), aligned on
+// a cache line, optionally backed by transparent or explicit huge pages, and
+// bound to the NUMA node of the thread which allocates them. They are kept
+// around and reused by subsequent frames, so that the page faults are only
+// paid once.
+
+#ifndef FRAME_BUFFER_ARENA_H_
+#define FRAME_BUFFER_ARENA_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum class HugePages { kNone, kTransparent, kExplicit };
+
+// Parses "none", "transparent" or "explicit".
+bool ParseHugePages(const std::string& text, HugePages* huge_pages);
+
+class FrameBufferArena {
+   public:
+    static constexpr size_t kAlignment = 64;
+
+    explicit FrameBufferArena(HugePages huge_pages = HugePages::kNone,
+                              bool numa_local = true);
+    ~FrameBufferArena();
+
+    FrameBufferArena(const FrameBufferArena&) = delete;
+    FrameBufferArena& operator=(const FrameBufferArena&) = delete;
+
+    // Returns an uninitialized buffer of at least size bytes for the given
+    // slot. The buffer previously returned for this slot is reused when it is
+    // large enough, and its content is then preserved.
+    void* Get(size_t slot, size_t size);
+
+    template <typename T>
+    T* Get(size_t slot, size_t count) {
+        return static_cast<T*>(Get(slot, count * sizeof(T)));
+    }
+
+    // Frees all the buffers.
+    void Release();
+
+    // Total size of the buffers currently held.
+    size_t capacity() const;
+
+   private:
+    struct Buffer {
+        void* data = nullptr;
+        size_t capacity = 0;
+        size_t mapped_size = 0;  // 0 if not allocated with mmap.
+    };
+
+    void Allocate(Buffer* buffer, size_t size);
+    void Free(Buffer* buffer);
+
+    HugePages huge_pages_;
+    bool numa_local_;
+    std::vector<Buffer> buffers_;
+};
+
+#endif  // FRAME_BUFFER_ARENA_H_
@@ -0,0 +1,345 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Multi-frame container.
+
+#include "frame_container.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "absl/log/log.h"
+
+namespace {
+
+const char kMagic[8] = {'E', 'A', 'F', 'R', 'A', 'M', 'E', 'S'};
+const uint32_t kVersion = 1;
+const uint32_t kSampleFormatInt16 = 1;
+
+const size_t kHeaderSize = 64;
+const size_t kEntrySize = 256;
+const size_t kAlignment = 64;
+
+const size_t kEntryParametersOffset = 8;
+const size_t kEntryRegionsOffset = 128;
+const size_t kEntryNameOffset = 192;
+const size_t kMaxNameSize = kEntrySize - kEntryNameOffset - 1;
+
+const size_t kPairSize = 2 * sizeof(int16_t);
+
+// I/Q pairs converted and written at once.
+const size_t kChunkSize = 4096;
+
+void PutHeader(uint32_t num_frames, uint64_t index_offset, uint8_t* p) {
+    memset(p, 0, kHeaderSize);
+    memcpy(p, kMagic, sizeof(kMagic));
+    PutU32(kVersion, p + 8);
+    PutU32(kSampleFormatInt16, p + 12);
+    PutU32(num_frames, p + 16);
+    PutU32(kEntrySize, p + 20);
+    PutU64(index_offset, p + 24);
+}
+
+}  // namespace
+
+void PutU32(uint32_t value, uint8_t* p) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void PutU64(uint64_t value, uint8_t* p) {
+    PutU32(static_cast<uint32_t>(value), p);
+    PutU32(static_cast<uint32_t>(value >> 32), p + 4);
+}
+
+void PutFloat(float value, uint8_t* p) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    PutU32(bits, p);
+}
+
+uint32_t GetU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+}
+
+uint64_t GetU64(const uint8_t* p) {
+    return GetU32(p) | (uint64_t(GetU32(p + 4)) << 32);
+}
+
+float GetFloat(const uint8_t* p) {
+    uint32_t bits = GetU32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void SerializeParameters(const dsp_parameter_t& parameters, uint8_t* p) {
+    const uint32_t values[] = {
+        parameters.sample_rate,      parameters.symbol_rate,
+        parameters.zc_rate,          parameters.num_symbols,
+        parameters.num_null_symbols, parameters.zc_length,
+        parameters.zc_root,          parameters.zc_shift,
+        parameters.shift_frequency,  parameters.symbol_scale,
+        parameters.symbol_max_value, parameters.symbol_clamp,
+        parameters.pilot_frequency[0],
+        parameters.pilot_frequency[1],
+    };
+    for (uint32_t value : values) {
+        PutU32(value, p);
+        p += 4;
+    }
+    PutFloat(parameters.pilot_amplitude[0], p);
+    PutFloat(parameters.pilot_amplitude[1], p + 4);
+    PutFloat(parameters.rrc_roll_off, p + 8);
+}
+
+void DeserializeParameters(const uint8_t* p, dsp_parameter_t* parameters) {
+    parameters->sample_rate = GetU32(p);
+    parameters->symbol_rate = GetU32(p + 4);
+    parameters->zc_rate = GetU32(p + 8);
+    parameters->num_symbols = GetU32(p + 12);
+    parameters->num_null_symbols = GetU32(p + 16);
+    parameters->zc_length = GetU32(p + 20);
+    parameters->zc_root = GetU32(p + 24);
+    parameters->zc_shift = GetU32(p + 28);
+    parameters->shift_frequency = GetU32(p + 32);
+    parameters->symbol_scale = GetU32(p + 36);
+    parameters->symbol_max_value = GetU32(p + 40);
+    parameters->symbol_clamp = GetU32(p + 44) != 0;
+    parameters->pilot_frequency[0] = GetU32(p + 48);
+    parameters->pilot_frequency[1] = GetU32(p + 52);
+    parameters->pilot_amplitude[0] = GetFloat(p + 56);
+    parameters->pilot_amplitude[1] = GetFloat(p + 60);
+    parameters->rrc_roll_off = GetFloat(p + 64);
+}
+
+FrameContainerWriter::~FrameContainerWriter() {
+    if (file_.is_open()) {
+        Close();
+    }
+}
+
+bool FrameContainerWriter::Open(const std::string& file_name) {
+    file_.open(file_name, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        LOG(ERROR) << "Failed to open " << file_name;
+        return false;
+    }
+    file_name_ = file_name;
+    entries_.clear();
+
+    // Rewritten by Close, once the index is known.
+    uint8_t header[kHeaderSize];
+    PutHeader(0, 0, header);
+    file_.write(reinterpret_cast<const char*>(header), kHeaderSize);
+    position_ = kHeaderSize;
+    return file_.good();
+}
+
+void FrameContainerWriter::Pad() {
+    static const char zeros[kAlignment] = {0};
+    size_t padding = (kAlignment - position_ % kAlignment) % kAlignment;
+    file_.write(zeros, padding);
+    position_ += padding;
+}
+
+void FrameContainerWriter::WriteRegion(const iq_sample_t* samples,
+                                       size_t size,
+                                       FrameContainerEntry* entry,
+                                       FrameRegion region) {
+    Pad();
+    entry->offset[static_cast<size_t>(region)] = position_;
+    entry->size[static_cast<size_t>(region)] = size;
+
+    int16_t chunk[2 * kChunkSize];
+    for (size_t i = 0; i < size; i += kChunkSize) {
+        size_t n = std::min(kChunkSize, size - i);
+        for (size_t j = 0; j < n; ++j) {
+            chunk[2 * j] = static_cast<int16_t>(samples[i + j].i);
+            chunk[2 * j + 1] = static_cast<int16_t>(samples[i + j].q);
+        }
+        file_.write(reinterpret_cast<const char*>(chunk), n * kPairSize);
+    }
+    position_ += size * kPairSize;
+}
+
+bool FrameContainerWriter::Append(const FrameConfig& config,
+                                  const Frame& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    FrameContainerEntry entry;
+    entry.name = config.name.substr(0, kMaxNameSize);
+    entry.seed = config.seed;
+    entry.parameters = config.parameters;
+
+    const dsp_memory_plan_t& plan = frame.plan;
+    const iq_sample_t* samples = frame.samples;
+    WriteRegion(samples, plan.num_samples_zc, &entry, FrameRegion::kZc);
+    samples += plan.num_samples_zc;
+    WriteRegion(samples, plan.num_samples_qd, &entry,
+                FrameRegion::kQuantumData);
+    samples += plan.num_samples_qd;
+    WriteRegion(samples, plan.num_samples_tail, &entry, FrameRegion::kTail);
+    WriteRegion(frame.symbols, plan.num_symbols, &entry,
+                FrameRegion::kSymbols);
+
+    entries_.push_back(entry);
+    if (!file_) {
+        LOG(ERROR) << "Failed to write " << file_name_;
+        return false;
+    }
+    return true;
+}
+
+bool FrameContainerWriter::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    Pad();
+    const uint64_t index_offset = position_;
+    for (const FrameContainerEntry& entry : entries_) {
+        uint8_t e[kEntrySize] = {0};
+        PutU32(entry.seed, e);
+        SerializeParameters(entry.parameters, e + kEntryParametersOffset);
+        for (size_t i = 0; i < kNumFrameRegions; ++i) {
+            PutU64(entry.offset[i], e + kEntryRegionsOffset + 16 * i);
+            PutU64(entry.size[i], e + kEntryRegionsOffset + 16 * i + 8);
+        }
+        memcpy(e + kEntryNameOffset, entry.name.data(), entry.name.size());
+        file_.write(reinterpret_cast<const char*>(e), kEntrySize);
+    }
+
+    uint8_t header[kHeaderSize];
+    PutHeader(static_cast<uint32_t>(entries_.size()), index_offset, header);
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(header), kHeaderSize);
+    file_.close();
+
+    bool success = !file_.fail();
+    if (!success) {
+        LOG(ERROR) << "Failed to write " << file_name_;
+    }
+    return success;
+}
+
+FrameContainerReader::~FrameContainerReader() {
+    Close();
+}
+
+bool FrameContainerReader::Open(const std::string& file_name,
+                                std::string* error) {
+    Close();
+
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        *error = "failed to open " + file_name;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)kHeaderSize) {
+        close(fd);
+        *error = "truncated header";
+        return false;
+    }
+    size_t size = st.st_size;
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        *error = "failed to map " + file_name;
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(data);
+    size_ = size;
+
+    const uint8_t* header = data_;
+    const uint32_t num_frames = GetU32(header + 16);
+    const uint64_t index_offset = GetU64(header + 24);
+    const char* failure = nullptr;
+    if (memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+        failure = "not a frame container";
+    } else if (GetU32(header + 8) != kVersion) {
+        failure = "unsupported version";
+    } else if (GetU32(header + 12) != kSampleFormatInt16) {
+        failure = "unsupported sample format";
+    } else if (GetU32(header + 20) != kEntrySize) {
+        failure = "invalid index entry size";
+    } else if (index_offset < kHeaderSize || index_offset > size_ ||
+               (size_ - index_offset) / kEntrySize < num_frames) {
+        failure = "truncated index";
+    }
+    if (failure) {
+        *error = failure;
+        Close();
+        return false;
+    }
+
+    entries_.resize(num_frames);
+    for (size_t i = 0; i < num_frames; ++i) {
+        const uint8_t* e = data_ + index_offset + i * kEntrySize;
+        FrameContainerEntry& entry = entries_[i];
+        entry.seed = GetU32(e);
+        DeserializeParameters(e + kEntryParametersOffset, &entry.parameters);
+        const char* name =
+            reinterpret_cast<const char*>(e + kEntryNameOffset);
+        entry.name.assign(name, strnlen(name, kMaxNameSize));
+        for (size_t j = 0; j < kNumFrameRegions; ++j) {
+            uint64_t offset = GetU64(e + kEntryRegionsOffset + 16 * j);
+            uint64_t pairs = GetU64(e + kEntryRegionsOffset + 16 * j + 8);
+            if (offset % kAlignment || offset < kHeaderSize ||
+                offset > index_offset ||
+                pairs > (index_offset - offset) / kPairSize) {
+                *error = "invalid region in frame " + std::to_string(i);
+                Close();
+                return false;
+            }
+            entry.offset[j] = offset;
+            entry.size[j] = pairs;
+        }
+    }
+    return true;
+}
+
+void FrameContainerReader::Close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+    entries_.clear();
+}
+
+const int16_t* FrameContainerReader::Region(size_t index, FrameRegion region,
+                                            size_t* size) const {
+    const FrameContainerEntry& entry = entries_[index];
+    *size = entry.size[static_cast<size_t>(region)];
+    return reinterpret_cast<const int16_t*>(
+        data_ + entry.offset[static_cast<size_t>(region)]);
+}
+
+size_t FrameContainerReader::num_samples(size_t index) const {
+    const FrameContainerEntry& entry = entries_[index];
+    return entry.size[0] + entry.size[1] + entry.size[2];
+}
+
+void FrameContainerReader::CopySamples(size_t index, int16_t* out) const {
+    const FrameRegion regions[] = {FrameRegion::kZc, FrameRegion::kQuantumData,
+                                   FrameRegion::kTail};
+    for (FrameRegion region : regions) {
+        size_t size;
+        const int16_t* samples = Region(index, region, &size);
+        memcpy(out, samples, size * kPairSize);
+        out += 2 * size;
+    }
+}
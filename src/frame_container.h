@@ -0,0 +1,139 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Multi-frame container: frames with the parameters which produced them, and
+// an index giving the location of their regions (ZC sequence, quantum data,
+// null tail, symbols). Every region is stored as interleaved int16 I/Q pairs,
+// aligned on 64 bytes, so that a memory-mapped container can be sliced
+// without any parsing or copy.
+//
+// Layout (little-endian):
+//   Header (64 bytes): magic "EAFRAMES", version (uint32), sample format
+//   (uint32, 1: int16 I/Q pairs), number of frames (uint32), size of an
+//   index entry (uint32), offset of the index (uint64), then zeros.
+//   Regions of the frames, each one aligned on 64 bytes.
+//   Index: one 256-byte entry per frame:
+//     0    seed (uint32), 4 reserved bytes
+//     8    parameters, in the order of dsp_parameter_t, as 17 uint32 or
+//          float32 (symbol_clamp as a uint32)
+//     128  offset (bytes) and size (pairs) of the ZC sequence, quantum data,
+//          tail and symbols regions (uint64 each)
+//     192  name, NUL-padded (64 bytes)
+//
+// The index is written last, so frames can be appended as they are
+// generated.
+
+#ifndef FRAME_CONTAINER_H_
+#define FRAME_CONTAINER_H_
+
+extern "C" {
+#include "dsp/dsp_parameters.h"
+}
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "frame_generator.h"
+
+enum class FrameRegion { kZc = 0, kQuantumData, kTail, kSymbols };
+
+const size_t kNumFrameRegions = 4;
+
+// Parameters in the layout of an index entry, also used by the frame service
+// (frame_service.h).
+const size_t kSerializedParametersSize = 68;
+
+void SerializeParameters(const dsp_parameter_t& parameters, uint8_t* p);
+void DeserializeParameters(const uint8_t* p, dsp_parameter_t* parameters);
+
+// Little-endian fields of the container, frame service and capture
+// checkpoint headers.
+void PutU32(uint32_t value, uint8_t* p);
+void PutU64(uint64_t value, uint8_t* p);
+void PutFloat(float value, uint8_t* p);
+uint32_t GetU32(const uint8_t* p);
+uint64_t GetU64(const uint8_t* p);
+float GetFloat(const uint8_t* p);
+
+struct FrameContainerEntry {
+    std::string name;
+    uint32_t seed = 0;
+    dsp_parameter_t parameters = {};
+
+    // Offset in bytes and number of I/Q pairs of each region.
+    uint64_t offset[kNumFrameRegions] = {0};
+    uint64_t size[kNumFrameRegions] = {0};
+};
+
+// Appends frames to a new container. Append is thread-safe; frames are
+// stored in the order of the calls.
+class FrameContainerWriter {
+   public:
+    FrameContainerWriter() = default;
+    ~FrameContainerWriter();
+
+    FrameContainerWriter(const FrameContainerWriter&) = delete;
+    FrameContainerWriter& operator=(const FrameContainerWriter&) = delete;
+
+    bool Open(const std::string& file_name);
+    bool Append(const FrameConfig& config, const Frame& frame);
+
+    // Writes the index. Returns false if any write failed.
+    bool Close();
+
+   private:
+    void WriteRegion(const iq_sample_t* samples, size_t size,
+                     FrameContainerEntry* entry, FrameRegion region);
+    void Pad();
+
+    std::mutex mutex_;
+    std::ofstream file_;
+    std::string file_name_;
+    uint64_t position_ = 0;
+    std::vector<FrameContainerEntry> entries_;
+};
+
+// Read-only access to a memory-mapped container.
+class FrameContainerReader {
+   public:
+    FrameContainerReader() = default;
+    ~FrameContainerReader();
+
+    FrameContainerReader(const FrameContainerReader&) = delete;
+    FrameContainerReader& operator=(const FrameContainerReader&) = delete;
+
+    // On failure (missing, truncated or corrupted file), returns false and
+    // sets error.
+    bool Open(const std::string& file_name, std::string* error);
+    void Close();
+
+    size_t num_frames() const { return entries_.size(); }
+    const FrameContainerEntry& frame(size_t index) const {
+        return entries_[index];
+    }
+
+    // Interleaved I/Q pairs of a region, in the mapped file; *size receives
+    // the number of pairs.
+    const int16_t* Region(size_t index, FrameRegion region,
+                          size_t* size) const;
+
+    // Number of samples of a frame (all regions but the symbols).
+    size_t num_samples(size_t index) const;
+
+    // Copies the samples of a frame, contiguously, to out (2 * num_samples
+    // values).
+    void CopySamples(size_t index, int16_t* out) const;
+
+   private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<FrameContainerEntry> entries_;
+};
+
+#endif  // FRAME_CONTAINER_H_
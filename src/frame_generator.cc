@@ -0,0 +1,583 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Generation of a complete QOSST-compatible frame.
+
+#include "frame_generator.h"
+
+extern "C" {
+#include "dsp/dsp_graph.h"
+#include "dsp/dsp_interpolator.h"
+#include "dsp/dsp_phasor_bank.h"
+#include "dsp/dsp_planar.h"
+#include "dsp/dsp_rng.h"
+#include "dsp/dsp_rrc_filter.h"
+#include "dsp/dsp_zc_generator.h"
+}
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "iq_codec.h"
+
+namespace {
+
+enum FrameBufferSlot {
+    FRAME_BUFFER_SYMBOLS,
+    FRAME_BUFFER_SAMPLES,
+    FRAME_BUFFER_DAC_SAMPLES,
+    FRAME_BUFFER_SYMBOLS_I,
+    FRAME_BUFFER_SYMBOLS_Q,
+    FRAME_BUFFER_SAMPLES_I,
+    FRAME_BUFFER_SAMPLES_Q,
+    FRAME_BUFFER_STAGE_I,
+    FRAME_BUFFER_STAGE_Q,
+    FRAME_BUFFER_NEXT_STAGE_I,
+    FRAME_BUFFER_NEXT_STAGE_Q,
+    FRAME_BUFFER_GRAPH,
+    FRAME_BUFFER_PROBE_RRC
+};
+
+#ifdef DSP_STATISTICS
+double Decibels(double power) { return 10.0 * log10(power); }
+#endif  // DSP_STATISTICS
+
+}  // namespace
+
+LutCache::~LutCache() {
+    dsp_lut_registry_release(phasor_);
+    for (const auto& entry : rrc_) {
+        dsp_lut_registry_release(entry.second);
+    }
+}
+
+const iq_sample_t* LutCache::phasor() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!phasor_) {
+        phasor_ = dsp_lut_registry_acquire_phasor();
+        CHECK(phasor_) << "Failed to build the phasor LUT";
+    }
+    return phasor_;
+}
+
+const sample_t* LutCache::rrc(float roll_off) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const sample_t*& table = rrc_[roll_off];
+    if (!table) {
+        table = dsp_lut_registry_acquire_rrc(roll_off);
+        CHECK(table) << "Failed to build the RRC LUT";
+    }
+    return table;
+}
+
+namespace {
+
+// Amplitude of the frequency shift.
+const float kShiftAmplitude = 0.70710678118f;
+
+// Capacity of the queue between the stages of a pipelined frame, in chunks.
+const size_t kPipelineQueueChunks = 8;
+
+void InitPhasorBank(const dsp_parameter_t& parameters, LutCache* luts,
+                    phasor_bank_state_t* phasor_bank) {
+    uint32_t frequencies[3] = {parameters.shift_frequency,
+                               parameters.pilot_frequency[0],
+                               parameters.pilot_frequency[1]};
+    float amplitudes[3] = {kShiftAmplitude, parameters.pilot_amplitude[0],
+                           parameters.pilot_amplitude[1]};
+    dsp_phasor_bank_init(phasor_bank, luts->phasor(),
+                         PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, frequencies,
+                         amplitudes, parameters.sample_rate);
+}
+
+// Returns false for the Gaussian symbols, which are not mapped.
+bool InitSymbolMapper(const FrameConfig& config, symbol_mapper_t* mapper) {
+    const Modulation& modulation = config.modulation;
+    if (modulation.type == DSP_MODULATION_GAUSSIAN) {
+        return false;
+    }
+    CHECK(dsp_symbol_mapper_init(mapper, modulation.type, modulation.order,
+                                 modulation.shaping,
+                                 config.parameters.symbol_scale,
+                                 config.parameters.symbol_max_value))
+        << "Invalid modulation";
+    return true;
+}
+
+// The RRC filter, at the sample rate or followed by the stages of a
+// multistage interpolator.
+void InitPulseShaping(const FrameConfig& config, LutCache* luts,
+                      interpolator_state_t* interpolator,
+                      rrc_filter_state_t* rrc_filter) {
+    const dsp_parameter_t& parameters = config.parameters;
+    CHECK(dsp_interpolator_init(interpolator, config.interpolation_stages,
+                                parameters.rrc_roll_off,
+                                parameters.symbol_rate,
+                                parameters.sample_rate))
+        << "Invalid number of interpolation stages";
+    dsp_interpolator_init_rrc(interpolator, rrc_filter,
+                              luts->rrc(parameters.rrc_roll_off),
+                              parameters.symbol_rate, parameters.sample_rate);
+}
+
+// Number of samples at the start of the output of the RRC filter, before the
+// peak of the impulse response of the first symbol, which are not
+// transmitted.
+size_t NumPrerollSamples(const dsp_parameter_t& parameters) {
+    return parameters.sample_rate / parameters.symbol_rate * 25 / 4;
+}
+
+// The frame, as a dataflow graph (see dsp/dsp_graph.h):
+//
+//   rng or mapper, zeros -> concat -> tap (symbols) -> rrc [-> half-bands]
+//     -> skip (preroll) [-> tap (rrc probe)] [-> queue]
+//     -> concat with zeros (tail) -> phasor bank
+//   zc, phasor bank -> concat (output)
+//
+// With config.pipeline, the queue separates the symbols and RRC filter,
+// generated by a second thread, from the rest.
+void GenerateSamples(const FrameConfig& config, LutCache* luts,
+                     FrameBufferArena* arena, iq_sample_t* symbols,
+                     iq_sample_t* samples, iq_sample_t* rrc_samples,
+                     Frame* frame) {
+    const dsp_parameter_t& parameters = config.parameters;
+    const dsp_memory_plan_t& plan = frame->plan;
+
+    rng_state_t rng_state;
+    dsp_rng_init(&rng_state, parameters.symbol_scale,
+                 parameters.symbol_max_value, parameters.symbol_clamp,
+                 config.seed, 0);
+    symbol_mapper_t mapper;
+    const bool mapped = InitSymbolMapper(config, &mapper);
+    interpolator_state_t interpolator;
+    rrc_filter_state_t rrc_state;
+    InitPulseShaping(config, luts, &interpolator, &rrc_state);
+    phasor_bank_state_t phasor_state;
+    InitPhasorBank(parameters, luts, &phasor_state);
+    zc_generator_state_t zc_state;
+    dsp_zc_generator_init(&zc_state, luts->phasor(), parameters.zc_length,
+                          parameters.zc_root, parameters.zc_shift,
+                          parameters.zc_rate, parameters.sample_rate);
+
+    dsp_graph_t graph;
+    dsp_graph_init(&graph, config.chunk_size);
+    graph.wait = [] { std::this_thread::yield(); };
+
+    const int random = mapped
+        ? dsp_graph_add_symbol_mapper(&graph, &mapper, &rng_state)
+        : dsp_graph_add_rng(&graph, &rng_state);
+    const int flush = dsp_graph_add_zeros(&graph);
+    const int symbol_inputs[2] = {random, flush};
+    const size_t symbol_lengths[2] = {parameters.num_symbols,
+                                      DSP_GRAPH_UNLIMITED};
+    const int all_symbols =
+        dsp_graph_add_concat(&graph, symbol_inputs, symbol_lengths, 2);
+    const int tap = dsp_graph_add_tap(&graph, all_symbols, symbols,
+                                      parameters.num_symbols);
+    int shaped = dsp_graph_add_rrc(
+        &graph, tap, &rrc_state, parameters.symbol_rate,
+        parameters.sample_rate >> interpolator.num_stages);
+    for (size_t s = 0; s < interpolator.num_stages; ++s) {
+        shaped = dsp_graph_add_half_band(&graph, shaped, &interpolator.stage[s]);
+    }
+    int quantum_data = dsp_graph_add_skip(
+        &graph, shaped,
+        NumPrerollSamples(parameters) + dsp_interpolator_delay(&interpolator));
+    if (rrc_samples) {
+        quantum_data = dsp_graph_add_tap(&graph, quantum_data, rrc_samples,
+                                         plan.num_samples_qd);
+    }
+    int queue = DSP_GRAPH_INVALID_NODE;
+    if (config.pipeline) {
+        queue = dsp_graph_add_queue(&graph, quantum_data,
+                                    kPipelineQueueChunks * graph.chunk_size);
+        quantum_data = queue;
+    }
+    const int tail = dsp_graph_add_zeros(&graph);
+    const int body_inputs[2] = {quantum_data, tail};
+    const size_t body_lengths[2] = {plan.num_samples_qd, DSP_GRAPH_UNLIMITED};
+    const int body = dsp_graph_add_concat(&graph, body_inputs, body_lengths, 2);
+    const int shifted = dsp_graph_add_phasor_bank(&graph, body, &phasor_state);
+    const int zc = dsp_graph_add_zc(&graph, &zc_state);
+    const int frame_inputs[2] = {zc, shifted};
+    const size_t frame_lengths[2] = {plan.num_samples_zc, DSP_GRAPH_UNLIMITED};
+    const int output =
+        dsp_graph_add_concat(&graph, frame_inputs, frame_lengths, 2);
+    CHECK(output != DSP_GRAPH_INVALID_NODE &&
+          (!config.pipeline || queue != DSP_GRAPH_INVALID_NODE));
+
+    dsp_graph_assign(&graph, arena->Get<char>(FRAME_BUFFER_GRAPH,
+                                              dsp_graph_memory_size(&graph)));
+
+    std::thread producer;
+    if (config.pipeline) {
+        producer = std::thread(dsp_graph_fill_queue, &graph, queue,
+                               plan.num_samples_qd);
+    }
+
+    // The regions are pulled in turn, so that the statistics of the phasor
+    // bank are kept apart.
+    const size_t region_size[3] = {plan.num_samples_zc, plan.num_samples_qd,
+                                   plan.num_samples_tail};
+    for (size_t region = 0; region < 3; ++region) {
+        dsp_graph_process(&graph, output, samples, region_size[region]);
+        samples += region_size[region];
+#ifdef DSP_STATISTICS
+        if (region) {
+            frame->statistics.region[region] = phasor_state.statistics;
+            dsp_signal_statistics_reset(&phasor_state.statistics);
+        }
+#endif  // DSP_STATISTICS
+    }
+    if (producer.joinable()) {
+        producer.join();
+    }
+
+#ifdef DSP_STATISTICS
+    frame->statistics.symbols = rng_state.statistics;
+    frame->statistics.region[DSP_FRAME_REGION_ZC] = zc_state.statistics;
+    frame->statistics.num_wrapped = phasor_state.num_wrapped;
+#endif  // DSP_STATISTICS
+}
+
+// The same chain on separate I and Q planes, block after block over the
+// whole frame, interleaved at the end.
+void GeneratePlanarSamples(const FrameConfig& config, LutCache* luts,
+                           FrameBufferArena* arena, iq_sample_t* symbols,
+                           iq_sample_t* samples, iq_sample_t* rrc_samples,
+                           Frame* frame) {
+    const dsp_parameter_t& parameters = config.parameters;
+    const dsp_memory_plan_t& plan = frame->plan;
+    const size_t num_samples_zc = plan.num_samples_zc;
+    const size_t num_samples_qd = plan.num_samples_qd;
+    const size_t num_samples_tail = plan.num_samples_tail;
+    const size_t num_samples = plan.num_samples;
+
+    interpolator_state_t interpolator;
+    rrc_filter_state_t rrc_state;
+    InitPulseShaping(config, luts, &interpolator, &rrc_state);
+    const size_t num_stages = interpolator.num_stages;
+    const size_t preroll =
+        NumPrerollSamples(parameters) + dsp_interpolator_delay(&interpolator);
+    const size_t num_shaped = preroll + num_samples_qd;
+
+    // The delay of an interpolator consumes more flush symbols.
+    const size_t num_planar_symbols = std::max(
+        plan.num_symbols,
+        DSP_PLAN_SYMBOLS_PER_BLOCK(num_shaped + (size_t{1} << num_stages),
+                                   parameters.symbol_rate,
+                                   parameters.sample_rate));
+    sample_t* symbols_i =
+        arena->Get<sample_t>(FRAME_BUFFER_SYMBOLS_I, num_planar_symbols);
+    sample_t* symbols_q =
+        arena->Get<sample_t>(FRAME_BUFFER_SYMBOLS_Q, num_planar_symbols);
+    sample_t* samples_i =
+        arena->Get<sample_t>(FRAME_BUFFER_SAMPLES_I, num_samples);
+    sample_t* samples_q =
+        arena->Get<sample_t>(FRAME_BUFFER_SAMPLES_Q, num_samples);
+
+    rng_state_t rng_state;
+    dsp_rng_init(&rng_state, parameters.symbol_scale,
+                 parameters.symbol_max_value, parameters.symbol_clamp,
+                 config.seed, 0);
+    symbol_mapper_t mapper;
+    if (InitSymbolMapper(config, &mapper)) {
+        dsp_symbol_mapper_process_planar(&mapper, &rng_state, symbols_i,
+                                         symbols_q, parameters.num_symbols);
+    } else {
+        dsp_rng_generate_icdf_planar(&rng_state, symbols_i, symbols_q,
+                                     parameters.num_symbols);
+    }
+#ifdef DSP_STATISTICS
+    frame->statistics.symbols = rng_state.statistics;
+#endif  // DSP_STATISTICS
+    for (size_t i = parameters.num_symbols; i < num_planar_symbols; ++i) {
+        symbols_i[i] = 0;
+        symbols_q[i] = 0;
+    }
+
+    // The RRC filter does not cover the tail: it only contains the pilots.
+    memset(&samples_i[num_samples_zc + num_samples_qd], 0,
+           num_samples_tail * sizeof(sample_t));
+    memset(&samples_q[num_samples_zc + num_samples_qd], 0,
+           num_samples_tail * sizeof(sample_t));
+
+    // With a multistage interpolator, the RRC filter and the stages but the
+    // last one write all their samples, preroll included, to intermediate
+    // planes. The last block drops the preroll by writing it to the quantum
+    // data first, then overwriting it.
+    const sample_t* in_i = symbols_i;
+    const sample_t* in_q = symbols_q;
+    if (num_stages) {
+        const size_t stage_size = (num_shaped + 1) / 2;
+        sample_t* stage_i =
+            arena->Get<sample_t>(FRAME_BUFFER_STAGE_I, stage_size);
+        sample_t* stage_q =
+            arena->Get<sample_t>(FRAME_BUFFER_STAGE_Q, stage_size);
+        sample_t* next_i =
+            arena->Get<sample_t>(FRAME_BUFFER_NEXT_STAGE_I, stage_size);
+        sample_t* next_q =
+            arena->Get<sample_t>(FRAME_BUFFER_NEXT_STAGE_Q, stage_size);
+        // Samples at the output of the stage before stage s.
+        auto size_before = [num_shaped, num_stages](size_t s) {
+            const size_t shift = num_stages - s;
+            return (num_shaped + (size_t{1} << shift) - 1) >> shift;
+        };
+        dsp_rrc_filter_process_planar(&rrc_state, symbols_i, symbols_q,
+                                      stage_i, stage_q, size_before(0));
+        for (size_t s = 0; s + 1 < num_stages; ++s) {
+            dsp_half_band_process_planar(&interpolator.stage[s], stage_i,
+                                         stage_q, next_i, next_q,
+                                         size_before(s + 1));
+            std::swap(stage_i, next_i);
+            std::swap(stage_q, next_q);
+        }
+        in_i = stage_i;
+        in_q = stage_q;
+    }
+    auto shape = [&](const sample_t* i, const sample_t* q, size_t size) {
+        sample_t* out_i = &samples_i[num_samples_zc];
+        sample_t* out_q = &samples_q[num_samples_zc];
+        return num_stages
+                   ? dsp_half_band_process_planar(
+                         &interpolator.stage[num_stages - 1], i, q, out_i,
+                         out_q, size)
+                   : dsp_rrc_filter_process_planar(&rrc_state, i, q, out_i,
+                                                   out_q, size);
+    };
+    size_t consumed = shape(in_i, in_q, preroll);
+    shape(&in_i[consumed], &in_q[consumed], num_samples_qd);
+    if (rrc_samples) {
+        dsp_planar_interleave(&samples_i[num_samples_zc],
+                              &samples_q[num_samples_zc], rrc_samples,
+                              num_samples_qd);
+    }
+
+    phasor_bank_state_t phasor_state;
+    InitPhasorBank(parameters, luts, &phasor_state);
+    // The quantum data and the tail are processed in turn, so that their
+    // statistics are kept apart.
+    const size_t region_size[2] = {num_samples_qd, num_samples_tail};
+    size_t offset = num_samples_zc;
+    for (size_t region = 0; region < 2; ++region) {
+        dsp_phasor_bank_process_planar(&phasor_state, &samples_i[offset],
+                                       &samples_q[offset],
+                                       region_size[region]);
+        offset += region_size[region];
+#ifdef DSP_STATISTICS
+        frame->statistics.region[DSP_FRAME_REGION_QD + region] =
+            phasor_state.statistics;
+        dsp_signal_statistics_reset(&phasor_state.statistics);
+#endif  // DSP_STATISTICS
+    }
+#ifdef DSP_STATISTICS
+    frame->statistics.num_wrapped = phasor_state.num_wrapped;
+#endif  // DSP_STATISTICS
+
+    zc_generator_state_t zc_state;
+    dsp_zc_generator_init(&zc_state, luts->phasor(), parameters.zc_length,
+                          parameters.zc_root, parameters.zc_shift,
+                          parameters.zc_rate, parameters.sample_rate);
+    dsp_zc_generator_process_planar(&zc_state, samples_i, samples_q,
+                                    num_samples_zc);
+#ifdef DSP_STATISTICS
+    frame->statistics.region[DSP_FRAME_REGION_ZC] = zc_state.statistics;
+#endif  // DSP_STATISTICS
+
+    dsp_planar_interleave(samples_i, samples_q, samples, num_samples);
+    dsp_planar_interleave(symbols_i, symbols_q, symbols, plan.num_symbols);
+}
+
+}  // namespace
+
+Frame GenerateFrame(const FrameConfig& config, LutCache* luts,
+                    FrameBufferArena* arena, bool log_progress) {
+    Frame frame;
+    dsp_memory_plan_frame(&frame.plan, &config.parameters);
+
+    // The symbols are followed by the zeros which flush the RRC filter.
+    iq_sample_t* symbols =
+        arena->Get<iq_sample_t>(FRAME_BUFFER_SYMBOLS, frame.plan.num_symbols);
+    for (size_t i = config.parameters.num_symbols; i < frame.plan.num_symbols;
+         ++i) {
+        symbols[i] = iq_sample_t{0, 0};
+    }
+    iq_sample_t* samples =
+        arena->Get<iq_sample_t>(FRAME_BUFFER_SAMPLES, frame.plan.num_samples);
+    iq_sample_t* rrc_samples = nullptr;
+    if (config.probes & (1 << static_cast<int>(ProbePoint::kRrc))) {
+        rrc_samples = arena->Get<iq_sample_t>(FRAME_BUFFER_PROBE_RRC,
+                                              frame.plan.num_samples_qd);
+    }
+
+    if (log_progress) LOG(INFO) << "Generating symbols and IQ samples...";
+    if (config.planar) {
+        GeneratePlanarSamples(config, luts, arena, symbols, samples,
+                              rrc_samples, &frame);
+    } else {
+        GenerateSamples(config, luts, arena, symbols, samples, rrc_samples,
+                        &frame);
+    }
+    if (log_progress) LOG(INFO) << "Done...";
+
+    frame.symbols = symbols;
+    frame.samples = samples;
+    frame.rrc_samples = rrc_samples;
+    return frame;
+}
+
+namespace {
+
+void WriteSymbols(const Frame& frame, std::ostream& out) {
+    for (size_t i = 0; i < frame.plan.num_symbols; ++i) {
+        out << frame.symbols[i].i << '\t' << frame.symbols[i].q << '\n';
+    }
+}
+
+bool WriteFile(const std::string& file_name, const char* data, size_t size) {
+    std::ofstream file(file_name, std::ios::binary);
+    if (!file) {
+        LOG(ERROR) << "Failed to open " << file_name;
+        return false;
+    }
+    file.write(data, size);
+    return static_cast<bool>(file);
+}
+
+bool WriteCompressedFile(const std::string& file_name, const char* data,
+                         size_t size, IqCodecStream stream,
+                         size_t num_threads) {
+    IqCodecOptions options;
+    options.num_threads = num_threads;
+    std::string compressed = IqCodecCompress(data, size, stream, options);
+    return WriteFile(file_name + kIqCodecExtension, compressed.data(),
+                     compressed.size());
+}
+
+}  // namespace
+
+#ifdef DSP_STATISTICS
+void LogFrameStatistics(const std::string& name,
+                        const dsp_frame_statistics_t& statistics) {
+    const std::string prefix = (name.empty() ? "Frame" : name) + ": ";
+    const dsp_symbol_statistics_t& symbols = statistics.symbols;
+    LOG(INFO) << prefix << symbols.num_symbols << " symbols, variance "
+              << dsp_symbol_statistics_variance(&symbols, 0) << " (I) "
+              << dsp_symbol_statistics_variance(&symbols, 1) << " (Q), "
+              << symbols.num_rejected << " rejected, " << symbols.num_clamped
+              << " clamped";
+
+    static const char* const kRegionNames[DSP_FRAME_NUM_REGIONS] = {
+        "ZC", "QD", "tail"};
+    std::ostringstream power;
+    power.setf(std::ios::fixed);
+    power.precision(2);
+    for (size_t i = 0; i < DSP_FRAME_NUM_REGIONS; ++i) {
+        const dsp_signal_statistics_t& region = statistics.region[i];
+        double peak = dsp_signal_statistics_peak_magnitude(&region);
+        power << (i ? ", " : "") << kRegionNames[i] << " "
+              << Decibels(dsp_signal_statistics_mean_power(&region)) << "/"
+              << Decibels(peak * peak);
+    }
+    LOG(INFO) << prefix << "power (dBFS, mean/peak) " << power.str() << ", "
+              << statistics.num_wrapped << " samples wrapped by the pilot add";
+}
+#endif  // DSP_STATISTICS
+
+bool ParseSampleFormat(const std::string& text, dsp_sample_format_t* format) {
+    static const char* const kNames[DSP_NUM_SAMPLE_FORMATS] = {
+        "int16", "packed14", "packed12", "cf32", "cf16"};
+    for (int i = 0; i < DSP_NUM_SAMPLE_FORMATS; ++i) {
+        if (text == kNames[i]) {
+            *format = static_cast<dsp_sample_format_t>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseModulation(const std::string& text, dsp_modulation_t* modulation) {
+    static const char* const kNames[DSP_NUM_MODULATIONS] = {"gaussian", "psk",
+                                                            "qam"};
+    for (int i = 0; i < DSP_NUM_MODULATIONS; ++i) {
+        if (text == kNames[i]) {
+            *modulation = static_cast<dsp_modulation_t>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IsValidModulation(const Modulation& modulation) {
+    if (modulation.type == DSP_MODULATION_GAUSSIAN) {
+        return true;
+    }
+    symbol_mapper_t mapper;
+    return dsp_symbol_mapper_init(&mapper, modulation.type, modulation.order,
+                                  modulation.shaping, 1, 1);
+}
+
+bool IsValidInterpolation(const dsp_parameter_t& parameters,
+                          size_t num_stages) {
+    interpolator_state_t interpolator;
+    return dsp_interpolator_init(&interpolator, num_stages,
+                                 parameters.rrc_roll_off,
+                                 parameters.symbol_rate,
+                                 parameters.sample_rate);
+}
+
+bool WriteFrame(const FrameConfig& config, const Frame& frame,
+                FrameBufferArena* arena, size_t num_threads) {
+    const SampleFormat& output_format = config.output_format;
+    if (config.compress && output_format.format != DSP_SAMPLE_FORMAT_INT16) {
+        LOG(ERROR) << config.output
+                   << ": only int16 samples can be compressed";
+        return false;
+    }
+
+    // The conversion to the output format is the only pass over the samples.
+    const size_t num_samples = frame.plan.num_samples;
+    sample_format_state_t format;
+    dsp_sample_format_init(&format, output_format.format, output_format.scale,
+                           output_format.saturation);
+    const size_t dac_size =
+        dsp_sample_format_size(output_format.format, num_samples);
+    char* dac_bytes = arena->Get<char>(FRAME_BUFFER_DAC_SAMPLES, dac_size);
+    dsp_sample_format_process(&format, frame.samples, dac_bytes, num_samples);
+
+    bool success = true;
+
+    if (config.compress) {
+        std::ostringstream symbols;
+        WriteSymbols(frame, symbols);
+        const std::string text = symbols.str();
+        success &= WriteCompressedFile(config.output_symbols, text.data(),
+                                       text.size(), IqCodecStream::kSymbols,
+                                       num_threads);
+        success &= WriteCompressedFile(config.output, dac_bytes, dac_size,
+                                       IqCodecStream::kIq, num_threads);
+        return success;
+    }
+
+    // Write TSV
+    std::ofstream symbols_file(config.output_symbols);
+    if (!symbols_file) {
+        LOG(ERROR) << "Failed to open " << config.output_symbols;
+        success = false;
+    } else {
+        WriteSymbols(frame, symbols_file);
+    }
+
+    // Write binary samples
+    success &= WriteFile(config.output, dac_bytes, dac_size);
+    return success;
+}
@@ -0,0 +1,178 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Generation of a complete QOSST-compatible frame (ZC sync sequence, quantum
+// data, null tail) with all the DSP blocks, and export to files.
+
+#ifndef FRAME_GENERATOR_H_
+#define FRAME_GENERATOR_H_
+
+extern "C" {
+#include "dsp/dsp_graph.h"
+#include "dsp/dsp_lut_registry.h"
+#include "dsp/dsp_memory_plan.h"
+#include "dsp/dsp_parameters.h"
+#include "dsp/dsp_sample_format.h"
+#include "dsp/dsp_statistics.h"
+#include "dsp/dsp_symbol_mapper.h"
+#include "dsp/dsp_types.h"
+}
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "frame_buffer_arena.h"
+
+// Format of the samples written to the output file (see
+// dsp/dsp_sample_format.h).
+struct SampleFormat {
+    dsp_sample_format_t format = DSP_SAMPLE_FORMAT_INT16;
+    float scale = 1.0f;
+    int32_t saturation = SAMPLE_FORMAT_NO_SATURATION;  // In int16 units.
+};
+
+// Parses int16, packed14, packed12, cf32 or cf16.
+bool ParseSampleFormat(const std::string& text, dsp_sample_format_t* format);
+
+// Intermediate signals of the pipeline, exported for the testbenches of
+// hardware ports (see probe_export.h).
+enum class ProbePoint {
+    kSymbols = 0,  // Output of the RNG or symbol mapper, flush zeros included.
+    kRrc,          // Pulse-shaped quantum data, before the phasor bank.
+    kPhasorBank,   // Output of the phasor bank: quantum data and tail.
+    kZc            // ZC sequence.
+};
+
+const size_t kNumProbePoints = 4;
+
+// Binary: interleaved int16 I/Q. Hex: one sample per line, as the 8 hex
+// digits of I then Q (16-bit two's complement), for $readmemh. TSV: one
+// sample per line, I and Q in decimal.
+enum class ProbeFormat { kBinary = 0, kHex, kTsv };
+
+// Modulation of the symbols (see dsp/dsp_symbol_mapper.h).
+struct Modulation {
+    dsp_modulation_t type = DSP_MODULATION_GAUSSIAN;
+    size_t order = 4;      // PSK and QAM.
+    float shaping = 0.0f;  // QAM.
+};
+
+// Parses gaussian, psk or qam.
+bool ParseModulation(const std::string& text, dsp_modulation_t* modulation);
+
+// Returns false if the order or shaping is not supported by the modulation.
+// Always true for the Gaussian modulation.
+bool IsValidModulation(const Modulation& modulation);
+
+// Returns false if a multistage interpolator of num_stages stages can't be
+// used with these parameters (see dsp_interpolator_init). Always true for 0
+// stages.
+bool IsValidInterpolation(const dsp_parameter_t& parameters,
+                          size_t num_stages);
+
+struct FrameConfig {
+    std::string name;
+    dsp_parameter_t parameters;
+    uint32_t seed = 1;
+    Modulation modulation;
+
+    std::string output;          // I/Q samples, in output_format.
+    std::string output_symbols;  // Symbols, TSV.
+    SampleFormat output_format;
+
+    // Compress the output files with the lossless codec (iq_codec.h). The
+    // extension kIqCodecExtension is appended to their names. Only with the
+    // int16 output format.
+    bool compress = false;
+
+    // Run the DSP chain on separate I and Q planes (see dsp/dsp_planar.h)
+    // rather than on interleaved samples. The samples are identical.
+    bool planar = false;
+
+    // The interleaved chain runs as a dataflow graph (dsp/dsp_graph.h), by
+    // chunks of chunk_size samples. With pipeline, the symbols and RRC
+    // filter are computed by a second thread.
+    size_t chunk_size = DSP_GRAPH_DEFAULT_CHUNK_SIZE;
+    bool pipeline = false;
+
+    // Pulse shaping: 0 for the direct RRC filter at the sample rate, or the
+    // number of half-band stages of a multistage interpolator (see
+    // dsp/dsp_interpolator.h), whose samples differ slightly from the direct
+    // ones (see MeasureInterpolation() in frame_verifier.h).
+    size_t interpolation_stages = 0;
+
+    // Check the frame with the loopback verifier (frame_verifier.h) before
+    // writing it; a frame which fails is not written.
+    bool verify = false;
+
+    // Probe points exported, as a bit mask of 1 << ProbePoint, to files
+    // named probe_prefix + the name of the point (see probe_export.h). Only
+    // kRrc adds a copy to the generation; the others are read from the
+    // frame.
+    uint32_t probes = 0;
+    ProbeFormat probe_format = ProbeFormat::kBinary;
+    std::string probe_prefix;
+};
+
+// Read-only LUTs used by the frames generated with this cache. The tables
+// come from the process-wide registry (dsp/dsp_lut_registry.h), so that they
+// are built once and shared by all the caches, and are released with the
+// cache. They can be used concurrently by any number of threads.
+class LutCache {
+   public:
+    LutCache() = default;
+    ~LutCache();
+
+    LutCache(const LutCache&) = delete;
+    LutCache& operator=(const LutCache&) = delete;
+
+    // The phasor LUT, filled.
+    const iq_sample_t* phasor();
+
+    const sample_t* rrc(float roll_off);
+
+   private:
+    std::mutex mutex_;
+    const iq_sample_t* phasor_ = nullptr;
+    std::map<float, const sample_t*> rrc_;
+};
+
+// Buffers holding a generated frame, owned by the arena passed to
+// GenerateFrame.
+struct Frame {
+    dsp_memory_plan_t plan;
+    const iq_sample_t* symbols;  // plan.num_symbols symbols.
+    const iq_sample_t* samples;  // plan.num_samples samples.
+
+    // With the kRrc probe, plan.num_samples_qd samples. Otherwise null.
+    const iq_sample_t* rrc_samples;
+#ifdef DSP_STATISTICS
+    dsp_frame_statistics_t statistics;  // See dsp/dsp_statistics.h.
+#endif  // DSP_STATISTICS
+};
+
+// Generates a frame, in buffers taken from (and reused by) arena.
+Frame GenerateFrame(const FrameConfig& config, LutCache* luts,
+                    FrameBufferArena* arena, bool log_progress);
+
+#ifdef DSP_STATISTICS
+// Logs the statistics of a frame: symbol variance, rejected and clamped
+// symbols, mean power and peak magnitude of each region (dBFS), and samples
+// wrapped by the pilot add.
+void LogFrameStatistics(const std::string& name,
+                        const dsp_frame_statistics_t& statistics);
+#endif  // DSP_STATISTICS
+
+// Writes the frame to config.output (converted to config.output_format) and
+// config.output_symbols. Returns false if one of the files could not be
+// written. num_threads is the number of
+// threads compressing the files (0: one per hardware thread).
+bool WriteFrame(const FrameConfig& config, const Frame& frame,
+                FrameBufferArena* arena, size_t num_threads);
+
+#endif  // FRAME_GENERATOR_H_
@@ -0,0 +1,526 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Frame service.
+
+#include "frame_service.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "absl/log/log.h"
+#include "frame_container.h"
+
+namespace {
+
+const char kRequestMagic[8] = {'E', 'A', 'F', 'R', 'M', 'R', 'E', 'Q'};
+const char kResponseMagic[8] = {'E', 'A', 'F', 'R', 'M', 'R', 'S', 'P'};
+const uint32_t kVersion = 1;
+
+const size_t kRequestSize = 128;
+const size_t kResponseSize = 128;
+
+const size_t kRequestParametersOffset = 32;
+const size_t kResponseErrorOffset = 72;
+const size_t kMaxErrorSize = kResponseSize - kResponseErrorOffset - 1;
+
+const uint32_t kFlagSymbols = 1;
+
+// Alignment of the symbols in the memfd.
+const size_t kAlignment = 64;
+
+// Returns false on error or end of stream.
+bool ReadFully(int fd, uint8_t* data, size_t size) {
+    while (size) {
+        ssize_t n = read(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool WriteFully(int fd, const uint8_t* data, size_t size) {
+    while (size) {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Sends data, with file_fd attached if it is not -1.
+bool SendWithFd(int fd, const uint8_t* data, size_t size, int file_fd) {
+    if (file_fd < 0) {
+        return WriteFully(fd, data, size);
+    }
+    struct iovec iov;
+    iov.iov_base = const_cast<uint8_t*>(data);
+    iov.iov_len = size;
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(header), &file_fd, sizeof(int));
+
+    ssize_t n;
+    do {
+        n = sendmsg(fd, &message, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        return false;
+    }
+    // The descriptor went with the first byte.
+    return WriteFully(fd, data + n, size - n);
+}
+
+// Receives size bytes, and the descriptor attached to them (-1 if none).
+bool ReceiveWithFd(int fd, uint8_t* data, size_t size, int* file_fd) {
+    *file_fd = -1;
+    struct iovec iov;
+    iov.iov_base = data;
+    iov.iov_len = size;
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        return false;
+    }
+    for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); header;
+         header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET &&
+            header->cmsg_type == SCM_RIGHTS) {
+            memcpy(file_fd, CMSG_DATA(header), sizeof(int));
+        }
+    }
+    if (!ReadFully(fd, data + n, size - n)) {
+        if (*file_fd >= 0) {
+            close(*file_fd);
+            *file_fd = -1;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool MakeAddress(const std::string& socket_path, struct sockaddr_un* address,
+                 std::string* error) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (socket_path.empty() ||
+        socket_path.size() >= sizeof(address->sun_path)) {
+        *error = "Invalid socket path: " + socket_path;
+        return false;
+    }
+    memcpy(address->sun_path, socket_path.data(), socket_path.size());
+    return true;
+}
+
+void PutRequest(const FrameRequest& request, uint8_t* p) {
+    memset(p, 0, kRequestSize);
+    memcpy(p, kRequestMagic, sizeof(kRequestMagic));
+    PutU32(kVersion, p + 8);
+    PutU32(request.seed, p + 12);
+    PutU32(request.output_format.format, p + 16);
+    PutFloat(request.output_format.scale, p + 20);
+    PutU32(static_cast<uint32_t>(request.output_format.saturation), p + 24);
+    PutU32(request.symbols ? kFlagSymbols : 0, p + 28);
+    SerializeParameters(request.parameters, p + kRequestParametersOffset);
+}
+
+bool GetRequest(const uint8_t* p, FrameRequest* request, std::string* error) {
+    if (memcmp(p, kRequestMagic, sizeof(kRequestMagic))) {
+        *error = "Not a frame request";
+        return false;
+    } else if (GetU32(p + 8) != kVersion) {
+        *error = "Unsupported request version";
+        return false;
+    }
+    request->seed = GetU32(p + 12);
+    const uint32_t format = GetU32(p + 16);
+    const uint32_t saturation = GetU32(p + 24);
+    const uint32_t flags = GetU32(p + 28);
+    if (format >= DSP_NUM_SAMPLE_FORMATS) {
+        *error = "Invalid output format";
+        return false;
+    } else if (saturation > SAMPLE_FORMAT_NO_SATURATION) {
+        *error = "Invalid output saturation";
+        return false;
+    } else if (flags & ~kFlagSymbols) {
+        *error = "Invalid flags";
+        return false;
+    }
+    request->output_format.format = static_cast<dsp_sample_format_t>(format);
+    request->output_format.scale = GetFloat(p + 20);
+    request->output_format.saturation = static_cast<int32_t>(saturation);
+    request->symbols = (flags & kFlagSymbols) != 0;
+    DeserializeParameters(p + kRequestParametersOffset, &request->parameters);
+    return true;
+}
+
+void PutResponse(FrameServiceStatus status, const dsp_memory_plan_t* plan,
+                 size_t samples_size, size_t symbols_offset,
+                 const std::string& error, uint8_t* p) {
+    memset(p, 0, kResponseSize);
+    memcpy(p, kResponseMagic, sizeof(kResponseMagic));
+    PutU32(static_cast<uint32_t>(status), p + 8);
+    if (plan) {
+        PutU64(plan->num_samples, p + 16);
+        PutU64(plan->num_symbols, p + 24);
+        PutU64(plan->num_samples_zc, p + 32);
+        PutU64(plan->num_samples_qd, p + 40);
+        PutU64(plan->num_samples_tail, p + 48);
+        PutU64(samples_size, p + 56);
+        PutU64(symbols_offset, p + 64);
+    }
+    memcpy(p + kResponseErrorOffset, error.data(),
+           std::min(error.size(), kMaxErrorSize));
+}
+
+}  // namespace
+
+FrameService::FrameService(HugePages huge_pages, bool numa_local,
+                           const Wisdom* wisdom, size_t max_frame_samples)
+    : wisdom_(wisdom),
+      max_frame_samples_(max_frame_samples),
+      arena_(huge_pages, numa_local) {}
+
+FrameService::~FrameService() {
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        unlink(socket_path_.c_str());
+    }
+}
+
+bool FrameService::Listen(const std::string& socket_path,
+                          std::string* error) {
+    struct sockaddr_un address;
+    if (!MakeAddress(socket_path, &address, error)) {
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        *error = std::string("socket: ") + strerror(errno);
+        return false;
+    }
+    unlink(socket_path.c_str());
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&address),
+             sizeof(address)) < 0 ||
+        listen(fd, SOMAXCONN) < 0) {
+        *error = socket_path + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+    socket_path_ = socket_path;
+    listen_fd_ = fd;
+    return true;
+}
+
+void FrameService::Serve() {
+    while (!stopping_) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (!stopping_) {
+                LOG(ERROR) << "accept: " << strerror(errno);
+            }
+            break;
+        }
+        connection_fd_ = fd;
+        if (!stopping_) {
+            ServeConnection(fd);
+        }
+        connection_fd_ = -1;
+        close(fd);
+    }
+}
+
+void FrameService::Stop() {
+    stopping_ = true;
+    // Wakes up accept, or the read of the next request.
+    if (listen_fd_ >= 0) {
+        shutdown(listen_fd_, SHUT_RDWR);
+    }
+    int fd = connection_fd_;
+    if (fd >= 0) {
+        shutdown(fd, SHUT_RDWR);
+    }
+}
+
+void FrameService::ServeConnection(int fd) {
+    uint8_t request_data[kRequestSize];
+    uint8_t response[kResponseSize];
+    while (!stopping_ && ReadFully(fd, request_data, kRequestSize)) {
+        FrameRequest request;
+        Frame frame;
+        size_t samples_size = 0;
+        size_t symbols_offset = 0;
+        FrameServiceStatus status = FrameServiceStatus::kInvalidRequest;
+        std::string error;
+        int memfd = -1;
+        if (GetRequest(request_data, &request, &error)) {
+            memfd = Generate(request, &frame, &samples_size, &symbols_offset,
+                             &status, &error);
+        }
+        ++num_requests_;
+        if (memfd < 0) {
+            LOG(WARNING) << "Request failed: " << error;
+        }
+        PutResponse(status, memfd < 0 ? nullptr : &frame.plan, samples_size,
+                    symbols_offset, error, response);
+        bool sent = SendWithFd(fd, response, kResponseSize, memfd);
+        if (memfd >= 0) {
+            close(memfd);
+        }
+        if (!sent) {
+            break;
+        }
+    }
+}
+
+int FrameService::Generate(const FrameRequest& request, Frame* frame,
+                           size_t* samples_size, size_t* symbols_offset,
+                           FrameServiceStatus* status, std::string* error) {
+    // Each symbol takes at least one sample: bounds the symbols, allocated
+    // with the frame, before planning.
+    if (request.parameters.num_symbols > max_frame_samples_) {
+        *error = "Frame of " +
+                 std::to_string(request.parameters.num_symbols) +
+                 " symbols, the limit is " +
+                 std::to_string(max_frame_samples_) + " samples";
+        *status = FrameServiceStatus::kInvalidParameters;
+        return -1;
+    }
+    std::unique_ptr<ExecutionPlan> plan =
+        ExecutionPlan::Create(request.parameters, &luts_, error);
+    if (!plan) {
+        *status = FrameServiceStatus::kInvalidParameters;
+        return -1;
+    }
+    if (plan->frame_plan().num_samples > max_frame_samples_) {
+        *error = "Frame of " +
+                 std::to_string(plan->frame_plan().num_samples) +
+                 " samples, the limit is " +
+                 std::to_string(max_frame_samples_);
+        *status = FrameServiceStatus::kInvalidParameters;
+        return -1;
+    }
+
+    FrameConfig config;
+    config.parameters = request.parameters;
+    config.seed = request.seed;
+    config.output_format = request.output_format;
+    if (wisdom_ && plan->ApplyWisdom(*wisdom_)) {
+        plan->Apply(&config);
+    }
+    *frame = GenerateFrame(config, &luts_, &arena_, false);
+
+    const SampleFormat& format = request.output_format;
+    const size_t num_samples = frame->plan.num_samples;
+    const size_t num_symbols = frame->plan.num_symbols;
+    *samples_size = dsp_sample_format_size(format.format, num_samples);
+    *symbols_offset = 0;
+    size_t size = *samples_size;
+    if (request.symbols) {
+        *symbols_offset = (size + kAlignment - 1) / kAlignment * kAlignment;
+        size = *symbols_offset + num_symbols * sizeof(iq_sample_t);
+    }
+
+    *status = FrameServiceStatus::kInternalError;
+    int fd = memfd_create("embedded_alice_frame",
+                          MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        *error = std::string("memfd_create: ") + strerror(errno);
+        return -1;
+    }
+    void* data = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (data == MAP_FAILED) {
+        *error = std::string("Failed to map the frame: ") + strerror(errno);
+        close(fd);
+        return -1;
+    }
+
+    // The conversion to the output format is the only copy of the samples.
+    sample_format_state_t converter;
+    dsp_sample_format_init(&converter, format.format, format.scale,
+                           format.saturation);
+    dsp_sample_format_process(&converter, frame->samples, data, num_samples);
+    if (request.symbols) {
+        memcpy(static_cast<uint8_t*>(data) + *symbols_offset, frame->symbols,
+               num_symbols * sizeof(iq_sample_t));
+    }
+    munmap(data, size);
+
+    // The client can map the frame without fearing it changes.
+    if (fcntl(fd, F_ADD_SEALS,
+              F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0) {
+        *error = std::string("Failed to seal the frame: ") + strerror(errno);
+        close(fd);
+        return -1;
+    }
+    *status = FrameServiceStatus::kOk;
+    return fd;
+}
+
+ServedFrame::~ServedFrame() { Reset(); }
+
+void ServedFrame::Reset() {
+    if (data_) {
+        munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    samples_size_ = 0;
+    symbols_ = nullptr;
+    plan_ = dsp_memory_plan_t{};
+}
+
+FrameServiceClient::~FrameServiceClient() { Close(); }
+
+bool FrameServiceClient::Connect(const std::string& socket_path,
+                                 std::string* error) {
+    Close();
+    struct sockaddr_un address;
+    if (!MakeAddress(socket_path, &address, error)) {
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        *error = std::string("socket: ") + strerror(errno);
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                sizeof(address)) < 0) {
+        *error = socket_path + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+    return true;
+}
+
+void FrameServiceClient::Close() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool FrameServiceClient::Generate(const FrameRequest& request,
+                                  ServedFrame* frame, std::string* error,
+                                  FrameServiceStatus* status) {
+    frame->Reset();
+    if (fd_ < 0) {
+        *error = "Not connected";
+        return false;
+    }
+    uint8_t request_data[kRequestSize];
+    PutRequest(request, request_data);
+    if (!WriteFully(fd_, request_data, kRequestSize)) {
+        *error = std::string("Failed to send the request: ") + strerror(errno);
+        return false;
+    }
+
+    uint8_t response[kResponseSize];
+    int memfd;
+    if (!ReceiveWithFd(fd_, response, kResponseSize, &memfd)) {
+        *error = "Failed to receive the response";
+        return false;
+    }
+    // Closed on return; the mapping stays valid.
+    std::unique_ptr<int, void (*)(int*)> memfd_closer(&memfd, [](int* fd) {
+        if (*fd >= 0) {
+            close(*fd);
+        }
+    });
+    if (memcmp(response, kResponseMagic, sizeof(kResponseMagic))) {
+        *error = "Invalid response";
+        return false;
+    }
+    const FrameServiceStatus response_status =
+        static_cast<FrameServiceStatus>(GetU32(response + 8));
+    if (status) {
+        *status = response_status;
+    }
+    if (response_status != FrameServiceStatus::kOk) {
+        const char* message =
+            reinterpret_cast<const char*>(response + kResponseErrorOffset);
+        *error = std::string(message, strnlen(message, kMaxErrorSize));
+        return false;
+    }
+
+    dsp_memory_plan_t plan = {};
+    plan.num_samples = GetU64(response + 16);
+    plan.num_symbols = GetU64(response + 24);
+    plan.num_samples_zc = GetU64(response + 32);
+    plan.num_samples_qd = GetU64(response + 40);
+    plan.num_samples_tail = GetU64(response + 48);
+    const uint64_t samples_size = GetU64(response + 56);
+    const uint64_t symbols_offset = GetU64(response + 64);
+    uint64_t size = samples_size;
+    if (request.symbols) {
+        size = symbols_offset + plan.num_symbols * sizeof(iq_sample_t);
+    }
+
+    struct stat file_stat;
+    if (memfd < 0 || fstat(memfd, &file_stat) < 0 ||
+        static_cast<uint64_t>(file_stat.st_size) < size || !size) {
+        *error = "Invalid frame";
+        return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, memfd, 0);
+    if (data == MAP_FAILED) {
+        *error = std::string("Failed to map the frame: ") + strerror(errno);
+        return false;
+    }
+    frame->data_ = static_cast<uint8_t*>(data);
+    frame->size_ = size;
+    frame->samples_size_ = samples_size;
+    if (request.symbols) {
+        frame->symbols_ =
+            reinterpret_cast<const iq_sample_t*>(frame->data_ + symbols_offset);
+    }
+    frame->plan_ = plan;
+    return true;
+}
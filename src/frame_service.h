@@ -0,0 +1,172 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Frame service: a long-running process generating frames on request, over a
+// Unix domain socket, for test controllers and sweeps issuing many small
+// frames. The LUTs (phasor, RRC filters), from which the ZC sequence and the
+// RRC pulse are generated, and the frame buffers stay warm from one request
+// to the next, so that the latency of a request is the generation itself.
+//
+// A client sends requests on a stream connection, one at a time, and reads
+// a response after each of them. The samples (and symbols) of a frame are
+// returned in a sealed memfd passed along with the response (SCM_RIGHTS),
+// which the client maps: they are copied once, by the conversion to the
+// requested output format.
+//
+// Request (128 bytes, little-endian):
+//   0    magic "EAFRMREQ"
+//   8    version (uint32)
+//   12   seed (uint32)
+//   16   output format (uint32, dsp_sample_format_t)
+//   20   output scale (float32)
+//   24   output saturation (uint32, in int16 units)
+//   28   flags (uint32, bit 0: return the symbols)
+//   32   parameters, as in a frame container index entry (68 bytes)
+//   100  zeros
+//
+// Response (128 bytes, little-endian):
+//   0    magic "EAFRMRSP"
+//   8    status (uint32, FrameServiceStatus)
+//   16   number of samples, symbols, ZC, quantum data and tail samples
+//        (uint64 each)
+//   56   size in bytes of the samples, at offset 0 of the memfd (uint64)
+//   64   offset of the symbols in the memfd (uint64), int16 I/Q pairs
+//   72   error message, NUL-padded (56 bytes)
+// A memfd is passed with the response only if the status is kOk.
+
+#ifndef FRAME_SERVICE_H_
+#define FRAME_SERVICE_H_
+
+extern "C" {
+#include "dsp/dsp_memory_plan.h"
+#include "dsp/dsp_parameters.h"
+#include "dsp/dsp_types.h"
+}
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "execution_plan.h"
+#include "frame_buffer_arena.h"
+#include "frame_generator.h"
+
+enum class FrameServiceStatus : uint32_t {
+    kOk = 0,
+    kInvalidRequest,
+    kInvalidParameters,
+    kInternalError,
+};
+
+// Frames longer than this are rejected by default: a single request must not
+// be able to exhaust the memory of a service shared by all the clients.
+const size_t kDefaultMaxFrameSamples = size_t(1) << 28;
+
+struct FrameRequest {
+    dsp_parameter_t parameters = {};
+    uint32_t seed = 1;
+    SampleFormat output_format;
+    bool symbols = false;
+};
+
+class FrameService {
+   public:
+    // wisdom (optional, must outlive the service) sets the execution choices
+    // of the configurations it knows. Requests for frames of more than
+    // max_frame_samples samples are answered with kInvalidParameters.
+    FrameService(HugePages huge_pages, bool numa_local,
+                 const Wisdom* wisdom = nullptr,
+                 size_t max_frame_samples = kDefaultMaxFrameSamples);
+    ~FrameService();
+
+    FrameService(const FrameService&) = delete;
+    FrameService& operator=(const FrameService&) = delete;
+
+    // Binds the socket, replacing any file at this path. On failure, returns
+    // false and sets error.
+    bool Listen(const std::string& socket_path, std::string* error);
+
+    // Serves the connections, one at a time, until Stop is called.
+    void Serve();
+
+    // Can be called from any thread, or from a signal handler.
+    void Stop();
+
+    size_t num_requests() const { return num_requests_; }
+
+   private:
+    void ServeConnection(int fd);
+
+    // Generates the frame of a request into a new memfd. Returns -1 and sets
+    // the error if the request fails.
+    int Generate(const FrameRequest& request, Frame* frame,
+                 size_t* samples_size, size_t* symbols_offset,
+                 FrameServiceStatus* status, std::string* error);
+
+    const Wisdom* wisdom_;
+    size_t max_frame_samples_;
+    LutCache luts_;
+    FrameBufferArena arena_;
+
+    std::string socket_path_;
+    int listen_fd_ = -1;
+    std::atomic<int> connection_fd_{-1};
+    std::atomic<bool> stopping_{false};
+    size_t num_requests_ = 0;
+};
+
+// A frame generated by the service, mapped in memory.
+class ServedFrame {
+   public:
+    ServedFrame() = default;
+    ~ServedFrame();
+
+    ServedFrame(const ServedFrame&) = delete;
+    ServedFrame& operator=(const ServedFrame&) = delete;
+
+    // Samples in the requested output format.
+    const void* samples() const { return data_; }
+    size_t samples_size() const { return samples_size_; }
+
+    // nullptr if the symbols were not requested.
+    const iq_sample_t* symbols() const { return symbols_; }
+
+    // Region sizes (num_samples_zc...) and number of symbols of the frame.
+    const dsp_memory_plan_t& plan() const { return plan_; }
+
+   private:
+    friend class FrameServiceClient;
+
+    void Reset();
+
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t samples_size_ = 0;
+    const iq_sample_t* symbols_ = nullptr;
+    dsp_memory_plan_t plan_ = {};
+};
+
+class FrameServiceClient {
+   public:
+    FrameServiceClient() = default;
+    ~FrameServiceClient();
+
+    FrameServiceClient(const FrameServiceClient&) = delete;
+    FrameServiceClient& operator=(const FrameServiceClient&) = delete;
+
+    bool Connect(const std::string& socket_path, std::string* error);
+    void Close();
+
+    // On failure, returns false and sets error (and status, if not null, when
+    // the service rejected the request).
+    bool Generate(const FrameRequest& request, ServedFrame* frame,
+                  std::string* error, FrameServiceStatus* status = nullptr);
+
+   private:
+    int fd_ = -1;
+};
+
+#endif  // FRAME_SERVICE_H_
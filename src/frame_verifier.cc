@@ -0,0 +1,467 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Loopback verification of a generated frame.
+
+#include "frame_verifier.h"
+
+extern "C" {
+#include "dsp/dsp_interpolator.h"
+#include "dsp/dsp_memory_plan.h"
+#include "dsp/dsp_rrc_filter.h"
+#include "dsp/dsp_zc_generator.h"
+}
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <complex>
+#include <sstream>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "fft.h"
+#include "frame_buffer_arena.h"
+
+namespace {
+
+typedef std::complex<float> Complex;
+
+// Root-raised cosine pulse, t in symbols (same formula as the LUT of the RRC
+// filter).
+double Rrc(double t, double roll_off) {
+    const double denum_scale = 4.0 * roll_off * t;
+    if (t == 0.0) {
+        return 1.0 + roll_off * (4.0 / M_PI - 1.0);
+    } else if (fabs(fabs(denum_scale) - 1.0) < 1e-9) {
+        return (roll_off / M_SQRT2) *
+            ((1.0 + 2.0 / M_PI) * sin(M_PI / (4.0 * roll_off)) +
+             (1.0 - 2.0 / M_PI) * cos(M_PI / (4.0 * roll_off)));
+    }
+    return (sin(M_PI * t * (1.0 - roll_off)) +
+            4.0 * roll_off * t * cos(M_PI * t * (1.0 + roll_off))) /
+           (M_PI * t * (1.0 - denum_scale * denum_scale));
+}
+
+// Matched filter and symbol clock of the quantum data.
+//
+// The filter is only evaluated at the symbol instants. Its taps are
+// quantized on 16 bits, and applied to the int16 samples with 32-bit
+// accumulators (which vectorizes well). The accumulators can't overflow as
+// long as the magnitudes of the quantized taps add up to at most 65535: their
+// scale leaves room for the rounding, and the bound is checked on the taps.
+class SymbolRecovery {
+   public:
+    SymbolRecovery(const dsp_parameter_t& parameters,
+                   const iq_sample_t* samples, size_t num_samples)
+        : samples_(samples), num_samples_(num_samples) {
+        const double samples_per_symbol =
+            static_cast<double>(parameters.sample_rate) /
+            parameters.symbol_rate;
+        symbol_increment_ = dsp_phase_increment(parameters.symbol_rate,
+                                                parameters.sample_rate);
+        shift_frequency_ = parameters.shift_frequency;
+        sample_rate_ = parameters.sample_rate;
+
+        // Same span as the transmitter's pulse, padded with null taps.
+        half_ = static_cast<size_t>(samples_per_symbol *
+                                    LUT_RRC_NUM_SYMBOLS / 2);
+        const size_t num_taps = 2 * half_ + 1;
+        num_taps_ = (num_taps + 7) / 8 * 8;
+
+        // The frequency shift is undone on the taps rather than on the
+        // samples: see Recover().
+        const double omega = 2.0 * M_PI * shift_frequency_ / sample_rate_;
+        std::vector<double> taps_i(num_taps_, 0.0);
+        std::vector<double> taps_q(num_taps_, 0.0);
+        double sum = 0.0;
+        for (size_t j = 0; j < num_taps; ++j) {
+            const double m = static_cast<double>(j) - half_;
+            const double h =
+                Rrc(m / samples_per_symbol, parameters.rrc_roll_off);
+            taps_i[j] = h * cos(omega * m);
+            taps_q[j] = -h * sin(omega * m);
+            sum += fabs(taps_i[j]) + fabs(taps_q[j]);
+        }
+        // Interleaved with the I/Q samples: the real and imaginary parts of
+        // the output are plain dot products with the I/Q pairs.
+        // Rounding adds at most 1/2 to each of the 2 * num_taps magnitudes.
+        const double scale = std::min(32767.0, (65535.0 - num_taps) / sum);
+        taps_real_.resize(2 * num_taps_);
+        taps_imag_.resize(2 * num_taps_);
+        int64_t magnitude = 0;
+        for (size_t j = 0; j < num_taps_; ++j) {
+            const int16_t t_i = static_cast<int16_t>(lrint(taps_i[j] * scale));
+            const int16_t t_q = static_cast<int16_t>(lrint(taps_q[j] * scale));
+            magnitude += abs(t_i) + abs(t_q);
+            taps_real_[2 * j] = t_i;
+            taps_real_[2 * j + 1] = -t_q;
+            taps_imag_[2 * j] = t_q;
+            taps_imag_[2 * j + 1] = t_i;
+        }
+        // |x| <= 32768, and 32768 * 65535 < 2^31.
+        CHECK_LE(magnitude, 65535) << "Matched filter taps too large";
+    }
+
+    // Sample of the quantum data at which the symbol clock wraps for the
+    // n-th time, as in the RRC filter of the transmitter.
+    size_t Instant(size_t phase, size_t n) const {
+        return phase + static_cast<size_t>(
+            ((static_cast<uint64_t>(n) << 32) + symbol_increment_ - 1) /
+            symbol_increment_);
+    }
+
+    // True if the matched filter at this instant only uses available
+    // samples.
+    bool Available(size_t t) const {
+        return t >= half_ && t + num_taps_ - half_ <= num_samples_;
+    }
+
+    // Matched filter output at the instants of symbols first to first + size
+    // - 1 (which must be available).
+    void Recover(size_t phase, size_t first, size_t size, Complex* out) const {
+        for (size_t k = 0; k < size; ++k) {
+            const size_t t = Instant(phase, first + k);
+            const Complex y = DotProduct(&samples_[t - half_].i);
+            if (!shift_frequency_) {
+                out[k] = y;
+                continue;
+            }
+            // Sum of h[m] y[t - m] exp(-i omega (t - m)), or exp(-i omega t)
+            // times the dot product with the modulated taps. The phase is
+            // computed exactly, in cycles.
+            const double cycles = static_cast<double>(
+                static_cast<uint64_t>(shift_frequency_) * t % sample_rate_) /
+                sample_rate_;
+            const double angle = -2.0 * M_PI * cycles;
+            out[k] = y * Complex(cos(angle), sin(angle));
+        }
+    }
+
+   private:
+    // x: interleaved I/Q samples.
+    Complex DotProduct(const int16_t* x) const {
+        int32_t acc_real = 0;
+        int32_t acc_imag = 0;
+        for (size_t j = 0; j < 2 * num_taps_; ++j) {
+            acc_real += taps_real_[j] * x[j];
+            acc_imag += taps_imag_[j] * x[j];
+        }
+        return Complex(acc_real, acc_imag);
+    }
+
+    const iq_sample_t* samples_;
+    size_t num_samples_;
+    uint32_t symbol_increment_;
+    uint32_t shift_frequency_;
+    uint32_t sample_rate_;
+
+    size_t half_;
+    size_t num_taps_;  // Padded to a multiple of 8.
+    std::vector<int16_t> taps_real_;
+    std::vector<int16_t> taps_imag_;
+};
+
+// Sums for the comparison of recovered and reference symbols.
+struct Comparison {
+    std::complex<double> cross = 0.0;  // Sum of r conj(s).
+    double energy_r = 0.0;
+    double energy_s = 0.0;
+    size_t count = 0;
+
+    void Add(Complex r, iq_sample_t s) {
+        const std::complex<double> rd(r.real(), r.imag());
+        const std::complex<double> sd(s.i, s.q);
+        cross += rd * std::conj(sd);
+        energy_r += std::norm(rd);
+        energy_s += std::norm(sd);
+        ++count;
+    }
+
+    double correlation() const {
+        const double denominator = sqrt(energy_r * energy_s);
+        return denominator > 0.0 ? std::abs(cross) / denominator : 0.0;
+    }
+
+    // After the least-squares gain g = cross / energy_s, the error energy is
+    // energy_r - |cross|^2 / energy_s, and the energy of g s is
+    // |cross|^2 / energy_s.
+    double evm() const {
+        const double reference =
+            energy_s > 0.0 ? std::norm(cross) / energy_s : 0.0;
+        if (reference <= 0.0) {
+            return 1.0;
+        }
+        return sqrt(std::max(energy_r - reference, 0.0) / reference);
+    }
+};
+
+// Locates the ZC sequence in the first samples. Returns the offset, and the
+// normalized correlation in *peak.
+size_t FindPreamble(const iq_sample_t* samples, size_t num_samples,
+                    const std::vector<iq_sample_t>& zc, size_t max_offset,
+                    double* peak) {
+    const size_t window = std::min(num_samples, zc.size() + max_offset);
+    const size_t num_offsets = window - zc.size() + 1;
+    const Fft fft(Fft::SizeFor(window));
+
+    // Circular correlation: offsets up to window - zc.size() do not wrap.
+    std::vector<Complex> x(fft.size());
+    std::vector<Complex> z(fft.size());
+    for (size_t n = 0; n < window; ++n) {
+        x[n] = Complex(samples[n].i, samples[n].q);
+    }
+    for (size_t n = 0; n < zc.size(); ++n) {
+        z[n] = Complex(zc[n].i, zc[n].q);
+    }
+    fft.Forward(x.data());
+    fft.Forward(z.data());
+    for (size_t k = 0; k < fft.size(); ++k) {
+        x[k] *= std::conj(z[k]);
+    }
+    fft.Inverse(x.data());
+
+    size_t offset = 0;
+    for (size_t tau = 1; tau < num_offsets; ++tau) {
+        if (std::norm(x[tau]) > std::norm(x[offset])) {
+            offset = tau;
+        }
+    }
+
+    double energy_x = 0.0;
+    double energy_z = 0.0;
+    for (size_t n = 0; n < zc.size(); ++n) {
+        const iq_sample_t& s = samples[offset + n];
+        energy_x += static_cast<double>(s.i) * s.i +
+                    static_cast<double>(s.q) * s.q;
+        energy_z += static_cast<double>(zc[n].i) * zc[n].i +
+                    static_cast<double>(zc[n].q) * zc[n].q;
+    }
+    const double denominator = sqrt(energy_x * energy_z);
+    *peak = denominator > 0.0 ? std::abs(x[offset]) / denominator : 0.0;
+    return offset;
+}
+
+}  // namespace
+
+VerifyReport VerifyFrame(const dsp_parameter_t& parameters,
+                         const iq_sample_t* samples, size_t num_samples,
+                         const iq_sample_t* symbols, size_t num_symbols,
+                         LutCache* luts, const VerifyOptions& options) {
+    VerifyReport report;
+    dsp_memory_plan_t plan;
+    dsp_memory_plan_frame(&plan, &parameters);
+    if (num_samples < plan.num_samples_zc) {
+        return report;
+    }
+
+    // Reference preamble.
+    std::vector<iq_sample_t> zc(plan.num_samples_zc);
+    zc_generator_state_t zc_state;
+    dsp_zc_generator_init(&zc_state, luts->phasor(), parameters.zc_length,
+                          parameters.zc_root, parameters.zc_shift,
+                          parameters.zc_rate, parameters.sample_rate);
+    dsp_zc_generator_process(&zc_state, zc.data(), zc.size());
+    report.zc_offset = FindPreamble(samples, num_samples, zc,
+                                    options.max_zc_offset, &report.zc_peak);
+
+    // Quantum data (and tail), and the random symbols it carries.
+    const size_t qd_start = report.zc_offset + plan.num_samples_zc;
+    SymbolRecovery recovery(parameters, samples + qd_start,
+                            num_samples - qd_start);
+    num_symbols = std::min<size_t>(num_symbols, parameters.num_symbols);
+
+    // Timing: best correlation over the first symbols, for each sample
+    // phase and symbol delay.
+    const size_t num_phases =
+        (parameters.sample_rate + parameters.symbol_rate - 1) /
+        parameters.symbol_rate;
+    const size_t max_delay = options.max_symbol_delay;
+    const size_t span = options.timing_symbols + 2 * max_delay;
+    std::vector<Complex> recovered(span);
+    double best_correlation = -1.0;
+    for (size_t phase = 0; phase < num_phases; ++phase) {
+        // The recovered symbols are indexed from the first one whose matched
+        // filter is available.
+        size_t first = 0;
+        while (!recovery.Available(recovery.Instant(phase, first)) &&
+               first < max_delay) {
+            ++first;
+        }
+        if (!recovery.Available(recovery.Instant(phase, first + span - 1))) {
+            continue;
+        }
+        recovery.Recover(phase, first, span, recovered.data());
+        for (size_t d = 0; d <= 2 * max_delay; ++d) {
+            // Recovered symbol first + max_delay + k against exported
+            // symbol d + k.
+            if (d + options.timing_symbols > num_symbols) {
+                break;
+            }
+            Comparison comparison;
+            for (size_t k = 0; k < options.timing_symbols; ++k) {
+                comparison.Add(recovered[max_delay + k], symbols[d + k]);
+            }
+            if (comparison.correlation() > best_correlation) {
+                best_correlation = comparison.correlation();
+                report.sample_phase = phase;
+                report.symbol_delay = static_cast<int>(d) -
+                    static_cast<int>(first + max_delay);
+            }
+        }
+    }
+    if (best_correlation < 0.0) {
+        return report;
+    }
+
+    // All the symbols recovered at this timing.
+    size_t first = std::max(0, -report.symbol_delay);
+    while (first < num_symbols &&
+           !recovery.Available(recovery.Instant(report.sample_phase, first))) {
+        ++first;
+    }
+    size_t last = first;
+    while (last + report.symbol_delay < num_symbols &&
+           recovery.Available(recovery.Instant(report.sample_phase, last))) {
+        ++last;
+    }
+    Comparison comparison;
+    Complex block[256];
+    for (size_t n = first; n < last; n += 256) {
+        const size_t size = std::min<size_t>(256, last - n);
+        recovery.Recover(report.sample_phase, n, size, block);
+        for (size_t k = 0; k < size; ++k) {
+            comparison.Add(block[k], symbols[n + k + report.symbol_delay]);
+        }
+    }
+    report.num_symbols = comparison.count;
+    report.correlation = comparison.correlation();
+    report.evm = comparison.evm();
+    report.passed = report.zc_offset == options.expected_zc_offset &&
+                    report.zc_peak >= options.min_zc_peak &&
+                    report.num_symbols > 0 &&
+                    report.correlation >= options.min_correlation &&
+                    report.evm <= options.max_evm;
+    return report;
+}
+
+void LogVerifyReport(const std::string& name, const VerifyReport& report) {
+    std::ostringstream message;
+    message << (name.empty() ? "Frame" : name) << ": "
+            << (report.passed ? "passed" : "FAILED") << ", ZC at "
+            << report.zc_offset << " (peak " << report.zc_peak << "), "
+            << report.num_symbols << " symbols at phase "
+            << report.sample_phase << ", delay " << report.symbol_delay
+            << ", correlation " << report.correlation << ", EVM "
+            << report.evm * 100.0 << "%";
+    if (report.passed) {
+        LOG(INFO) << message.str();
+    } else {
+        LOG(ERROR) << message.str();
+    }
+}
+
+bool VerifyGeneratedFrame(const FrameConfig& config, const Frame& frame,
+                          LutCache* luts) {
+    VerifyReport report = VerifyFrame(
+        config.parameters, frame.samples, frame.plan.num_samples,
+        frame.symbols, frame.plan.num_symbols, luts, VerifyOptions());
+    LogVerifyReport(config.name, report);
+    return report.passed;
+}
+
+namespace {
+
+// Segments of the averaged periodograms.
+const size_t kPeriodogramSize = 4096;
+
+// Averaged periodogram of x - y (y null: of x), Hann window.
+std::vector<double> Periodogram(const iq_sample_t* x, const iq_sample_t* y,
+                                size_t size) {
+    const Fft fft(kPeriodogramSize);
+    std::vector<double> power(kPeriodogramSize, 0.0);
+    std::vector<Complex> segment(kPeriodogramSize);
+    for (size_t start = 0; start + kPeriodogramSize <= size;
+         start += kPeriodogramSize) {
+        for (size_t n = 0; n < kPeriodogramSize; ++n) {
+            const double window =
+                0.5 - 0.5 * cos(2.0 * M_PI * n / kPeriodogramSize);
+            const iq_sample_t& a = x[start + n];
+            Complex value(a.i, a.q);
+            if (y) {
+                value -= Complex(y[start + n].i, y[start + n].q);
+            }
+            segment[n] = value * static_cast<float>(window);
+        }
+        fft.Forward(segment.data());
+        for (size_t k = 0; k < kPeriodogramSize; ++k) {
+            power[k] += std::norm(segment[k]);
+        }
+    }
+    return power;
+}
+
+}  // namespace
+
+InterpolationReport MeasureInterpolation(const FrameConfig& config,
+                                         LutCache* luts,
+                                         uint32_t num_symbols) {
+    FrameConfig direct = config;
+    direct.parameters.num_symbols =
+        std::min(direct.parameters.num_symbols, num_symbols);
+    direct.parameters.pilot_amplitude[0] = 0.0f;
+    direct.parameters.pilot_amplitude[1] = 0.0f;
+    direct.interpolation_stages = 0;
+    FrameConfig multistage = direct;
+    multistage.interpolation_stages = config.interpolation_stages;
+
+    FrameBufferArena direct_arena(HugePages::kNone, false);
+    FrameBufferArena multistage_arena(HugePages::kNone, false);
+    const Frame a = GenerateFrame(direct, luts, &direct_arena, false);
+    const Frame b = GenerateFrame(multistage, luts, &multistage_arena, false);
+    const iq_sample_t* x = a.samples + a.plan.num_samples_zc;
+    const iq_sample_t* y = b.samples + b.plan.num_samples_zc;
+    const size_t size = a.plan.num_samples_qd;
+
+    interpolator_state_t interpolator;
+    dsp_interpolator_init(&interpolator, config.interpolation_stages,
+                          config.parameters.rrc_roll_off,
+                          config.parameters.symbol_rate,
+                          config.parameters.sample_rate);
+
+    InterpolationReport report;
+    report.num_stages = config.interpolation_stages;
+    report.direct_multiplies = LUT_RRC_NUM_SYMBOLS;
+    report.multiplies = dsp_interpolator_multiplies(&interpolator);
+
+    double signal = 0.0;
+    double error = 0.0;
+    for (size_t n = 0; n < size; ++n) {
+        const double di = static_cast<double>(y[n].i) - x[n].i;
+        const double dq = static_cast<double>(y[n].q) - x[n].q;
+        signal += static_cast<double>(x[n].i) * x[n].i +
+                  static_cast<double>(x[n].q) * x[n].q;
+        error += di * di + dq * dq;
+    }
+    report.error_db = 10.0 * log10(std::max(error, 1e-12) / signal);
+
+    const std::vector<double> signal_power = Periodogram(x, nullptr, size);
+    const std::vector<double> error_power = Periodogram(y, x, size);
+    report.spectral_error_db = 10.0 * log10(
+        std::max(*std::max_element(error_power.begin(), error_power.end()),
+                 1e-12) /
+        *std::max_element(signal_power.begin(), signal_power.end()));
+    return report;
+}
+
+void LogInterpolationReport(const InterpolationReport& report) {
+    LOG(INFO) << "Multistage interpolation (" << report.num_stages
+              << " stages): " << report.multiplies
+              << " multiplies per sample and component (direct: "
+              << report.direct_multiplies << "), error " << report.error_db
+              << " dB, peak spectral error " << report.spectral_error_db
+              << " dB";
+}
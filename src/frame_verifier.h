@@ -0,0 +1,107 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Loopback verification of a generated frame, standing in for the receiver
+// (QOSST Bob):
+// - the ZC preamble is located by cross-correlation (through FFTs) with the
+//   reference sequence;
+// - the quantum data is frequency-shifted back to base-band and matched
+//   filtered with the RRC pulse, directly at the symbol instants;
+// - the symbol timing (sample phase and symbol delay) is found on the first
+//   symbols, and all the symbols recovered at that timing are compared with
+//   the exported ones, after a least-squares complex gain: correlation and
+//   error vector magnitude (EVM).
+
+#ifndef FRAME_VERIFIER_H_
+#define FRAME_VERIFIER_H_
+
+extern "C" {
+#include "dsp/dsp_parameters.h"
+#include "dsp/dsp_types.h"
+}
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "frame_generator.h"
+
+struct VerifyOptions {
+    // The preamble is searched at offsets 0 to max_zc_offset of the samples,
+    // and must be found at expected_zc_offset.
+    size_t max_zc_offset = 4096;
+    size_t expected_zc_offset = 0;
+
+    // Minimum normalized correlation between the samples and the ZC sequence
+    // at the detected offset.
+    double min_zc_peak = 0.9;
+
+    // Symbols used to find the timing, and range of the symbol delay (in
+    // symbols) searched, on both sides.
+    size_t timing_symbols = 512;
+    size_t max_symbol_delay = 16;
+
+    double min_correlation = 0.99;
+    double max_evm = 0.1;
+};
+
+struct VerifyReport {
+    bool passed = false;
+
+    // Preamble.
+    size_t zc_offset = 0;
+    double zc_peak = 0.0;  // Normalized correlation, 1 for a perfect match.
+
+    // Timing: the recovered symbol n is the exported symbol n +
+    // symbol_delay, at sample sample_phase + n * sample_rate / symbol_rate
+    // of the quantum data.
+    size_t sample_phase = 0;
+    int symbol_delay = 0;
+
+    // Comparison of the recovered and exported symbols.
+    size_t num_symbols = 0;
+    double correlation = 0.0;
+    double evm = 0.0;  // RMS, relative to the RMS of the reference.
+};
+
+// samples: the frame (ZC sequence, quantum data, null tail), possibly
+// preceded by max_zc_offset other samples. symbols: the exported symbols.
+VerifyReport VerifyFrame(const dsp_parameter_t& parameters,
+                         const iq_sample_t* samples, size_t num_samples,
+                         const iq_sample_t* symbols, size_t num_symbols,
+                         LutCache* luts, const VerifyOptions& options);
+
+void LogVerifyReport(const std::string& name, const VerifyReport& report);
+
+// Verifies a frame generated from config, with the default options, and logs
+// the report. Returns true if it passed.
+bool VerifyGeneratedFrame(const FrameConfig& config, const Frame& frame,
+                          LutCache* luts);
+
+// Comparison of the multistage interpolator with the direct RRC filter.
+struct InterpolationReport {
+    size_t num_stages = 0;
+
+    // Multiplies per sample and component.
+    double direct_multiplies = 0.0;
+    double multiplies = 0.0;
+
+    // Difference between the quantum data of both paths: RMS relative to the
+    // RMS of the direct samples, and peak of its power spectrum relative to
+    // the peak of the power spectrum of the direct samples (averaged
+    // periodograms), in dB.
+    double error_db = 0.0;
+    double spectral_error_db = 0.0;
+};
+
+// Generates the quantum data of config (at most num_symbols symbols, without
+// the pilots) with both paths, and compares them.
+InterpolationReport MeasureInterpolation(const FrameConfig& config,
+                                         LutCache* luts,
+                                         uint32_t num_symbols = 1 << 14);
+
+void LogInterpolationReport(const InterpolationReport& report);
+
+#endif  // FRAME_VERIFIER_H_
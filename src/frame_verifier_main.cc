@@ -0,0 +1,66 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Command line tool checking all the frames of containers with the loopback
+// verifier, for example in CI or before archiving them:
+//
+//   frame_verifier vectors.eaf
+
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "frame_container.h"
+#include "frame_generator.h"
+#include "frame_verifier.h"
+
+ABSL_FLAG(double, min_correlation, 0.99,
+          "Minimum correlation between recovered and exported symbols");
+ABSL_FLAG(double, max_evm, 0.1,
+          "Maximum EVM of the recovered symbols, relative to their RMS");
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    vector<char*> args = absl::ParseCommandLine(argc, argv);
+    vector<string> inputs(args.begin() + 1, args.end());
+    QCHECK(!inputs.empty()) << "No input file";
+
+    VerifyOptions options;
+    options.min_correlation = absl::GetFlag(FLAGS_min_correlation);
+    options.max_evm = absl::GetFlag(FLAGS_max_evm);
+
+    LutCache luts;
+    int failures = 0;
+    for (const string& input : inputs) {
+        FrameContainerReader reader;
+        string error;
+        if (!reader.Open(input, &error)) {
+            LOG(ERROR) << input << ": " << error;
+            ++failures;
+            continue;
+        }
+        for (size_t i = 0; i < reader.num_frames(); ++i) {
+            const FrameContainerEntry& entry = reader.frame(i);
+            vector<iq_sample_t> samples(reader.num_samples(i));
+            reader.CopySamples(i, &samples[0].i);
+            size_t num_symbols;
+            const iq_sample_t* symbols = reinterpret_cast<const iq_sample_t*>(
+                reader.Region(i, FrameRegion::kSymbols, &num_symbols));
+            VerifyReport report =
+                VerifyFrame(entry.parameters, samples.data(), samples.size(),
+                            symbols, num_symbols, &luts, options);
+            LogVerifyReport(input + "[" + to_string(i) + "]" +
+                                (entry.name.empty() ? "" : " " + entry.name),
+                            report);
+            if (!report.passed) {
+                ++failures;
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
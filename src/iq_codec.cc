@@ -0,0 +1,647 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Lossless codec for the archived frames.
+
+#include "iq_codec.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "work_stealing_pool.h"
+
+const char kIqCodecExtension[] = ".eaz";
+
+namespace {
+
+const char kMagic[4] = {'E', 'A', 'Z', '2'};
+const size_t kHeaderSize = 20;
+const size_t kBlockEntrySize = 8;
+
+enum BlockMethod {
+    BLOCK_STORED = 0,
+    BLOCK_CODED = 1
+};
+
+const int kOrder = 4;
+// The prediction fits on 32 bits: kOrder * 2^13 * 2^15 < 2^31.
+const int kCoefficientBits = 14;
+const int32_t kMaxCoefficient = (1 << (kCoefficientBits - 1)) - 1;
+// Number of samples from which the predictor of a block is computed.
+const size_t kAnalysisSize = 16384;
+
+const size_t kPartitionSize = 32;
+// A residual is the difference of two int16: 17 bits once zigzagged.
+const int kMaxWidth = 17;
+
+// Unpack() loads 8 bytes at once: the partitions of a block are followed by
+// as many padding bytes.
+const size_t kPadding = 8;
+
+void PutU32(uint32_t value, std::string* out) {
+    for (int i = 0; i < 4; ++i) {
+        out->push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+void PutU64(uint64_t value, std::string* out) {
+    for (int i = 0; i < 8; ++i) {
+        out->push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+uint32_t GetU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+}
+
+uint64_t GetU64(const uint8_t* p) {
+    return GetU32(p) | (uint64_t(GetU32(p + 4)) << 32);
+}
+
+inline uint32_t ZigZag(int32_t value) {
+    return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+inline int32_t UnZigZag(uint32_t value) {
+    return int32_t(value >> 1) ^ -int32_t(value & 1);
+}
+
+inline int32_t Clamp(int32_t prediction) {
+    return std::min<int32_t>(std::max<int32_t>(prediction, INT16_MIN),
+                             INT16_MAX);
+}
+
+struct Predictor {
+    int shift = 0;
+    int32_t coefficients[kOrder] = {0};
+};
+
+// history: the kOrder previous values, latest first; zeros before the start
+// of a block.
+inline int32_t Predict(const Predictor& predictor,
+                       const int32_t history[kOrder]) {
+    int32_t acc = 0;
+    for (int j = 0; j < kOrder; ++j) {
+        acc += predictor.coefficients[j] * history[j];
+    }
+    return Clamp(acc >> predictor.shift);
+}
+
+inline void Push(int32_t value, int32_t history[kOrder]) {
+    for (int j = kOrder - 1; j > 0; --j) {
+        history[j] = history[j - 1];
+    }
+    history[0] = value;
+}
+
+// Little-endian, in a single load.
+inline uint64_t Load64(const uint8_t* p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif  // __BYTE_ORDER__
+    return value;
+}
+
+// A partition of kPartitionSize values of width bits takes exactly 4 * width
+// bytes, LSB-first: each group of 8 values, width bytes. The width is a
+// template argument, so that the loops on a group are unrolled, with constant
+// shifts.
+template <int width>
+void Pack(const uint32_t* values, uint8_t* out) {
+    for (size_t group = 0; group < kPartitionSize; group += 8) {
+        uint64_t accumulator = 0;
+        int count = 0;
+        for (int i = 0; i < 8; ++i) {
+            accumulator |= uint64_t(values[group + i]) << count;
+            count += width;
+            for (; count >= 8; count -= 8) {
+                *out++ = static_cast<uint8_t>(accumulator);
+                accumulator >>= 8;
+            }
+        }
+    }
+}
+
+// Reads up to 7 bytes past the partition.
+template <int width>
+void Unpack(const uint8_t* in, uint32_t* values) {
+    for (size_t group = 0; group < kPartitionSize; group += 8) {
+        for (int i = 0; i < 8; ++i) {
+            const int bit = i * width;
+            values[group + i] = static_cast<uint32_t>(
+                Load64(in + bit / 8) >> (bit % 8)) & ((1u << width) - 1);
+        }
+        in += width;
+    }
+}
+
+typedef void (*PackFn)(const uint32_t* values, uint8_t* out);
+typedef void (*UnpackFn)(const uint8_t* in, uint32_t* values);
+
+const PackFn kPack[kMaxWidth + 1] = {
+    Pack<0>, Pack<1>, Pack<2>, Pack<3>, Pack<4>, Pack<5>, Pack<6>, Pack<7>,
+    Pack<8>, Pack<9>, Pack<10>, Pack<11>, Pack<12>, Pack<13>, Pack<14>,
+    Pack<15>, Pack<16>, Pack<17>
+};
+
+const UnpackFn kUnpack[kMaxWidth + 1] = {
+    Unpack<0>, Unpack<1>, Unpack<2>, Unpack<3>, Unpack<4>, Unpack<5>,
+    Unpack<6>, Unpack<7>, Unpack<8>, Unpack<9>, Unpack<10>, Unpack<11>,
+    Unpack<12>, Unpack<13>, Unpack<14>, Unpack<15>, Unpack<16>, Unpack<17>
+};
+
+// The I/Q pairs of a block are not necessarily aligned.
+inline int32_t LoadSample(const char* pairs, size_t i, int channel) {
+    int16_t value;
+    memcpy(&value, pairs + 4 * i + 2 * channel, sizeof(value));
+    return value;
+}
+
+// Linear prediction of order kOrder, by the autocorrelation method.
+Predictor AnalyzeChannel(const char* pairs, size_t num_pairs, int channel) {
+    Predictor predictor;
+    const size_t n = std::min(num_pairs, kAnalysisSize);
+    double r[kOrder + 1];
+    for (int lag = 0; lag <= kOrder; ++lag) {
+        double sum = 0.0;
+        for (size_t i = lag; i < n; ++i) {
+            sum += double(LoadSample(pairs, i, channel)) *
+                   double(LoadSample(pairs, i - lag, channel));
+        }
+        r[lag] = sum;
+    }
+    if (r[0] == 0.0) {
+        return predictor;
+    }
+    r[0] *= 1.0 + 1e-9;
+
+    // Levinson-Durbin recursion.
+    double a[kOrder] = {0.0};
+    double error = r[0];
+    for (int i = 0; i < kOrder; ++i) {
+        double acc = r[i + 1];
+        for (int j = 0; j < i; ++j) {
+            acc -= a[j] * r[i - j];
+        }
+        double k = acc / error;
+        double previous[kOrder];
+        std::copy(a, a + i, previous);
+        for (int j = 0; j < i; ++j) {
+            a[j] = previous[j] - k * previous[i - 1 - j];
+        }
+        a[i] = k;
+        error *= 1.0 - k * k;
+        if (error <= 0.0) {
+            break;
+        }
+    }
+
+    // Quantization: the largest coefficient uses all the bits.
+    double max_coefficient = 0.0;
+    for (int j = 0; j < kOrder; ++j) {
+        max_coefficient = std::max(max_coefficient, fabs(a[j]));
+    }
+    int shift = kCoefficientBits - 1;
+    while (shift > 0 && max_coefficient * (1 << shift) > kMaxCoefficient) {
+        --shift;
+    }
+    if (max_coefficient * (1 << shift) > kMaxCoefficient) {
+        return predictor;
+    }
+    predictor.shift = shift;
+    for (int j = 0; j < kOrder; ++j) {
+        predictor.coefficients[j] =
+            static_cast<int32_t>(lround(a[j] * (1 << shift)));
+    }
+    return predictor;
+}
+
+// x is preceded by its kOrder previous values.
+void ComputeResiduals(const int32_t* x, const Predictor& predictor,
+                      uint32_t* residuals) {
+    const int32_t* c = predictor.coefficients;
+    for (size_t i = 0; i < kPartitionSize; ++i) {
+        int32_t acc = 0;
+        for (int j = 0; j < kOrder; ++j) {
+            acc += c[j] * x[i - 1 - j];
+        }
+        residuals[i] = ZigZag(x[i] - Clamp(acc >> predictor.shift));
+    }
+}
+
+size_t NumPartitions(size_t num_pairs) {
+    return (num_pairs + kPartitionSize - 1) / kPartitionSize;
+}
+
+// pairs: num_pairs interleaved int16 I/Q pairs, native byte order.
+void EncodePairs(const char* pairs, size_t num_pairs, std::string* out) {
+    out->push_back(BLOCK_CODED);
+    PutU32(static_cast<uint32_t>(num_pairs), out);
+
+    Predictor predictor[2];
+    for (int channel = 0; channel < 2; ++channel) {
+        Predictor& p = predictor[channel];
+        p = AnalyzeChannel(pairs, num_pairs, channel);
+        out->push_back(static_cast<char>(p.shift));
+        for (int j = 0; j < kOrder; ++j) {
+            out->push_back(static_cast<char>(p.coefficients[j]));
+            out->push_back(static_cast<char>(p.coefficients[j] >> 8));
+        }
+    }
+
+    // For each partition: the widths of I and Q (uint8 each), then the I and
+    // Q values. The residuals of the last, incomplete partition are padded
+    // with zeros.
+    const size_t start = out->size();
+    out->resize(start + NumPartitions(num_pairs) * 2 * (1 + 4 * kMaxWidth) +
+                kPadding);
+    uint8_t* begin = reinterpret_cast<uint8_t*>(&(*out)[start]);
+    uint8_t* p = begin;
+    int32_t x[2][kOrder + kPartitionSize] = {{0}};
+    uint32_t residuals[kPartitionSize];
+    for (size_t i = 0; i < num_pairs; i += kPartitionSize) {
+        const size_t n = std::min(kPartitionSize, num_pairs - i);
+        uint8_t* widths = p;
+        p += 2;
+        for (int channel = 0; channel < 2; ++channel) {
+            int32_t* history = x[channel];
+            std::copy(history + kPartitionSize,
+                      history + kPartitionSize + kOrder, history);
+            for (size_t j = 0; j < n; ++j) {
+                history[kOrder + j] = LoadSample(pairs, i + j, channel);
+            }
+            ComputeResiduals(history + kOrder, predictor[channel], residuals);
+            std::fill(residuals + n, residuals + kPartitionSize, 0);
+
+            uint32_t all = 0;
+            for (size_t j = 0; j < kPartitionSize; ++j) {
+                all |= residuals[j];
+            }
+            const int width = all ? 32 - __builtin_clz(all) : 0;
+            widths[channel] = static_cast<uint8_t>(width);
+            kPack[width](residuals, p);
+            p += 4 * width;
+        }
+    }
+    memset(p, 0, kPadding);
+    out->resize(start + (p - begin) + kPadding);
+}
+
+// Decodes the num_pairs I/Q pairs of a coded block to out, in native byte
+// order. data points after the number of pairs.
+bool DecodePairs(const uint8_t* data, size_t size, size_t num_pairs,
+                 char* out) {
+    const uint8_t* end = data + size;
+    Predictor predictor[2];
+    for (int channel = 0; channel < 2; ++channel) {
+        Predictor& p = predictor[channel];
+        if (end - data < 1 + 2 * kOrder) {
+            return false;
+        }
+        p.shift = data[0];
+        ++data;
+        if (p.shift >= kCoefficientBits) {
+            return false;
+        }
+        for (int j = 0; j < kOrder; ++j) {
+            p.coefficients[j] = int16_t(data[0] | (data[1] << 8));
+            data += 2;
+            if (abs(p.coefficients[j]) > kMaxCoefficient) {
+                return false;
+            }
+        }
+    }
+    if (size_t(end - data) < kPadding) {
+        return false;
+    }
+    end -= kPadding;
+
+    int32_t history[2][kOrder] = {{0}};
+    uint32_t residuals[2][kPartitionSize];
+    for (size_t start = 0; start < num_pairs; start += kPartitionSize) {
+        if (end - data < 2) {
+            return false;
+        }
+        const uint8_t* widths = data;
+        data += 2;
+        for (int channel = 0; channel < 2; ++channel) {
+            const int width = widths[channel];
+            if (width > kMaxWidth || end - data < 4 * width) {
+                return false;
+            }
+            kUnpack[width](data, residuals[channel]);
+            data += 4 * width;
+        }
+        // Both channels at once: their dependency chains overlap.
+        const size_t n = std::min(kPartitionSize, num_pairs - start);
+        for (size_t i = 0; i < n; ++i) {
+            const int32_t s0 = Predict(predictor[0], history[0]) +
+                               UnZigZag(residuals[0][i]);
+            const int32_t s1 = Predict(predictor[1], history[1]) +
+                               UnZigZag(residuals[1][i]);
+            if (s0 != int16_t(s0) || s1 != int16_t(s1)) {
+                return false;
+            }
+            Push(s0, history[0]);
+            Push(s1, history[1]);
+            const int16_t pair[2] = {int16_t(s0), int16_t(s1)};
+            memcpy(out + 4 * (start + i), pair, sizeof(pair));
+        }
+    }
+    return true;
+}
+
+void AppendInt(int value, std::string* out) {
+    char digits[8];
+    unsigned magnitude = value < 0 ? -unsigned(value) : unsigned(value);
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) {
+        out->push_back('-');
+    }
+    while (n) {
+        out->push_back(digits[--n]);
+    }
+}
+
+void RenderSymbols(const std::vector<int16_t>& pairs, std::string* text) {
+    text->clear();
+    for (size_t i = 0; i < pairs.size(); i += 2) {
+        AppendInt(pairs[i], text);
+        text->push_back('\t');
+        AppendInt(pairs[i + 1], text);
+        text->push_back('\n');
+    }
+}
+
+bool ParseInt(const char** p, const char* end, char separator,
+              int16_t* value) {
+    const char* s = *p;
+    bool negative = s < end && *s == '-';
+    s += negative;
+    int32_t magnitude = 0;
+    const char* digits = s;
+    while (s < end && *s >= '0' && *s <= '9' && s - digits < 6) {
+        magnitude = magnitude * 10 + (*s++ - '0');
+    }
+    if (s == digits || s == end || *s != separator) {
+        return false;
+    }
+    int32_t v = negative ? -magnitude : magnitude;
+    if (v < INT16_MIN || v > INT16_MAX) {
+        return false;
+    }
+    *value = static_cast<int16_t>(v);
+    *p = s + 1;
+    return true;
+}
+
+// Parses symbols lines, and checks that printing them back gives the same
+// text.
+bool ParseSymbols(const char* text, size_t size, std::vector<int16_t>* pairs,
+                  std::string* scratch) {
+    pairs->clear();
+    const char* p = text;
+    const char* end = text + size;
+    while (p < end) {
+        int16_t i, q;
+        if (!ParseInt(&p, end, '\t', &i) || !ParseInt(&p, end, '\n', &q)) {
+            return false;
+        }
+        pairs->push_back(i);
+        pairs->push_back(q);
+    }
+    RenderSymbols(*pairs, scratch);
+    return scratch->size() == size && !memcmp(scratch->data(), text, size);
+}
+
+struct Block {
+    size_t offset;
+    size_t size;
+};
+
+std::vector<Block> CutBlocks(const char* data, size_t size,
+                             IqCodecStream stream,
+                             const IqCodecOptions& options) {
+    std::vector<Block> blocks;
+    size_t offset = 0;
+    while (offset < size) {
+        size_t block_size;
+        if (stream == IqCodecStream::kSymbols) {
+            // Whole lines.
+            const char* p = data + offset;
+            const char* end = data + size;
+            for (size_t line = 0; line < options.symbols_block_size && p < end;
+                 ++line) {
+                const char* newline = static_cast<const char*>(
+                    memchr(p, '\n', end - p));
+                p = newline ? newline + 1 : end;
+            }
+            block_size = p - (data + offset);
+        } else {
+            // Whole I/Q pairs.
+            block_size = std::min(size - offset,
+                                  std::max<size_t>(options.iq_block_size & ~3,
+                                                   4));
+        }
+        blocks.push_back({offset, block_size});
+        offset += block_size;
+    }
+    return blocks;
+}
+
+void EncodeBlock(const char* data, size_t size, IqCodecStream stream,
+                 std::string* out) {
+    std::vector<int16_t> pairs;
+    const char* coded = nullptr;
+    if (stream == IqCodecStream::kIq && size % 4 == 0) {
+        coded = data;
+    } else if (stream == IqCodecStream::kSymbols) {
+        std::string scratch;
+        if (ParseSymbols(data, size, &pairs, &scratch)) {
+            coded = reinterpret_cast<const char*>(pairs.data());
+        }
+    }
+    if (coded) {
+        EncodePairs(coded, (stream == IqCodecStream::kIq ? size / 2
+                                                         : pairs.size()) / 2,
+                    out);
+        if (out->size() < size + 1) {
+            return;
+        }
+        out->clear();
+    }
+    out->push_back(BLOCK_STORED);
+    out->append(data, size);
+}
+
+bool DecodeBlock(const uint8_t* data, size_t size, IqCodecStream stream,
+                 char* out, size_t out_size) {
+    if (!size) {
+        return false;
+    }
+    if (data[0] == BLOCK_STORED) {
+        if (size - 1 != out_size) {
+            return false;
+        }
+        memcpy(out, data + 1, out_size);
+        return true;
+    } else if (data[0] != BLOCK_CODED || stream == IqCodecStream::kRaw ||
+               size < 5) {
+        return false;
+    }
+
+    const size_t num_pairs = GetU32(data + 1);
+    if (stream == IqCodecStream::kIq) {
+        return num_pairs * 4 == out_size &&
+               DecodePairs(data + 5, size - 5, num_pairs, out);
+    }
+
+    // Each partition takes at least its two widths: this bounds the
+    // allocation.
+    if (NumPartitions(num_pairs) > size / 2) {
+        return false;
+    }
+    std::vector<int16_t> pairs(2 * num_pairs);
+    if (!DecodePairs(data + 5, size - 5, num_pairs,
+                     reinterpret_cast<char*>(pairs.data()))) {
+        return false;
+    }
+    std::string text;
+    RenderSymbols(pairs, &text);
+    if (text.size() != out_size) {
+        return false;
+    }
+    memcpy(out, text.data(), out_size);
+    return true;
+}
+
+size_t NumThreads(size_t requested, size_t num_blocks) {
+    if (!requested) {
+        requested = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return std::max<size_t>(1, std::min(requested, num_blocks));
+}
+
+}  // namespace
+
+IqCodecStream IqCodecStreamFromFileName(const std::string& file_name) {
+    auto ends_with = [&file_name](const char* suffix) {
+        size_t n = strlen(suffix);
+        return file_name.size() >= n &&
+               file_name.compare(file_name.size() - n, n, suffix) == 0;
+    };
+    if (ends_with(".tsv")) {
+        return IqCodecStream::kSymbols;
+    } else if (ends_with(".bin")) {
+        return IqCodecStream::kIq;
+    }
+    return IqCodecStream::kRaw;
+}
+
+std::string IqCodecCompress(const char* data, size_t size,
+                            IqCodecStream stream,
+                            const IqCodecOptions& options) {
+    std::vector<Block> blocks = CutBlocks(data, size, stream, options);
+    std::vector<std::string> encoded(blocks.size());
+    {
+        WorkStealingPool pool(NumThreads(options.num_threads, blocks.size()));
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            pool.Submit([&, i](size_t) {
+                EncodeBlock(data + blocks[i].offset, blocks[i].size, stream,
+                            &encoded[i]);
+            });
+        }
+        pool.Wait();
+    }
+
+    std::string out(kMagic, sizeof(kMagic));
+    out.push_back(static_cast<char>(stream));
+    out.append(3, '\0');
+    PutU64(size, &out);
+    PutU32(static_cast<uint32_t>(blocks.size()), &out);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        PutU32(static_cast<uint32_t>(encoded[i].size()), &out);
+        PutU32(static_cast<uint32_t>(blocks[i].size), &out);
+    }
+    for (const std::string& block : encoded) {
+        out += block;
+    }
+    return out;
+}
+
+bool IqCodecDecompress(const std::string& compressed, size_t num_threads,
+                       std::string* data, std::string* error) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(compressed.data());
+    const size_t size = compressed.size();
+    if (size < kHeaderSize || memcmp(p, kMagic, sizeof(kMagic))) {
+        *error = "not a compressed frame";
+        return false;
+    }
+    IqCodecStream stream = static_cast<IqCodecStream>(p[4]);
+    if (p[4] > static_cast<uint8_t>(IqCodecStream::kSymbols)) {
+        *error = "unknown stream type";
+        return false;
+    }
+    uint64_t original_size = GetU64(p + 8);
+    size_t num_blocks = GetU32(p + 16);
+    if ((size - kHeaderSize) / kBlockEntrySize < num_blocks) {
+        *error = "truncated block table";
+        return false;
+    }
+
+    struct Entry {
+        size_t in_offset, in_size, out_offset, out_size;
+    };
+    std::vector<Entry> entries(num_blocks);
+    size_t in_offset = kHeaderSize + num_blocks * kBlockEntrySize;
+    uint64_t out_offset = 0;
+    for (size_t i = 0; i < num_blocks; ++i) {
+        const uint8_t* entry = p + kHeaderSize + i * kBlockEntrySize;
+        entries[i] = {in_offset, GetU32(entry), out_offset,
+                      GetU32(entry + 4)};
+        in_offset += entries[i].in_size;
+        out_offset += entries[i].out_size;
+    }
+    if (in_offset != size) {
+        *error = "truncated or corrupted blocks";
+        return false;
+    }
+    if (out_offset != original_size) {
+        *error = "inconsistent block sizes";
+        return false;
+    }
+
+    data->resize(original_size);
+    std::vector<char> valid(num_blocks, 0);
+    {
+        WorkStealingPool pool(NumThreads(num_threads, num_blocks));
+        for (size_t i = 0; i < num_blocks; ++i) {
+            pool.Submit([&, i](size_t) {
+                const Entry& e = entries[i];
+                valid[i] = DecodeBlock(p + e.in_offset, e.in_size, stream,
+                                       &(*data)[e.out_offset], e.out_size);
+            });
+        }
+        pool.Wait();
+    }
+    for (size_t i = 0; i < num_blocks; ++i) {
+        if (!valid[i]) {
+            *error = "corrupted block " + std::to_string(i);
+            return false;
+        }
+    }
+    return true;
+}
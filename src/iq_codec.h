@@ -0,0 +1,72 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Lossless codec for the archived frames: interleaved int16 I/Q samples
+// (out_iq.bin) and symbols (out_symbols.tsv).
+//
+// The stream is cut into independent blocks, compressed and decompressed in
+// parallel. In each block, the I and Q channels are predicted by a linear
+// predictor of fixed order 4 (coefficients computed for the block, quantized
+// on 14 bits), and the residuals are bit-packed by partitions of 32 values,
+// all on the width of the largest one. The I/Q samples of a default frame
+// shrink to about 64% of their size, the symbols to about 36%; the codec runs
+// at about 300 MB/s per thread both ways. The decoder unpacks a partition at
+// once, with the width as a template argument, and reconstructs I and Q in
+// the same loop, so that their dependency chains overlap.
+//
+// A symbols block is parsed into int16 pairs, and coded as such only if
+// printing them back gives the original text. Any block which can't be coded,
+// or which would not get smaller, is stored as is: decompression always
+// restores the exact original bytes.
+//
+// Format (little-endian):
+//   "EAZ2", stream type (uint8), 3 reserved bytes, original size (uint64),
+//   number of blocks (uint32), then for each block its compressed size and
+//   original size (uint32 each), then the blocks.
+//   Block: method (uint8: 0 stored, 1 coded), then for a coded block the
+//   number of I/Q pairs (uint32), the predictor of each channel (shift as
+//   uint8, then 4 int16 coefficients), the partitions, and 8 padding bytes.
+//   Partition: the widths of the I and Q residuals (uint8 each, at most 17),
+//   then the 32 zigzagged I residuals, LSB-first on 4 * width bytes, then the
+//   32 Q residuals. The last partition is padded with null residuals.
+
+#ifndef IQ_CODEC_H_
+#define IQ_CODEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+enum class IqCodecStream : uint8_t {
+    kRaw = 0,      // Any data, stored.
+    kIq = 1,       // Interleaved int16 I/Q samples, native byte order.
+    kSymbols = 2,  // "<i>\t<q>\n" lines.
+};
+
+// File name extension of the compressed files.
+extern const char kIqCodecExtension[];
+
+// Guesses the stream type from a file name (.bin: I/Q, .tsv: symbols).
+IqCodecStream IqCodecStreamFromFileName(const std::string& file_name);
+
+struct IqCodecOptions {
+    // Size of the original data in a block: bytes for I/Q samples, lines for
+    // symbols.
+    size_t iq_block_size = 1 << 20;
+    size_t symbols_block_size = 1 << 16;
+
+    // 0: one thread per hardware thread.
+    size_t num_threads = 0;
+};
+
+std::string IqCodecCompress(const char* data, size_t size,
+                            IqCodecStream stream,
+                            const IqCodecOptions& options);
+
+// On failure (corrupted or truncated input), returns false and sets error.
+bool IqCodecDecompress(const std::string& compressed, size_t num_threads,
+                       std::string* data, std::string* error);
+
+#endif  // IQ_CODEC_H_
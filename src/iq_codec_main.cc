@@ -0,0 +1,135 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Command line tool compressing archived frames with the lossless codec, and
+// restoring the original files.
+//
+//   iq_codec out_iq.bin out_symbols.tsv        (writes *.eaz)
+//   iq_codec --decompress out_iq.bin.eaz       (writes out_iq.bin)
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "iq_codec.h"
+
+ABSL_FLAG(bool, decompress, false, "Restore the original files");
+ABSL_FLAG(std::string, stream, "auto",
+          "Contents of the files to compress: iq, symbols, raw, or auto to "
+          "guess from the extension (.bin: iq, .tsv: symbols)");
+ABSL_FLAG(std::string, output, "",
+          "Output file name, when processing a single file (default: the "
+          "input file name with the .eaz extension added or removed)");
+ABSL_FLAG(uint32_t, threads, 0,
+          "Number of threads (0: one per hardware thread)");
+
+using namespace std;
+
+namespace {
+
+bool ReadFile(const string& file_name, string* data) {
+    ifstream file(file_name, ios::binary);
+    if (!file) {
+        return false;
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    *data = contents.str();
+    return true;
+}
+
+bool WriteFile(const string& file_name, const string& data) {
+    ofstream file(file_name, ios::binary);
+    return file && file.write(data.data(), data.size());
+}
+
+bool ParseStream(const string& name, IqCodecStream* stream) {
+    if (name == "iq") {
+        *stream = IqCodecStream::kIq;
+    } else if (name == "symbols") {
+        *stream = IqCodecStream::kSymbols;
+    } else if (name == "raw") {
+        *stream = IqCodecStream::kRaw;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+string OutputFileName(const string& input, bool decompress) {
+    const string extension = kIqCodecExtension;
+    if (!decompress) {
+        return input + extension;
+    }
+    if (input.size() > extension.size() &&
+        input.compare(input.size() - extension.size(), extension.size(),
+                      extension) == 0) {
+        return input.substr(0, input.size() - extension.size());
+    }
+    return input + ".out";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    vector<char*> args = absl::ParseCommandLine(argc, argv);
+    vector<string> inputs(args.begin() + 1, args.end());
+    QCHECK(!inputs.empty()) << "No input file";
+    QCHECK(absl::GetFlag(FLAGS_output).empty() || inputs.size() == 1)
+        << "--output requires a single input file";
+
+    const bool decompress = absl::GetFlag(FLAGS_decompress);
+    const string stream_name = absl::GetFlag(FLAGS_stream);
+    IqCodecStream stream = IqCodecStream::kRaw;
+    QCHECK(stream_name == "auto" || ParseStream(stream_name, &stream))
+        << "Invalid --stream value";
+
+    IqCodecOptions options;
+    options.num_threads = absl::GetFlag(FLAGS_threads);
+
+    int failures = 0;
+    for (const string& input : inputs) {
+        string output = absl::GetFlag(FLAGS_output);
+        if (output.empty()) {
+            output = OutputFileName(input, decompress);
+        }
+
+        string data;
+        if (!ReadFile(input, &data)) {
+            LOG(ERROR) << "Failed to read " << input;
+            ++failures;
+            continue;
+        }
+
+        string result;
+        if (decompress) {
+            string error;
+            if (!IqCodecDecompress(data, options.num_threads, &result,
+                                   &error)) {
+                LOG(ERROR) << input << ": " << error;
+                ++failures;
+                continue;
+            }
+        } else {
+            result = IqCodecCompress(
+                data.data(), data.size(),
+                stream_name == "auto" ? IqCodecStreamFromFileName(input)
+                                      : stream,
+                options);
+            LOG(INFO) << input << ": " << data.size() << " -> "
+                      << result.size() << " bytes";
+        }
+
+        if (!WriteFile(output, result)) {
+            LOG(ERROR) << "Failed to write " << output;
+            ++failures;
+        }
+    }
+    return failures ? 1 : 0;
+}
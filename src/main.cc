@@ -6,18 +6,14 @@
 // frame.
 
 extern "C" {
-#include <assert.h>
-#include <stdio.h>
-#include <stdlib.h>
-
 #include "dsp/dsp_parameters.h"
-#include "dsp/dsp_phasor_bank.h"
-#include "dsp/dsp_rng.h"
-#include "dsp/dsp_rrc_filter.h"
-#include "dsp/dsp_zc_generator.h"
 }
 
+#include <signal.h>
+
 #include <fstream>
+#include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -25,6 +21,16 @@ extern "C" {
 #include "absl/flags/parse.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "execution_plan.h"
+#include "frame_buffer_arena.h"
+#include "frame_container.h"
+#include "frame_generator.h"
+#include "frame_service.h"
+#include "frame_verifier.h"
+#include "paced_stream.h"
+#include "probe_export.h"
+#include "stream_capture.h"
+#include "sweep.h"
 
 ABSL_FLAG(uint64_t, sample_rate, 2000000000, "Sample rate in Hz");
 ABSL_FLAG(uint64_t, symbol_rate, 100000000, "Symbol rate in Hz");
@@ -43,20 +49,250 @@ ABSL_FLAG(uint32_t, pilot_1_freq, 200e6, "Pilot 1 frequency in Hz");
 ABSL_FLAG(double, pilot_1_amplitude, 0.16, "Pilot 1 amplitude");
 ABSL_FLAG(uint32_t, pilot_2_freq, 220e6, "Pilot 2 frequency in Hz");
 ABSL_FLAG(double, pilot_2_amplitude, 0.16, "Pilot 2 amplitude");
+ABSL_FLAG(uint32_t, seed, 1, "Seed of the symbols RNG");
+ABSL_FLAG(std::string, modulation, "gaussian",
+          "Modulation of the symbols: gaussian, psk or qam");
+ABSL_FLAG(uint32_t, modulation_order, 4,
+          "Number of points of the PSK or QAM constellation (QAM: 4, 16, 64 "
+          "or 256)");
+ABSL_FLAG(double, shaping, 0.0,
+          "Maxwell-Boltzmann shaping of the QAM constellation (0: uniform)");
 
 ABSL_FLAG(std::string, output, "out_iq.bin", "Output I/Q samples file name");
 ABSL_FLAG(std::string, output_symbols, "out_symbols.tsv",
           "Output symbols file name");
 
-iq_sample_t lut_phasor[LUT_PHASOR_SIZE];
-sample_t lut_rrc[LUT_RRC_SIZE];
+ABSL_FLAG(std::string, output_format, "int16",
+          "Format of the output samples: int16, packed14 or packed12 (DAC "
+          "resolutions, packed), cf32 or cf16 (complex floats, 1.0 = full "
+          "scale)");
+ABSL_FLAG(double, output_scale, 1.0,
+          "Gain applied to the output samples (at most 16)");
+ABSL_FLAG(int32_t, output_saturation, 32768,
+          "Maximum magnitude of the integer output formats, in int16 units");
+
+ABSL_FLAG(bool, compress, false,
+          "Compress the output files with the built-in lossless codec (.eaz "
+          "extension appended; restore them with iq_codec --decompress)");
+
+ABSL_FLAG(bool, planar, false,
+          "Generate the frame with separate I and Q planes, interleaved only "
+          "for the output (same samples)");
+
+ABSL_FLAG(bool, pipeline, false,
+          "Generate the symbols and run the RRC filter on a second thread, "
+          "pipelined with the rest of the chain (same samples)");
+
+ABSL_FLAG(uint32_t, interpolation_stages, 0,
+          "Run the RRC filter at the sample rate divided by 2^N, followed by N "
+          "half-band interpolators (at most 4; 0: RRC filter at the sample "
+          "rate), and report the deviation from the direct filter");
+
+ABSL_FLAG(bool, verify, false,
+          "Check each frame with the loopback verifier (ZC detection, "
+          "matched filter, symbol EVM) before writing it");
+
+ABSL_FLAG(std::string, probes, "",
+          "Export the intermediate signals of these probe points, "
+          "comma-separated (symbols, rrc, phasor_bank, zc), or all, for "
+          "hardware testbenches");
+ABSL_FLAG(std::string, probe_format, "bin",
+          "Format of the probe files: bin (int16 I/Q), hex (one sample per "
+          "line, IIIIQQQQ, for $readmemh) or tsv");
+ABSL_FLAG(std::string, probe_prefix, "probe_",
+          "Prefix of the probe file names, followed by the name of the point "
+          "(in a sweep, the output directory and frame name come first)");
+
+ABSL_FLAG(std::string, container, "",
+          "Write the frames, with their parameters and an index, to this "
+          "memory-mappable container instead of the output files");
+
+ABSL_FLAG(std::string, wisdom, "",
+          "File recording the fastest execution choices on this machine (see "
+          "--tune); the choices found there replace --planar and "
+          "--stream_block_size");
+ABSL_FLAG(bool, tune, false,
+          "Time the execution choices for the frame configurations, and "
+          "record the fastest ones in the --wisdom file");
+
+ABSL_FLAG(std::string, huge_pages, "transparent",
+          "Huge pages for the frame buffers: none, transparent or explicit");
+ABSL_FLAG(bool, numa_local, true,
+          "Bind the frame buffers to the NUMA node of the generating thread");
+
+ABSL_FLAG(std::string, sweep, "",
+          "Generate all the frame configurations listed in this file");
+ABSL_FLAG(std::string, sweep_output_dir, ".",
+          "Output directory for the frames of a sweep");
+ABSL_FLAG(uint32_t, threads, 0,
+          "Number of threads for a sweep or for the compression of a frame "
+          "(0: one per hardware thread)");
+
+ABSL_FLAG(bool, stream, false,
+          "Stream the frame in real time, paced at the sample rate, to a "
+          "consumer with a fixed-size buffer, and report the timing");
+ABSL_FLAG(uint32_t, stream_block_size, 4096,
+          "Number of samples generated at once in streaming mode");
+ABSL_FLAG(uint32_t, stream_buffer_size, 1 << 20,
+          "Size of the consumer buffer in streaming mode, in samples");
+ABSL_FLAG(double, stream_rate, 0,
+          "Streaming rate in samples/s (0: the sample rate)");
+ABSL_FLAG(uint32_t, stream_frames, 1,
+          "Number of frames streamed back to back");
+ABSL_FLAG(bool, stream_calibrate, false,
+          "Before streaming, measure the sustainable rate of each block size");
+
+ABSL_FLAG(bool, capture, false,
+          "Generate the frames by blocks, as in streaming mode, and write "
+          "them back to back to --output, without pacing");
+ABSL_FLAG(std::string, checkpoint, "",
+          "In capture mode, periodically save the state of the generator to "
+          "this file, to resume an interrupted capture");
+ABSL_FLAG(uint32_t, checkpoint_interval, 1024,
+          "Number of blocks between two checkpoints");
+ABSL_FLAG(bool, resume, false,
+          "Continue the capture from the --checkpoint file, with the same "
+          "output bytes as an uninterrupted capture");
+
+ABSL_FLAG(std::string, serve, "",
+          "Run as a service generating the frames requested on this Unix "
+          "domain socket (see src/frame_service.h), until interrupted");
+ABSL_FLAG(uint64_t, serve_max_samples, kDefaultMaxFrameSamples,
+          "Largest frame generated by the service, in samples; longer "
+          "requests are rejected");
 
 using namespace std;
 
+namespace {
+
+FrameService* service = nullptr;
+
+void StopService(int) { service->Stop(); }
+
+void LogLatency(const LatencyStats& latency) {
+    LOG(INFO) << "Block latency (us): p50 " << latency.p50 * 1e6 << ", p90 "
+              << latency.p90 * 1e6 << ", p99 " << latency.p99 * 1e6
+              << ", p99.9 " << latency.p999 * 1e6 << ", WCET "
+              << latency.wcet * 1e6;
+}
+
+// Validates a frame configuration, and sets its execution choices from the
+// wisdom, after timing them if requested (once per wisdom key).
+std::unique_ptr<ExecutionPlan> Plan(FrameConfig* config, LutCache* luts,
+                                    Wisdom* wisdom, bool tune,
+                                    set<string>* tuned_keys) {
+    string error;
+    std::unique_ptr<ExecutionPlan> plan =
+        ExecutionPlan::Create(config->parameters, luts, &error);
+    QCHECK(plan) << (config->name.empty() ? "" : config->name + ": ")
+                 << "Invalid parameters: " << error;
+    const string key = plan->wisdom_key();
+    if (tune && tuned_keys->insert(key).second) {
+        LOG(INFO) << "Tuning " << key << "...";
+        plan->Tune(TuneOptions(), wisdom);
+        LOG(INFO) << "Fastest: planar=" << plan->choices().planar
+                  << " chunk_size=" << plan->choices().chunk_size
+                  << " block_size=" << plan->choices().block_size;
+    } else {
+        plan->ApplyWisdom(*wisdom);
+    }
+    if (plan->tuned()) {
+        plan->Apply(config);
+    }
+    return plan;
+}
+
+void Stream(const FrameConfig& config, LutCache* luts, size_t block_size) {
+    PacedStreamOptions options;
+    options.block_size = block_size;
+    options.buffer_size = absl::GetFlag(FLAGS_stream_buffer_size);
+    options.rate = absl::GetFlag(FLAGS_stream_rate);
+    options.num_frames = absl::GetFlag(FLAGS_stream_frames);
+    QCHECK(options.block_size > 0) << "Invalid --stream_block_size";
+    QCHECK(options.num_frames > 0) << "Invalid --stream_frames";
+
+    if (absl::GetFlag(FLAGS_stream_calibrate)) {
+        LOG(INFO) << "Calibrating block sizes...";
+        dsp_memory_plan_t plan;
+        dsp_memory_plan_frame(&plan, &config.parameters);
+        vector<BlockSizeCalibration> calibrations = CalibrateBlockSizes(
+            config, luts, options.buffer_size, options.rate,
+            std::min<size_t>(plan.num_samples, 1 << 22));
+        const BlockSizeCalibration* largest = nullptr;
+        const BlockSizeCalibration* fastest = nullptr;
+        for (const BlockSizeCalibration& c : calibrations) {
+            LOG(INFO) << "Block size " << c.block_size << ": p99 "
+                      << c.latency.p99 * 1e6 << " us, WCET "
+                      << c.latency.wcet * 1e6 << " us, sustainable rate "
+                      << c.sustainable_rate * 1e-6 << " MS/s"
+                      << (c.sustainable ? "" : " (not sustainable)");
+            if (c.sustainable) {
+                largest = &c;
+            }
+            if (!fastest || c.sustainable_rate > fastest->sustainable_rate) {
+                fastest = &c;
+            }
+        }
+        if (fastest) {
+            LOG(INFO) << "Highest sustainable rate: "
+                      << fastest->sustainable_rate * 1e-6
+                      << " MS/s, with blocks of " << fastest->block_size
+                      << " samples";
+        }
+        if (largest) {
+            LOG(INFO) << "Largest sustainable block size: "
+                      << largest->block_size << " samples";
+        } else {
+            LOG(WARNING) << "No block size sustains the streaming rate";
+        }
+    }
+
+    LOG(INFO) << "Streaming...";
+    PacedStreamReport report = RunPacedStream(config, luts, options);
+    LOG(INFO) << "Streamed " << report.num_samples << " samples in "
+              << report.num_blocks << " blocks of " << report.block_size
+              << " at " << report.rate * 1e-6 << " MS/s, buffer of "
+              << report.buffer_size << " samples, in " << report.elapsed
+              << " s";
+    LogLatency(report.latency);
+    LOG(INFO) << "Sustainable rate with this block size: "
+              << report.sustainable_rate * 1e-6 << " MS/s";
+    LOG(INFO) << "Deadline misses: " << report.deadline_misses << " of "
+              << report.num_blocks << " blocks";
+    LOG(INFO) << "Underruns: " << report.underruns << " ("
+              << report.underrun_samples << " samples of silence)";
+}
+
+bool Capture(const FrameConfig& config, LutCache* luts, size_t block_size) {
+    StreamCaptureOptions options;
+    options.block_size = block_size;
+    options.num_frames = absl::GetFlag(FLAGS_stream_frames);
+    options.checkpoint = absl::GetFlag(FLAGS_checkpoint);
+    options.checkpoint_interval = absl::GetFlag(FLAGS_checkpoint_interval);
+    options.resume = absl::GetFlag(FLAGS_resume);
+
+    StreamCaptureReport report;
+    string error;
+    if (!CaptureStream(config, luts, options, &report, &error)) {
+        LOG(ERROR) << error;
+        return false;
+    }
+    if (report.resumed_samples) {
+        LOG(INFO) << "Resumed at sample " << report.resumed_samples;
+    }
+    LOG(INFO) << "Captured " << report.num_samples << " samples to "
+              << config.output << " (" << report.num_blocks << " blocks, "
+              << report.num_checkpoints << " checkpoints)";
+    return true;
+}
+
+}  // namespace
+
 int main(int argc, char** argv) {
     absl::ParseCommandLine(argc, argv);
 
-    dsp_parameter_t dsp_parameters;
+    FrameConfig config;
+    dsp_parameter_t& dsp_parameters = config.parameters;
 
     dsp_parameters.sample_rate =
         static_cast<uint32_t>(absl::GetFlag(FLAGS_sample_rate));
@@ -96,92 +332,158 @@ int main(int argc, char** argv) {
     dsp_parameters.rrc_roll_off =
         static_cast<float>(absl::GetFlag(FLAGS_rrc_roll_off));
 
-    // Allocate symbols buffer (and RRC tail)
-    const size_t LUT_RRC_NUM_SYMBOLS_LOCAL = LUT_RRC_NUM_SYMBOLS;
-    vector<iq_sample_t> symbols(
-        (dsp_parameters.num_symbols + LUT_RRC_NUM_SYMBOLS_LOCAL));
-
-    rng_state_t rng_state;
-    LOG(INFO) << "Generating random symbols...";
-    dsp_rng_init(&rng_state, dsp_parameters.symbol_scale,
-                 dsp_parameters.symbol_max_value, dsp_parameters.symbol_clamp,
-                 1, 0);
-    dsp_rng_generate_icdf(&rng_state, symbols.data(),
-                          dsp_parameters.num_symbols);
-
-    for (size_t i = 0; i < LUT_RRC_NUM_SYMBOLS_LOCAL; ++i) {
-        symbols[i + dsp_parameters.num_symbols] = iq_sample_t{0, 0};
+    config.seed = absl::GetFlag(FLAGS_seed);
+    QCHECK(ParseModulation(absl::GetFlag(FLAGS_modulation),
+                           &config.modulation.type))
+        << "Invalid --modulation value";
+    config.modulation.order = absl::GetFlag(FLAGS_modulation_order);
+    config.modulation.shaping =
+        static_cast<float>(absl::GetFlag(FLAGS_shaping));
+    QCHECK(IsValidModulation(config.modulation))
+        << "Invalid --modulation_order or --shaping value";
+    config.output = absl::GetFlag(FLAGS_output);
+    config.output_symbols = absl::GetFlag(FLAGS_output_symbols);
+    QCHECK(ParseSampleFormat(absl::GetFlag(FLAGS_output_format),
+                             &config.output_format.format))
+        << "Invalid --output_format value";
+    config.output_format.scale =
+        static_cast<float>(absl::GetFlag(FLAGS_output_scale));
+    config.output_format.saturation = absl::GetFlag(FLAGS_output_saturation);
+    QCHECK(config.output_format.saturation >= 0)
+        << "Invalid --output_saturation value";
+    config.compress = absl::GetFlag(FLAGS_compress);
+    config.planar = absl::GetFlag(FLAGS_planar);
+    config.pipeline = absl::GetFlag(FLAGS_pipeline);
+    config.interpolation_stages = absl::GetFlag(FLAGS_interpolation_stages);
+    QCHECK(IsValidInterpolation(dsp_parameters, config.interpolation_stages))
+        << "Invalid --interpolation_stages value for these rates";
+    config.verify = absl::GetFlag(FLAGS_verify);
+    QCHECK(ParseProbePoints(absl::GetFlag(FLAGS_probes), &config.probes))
+        << "Invalid --probes value";
+    QCHECK(ParseProbeFormat(absl::GetFlag(FLAGS_probe_format),
+                            &config.probe_format))
+        << "Invalid --probe_format value";
+    config.probe_prefix = absl::GetFlag(FLAGS_probe_prefix);
+    QCHECK(config.output_format.format == DSP_SAMPLE_FORMAT_INT16 ||
+           (!config.compress && absl::GetFlag(FLAGS_container).empty()))
+        << "--compress and --container require --output_format=int16";
+
+    HugePages huge_pages;
+    QCHECK(ParseHugePages(absl::GetFlag(FLAGS_huge_pages), &huge_pages))
+        << "Invalid --huge_pages value";
+    const bool numa_local = absl::GetFlag(FLAGS_numa_local);
+
+    const string wisdom_file = absl::GetFlag(FLAGS_wisdom);
+    const bool tune = absl::GetFlag(FLAGS_tune);
+    QCHECK(!tune || !wisdom_file.empty()) << "--tune requires --wisdom";
+    Wisdom wisdom;
+    if (!wisdom_file.empty()) {
+        string error;
+        QCHECK(wisdom.Load(wisdom_file, &error)) << error;
+    }
+    if (!absl::GetFlag(FLAGS_serve).empty()) {
+        FrameService frame_service(huge_pages, numa_local, &wisdom,
+                                   absl::GetFlag(FLAGS_serve_max_samples));
+        string error;
+        QCHECK(frame_service.Listen(absl::GetFlag(FLAGS_serve), &error))
+            << error;
+        service = &frame_service;
+        signal(SIGINT, StopService);
+        signal(SIGTERM, StopService);
+        LOG(INFO) << "Serving frames on " << absl::GetFlag(FLAGS_serve);
+        frame_service.Serve();
+        LOG(INFO) << "Served " << frame_service.num_requests()
+                  << " requests";
+        return 0;
     }
 
-    const uint32_t sr = dsp_parameters.sample_rate;
-    const uint32_t symbol_rate = dsp_parameters.symbol_rate;
-    const uint32_t zc_rate = dsp_parameters.zc_rate;
-    size_t num_samples_zc = dsp_parameters.zc_length * (sr / zc_rate);
-    size_t num_samples_qd = dsp_parameters.num_symbols * (sr / symbol_rate);
-    size_t num_samples_tail =
-        dsp_parameters.num_null_symbols * (sr / symbol_rate);
-    size_t num_samples = num_samples_zc + num_samples_qd + num_samples_tail;
-
-    LOG(INFO) << "Generating IQ samples...";
-    vector<iq_sample_t> samples(num_samples);
-
-    rrc_filter_state_t rrc_state;
-    dsp_rrc_filter_init(&rrc_state, &lut_rrc[0], dsp_parameters.rrc_roll_off,
-                        symbol_rate, sr);
-
-    size_t num_first_samples_truncated = sr / symbol_rate * 25 / 4;
-    size_t consumed = dsp_rrc_filter_process(&rrc_state, &symbols[0],
-                                             &samples[num_samples_zc],
-                                             num_first_samples_truncated);
-    consumed +=
-        dsp_rrc_filter_process(&rrc_state, &symbols[consumed],
-                               &samples[num_samples_zc], num_samples_qd);
-
-    phasor_bank_state_t phasor_state;
-    uint32_t frequencies[3] = {dsp_parameters.shift_frequency,
-                               dsp_parameters.pilot_frequency[0],
-                               dsp_parameters.pilot_frequency[1]};
-    float amplitudes[3] = {0.70710678118f, dsp_parameters.pilot_amplitude[0],
-                           dsp_parameters.pilot_amplitude[1]};
-    dsp_phasor_bank_init(&phasor_state, &lut_phasor[0],
-                         PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, frequencies,
-                         amplitudes, sr);
-    dsp_phasor_bank_process(&phasor_state, &samples[num_samples_zc],
-                            num_samples_qd + num_samples_tail);
-
-    LOG(INFO) << "Generating sync sequence...";
-    zc_generator_state_t zc_state;
-    dsp_zc_generator_init(&zc_state, phasor_state.lut_phasor,
-                          dsp_parameters.zc_length, dsp_parameters.zc_root,
-                          dsp_parameters.zc_shift, zc_rate, sr);
-    dsp_zc_generator_process(&zc_state, &samples[0], num_samples_zc);
-
-    LOG(INFO) << "Done...";
-
-    vector<short> dac_samples(2 * num_samples);
-    for (size_t i = 0; i < num_samples; ++i) {
-        dac_samples[i * 2] = samples[i].i;
-        dac_samples[i * 2 + 1] = samples[i].q;
+    LutCache luts;
+    set<string> tuned_keys;
+    if (config.interpolation_stages) {
+        LogInterpolationReport(MeasureInterpolation(config, &luts));
     }
 
-    // Write TSV
-    std::ofstream symbols_file(absl::GetFlag(FLAGS_output_symbols));
-    if (!symbols_file) {
-        LOG(ERROR) << "Failed to open " << absl::GetFlag(FLAGS_output_symbols);
-    } else {
-        for (const auto& s : symbols) {
-            symbols_file << s.i << '\t' << s.q << '\n';
+    if (!absl::GetFlag(FLAGS_sweep).empty()) {
+        std::ifstream sweep_file(absl::GetFlag(FLAGS_sweep));
+        QCHECK(sweep_file) << "Failed to open " << absl::GetFlag(FLAGS_sweep);
+        vector<FrameConfig> configs;
+        string error;
+        QCHECK(ParseSweep(sweep_file, config,
+                          absl::GetFlag(FLAGS_sweep_output_dir), &configs,
+                          &error))
+            << absl::GetFlag(FLAGS_sweep) << ": " << error;
+        for (FrameConfig& c : configs) {
+            Plan(&c, &luts, &wisdom, tune, &tuned_keys);
+        }
+        QCHECK(!tune || wisdom.Save(wisdom_file))
+            << "Failed to write " << wisdom_file;
+        FrameContainerWriter container;
+        const bool use_container = !absl::GetFlag(FLAGS_container).empty();
+        QCHECK(!use_container ||
+               container.Open(absl::GetFlag(FLAGS_container)));
+        size_t failures =
+            RunSweep(configs, absl::GetFlag(FLAGS_threads), huge_pages,
+                     numa_local, use_container ? &container : nullptr);
+        if (use_container && !container.Close()) {
+            ++failures;
         }
+        return failures ? 1 : 0;
     }
 
-    // Write binary samples
-    std::ofstream bin_file(absl::GetFlag(FLAGS_output), std::ios::binary);
-    if (!bin_file) {
-        LOG(ERROR) << "Failed to open " << absl::GetFlag(FLAGS_output);
-    } else {
-        bin_file.write(reinterpret_cast<const char*>(dac_samples.data()),
-                       dac_samples.size() * sizeof(int16_t));
+    std::unique_ptr<ExecutionPlan> plan =
+        Plan(&config, &luts, &wisdom, tune, &tuned_keys);
+    QCHECK(!tune || wisdom.Save(wisdom_file))
+        << "Failed to write " << wisdom_file;
+
+    QCHECK(absl::GetFlag(FLAGS_capture) ||
+           (!absl::GetFlag(FLAGS_resume) &&
+            absl::GetFlag(FLAGS_checkpoint).empty()))
+        << "--checkpoint and --resume require --capture";
+    QCHECK(!config.probes ||
+           (!absl::GetFlag(FLAGS_stream) && !absl::GetFlag(FLAGS_capture)))
+        << "--probes requires the whole-frame generation";
+    if (absl::GetFlag(FLAGS_stream)) {
+        QCHECK(config.modulation.type == DSP_MODULATION_GAUSSIAN)
+            << "--stream only generates Gaussian symbols";
+        QCHECK(!config.interpolation_stages)
+            << "--stream only uses the direct RRC filter";
+        Stream(config, &luts,
+               plan->tuned() ? plan->choices().block_size
+                             : absl::GetFlag(FLAGS_stream_block_size));
+        return 0;
+    }
+    if (absl::GetFlag(FLAGS_capture)) {
+        QCHECK(config.modulation.type == DSP_MODULATION_GAUSSIAN)
+            << "--capture only generates Gaussian symbols";
+        QCHECK(!config.interpolation_stages)
+            << "--capture only uses the direct RRC filter";
+        QCHECK(!config.compress && absl::GetFlag(FLAGS_container).empty())
+            << "--capture writes uncompressed samples to --output";
+        return Capture(config, &luts,
+                       plan->tuned() ? plan->choices().block_size
+                                     : absl::GetFlag(FLAGS_stream_block_size))
+                   ? 0
+                   : 1;
     }
 
-    return 0;
+    FrameBufferArena arena(huge_pages, numa_local);
+    Frame frame = GenerateFrame(config, &luts, &arena, true);
+#ifdef DSP_STATISTICS
+    LogFrameStatistics(config.name, frame.statistics);
+#endif  // DSP_STATISTICS
+    if (config.verify && !VerifyGeneratedFrame(config, frame, &luts)) {
+        return 1;
+    }
+    if (!WriteProbes(config, frame, absl::GetFlag(FLAGS_threads))) {
+        return 1;
+    }
+    if (!absl::GetFlag(FLAGS_container).empty()) {
+        FrameContainerWriter container;
+        QCHECK(container.Open(absl::GetFlag(FLAGS_container)));
+        bool success = container.Append(config, frame);
+        success &= container.Close();
+        return success ? 0 : 1;
+    }
+    return WriteFrame(config, frame, &arena, absl::GetFlag(FLAGS_threads))
+        ? 0 : 1;
 }
@@ -0,0 +1,251 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Real-time paced streaming.
+
+#include "paced_stream.h"
+
+extern "C" {
+#include "dsp/dsp_frame_generator.h"
+}
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "absl/log/log.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Period at which the consumer wakes up to drain the buffer.
+const std::chrono::microseconds kConsumerTick(50);
+
+// Number of samples copied at once by the consumer.
+const size_t kConsumerChunkSize = 4096;
+
+double Seconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+// Generates the frame by blocks, starting it over at the end.
+class BlockSource {
+   public:
+    BlockSource(const FrameConfig& config, LutCache* luts, size_t block_size)
+        : config_(config), luts_(luts), block_size_(block_size) {
+        dsp_memory_plan_t plan;
+        dsp_memory_plan_streaming(&plan, &config.parameters, block_size);
+        symbols_.reset(new iq_sample_t[plan.symbols_per_block]);
+        Restart();
+    }
+
+    size_t frame_size() const { return state_.num_samples; }
+
+    void Fill(iq_sample_t* out, size_t size) {
+        while (size) {
+            size_t n = dsp_frame_generator_process(&state_, out, size);
+            out += n;
+            size -= n;
+            if (size) {
+                Restart();
+            }
+        }
+    }
+
+   private:
+    void Restart() {
+        dsp_frame_generator_init(
+            &state_, &config_.parameters, config_.seed, luts_->phasor(),
+            luts_->rrc(config_.parameters.rrc_roll_off), symbols_.get(),
+            block_size_);
+    }
+
+    const FrameConfig& config_;
+    LutCache* luts_;
+    size_t block_size_;
+    std::unique_ptr<iq_sample_t[]> symbols_;
+    frame_generator_state_t state_;
+};
+
+}  // namespace
+
+double PlaybackSchedule::Due(double now) const {
+    return (now - delay_.load(std::memory_order_relaxed)) * rate_;
+}
+
+size_t PlaybackSchedule::Advance(double now, size_t available) {
+    double due = std::min(Due(now), static_cast<double>(num_samples_));
+    if (due <= static_cast<double>(position_)) {
+        return 0;
+    }
+    size_t needed = static_cast<size_t>(due) - position_;
+    size_t n = std::min(needed, available);
+    position_ += n;
+
+    if (n < needed) {
+        size_t missing = needed - n;
+        if (!underrun_) {
+            ++underruns_;
+        }
+        underrun_samples_ += missing;
+        delay_.store(delay_.load(std::memory_order_relaxed) + missing / rate_,
+                     std::memory_order_relaxed);
+    }
+    underrun_ = n < needed;
+    return n;
+}
+
+bool PlaybackSchedule::Late(double now, size_t position) const {
+    return Due(now) > static_cast<double>(position);
+}
+
+LatencyStats ComputeLatencyStats(std::vector<double> durations) {
+    LatencyStats stats;
+    if (durations.empty()) {
+        return stats;
+    }
+    std::sort(durations.begin(), durations.end());
+    auto percentile = [&durations](double p) {
+        size_t index = static_cast<size_t>(p * (durations.size() - 1) + 0.5);
+        return durations[index];
+    };
+    stats.p50 = percentile(0.5);
+    stats.p90 = percentile(0.9);
+    stats.p99 = percentile(0.99);
+    stats.p999 = percentile(0.999);
+    stats.wcet = durations.back();
+    return stats;
+}
+
+PacedStreamReport RunPacedStream(const FrameConfig& config, LutCache* luts,
+                                 const PacedStreamOptions& options) {
+    PacedStreamReport report;
+    const size_t block_size = options.block_size;
+    const size_t num_slots = std::max<size_t>(
+        2, options.buffer_size / block_size);
+    const size_t capacity = num_slots * block_size;
+    const double rate = options.rate > 0.0
+        ? options.rate : static_cast<double>(config.parameters.sample_rate);
+
+    BlockSource source(config, luts, block_size);
+    const size_t total = source.frame_size() * options.num_frames;
+
+    report.block_size = block_size;
+    report.buffer_size = capacity;
+    report.rate = rate;
+    report.num_samples = total;
+
+    std::unique_ptr<iq_sample_t[]> buffer(new iq_sample_t[capacity]);
+    std::atomic<size_t> produced(0);
+    std::atomic<size_t> consumed(0);
+
+    PlaybackSchedule schedule(rate, total);
+    // Set when the consumer starts, after the prefill.
+    std::atomic<bool> started(false);
+    std::atomic<int64_t> start_time(0);
+
+    std::thread consumer([&] {
+        while (produced.load(std::memory_order_acquire) <
+               std::min(capacity, total)) {
+            std::this_thread::yield();
+        }
+        Clock::time_point start = Clock::now();
+        start_time.store(start.time_since_epoch().count(),
+                         std::memory_order_relaxed);
+        started.store(true, std::memory_order_release);
+
+        iq_sample_t dac[kConsumerChunkSize];
+        Clock::time_point tick = start;
+        while (!schedule.done()) {
+            tick += kConsumerTick;
+            std::this_thread::sleep_until(tick);
+
+            size_t position = schedule.position();
+            size_t n = schedule.Advance(
+                Seconds(Clock::now() - start),
+                produced.load(std::memory_order_acquire) - position);
+            for (size_t done = 0; done < n; ) {
+                size_t offset = (position + done) % capacity;
+                size_t chunk = std::min(
+                    {n - done, capacity - offset, kConsumerChunkSize});
+                memcpy(dac, &buffer[offset], chunk * sizeof(iq_sample_t));
+                done += chunk;
+            }
+            consumed.store(schedule.position(), std::memory_order_release);
+        }
+        report.elapsed = Seconds(Clock::now() - start);
+    });
+
+    std::vector<double> durations;
+    durations.reserve((total + block_size - 1) / block_size);
+    for (size_t position = 0; position < total; position += block_size) {
+        size_t n = std::min(block_size, total - position);
+        while (position + n >
+               consumed.load(std::memory_order_acquire) + capacity) {
+            std::this_thread::yield();
+        }
+
+        Clock::time_point begin = Clock::now();
+        source.Fill(&buffer[position % capacity], n);
+        Clock::time_point end = Clock::now();
+        produced.store(position + n, std::memory_order_release);
+        durations.push_back(Seconds(end - begin));
+
+        if (started.load(std::memory_order_acquire)) {
+            Clock::time_point start(Clock::duration(
+                start_time.load(std::memory_order_relaxed)));
+            if (schedule.Late(Seconds(end - start), position)) {
+                ++report.deadline_misses;
+            }
+        }
+    }
+    consumer.join();
+
+    report.underruns = schedule.underruns();
+    report.underrun_samples = schedule.underrun_samples();
+    report.num_blocks = durations.size();
+    report.latency = ComputeLatencyStats(std::move(durations));
+    if (report.latency.wcet > 0.0) {
+        report.sustainable_rate = block_size / report.latency.wcet;
+    }
+    return report;
+}
+
+std::vector<BlockSizeCalibration> CalibrateBlockSizes(
+    const FrameConfig& config, LutCache* luts, size_t buffer_size,
+    double rate, size_t num_samples) {
+    if (rate <= 0.0) {
+        rate = static_cast<double>(config.parameters.sample_rate);
+    }
+    std::vector<BlockSizeCalibration> calibrations;
+    for (size_t block_size = 64; block_size <= buffer_size / 2;
+         block_size *= 2) {
+        BlockSource source(config, luts, block_size);
+        std::unique_ptr<iq_sample_t[]> block(new iq_sample_t[block_size]);
+        size_t num_blocks = std::max<size_t>(1, num_samples / block_size);
+        std::vector<double> durations;
+        durations.reserve(num_blocks);
+        for (size_t i = 0; i < num_blocks; ++i) {
+            Clock::time_point begin = Clock::now();
+            source.Fill(block.get(), block_size);
+            durations.push_back(Seconds(Clock::now() - begin));
+        }
+
+        BlockSizeCalibration calibration;
+        calibration.block_size = block_size;
+        calibration.latency = ComputeLatencyStats(std::move(durations));
+        calibration.sustainable_rate = calibration.latency.wcet > 0.0
+            ? block_size / calibration.latency.wcet : 0.0;
+        calibration.sustainable =
+            calibration.sustainable_rate >= rate &&
+            calibration.latency.wcet * rate <= buffer_size - block_size;
+        calibrations.push_back(calibration);
+    }
+    return calibrations;
+}
@@ -0,0 +1,121 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Real-time paced streaming: the frame is generated by small blocks into a
+// fixed-size buffer, drained at exactly the sample rate by a consumer thread
+// standing in for the DAC. The producer runs as far ahead as the buffer
+// allows; the timing of each block is measured against a monotonic clock.
+//
+// A block misses its deadline when it is completed after the consumer needed
+// its first sample. The consumer underruns when the buffer does not hold the
+// samples it needs; it then plays silence for the missing samples, which
+// delays the rest of the stream.
+
+#ifndef PACED_STREAM_H_
+#define PACED_STREAM_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <vector>
+
+#include "frame_generator.h"
+
+struct PacedStreamOptions {
+    size_t block_size = 4096;      // Samples generated at once.
+    size_t buffer_size = 1 << 20;  // Samples between producer and consumer.
+    double rate = 0.0;             // Samples/s. 0: the sample rate.
+    size_t num_frames = 1;         // Frames streamed back to back.
+};
+
+// Generation time of one block, in seconds.
+struct LatencyStats {
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double p999 = 0.0;
+    double wcet = 0.0;
+};
+
+struct PacedStreamReport {
+    size_t block_size = 0;
+    size_t buffer_size = 0;  // Rounded to a whole number of blocks.
+    double rate = 0.0;
+
+    size_t num_blocks = 0;
+    size_t num_samples = 0;
+    double elapsed = 0.0;  // Seconds, from the start of the consumer.
+    LatencyStats latency;
+
+    size_t deadline_misses = 0;
+    size_t underruns = 0;         // Events.
+    size_t underrun_samples = 0;  // Samples replaced by silence.
+
+    // Highest rate at which this block size can be sustained: block_size
+    // divided by the worst-case generation time of a block.
+    double sustainable_rate = 0.0;
+};
+
+// Playback of the consumer standing in for the DAC, independent of the clock
+// and threads: times are in seconds since the consumer started. Advance() is
+// called by the consumer only; Late() can be called by the producer at the
+// same time.
+class PlaybackSchedule {
+   public:
+    PlaybackSchedule(double rate, size_t num_samples)
+        : rate_(rate), num_samples_(num_samples) { }
+
+    // Plays the samples due at time now, out of the available ones after
+    // position(). Returns the number of samples taken from the buffer; the
+    // missing ones are played as silence, which delays the rest of the
+    // stream.
+    size_t Advance(double now, size_t available);
+
+    // Whether a block starting at sample position, completed at time now,
+    // was completed after its first sample was due.
+    bool Late(double now, size_t position) const;
+
+    size_t position() const { return position_; }
+    bool done() const { return position_ >= num_samples_; }
+    size_t underruns() const { return underruns_; }
+    size_t underrun_samples() const { return underrun_samples_; }
+
+   private:
+    // Samples due at time now.
+    double Due(double now) const;
+
+    const double rate_;
+    const size_t num_samples_;
+
+    // Silence played so far, in seconds.
+    std::atomic<double> delay_{0.0};
+
+    size_t position_ = 0;
+    bool underrun_ = false;
+    size_t underruns_ = 0;
+    size_t underrun_samples_ = 0;
+};
+
+// Computes the percentiles of the block durations, in seconds.
+LatencyStats ComputeLatencyStats(std::vector<double> durations);
+
+PacedStreamReport RunPacedStream(const FrameConfig& config, LutCache* luts,
+                                 const PacedStreamOptions& options);
+
+struct BlockSizeCalibration {
+    size_t block_size;
+    LatencyStats latency;
+    double sustainable_rate;  // block_size / wcet.
+    // The rate is sustained, and a block can be generated while the buffer
+    // still holds enough samples for the consumer.
+    bool sustainable;
+};
+
+// Measures the generation time of blocks of increasing sizes (powers of two,
+// up to half the buffer), without pacing, over num_samples samples each.
+std::vector<BlockSizeCalibration> CalibrateBlockSizes(
+    const FrameConfig& config, LutCache* luts, size_t buffer_size,
+    double rate, size_t num_samples);
+
+#endif  // PACED_STREAM_H_
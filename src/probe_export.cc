@@ -0,0 +1,212 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Export of the probe points of a frame.
+
+#include "probe_export.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/strings/str_split.h"
+#include "work_stealing_pool.h"
+
+namespace {
+
+const char* const kProbeNames[kNumProbePoints] = {"symbols", "rrc",
+                                                   "phasor_bank", "zc"};
+const char* const kFormatNames[3] = {"bin", "hex", "tsv"};
+
+// Samples formatted by a task.
+const size_t kChunkSize = 1 << 16;
+
+// Chunks formatted per thread before the batch is written.
+const size_t kChunksPerThread = 2;
+
+const char kHexDigits[] = "0123456789abcdef";
+
+inline char* FormatHex(sample_t value, char* out) {
+    const uint16_t bits = static_cast<uint16_t>(value);
+    out[0] = kHexDigits[bits >> 12];
+    out[1] = kHexDigits[(bits >> 8) & 0xf];
+    out[2] = kHexDigits[(bits >> 4) & 0xf];
+    out[3] = kHexDigits[bits & 0xf];
+    return out + 4;
+}
+
+inline char* FormatDecimal(sample_t value, char* out) {
+    int32_t x = value;
+    if (x < 0) {
+        *out++ = '-';
+        x = -x;
+    }
+    char digits[5];
+    size_t n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + x % 10);
+        x /= 10;
+    } while (x);
+    while (n) {
+        *out++ = digits[--n];
+    }
+    return out;
+}
+
+// The samples of a probe point, and their number.
+const iq_sample_t* ProbeSamples(const Frame& frame, ProbePoint point,
+                                size_t* size) {
+    const dsp_memory_plan_t& plan = frame.plan;
+    switch (point) {
+        case ProbePoint::kSymbols:
+            *size = plan.num_symbols;
+            return frame.symbols;
+        case ProbePoint::kRrc:
+            *size = plan.num_samples_qd;
+            return frame.rrc_samples;
+        case ProbePoint::kPhasorBank:
+            *size = plan.num_samples - plan.num_samples_zc;
+            return frame.samples + plan.num_samples_zc;
+        case ProbePoint::kZc:
+            *size = plan.num_samples_zc;
+            return frame.samples;
+    }
+    return nullptr;
+}
+
+bool WriteProbe(const std::string& file_name, ProbeFormat format,
+                const iq_sample_t* samples, size_t size,
+                WorkStealingPool* pool) {
+    std::ofstream file(file_name, std::ios::binary);
+    if (!file) {
+        LOG(ERROR) << "Failed to open " << file_name;
+        return false;
+    }
+    if (format == ProbeFormat::kBinary) {
+        file.write(reinterpret_cast<const char*>(samples),
+                   size * sizeof(iq_sample_t));
+        return static_cast<bool>(file);
+    }
+
+    const size_t num_chunks = (size + kChunkSize - 1) / kChunkSize;
+    const size_t batch_size = std::min(
+        num_chunks, kChunksPerThread * pool->num_threads());
+    std::vector<std::unique_ptr<char[]>> text(batch_size);
+    std::vector<size_t> text_size(batch_size);
+    for (size_t i = 0; i < batch_size; ++i) {
+        text[i].reset(new char[kChunkSize * kMaxProbeLineSize]);
+    }
+    for (size_t first = 0; first < num_chunks; first += batch_size) {
+        const size_t n = std::min(batch_size, num_chunks - first);
+        for (size_t i = 0; i < n; ++i) {
+            pool->Submit([&, i](size_t) {
+                const size_t start = (first + i) * kChunkSize;
+                text_size[i] = FormatProbe(
+                    format, samples + start,
+                    std::min(kChunkSize, size - start), text[i].get());
+            });
+        }
+        pool->Wait();
+        for (size_t i = 0; i < n; ++i) {
+            file.write(text[i].get(), text_size[i]);
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+}  // namespace
+
+bool ParseProbePoints(const std::string& text, uint32_t* points) {
+    *points = 0;
+    if (text == "all") {
+        *points = (1 << kNumProbePoints) - 1;
+        return true;
+    }
+    for (absl::string_view name :
+         absl::StrSplit(text, ',', absl::SkipEmpty())) {
+        const char* const* entry =
+            std::find(kProbeNames, kProbeNames + kNumProbePoints, name);
+        if (entry == kProbeNames + kNumProbePoints) {
+            return false;
+        }
+        *points |= 1 << (entry - kProbeNames);
+    }
+    return true;
+}
+
+bool ParseProbeFormat(const std::string& text, ProbeFormat* format) {
+    for (int i = 0; i < 3; ++i) {
+        if (text == kFormatNames[i]) {
+            *format = static_cast<ProbeFormat>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string ProbeFileName(const std::string& prefix, ProbePoint point,
+                          ProbeFormat format) {
+    return prefix + kProbeNames[static_cast<int>(point)] + "." +
+           kFormatNames[static_cast<int>(format)];
+}
+
+size_t FormatProbe(ProbeFormat format, const iq_sample_t* samples,
+                   size_t size, char* out) {
+    char* p = out;
+    if (format == ProbeFormat::kHex) {
+        for (size_t n = 0; n < size; ++n) {
+            p = FormatHex(samples[n].i, p);
+            p = FormatHex(samples[n].q, p);
+            *p++ = '\n';
+        }
+    } else if (format == ProbeFormat::kTsv) {
+        for (size_t n = 0; n < size; ++n) {
+            p = FormatDecimal(samples[n].i, p);
+            *p++ = '\t';
+            p = FormatDecimal(samples[n].q, p);
+            *p++ = '\n';
+        }
+    } else {
+        memcpy(p, samples, size * sizeof(iq_sample_t));
+        p += size * sizeof(iq_sample_t);
+    }
+    return p - out;
+}
+
+bool WriteProbes(const FrameConfig& config, const Frame& frame,
+                 size_t num_threads) {
+    if (!config.probes) {
+        return true;
+    }
+    std::unique_ptr<WorkStealingPool> pool;
+    if (config.probe_format != ProbeFormat::kBinary) {
+        pool.reset(new WorkStealingPool(num_threads));
+    }
+    bool success = true;
+    for (size_t i = 0; i < kNumProbePoints; ++i) {
+        if (!(config.probes & (1 << i))) {
+            continue;
+        }
+        const ProbePoint point = static_cast<ProbePoint>(i);
+        size_t size = 0;
+        const iq_sample_t* samples = ProbeSamples(frame, point, &size);
+        if (!samples) {
+            LOG(ERROR) << kProbeNames[i] << " was not captured";
+            success = false;
+            continue;
+        }
+        const std::string file_name =
+            ProbeFileName(config.probe_prefix, point, config.probe_format);
+        if (!WriteProbe(file_name, config.probe_format, samples, size,
+                        pool.get())) {
+            LOG(ERROR) << "Failed to write " << file_name;
+            success = false;
+        }
+    }
+    return success;
+}
@@ -0,0 +1,48 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Export of the probe points of a frame (see ProbePoint in
+// frame_generator.h): the golden stimuli and responses of the testbenches of
+// hardware ports, stage by stage.
+//
+// Each probe point is written to its own file, named after the point:
+// probe_prefix + "symbols", "rrc", "phasor_bank" or "zc", with the extension
+// of the format (.bin, .hex or .tsv). The text formats are produced by
+// chunks: a batch of chunks is formatted in parallel, then written in order,
+// so that the memory taken stays bounded whatever the size of the frame.
+
+#ifndef PROBE_EXPORT_H_
+#define PROBE_EXPORT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "frame_generator.h"
+
+// Parses a comma-separated list of probe point names, or "all", into a bit
+// mask of 1 << ProbePoint. An empty list gives 0.
+bool ParseProbePoints(const std::string& text, uint32_t* points);
+
+// Parses bin, hex or tsv.
+bool ParseProbeFormat(const std::string& text, ProbeFormat* format);
+
+// File name of a probe point.
+std::string ProbeFileName(const std::string& prefix, ProbePoint point,
+                          ProbeFormat format);
+
+// Formats size samples. Returns the number of bytes written to out, which
+// must hold kMaxProbeLineSize bytes per sample.
+const size_t kMaxProbeLineSize = 14;
+size_t FormatProbe(ProbeFormat format, const iq_sample_t* samples,
+                   size_t size, char* out);
+
+// Writes the probe points of config.probes. num_threads is the number of
+// threads formatting the text files (0: one per hardware thread). Returns
+// false if a file could not be written.
+bool WriteProbes(const FrameConfig& config, const Frame& frame,
+                 size_t num_threads);
+
+#endif  // PROBE_EXPORT_H_
@@ -0,0 +1,301 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Capture of a stream to a file, with checkpoints.
+
+#include "stream_capture.h"
+
+extern "C" {
+#include "dsp/dsp_frame_generator.h"
+}
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "frame_container.h"
+
+namespace {
+
+const char kMagic[8] = {'E', 'A', 'C', 'H', 'K', 'P', 'T', '1'};
+const uint32_t kVersion = 1;
+
+const size_t kParametersOffset = 16;
+const size_t kFormatOffset = 84;
+const size_t kPositionOffset = 96;
+const size_t kHeaderSize = 144;
+
+std::string SystemError(const std::string& what, const std::string& name) {
+    return what + " " + name + ": " + strerror(errno);
+}
+
+bool WriteAll(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool ReadAll(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size) {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Position of the capture at a block boundary.
+struct CapturePosition {
+    uint64_t frame = 0;
+    uint64_t num_samples = 0;
+    uint64_t num_bytes = 0;
+};
+
+// Checkpoint header, without the position, for this configuration.
+std::vector<uint8_t> MakeHeader(const FrameConfig& config,
+                                const StreamCaptureOptions& options) {
+    std::vector<uint8_t> header(
+        kHeaderSize + dsp_frame_generator_snapshot_size(), 0);
+    uint8_t* p = header.data();
+    memcpy(p, kMagic, sizeof(kMagic));
+    PutU32(kVersion, p + 8);
+    PutU32(config.seed, p + 12);
+    SerializeParameters(config.parameters, p + kParametersOffset);
+    PutU32(config.output_format.format, p + kFormatOffset);
+    PutFloat(config.output_format.scale, p + kFormatOffset + 4);
+    PutU32(static_cast<uint32_t>(config.output_format.saturation),
+           p + kFormatOffset + 8);
+    PutU64(options.block_size, p + kPositionOffset);
+    PutU64(options.num_frames, p + kPositionOffset + 8);
+    PutU64(dsp_frame_generator_snapshot_size(), p + kPositionOffset + 40);
+    return header;
+}
+
+// Writes the checkpoint to a temporary file, then renames it, so that the
+// checkpoint file always holds a complete checkpoint.
+bool WriteCheckpoint(const std::string& file_name,
+                     std::vector<uint8_t>* checkpoint,
+                     const CapturePosition& position,
+                     const frame_generator_state_t& generator,
+                     std::string* error) {
+    uint8_t* p = checkpoint->data();
+    PutU64(position.frame, p + kPositionOffset + 16);
+    PutU64(position.num_samples, p + kPositionOffset + 24);
+    PutU64(position.num_bytes, p + kPositionOffset + 32);
+    dsp_frame_generator_save(&generator, p + kHeaderSize);
+
+    const std::string temporary = file_name + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        *error = SystemError("Failed to create", temporary);
+        return false;
+    }
+    bool success = WriteAll(fd, p, checkpoint->size()) && fsync(fd) == 0;
+    close(fd);
+    if (!success || rename(temporary.c_str(), file_name.c_str()) != 0) {
+        *error = SystemError("Failed to write", file_name);
+        return false;
+    }
+    return true;
+}
+
+// Reads the position and the generator state from the checkpoint, after
+// checking that it was written for this configuration.
+bool ReadCheckpoint(const std::string& file_name,
+                    const std::vector<uint8_t>& expected,
+                    CapturePosition* position,
+                    frame_generator_state_t* generator, std::string* error) {
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        *error = SystemError("Failed to open", file_name);
+        return false;
+    }
+    std::vector<uint8_t> checkpoint(expected.size());
+    uint8_t extra;
+    bool success = ReadAll(fd, checkpoint.data(), checkpoint.size()) &&
+                   read(fd, &extra, 1) == 0;
+    close(fd);
+    const uint8_t* p = checkpoint.data();
+    if (!success || memcmp(p, kMagic, sizeof(kMagic)) ||
+        GetU32(p + 8) != kVersion ||
+        GetU64(p + kPositionOffset + 40) !=
+            dsp_frame_generator_snapshot_size()) {
+        *error = file_name + ": not a checkpoint of this build";
+        return false;
+    }
+    // Everything but the position must match. The number of frames may
+    // differ, to extend or shorten a capture.
+    if (memcmp(p, expected.data(), kPositionOffset) ||
+        GetU64(p + kPositionOffset) != GetU64(&expected[kPositionOffset])) {
+        *error = file_name + ": checkpoint of another configuration";
+        return false;
+    }
+    position->frame = GetU64(p + kPositionOffset + 16);
+    position->num_samples = GetU64(p + kPositionOffset + 24);
+    position->num_bytes = GetU64(p + kPositionOffset + 32);
+    if (!dsp_frame_generator_restore(generator, p + kHeaderSize)) {
+        *error = file_name + ": invalid generator state";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool CaptureStream(const FrameConfig& config, LutCache* luts,
+                   const StreamCaptureOptions& options,
+                   StreamCaptureReport* report, std::string* error) {
+    *report = StreamCaptureReport();
+    const dsp_sample_format_t format = config.output_format.format;
+    if (!options.block_size || !options.num_frames ||
+        (format == DSP_SAMPLE_FORMAT_PACKED14 && options.block_size % 2)) {
+        *error = "Invalid block size or number of frames";
+        return false;
+    }
+    const bool checkpoints = !options.checkpoint.empty();
+    if (checkpoints && !options.checkpoint_interval) {
+        *error = "Invalid checkpoint interval";
+        return false;
+    }
+    if (options.resume && !checkpoints) {
+        *error = "Resuming requires a checkpoint file";
+        return false;
+    }
+
+    dsp_memory_plan_t plan;
+    dsp_memory_plan_streaming(&plan, &config.parameters, options.block_size);
+    std::unique_ptr<iq_sample_t[]> symbols(
+        new iq_sample_t[plan.symbols_per_block]);
+    frame_generator_state_t generator;
+    auto restart = [&]() {
+        dsp_frame_generator_init(
+            &generator, &config.parameters, config.seed, luts->phasor(),
+            luts->rrc(config.parameters.rrc_roll_off), symbols.get(),
+            options.block_size);
+    };
+    restart();
+    const uint64_t frame_size = generator.num_samples;
+    const uint64_t total = frame_size * options.num_frames;
+
+    std::vector<uint8_t> checkpoint = MakeHeader(config, options);
+    CapturePosition position;
+    if (options.resume &&
+        !ReadCheckpoint(options.checkpoint, checkpoint, &position,
+                        &generator, error)) {
+        return false;
+    }
+    if (position.num_samples > total) {
+        *error = options.checkpoint + ": beyond the end of the capture";
+        return false;
+    }
+
+    // The samples written after the checkpoint are discarded.
+    const std::string& output = config.output;
+    int fd = open(output.c_str(),
+                  O_WRONLY | (options.resume ? 0 : O_CREAT | O_TRUNC), 0644);
+    if (fd < 0) {
+        *error = SystemError("Failed to open", output);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<uint64_t>(st.st_size) < position.num_bytes) {
+        *error = output + ": shorter than the checkpoint";
+        close(fd);
+        return false;
+    }
+    if (ftruncate(fd, position.num_bytes) != 0 ||
+        lseek(fd, position.num_bytes, SEEK_SET) < 0) {
+        *error = SystemError("Failed to truncate", output);
+        close(fd);
+        return false;
+    }
+    report->resumed_samples = position.num_samples;
+
+    sample_format_state_t converter;
+    dsp_sample_format_init(&converter, format, config.output_format.scale,
+                           config.output_format.saturation);
+    std::unique_ptr<iq_sample_t[]> block(new iq_sample_t[options.block_size]);
+    std::vector<char> bytes(
+        dsp_sample_format_size(format, options.block_size));
+
+    bool success = true;
+    if (checkpoints && !options.resume) {
+        // A capture interrupted before its first periodic checkpoint is
+        // resumed from the start.
+        success = WriteCheckpoint(options.checkpoint, &checkpoint, position,
+                                  generator, error);
+        ++report->num_checkpoints;
+    }
+    while (success && position.num_samples < total &&
+           (!options.max_blocks || report->num_blocks < options.max_blocks)) {
+        size_t size = static_cast<size_t>(std::min<uint64_t>(
+            options.block_size, total - position.num_samples));
+        iq_sample_t* out = block.get();
+        for (size_t remaining = size; remaining;) {
+            size_t n = dsp_frame_generator_process(&generator, out, remaining);
+            out += n;
+            remaining -= n;
+            if (remaining) {
+                ++position.frame;
+                restart();
+            }
+        }
+        const size_t num_bytes = dsp_sample_format_size(format, size);
+        dsp_sample_format_process(&converter, block.get(), bytes.data(),
+                                  size);
+        if (!WriteAll(fd, bytes.data(), num_bytes)) {
+            *error = SystemError("Failed to write", output);
+            success = false;
+            break;
+        }
+        position.num_samples += size;
+        position.num_bytes += num_bytes;
+        ++report->num_blocks;
+
+        // The samples are on disk before the checkpoint refers to them.
+        const bool last = position.num_samples == total;
+        if (checkpoints &&
+            (last || report->num_blocks % options.checkpoint_interval == 0)) {
+            if (fsync(fd) != 0) {
+                *error = SystemError("Failed to flush", output);
+                success = false;
+                break;
+            }
+            success = WriteCheckpoint(options.checkpoint, &checkpoint,
+                                      position, generator, error);
+            ++report->num_checkpoints;
+        }
+    }
+    if (close(fd) != 0 && success) {
+        *error = SystemError("Failed to close", output);
+        success = false;
+    }
+    report->num_samples = position.num_samples;
+    report->complete = success && position.num_samples == total;
+    return success;
+}
@@ -0,0 +1,70 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Capture of a stream to a file, with checkpoints: frames are generated back
+// to back by blocks, by the streaming frame generator, and appended to the
+// output file (in its output format) as they come, without pacing.
+//
+// Every checkpoint_interval blocks, between two blocks, the output file is
+// flushed to disk, then the state of the generator (see
+// dsp_frame_generator_save) and the position in the output are written to
+// the checkpoint file, which is replaced at once. A capture interrupted at
+// any time is resumed from its last checkpoint: the output file is cut back
+// to the samples written at that time, and the capture continues with the
+// same bytes as an uninterrupted one.
+//
+// Checkpoint file (little-endian):
+//   0    magic "EACHKPT1"
+//   8    version (uint32), seed (uint32)
+//   16   parameters, as in the index of a frame container (68 bytes, see
+//        frame_container.h)
+//   84   output format (uint32), scale (float32), saturation (int32)
+//   96   block size, number of frames, frame being generated, samples
+//        written, size of the output file in bytes, size of the snapshot
+//        (uint64 each)
+//   144  snapshot of the generator
+// A snapshot can only be restored by the build which made it.
+
+#ifndef STREAM_CAPTURE_H_
+#define STREAM_CAPTURE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "frame_generator.h"
+
+struct StreamCaptureOptions {
+    size_t block_size = 4096;  // Samples generated at once.
+    size_t num_frames = 1;     // Frames captured back to back.
+
+    std::string checkpoint;             // Checkpoint file; empty: none.
+    size_t checkpoint_interval = 1024;  // Blocks between checkpoints.
+
+    // Continue the capture from the checkpoint file, which must have been
+    // written for the same configuration.
+    bool resume = false;
+
+    // Stop after this many blocks, as if interrupted (0: never).
+    size_t max_blocks = 0;
+};
+
+struct StreamCaptureReport {
+    uint64_t num_samples = 0;      // In the output file.
+    uint64_t resumed_samples = 0;  // Already there when resuming.
+    size_t num_blocks = 0;         // Generated by this run.
+    size_t num_checkpoints = 0;
+    bool complete = false;
+};
+
+// Captures options.num_frames frames of config to config.output. Only the
+// Gaussian symbols and the direct RRC filter of the streaming generator are
+// supported. Returns false and sets error if a file can't be read or written,
+// or if the checkpoint does not match the configuration.
+bool CaptureStream(const FrameConfig& config, LutCache* luts,
+                   const StreamCaptureOptions& options,
+                   StreamCaptureReport* report, std::string* error);
+
+#endif  // STREAM_CAPTURE_H_
@@ -0,0 +1,219 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Parameter sweep.
+
+#include "sweep.h"
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <sstream>
+
+#include "absl/log/log.h"
+#include "absl/strings/numbers.h"
+#include "frame_verifier.h"
+#include "probe_export.h"
+#include "work_stealing_pool.h"
+
+namespace {
+
+bool ParseU32(const std::string& value, uint32_t* out) {
+    if (absl::SimpleAtoi(value, out)) {
+        return true;
+    }
+    // Accept the 200e6 notation used for frequencies.
+    double v;
+    if (!absl::SimpleAtod(value, &v) || v < 0 || v > 4294967295.0) {
+        return false;
+    }
+    *out = static_cast<uint32_t>(v);
+    return true;
+}
+
+bool ParseFloat(const std::string& value, float* out) {
+    double v;
+    if (!absl::SimpleAtod(value, &v)) {
+        return false;
+    }
+    *out = static_cast<float>(v);
+    return true;
+}
+
+}  // namespace
+
+bool SetFrameConfigValue(const std::string& key, const std::string& value,
+                         FrameConfig* config) {
+    dsp_parameter_t* p = &config->parameters;
+    if (key == "name") {
+        config->name = value;
+        return !value.empty();
+    } else if (key == "seed") {
+        return ParseU32(value, &config->seed);
+    } else if (key == "modulation") {
+        return ParseModulation(value, &config->modulation.type);
+    } else if (key == "modulation_order") {
+        uint32_t order;
+        if (!ParseU32(value, &order)) {
+            return false;
+        }
+        config->modulation.order = order;
+        return true;
+    } else if (key == "shaping") {
+        return ParseFloat(value, &config->modulation.shaping);
+    } else if (key == "compress") {
+        return absl::SimpleAtob(value, &config->compress);
+    } else if (key == "planar") {
+        return absl::SimpleAtob(value, &config->planar);
+    } else if (key == "pipeline") {
+        return absl::SimpleAtob(value, &config->pipeline);
+    } else if (key == "interpolation_stages") {
+        uint32_t num_stages;
+        if (!ParseU32(value, &num_stages)) {
+            return false;
+        }
+        config->interpolation_stages = num_stages;
+        return true;
+    } else if (key == "verify") {
+        return absl::SimpleAtob(value, &config->verify);
+    } else if (key == "output_format") {
+        return ParseSampleFormat(value, &config->output_format.format);
+    } else if (key == "output_scale") {
+        return ParseFloat(value, &config->output_format.scale);
+    } else if (key == "output_saturation") {
+        return absl::SimpleAtoi(value, &config->output_format.saturation) &&
+               config->output_format.saturation >= 0;
+    } else if (key == "sample_rate") {
+        return ParseU32(value, &p->sample_rate);
+    } else if (key == "symbol_rate") {
+        return ParseU32(value, &p->symbol_rate);
+    } else if (key == "zc_rate") {
+        return ParseU32(value, &p->zc_rate);
+    } else if (key == "zc_length") {
+        return ParseU32(value, &p->zc_length);
+    } else if (key == "zc_root") {
+        return ParseU32(value, &p->zc_root);
+    } else if (key == "zc_shift") {
+        return ParseU32(value, &p->zc_shift);
+    } else if (key == "num_symbols") {
+        return ParseU32(value, &p->num_symbols);
+    } else if (key == "num_null_symbols") {
+        return ParseU32(value, &p->num_null_symbols);
+    } else if (key == "symbol_scale") {
+        return ParseU32(value, &p->symbol_scale);
+    } else if (key == "symbol_max_value") {
+        return ParseU32(value, &p->symbol_max_value);
+    } else if (key == "symbol_clamp") {
+        return absl::SimpleAtob(value, &p->symbol_clamp);
+    } else if (key == "rrc_roll_off") {
+        return ParseFloat(value, &p->rrc_roll_off);
+    } else if (key == "shift_frequency") {
+        return ParseU32(value, &p->shift_frequency);
+    } else if (key == "pilot_1_freq") {
+        return ParseU32(value, &p->pilot_frequency[0]);
+    } else if (key == "pilot_1_amplitude") {
+        return ParseFloat(value, &p->pilot_amplitude[0]);
+    } else if (key == "pilot_2_freq") {
+        return ParseU32(value, &p->pilot_frequency[1]);
+    } else if (key == "pilot_2_amplitude") {
+        return ParseFloat(value, &p->pilot_amplitude[1]);
+    }
+    return false;
+}
+
+bool ParseSweep(std::istream& in, const FrameConfig& base,
+                const std::string& output_dir,
+                std::vector<FrameConfig>* configs, std::string* error) {
+    std::set<std::string> names;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        std::istringstream fields(line);
+        std::string field;
+        if (!(fields >> field) || field[0] == '#') {
+            continue;
+        }
+
+        FrameConfig config = base;
+        config.name = "frame_" + std::to_string(configs->size());
+        do {
+            size_t separator = field.find('=');
+            std::string key = field.substr(0, separator);
+            std::string value = separator == std::string::npos
+                                    ? std::string()
+                                    : field.substr(separator + 1);
+            if (separator == std::string::npos ||
+                !SetFrameConfigValue(key, value, &config)) {
+                *error = "line " + std::to_string(line_number) +
+                         ": invalid setting \"" + field + "\"";
+                return false;
+            }
+        } while (fields >> field);
+
+        if (!IsValidModulation(config.modulation)) {
+            *error = "line " + std::to_string(line_number) +
+                     ": invalid modulation";
+            return false;
+        }
+        if (!IsValidInterpolation(config.parameters,
+                                  config.interpolation_stages)) {
+            *error = "line " + std::to_string(line_number) +
+                     ": invalid interpolation_stages";
+            return false;
+        }
+        if (!names.insert(config.name).second) {
+            *error = "line " + std::to_string(line_number) +
+                     ": duplicate name \"" + config.name + "\"";
+            return false;
+        }
+        config.output = output_dir + "/" + config.name + "_iq.bin";
+        config.output_symbols = output_dir + "/" + config.name + "_symbols.tsv";
+        config.probe_prefix = output_dir + "/" + config.name + "_probe_";
+        configs->push_back(config);
+    }
+    return true;
+}
+
+size_t RunSweep(const std::vector<FrameConfig>& configs, size_t num_threads,
+                HugePages huge_pages, bool numa_local,
+                FrameContainerWriter* container) {
+    LutCache luts;
+    std::atomic<size_t> failures(0);
+    std::atomic<size_t> done(0);
+
+    WorkStealingPool pool(num_threads);
+
+    // One arena per worker, created by the worker itself so that its
+    // buffers are local to its NUMA node, and reused by all its frames.
+    std::vector<std::unique_ptr<FrameBufferArena>> arenas(
+        pool.num_threads());
+
+    for (const FrameConfig& config : configs) {
+        pool.Submit([&, config](size_t worker) {
+            std::unique_ptr<FrameBufferArena>& arena = arenas[worker];
+            if (!arena) {
+                arena.reset(new FrameBufferArena(huge_pages, numa_local));
+            }
+            Frame frame = GenerateFrame(config, &luts, arena.get(), false);
+#ifdef DSP_STATISTICS
+            LogFrameStatistics(config.name, frame.statistics);
+#endif  // DSP_STATISTICS
+            // The frames are already written in parallel.
+            bool success =
+                (!config.verify ||
+                 VerifyGeneratedFrame(config, frame, &luts)) &&
+                WriteProbes(config, frame, 1) &&
+                (container ? container->Append(config, frame)
+                           : WriteFrame(config, frame, arena.get(), 1));
+            if (!success) {
+                ++failures;
+            }
+            LOG(INFO) << "[" << ++done << "/" << configs.size() << "] "
+                      << config.name;
+        });
+    }
+    pool.Wait();
+    return failures;
+}
@@ -0,0 +1,45 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Parameter sweep: generates many frames, with different configurations, in
+// parallel.
+//
+// A sweep file lists one frame configuration per line, as whitespace-separated
+// key=value pairs. Keys are the names of the command line flags (for example
+// "rrc_roll_off=0.2 seed=3 zc_root=7"), plus "name", used to name the output
+// files <name>_iq.bin and <name>_symbols.tsv (default: frame_<index>). Keys
+// which are not specified take the value given on the command line. Empty
+// lines and lines starting with # are ignored.
+
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "frame_buffer_arena.h"
+#include "frame_container.h"
+#include "frame_generator.h"
+
+// Sets one parameter of a frame configuration. Returns false if the key is
+// unknown or the value is invalid.
+bool SetFrameConfigValue(const std::string& key, const std::string& value,
+                         FrameConfig* config);
+
+// Parses a sweep file. On failure, returns false and sets error.
+bool ParseSweep(std::istream& in, const FrameConfig& base,
+                const std::string& output_dir,
+                std::vector<FrameConfig>* configs, std::string* error);
+
+// Generates and writes all the frames, distributed on num_threads threads
+// (0 for one per hardware thread). The LUTs are shared by all the frames.
+// When container is not null, the frames are appended to it, in the order in
+// which they complete, instead of being written to their own files. Returns
+// the number of frames which could not be written.
+size_t RunSweep(const std::vector<FrameConfig>& configs, size_t num_threads,
+                HugePages huge_pages, bool numa_local,
+                FrameContainerWriter* container);
+
+#endif  // SWEEP_H_
@@ -0,0 +1,98 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Minimal work-stealing thread pool.
+
+#include "work_stealing_pool.h"
+
+WorkStealingPool::WorkStealingPool(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+    }
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        queues_.emplace_back(new Queue);
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads_.emplace_back(&WorkStealingPool::Run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_available_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::Submit(Task task) {
+    size_t queue;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue = next_queue_;
+        next_queue_ = (next_queue_ + 1) % queues_.size();
+        ++pending_;
+        ++queued_;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+        queues_[queue]->tasks.push_back(std::move(task));
+    }
+    work_available_.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    all_done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+bool WorkStealingPool::Pop(size_t worker, Task* task) {
+    const size_t num_queues = queues_.size();
+    for (size_t i = 0; i < num_queues; ++i) {
+        Queue* queue = queues_[(worker + i) % num_queues].get();
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            *task = std::move(queue->tasks.back());
+            queue->tasks.pop_back();
+        } else {
+            *task = std::move(queue->tasks.front());
+            queue->tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::Run(size_t worker) {
+    while (true) {
+        Task task;
+        if (Pop(worker, &task)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --queued_;
+            }
+            task(worker);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_ == 0) {
+                all_done_.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_available_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0) {
+            return;
+        }
+    }
+}
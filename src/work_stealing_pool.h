@@ -0,0 +1,62 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Minimal work-stealing thread pool. Each worker has its own task queue;
+// submitted tasks are dealt round-robin, workers pop from the back of their
+// own queue and, when it is empty, steal from the front of the others.
+
+#ifndef WORK_STEALING_POOL_H_
+#define WORK_STEALING_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+   public:
+    // The task receives the index of the worker running it, in
+    // [0, num_threads()), to let it use per-worker resources.
+    typedef std::function<void(size_t worker)> Task;
+
+    // num_threads = 0 uses one thread per hardware thread.
+    explicit WorkStealingPool(size_t num_threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t num_threads() const { return threads_.size(); }
+
+    void Submit(Task task);
+
+    // Blocks until all the submitted tasks have completed.
+    void Wait();
+
+   private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool Pop(size_t worker, Task* task);
+    void Run(size_t worker);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable all_done_;
+    size_t queued_ = 0;
+    size_t pending_ = 0;
+    size_t next_queue_ = 0;
+    bool stop_ = false;
+};
+
+#endif  // WORK_STEALING_POOL_H_
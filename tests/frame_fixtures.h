@@ -0,0 +1,47 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Frame configurations shared by the tests: the rates of the command-line
+// tool (20 samples per symbol, ZC sequence of length 3989, two pilots), with
+// few symbols. Tests override the fields they exercise.
+
+#ifndef TESTS_FRAME_FIXTURES_H_
+#define TESTS_FRAME_FIXTURES_H_
+
+extern "C" {
+#include "dsp/dsp_parameters.h"
+}
+
+#include <stdint.h>
+
+#include "frame_generator.h"
+
+inline dsp_parameter_t SmallFrameParameters(uint32_t num_symbols = 1000) {
+    dsp_parameter_t p = {};
+    p.sample_rate = 2000000000;
+    p.symbol_rate = 100000000;
+    p.zc_rate = 50000000;
+    p.zc_length = 3989;
+    p.zc_root = 5;
+    p.num_symbols = num_symbols;
+    p.num_null_symbols = 10;
+    p.symbol_scale = 7500;
+    p.symbol_max_value = 0x5fff;
+    p.pilot_frequency[0] = 200000000;
+    p.pilot_frequency[1] = 220000000;
+    p.pilot_amplitude[0] = 0.16f;
+    p.pilot_amplitude[1] = 0.16f;
+    p.rrc_roll_off = 0.3f;
+    return p;
+}
+
+inline FrameConfig SmallFrameConfig(uint32_t num_symbols = 1000,
+                                    uint32_t seed = 7) {
+    FrameConfig config;
+    config.parameters = SmallFrameParameters(num_symbols);
+    config.seed = seed;
+    return config;
+}
+
+#endif  // TESTS_FRAME_FIXTURES_H_
@@ -9,14 +9,26 @@
 #include "testdata_path.h"
 
 extern "C" {
+#include "dsp/dsp_graph.h"
+#include "dsp/dsp_interpolator.h"
+#include "dsp/dsp_lut_registry.h"
+#include "dsp/dsp_luts.h"
+#include "dsp/dsp_memory_plan.h"
+#include "dsp/dsp_planar.h"
 #include "dsp/dsp_rng.h"
 #include "dsp/dsp_rrc_filter.h"
+#include "dsp/dsp_sample_format.h"
+#include "dsp/dsp_statistics.h"
+#include "dsp/dsp_symbol_mapper.h"
 #include "dsp/dsp_zc_generator.h"
 }
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
@@ -51,6 +63,13 @@ void CheckArray(const vector<iq_sample_t>& a, const vector<iq_sample_t>& b,
     }
 }
 
+// The phasor LUT, obtained once for all the tests.
+const iq_sample_t* PhasorLut() {
+    static iq_sample_t lut_phasor[LUT_PHASOR_SIZE];
+    static const iq_sample_t* table = dsp_phasor_bank_get_lut(lut_phasor);
+    return table;
+}
+
 TEST(RNGTest, FirstSamples) {
     const size_t num_samples = 10;
     vector<iq_sample_t> samples(num_samples);
@@ -66,9 +85,9 @@ TEST(ZCGeneratorTest, FullSequence) {
     size_t zc_rate = 200000000 / 5;
     zc_generator_state_t zc;
 
-    iq_sample_t lut_phasor[LUT_PHASOR_SIZE];
+    const iq_sample_t* lut_phasor = PhasorLut();
 
-    dsp_zc_generator_init(&zc, &lut_phasor[0], 3989, 5, 0, zc_rate, sr);
+    dsp_zc_generator_init(&zc, lut_phasor, 3989, 5, 0, zc_rate, sr);
     size_t num_samples = (sr / zc_rate) * zc.length;
     vector<iq_sample_t> samples(num_samples);
     dsp_zc_generator_process(&zc, samples.data(), num_samples);
@@ -122,7 +141,7 @@ class PhasorsTest : public ::testing::Test {
             {16384, 0}, {16384, 0}, {16384, 0}, {16384, 0},
             {0, -8192}, {0, -8192}, {0, -8192}, {0, -8192},
             {0, -8192}, {0, -8192}, {0, -8192}, {0, -8192}};
-        iq_sample_t lut_phasor[LUT_PHASOR_SIZE];
+        const iq_sample_t* lut_phasor = PhasorLut();
         phasor_bank_state_t phasor_bank;
         uint32_t f[3] = {1, 2, 4};
         dsp_phasor_bank_init(&phasor_bank, lut_phasor,
@@ -154,3 +173,831 @@ TEST_F(PhasorsTest, ShiftAndPilots) {
     }
     RunPhasorTest(amplitude, expected);
 }
+
+TEST_F(PhasorsTest, KernelSelection) {
+    const iq_sample_t* lut_phasor = PhasorLut();
+    phasor_bank_state_t phasor_bank;
+    uint32_t f[3] = {0, 2, 4};
+    float amplitude[3] = {0.7f, 0.0f, 0.0f};
+    dsp_phasor_bank_init(&phasor_bank, lut_phasor,
+                         PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, f, amplitude,
+                         8);
+    EXPECT_EQ(phasor_bank.algorithm, PHASOR_BANK_ALGORITHM_SCALE);
+
+    amplitude[2] = 0.1f;
+    dsp_phasor_bank_init(&phasor_bank, lut_phasor,
+                         PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, f, amplitude,
+                         8);
+    EXPECT_EQ(phasor_bank.algorithm, PHASOR_BANK_ALGORITHM_SCALE_PILOTS);
+    EXPECT_EQ(phasor_bank.num_active_pilots, 1);
+
+    dsp_phasor_bank_init_tones(&phasor_bank, lut_phasor,
+                               PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, 3, 0x3,
+                               f, amplitude, 8);
+    EXPECT_EQ(phasor_bank.algorithm, PHASOR_BANK_ALGORITHM_SCALE);
+
+    f[0] = 1;
+    dsp_phasor_bank_init_tones(&phasor_bank, lut_phasor,
+                               PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, 1,
+                               PHASOR_BANK_ALL_TONES, f, amplitude, 8);
+    EXPECT_EQ(phasor_bank.algorithm, PHASOR_BANK_ALGORITHM_SHIFT);
+
+    dsp_phasor_bank_init_tones(&phasor_bank, lut_phasor,
+                               PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, 3, 0x6,
+                               f, amplitude, 8);
+    EXPECT_EQ(phasor_bank.algorithm, PHASOR_BANK_ALGORITHM_PILOTS);
+}
+
+TEST_F(PhasorsTest, SpecializedKernelsMatchGeneric) {
+    const size_t num_samples = 1000;
+    vector<iq_sample_t> in(num_samples);
+    rng_state_t rng;
+    dsp_rng_init(&rng, 7500, 0x5fff, false, 1, 0);
+    dsp_rng_generate_icdf(&rng, in.data(), num_samples);
+
+    const iq_sample_t* lut_phasor = PhasorLut();
+    uint32_t f[3] = {0, 200, 220};
+    float amplitude[3] = {0.70710678118f, 0.16f, 0.0f};
+
+    phasor_bank_state_t generic;
+    dsp_phasor_bank_init(&generic, lut_phasor,
+                         PHASOR_BANK_ALGORITHM_SHIFT_PILOTS, f, amplitude,
+                         2000);
+    vector<iq_sample_t> expected = in;
+    dsp_phasor_bank_process(&generic, expected.data(), num_samples);
+
+    phasor_bank_state_t specialized;
+    dsp_phasor_bank_init(&specialized, lut_phasor,
+                         PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, f, amplitude,
+                         2000);
+    EXPECT_EQ(specialized.algorithm, PHASOR_BANK_ALGORITHM_SCALE_PILOTS);
+    vector<iq_sample_t> out = in;
+    dsp_phasor_bank_process(&specialized, out.data(), 333);
+    dsp_phasor_bank_process(&specialized, &out[333], num_samples - 333);
+    CheckArray(out, expected, 0);
+
+    for (size_t i = 0; i < NUM_PHASORS; ++i) {
+        EXPECT_EQ(specialized.phase[i], generic.phase[i]);
+    }
+}
+
+TEST_F(PhasorsTest, PilotCacheMatchesAccumulators) {
+    const size_t num_samples = 1 << 20;
+    vector<iq_sample_t> in(num_samples);
+    rng_state_t rng;
+    dsp_rng_init(&rng, 7500, 0x5fff, false, 1, 0);
+    dsp_rng_generate_icdf(&rng, in.data(), num_samples);
+
+    const iq_sample_t* lut_phasor = PhasorLut();
+    uint32_t f[3] = {50000000, 200000000, 220000000};
+    float amplitude[3] = {0.70710678118f, 0.16f, 0.16f};
+
+    phasor_bank_state_t reference;
+    dsp_phasor_bank_init(&reference, lut_phasor,
+                         PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, f, amplitude,
+                         2000000000);
+    EXPECT_EQ(reference.pilot_cache_period, 100);
+    reference.pilot_cache_period = 0;
+    vector<iq_sample_t> expected = in;
+    dsp_phasor_bank_process(&reference, expected.data(), num_samples);
+
+    phasor_bank_state_t cached;
+    dsp_phasor_bank_init(&cached, lut_phasor,
+                         PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, f, amplitude,
+                         2000000000);
+    vector<iq_sample_t> out = in;
+    size_t block_size = 1;
+    for (size_t i = 0; i < num_samples;) {
+        size_t n = min(block_size, num_samples - i);
+        dsp_phasor_bank_process(&cached, &out[i], n);
+        i += n;
+        block_size = block_size * 3 % 1021 + 1;
+    }
+    CheckArray(out, expected, 0);
+}
+
+TEST_F(PhasorsTest, RetuneIsScheduledAndPhaseContinuous) {
+    const size_t num_samples = 3000;
+    const size_t retune_position = 1234;
+    vector<iq_sample_t> in(num_samples);
+    rng_state_t rng;
+    dsp_rng_init(&rng, 7500, 0x5fff, false, 1, 0);
+    dsp_rng_generate_icdf(&rng, in.data(), num_samples);
+
+    const iq_sample_t* lut_phasor = PhasorLut();
+    uint32_t f[3] = {50000000, 200000000, 220000000};
+    float amplitude[3] = {0.70710678118f, 0.16f, 0.16f};
+    uint32_t new_f[3] = {0, 210000000, 230000001};
+    float new_amplitude[3] = {0.70710678118f, 0.16f, 0.16f};
+
+    // Retune applied at once, when the position is reached.
+    phasor_bank_state_t reference;
+    dsp_phasor_bank_init(&reference, lut_phasor,
+                         PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, f, amplitude,
+                         2000000000);
+    vector<iq_sample_t> expected = in;
+    dsp_phasor_bank_process(&reference, expected.data(), retune_position);
+    phase_t phase[NUM_PHASORS];
+    for (size_t i = 0; i < NUM_PHASORS; ++i) {
+        phase[i] = reference.phase[i];
+    }
+    dsp_phasor_bank_retune(&reference, new_f, new_amplitude, retune_position,
+                           0);
+    EXPECT_EQ(reference.algorithm, PHASOR_BANK_ALGORITHM_SCALE_PILOTS);
+    for (size_t i = 0; i < NUM_PHASORS; ++i) {
+        EXPECT_EQ(reference.phase[i], phase[i]);
+    }
+    dsp_phasor_bank_process(&reference, &expected[retune_position],
+                            num_samples - retune_position);
+
+    // Retune scheduled in advance, with blocks straddling the position.
+    phasor_bank_state_t scheduled;
+    dsp_phasor_bank_init(&scheduled, lut_phasor,
+                         PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, f, amplitude,
+                         2000000000);
+    dsp_phasor_bank_retune(&scheduled, new_f, new_amplitude, retune_position,
+                           0);
+    EXPECT_EQ(scheduled.algorithm, PHASOR_BANK_ALGORITHM_SHIFT_PILOTS);
+    vector<iq_sample_t> out = in;
+    for (size_t i = 0; i < num_samples; i += 1000) {
+        dsp_phasor_bank_process(&scheduled, &out[i], 1000);
+    }
+    CheckArray(out, expected, 0);
+    for (size_t i = 0; i < NUM_PHASORS; ++i) {
+        EXPECT_EQ(scheduled.phase[i], reference.phase[i]);
+    }
+}
+
+TEST_F(PhasorsTest, RetuneRampsAmplitudes) {
+    const size_t ramp_size = 800;
+    const iq_sample_t* lut_phasor = PhasorLut();
+    uint32_t f[3] = {0, 1, 0};
+    float amplitude[3] = {0.0f, 0.5f, 0.0f};
+    phasor_bank_state_t phasor_bank;
+    dsp_phasor_bank_init_tones(&phasor_bank, lut_phasor,
+                               PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, 3, 0x6,
+                               f, amplitude, 1000);
+    EXPECT_EQ(phasor_bank.algorithm, PHASOR_BANK_ALGORITHM_PILOTS);
+
+    vector<iq_sample_t> out(1000, iq_sample_t{0, 0});
+    dsp_phasor_bank_process(&phasor_bank, out.data(), 100);
+
+    // The pilot fades out, and the bank is then bypassed.
+    float silent[3] = {0.0f, 0.0f, 0.0f};
+    dsp_phasor_bank_retune(&phasor_bank, f, silent, 100, ramp_size);
+    EXPECT_EQ(phasor_bank.algorithm, PHASOR_BANK_ALGORITHM_BYPASS);
+    for (size_t i = 100; i < out.size(); i += 64) {
+        dsp_phasor_bank_process(&phasor_bank, &out[i],
+                                min<size_t>(64, out.size() - i));
+    }
+    EXPECT_EQ(phasor_bank.ramp_remaining, 0);
+
+    for (size_t i = 0; i < out.size(); ++i) {
+        double magnitude = hypot(out[i].i, out[i].q);
+        double expected = 16383.0;
+        if (i >= 100) {
+            expected *= max(0.0, 1.0 - (i - 100.0) / ramp_size);
+        }
+        EXPECT_NEAR(magnitude, expected, 4.0) << "sample " << i;
+    }
+
+    // The phase has kept running during the ramp.
+    EXPECT_EQ(phasor_bank.phase[1], phasor_bank.phase_increment[1] * 1000);
+}
+
+TEST(GraphTest, RejectInvalidNodes) {
+    dsp_graph_t graph;
+    dsp_graph_init(&graph, 0);
+    EXPECT_EQ(graph.chunk_size, DSP_GRAPH_DEFAULT_CHUNK_SIZE);
+
+    int zeros = dsp_graph_add_zeros(&graph);
+    ASSERT_NE(zeros, DSP_GRAPH_INVALID_NODE);
+    EXPECT_EQ(dsp_graph_add_skip(&graph, zeros + 1, 10),
+              DSP_GRAPH_INVALID_NODE);
+    int skip = dsp_graph_add_skip(&graph, zeros, 10);
+    ASSERT_NE(skip, DSP_GRAPH_INVALID_NODE);
+
+    // Each node has a single consumer.
+    EXPECT_EQ(dsp_graph_add_queue(&graph, zeros, 100),
+              DSP_GRAPH_INVALID_NODE);
+    EXPECT_EQ(dsp_graph_add_queue(&graph, skip, 0), DSP_GRAPH_INVALID_NODE);
+    const int inputs[2] = {skip, skip};
+    const size_t lengths[2] = {1, 1};
+    EXPECT_EQ(dsp_graph_add_concat(&graph, inputs, lengths, 2),
+              DSP_GRAPH_INVALID_NODE);
+
+    while (graph.num_nodes < DSP_GRAPH_MAX_NODES) {
+        ASSERT_NE(dsp_graph_add_zeros(&graph), DSP_GRAPH_INVALID_NODE);
+    }
+    EXPECT_EQ(dsp_graph_add_zeros(&graph), DSP_GRAPH_INVALID_NODE);
+}
+
+TEST(GraphTest, ConcatSkipAndTap) {
+    const iq_sample_t* lut_phasor = PhasorLut();
+    zc_generator_state_t zc;
+    dsp_zc_generator_init(&zc, lut_phasor, 139, 5, 0, 1, 3);
+    vector<iq_sample_t> expected(500);
+    dsp_zc_generator_process(&zc, expected.data(), expected.size());
+
+    // 100 samples of the ZC sequence, from the 50th, then zeros.
+    dsp_zc_generator_init(&zc, lut_phasor, 139, 5, 0, 1, 3);
+    dsp_graph_t graph;
+    dsp_graph_init(&graph, 16);
+    vector<iq_sample_t> tapped(30);
+    int sequence = dsp_graph_add_zc(&graph, &zc);
+    int skip = dsp_graph_add_skip(&graph, sequence, 50);
+    int tap = dsp_graph_add_tap(&graph, skip, tapped.data(), tapped.size());
+    int zeros = dsp_graph_add_zeros(&graph);
+    const int inputs[2] = {tap, zeros};
+    const size_t lengths[2] = {100, 20};
+    int output = dsp_graph_add_concat(&graph, inputs, lengths, 2);
+    ASSERT_NE(output, DSP_GRAPH_INVALID_NODE);
+    EXPECT_EQ(dsp_graph_memory_size(&graph), 0);
+
+    vector<iq_sample_t> out(200, iq_sample_t{1, 1});
+    dsp_graph_process(&graph, output, out.data(), 77);
+    dsp_graph_process(&graph, output, &out[77], out.size() - 77);
+    for (size_t i = 0; i < out.size(); ++i) {
+        iq_sample_t x = i < 100 ? expected[50 + i] : iq_sample_t{0, 0};
+        EXPECT_EQ(out[i].i, x.i) << i;
+        EXPECT_EQ(out[i].q, x.q) << i;
+    }
+    CheckArray(tapped, vector<iq_sample_t>(&expected[50], &expected[80]), 0);
+}
+
+TEST(PlanarLayoutTest, BlocksMatchInterleaved) {
+    const size_t num_symbols = 1000;
+    const size_t num_samples = 20 * num_symbols - 100;
+    const iq_sample_t* lut_phasor = PhasorLut();
+    sample_t lut_rrc[LUT_RRC_SIZE];
+
+    // RNG.
+    vector<iq_sample_t> symbols(num_symbols);
+    vector<sample_t> symbols_i(num_symbols), symbols_q(num_symbols);
+    rng_state_t rng;
+    dsp_rng_init(&rng, 7500, 0x5fff, false, 1, 0);
+    dsp_rng_generate_icdf(&rng, symbols.data(), num_symbols);
+    dsp_rng_init(&rng, 7500, 0x5fff, false, 1, 0);
+    dsp_rng_generate_icdf_planar(&rng, symbols_i.data(), symbols_q.data(),
+                                 num_symbols);
+    vector<iq_sample_t> interleaved(num_symbols);
+    dsp_planar_interleave(symbols_i.data(), symbols_q.data(),
+                          interleaved.data(), num_symbols);
+    CheckArray(interleaved, symbols, 0);
+
+    // RRC filter.
+    vector<iq_sample_t> samples(num_samples);
+    vector<sample_t> samples_i(num_samples), samples_q(num_samples);
+    rrc_filter_state_t rrc;
+    dsp_rrc_filter_init(&rrc, lut_rrc, 0.3f, 100, 2000);
+    size_t consumed = dsp_rrc_filter_process(&rrc, symbols.data(),
+                                             samples.data(), num_samples);
+    dsp_rrc_filter_init(&rrc, lut_rrc, 0.3f, 100, 2000);
+    EXPECT_EQ(dsp_rrc_filter_process_planar(
+                  &rrc, symbols_i.data(), symbols_q.data(), samples_i.data(),
+                  samples_q.data(), num_samples),
+              consumed);
+
+    // Phasor bank, with and without the pilot cache.
+    uint32_t f[3] = {50000000, 200000000, 220000000};
+    float amplitude[3] = {0.70710678118f, 0.16f, 0.16f};
+    for (uint32_t shift : {50000000u, 12345678u}) {
+        f[0] = shift;
+        vector<iq_sample_t> out = samples;
+        vector<sample_t> out_i = samples_i, out_q = samples_q;
+        phasor_bank_state_t phasor_bank;
+        dsp_phasor_bank_init(&phasor_bank, lut_phasor,
+                             PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, f,
+                             amplitude, 2000000000);
+        dsp_phasor_bank_process(&phasor_bank, out.data(), num_samples);
+        dsp_phasor_bank_init(&phasor_bank, lut_phasor,
+                             PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, f,
+                             amplitude, 2000000000);
+        dsp_phasor_bank_process_planar(&phasor_bank, out_i.data(),
+                                       out_q.data(), 777);
+        dsp_phasor_bank_process_planar(&phasor_bank, &out_i[777],
+                                       &out_q[777], num_samples - 777);
+        vector<iq_sample_t> planar(num_samples);
+        dsp_planar_interleave(out_i.data(), out_q.data(), planar.data(),
+                              num_samples);
+        CheckArray(planar, out, 0);
+    }
+
+    // ZC generator.
+    zc_generator_state_t zc;
+    dsp_zc_generator_init(&zc, lut_phasor, 3989, 5, 0, 50, 2000);
+    dsp_zc_generator_process(&zc, samples.data(), num_samples);
+    dsp_zc_generator_reset(&zc);
+    dsp_zc_generator_process_planar(&zc, samples_i.data(), samples_q.data(),
+                                    num_samples);
+    vector<iq_sample_t> planar(num_samples);
+    dsp_planar_interleave(samples_i.data(), samples_q.data(), planar.data(),
+                          num_samples);
+    CheckArray(planar, samples, 0);
+
+    vector<sample_t> i(num_samples), q(num_samples);
+    dsp_planar_deinterleave(samples.data(), i.data(), q.data(), num_samples);
+    EXPECT_EQ(i, samples_i);
+    EXPECT_EQ(q, samples_q);
+}
+
+TEST(SampleFormatTest, Int16ScalingAndSaturation) {
+    const vector<iq_sample_t> in = {
+        {0, 1}, {-1, 100}, {32767, -32768}, {-20000, 12345}};
+    vector<iq_sample_t> out(in.size());
+    sample_format_state_t state;
+
+    dsp_sample_format_init(&state, DSP_SAMPLE_FORMAT_INT16, 1.0f,
+                           SAMPLE_FORMAT_NO_SATURATION);
+    EXPECT_EQ(dsp_sample_format_size(DSP_SAMPLE_FORMAT_INT16, in.size()),
+              in.size() * 4);
+    dsp_sample_format_process(&state, in.data(), out.data(), in.size());
+    CheckArray(out, in, 0);
+
+    dsp_sample_format_init(&state, DSP_SAMPLE_FORMAT_INT16, 0.5f, 8000);
+    dsp_sample_format_process(&state, in.data(), out.data(), in.size());
+    CheckArray(out, {{0, 1}, {0, 50}, {8000, -8000}, {-8000, 6173}}, 0);
+}
+
+TEST(SampleFormatTest, PackedRoundTrip) {
+    vector<iq_sample_t> in(257);
+    for (size_t n = 0; n < in.size(); ++n) {
+        in[n].i = static_cast<sample_t>(n * 7919 - 32768);
+        in[n].q = static_cast<sample_t>(32767 - n * 104729);
+    }
+    in[0] = {32767, -32768};
+
+    for (int bits : {14, 12}) {
+        dsp_sample_format_t format = bits == 14 ? DSP_SAMPLE_FORMAT_PACKED14
+                                                : DSP_SAMPLE_FORMAT_PACKED12;
+        sample_format_state_t state;
+        dsp_sample_format_init(&state, format, 1.0f,
+                               SAMPLE_FORMAT_NO_SATURATION);
+        size_t size = dsp_sample_format_size(format, in.size());
+        EXPECT_EQ(size, (in.size() * 2 * bits + 7) / 8);
+        vector<uint8_t> out(size + 1, 0xaa);
+        dsp_sample_format_process(&state, in.data(), out.data(), in.size());
+        EXPECT_EQ(out[size], 0xaa) << "Overflow";
+
+        const int shift = 16 - bits;
+        const int32_t max = (1 << (bits - 1)) - 1;
+        uint64_t buffer = 0;
+        int buffered = 0;
+        size_t byte = 0;
+        for (size_t n = 0; n < 2 * in.size(); ++n) {
+            while (buffered < bits) {
+                buffer |= static_cast<uint64_t>(out[byte++]) << buffered;
+                buffered += 8;
+            }
+            int32_t value = static_cast<int32_t>(buffer & ((1 << bits) - 1));
+            value -= (value >> (bits - 1)) << bits;  // Sign extension.
+            buffer >>= bits;
+            buffered -= bits;
+
+            int32_t x = n % 2 ? in[n / 2].q : in[n / 2].i;
+            int32_t expected =
+                std::min((x + (1 << (shift - 1))) >> shift, max);
+            ASSERT_EQ(value, expected)
+                << bits << " bits, component " << n;
+        }
+    }
+}
+
+TEST(SampleFormatTest, Floats) {
+    const vector<iq_sample_t> in = {{0, 1}, {16384, -32768}, {32767, -3}};
+    sample_format_state_t state;
+
+    dsp_sample_format_init(&state, DSP_SAMPLE_FORMAT_CF32, 2.0f,
+                           SAMPLE_FORMAT_NO_SATURATION);
+    vector<float> cf32(2 * in.size());
+    dsp_sample_format_process(&state, in.data(), cf32.data(), in.size());
+    EXPECT_EQ(cf32, vector<float>({0.0f, 2.0f / 32768.0f, 1.0f, -2.0f,
+                                   32767.0f / 16384.0f, -6.0f / 32768.0f}));
+
+    // 1.0 is 0x3c00; 2^-15 is subnormal; 32767 / 32768 rounds to 1.0.
+    dsp_sample_format_init(&state, DSP_SAMPLE_FORMAT_CF16, 1.0f,
+                           SAMPLE_FORMAT_NO_SATURATION);
+    EXPECT_EQ(dsp_sample_format_size(DSP_SAMPLE_FORMAT_CF16, in.size()),
+              in.size() * 4);
+    vector<uint16_t> cf16(2 * in.size());
+    dsp_sample_format_process(&state, in.data(), cf16.data(), in.size());
+    EXPECT_EQ(cf16, vector<uint16_t>(
+                        {0x0000, 0x0200, 0x3800, 0xbc00, 0x3c00, 0x8600}));
+}
+
+TEST(SymbolMapperTest, MatchesScalarReference) {
+    symbol_mapper_t mapper;
+    ASSERT_TRUE(dsp_symbol_mapper_init(&mapper, DSP_MODULATION_QAM, 16, 0.5f,
+                                       7500, 0x5fff));
+
+    // One draw per symbol, in the order of dsp_rng_uniform_u32, whatever the
+    // number of symbols processed at once.
+    rng_state_t reference_rng;
+    dsp_rng_init(&reference_rng, 7500, 0x5fff, false, 42, 0);
+    vector<iq_sample_t> expected(1003);
+    for (iq_sample_t& symbol : expected) {
+        uint32_t u = dsp_rng_uniform_u32(&reference_rng);
+        uint32_t j = u >> (32 - mapper.table_bits);
+        uint32_t fraction = u << mapper.table_bits;
+        symbol = mapper.constellation[fraction < mapper.threshold[j]
+                                          ? j
+                                          : mapper.alias[j]];
+    }
+
+    rng_state_t rng;
+    dsp_rng_init(&rng, 7500, 0x5fff, false, 42, 0);
+    vector<iq_sample_t> out(expected.size());
+    size_t offset = 0;
+    for (size_t size : {1, 7, 300, 695}) {
+        dsp_symbol_mapper_process(&mapper, &rng, &out[offset], size);
+        offset += size;
+    }
+    CheckArray(out, expected, 0);
+    EXPECT_EQ(rng.state, reference_rng.state);
+
+    dsp_rng_init(&rng, 7500, 0x5fff, false, 42, 0);
+    vector<sample_t> out_i(expected.size());
+    vector<sample_t> out_q(expected.size());
+    dsp_symbol_mapper_process_planar(&mapper, &rng, out_i.data(),
+                                     out_q.data(), expected.size());
+    for (size_t n = 0; n < expected.size(); ++n) {
+        ASSERT_EQ(out_i[n], expected[n].i);
+        ASSERT_EQ(out_q[n], expected[n].q);
+    }
+}
+
+TEST(SymbolMapperTest, Constellations) {
+    symbol_mapper_t mapper;
+    EXPECT_FALSE(dsp_symbol_mapper_init(&mapper, DSP_MODULATION_QAM, 8, 0.0f,
+                                        7500, 0x5fff));
+    EXPECT_FALSE(dsp_symbol_mapper_init(&mapper, DSP_MODULATION_PSK, 1, 0.0f,
+                                        7500, 0x5fff));
+    EXPECT_FALSE(dsp_symbol_mapper_init(&mapper, DSP_MODULATION_QAM, 4,
+                                        -1.0f, 7500, 0x5fff));
+    EXPECT_FALSE(dsp_symbol_mapper_init(&mapper, DSP_MODULATION_GAUSSIAN, 4,
+                                        0.0f, 7500, 0x5fff));
+
+    // QPSK: +-scale +-j scale, as the mean energy of the Gaussian symbols.
+    ASSERT_TRUE(dsp_symbol_mapper_init(&mapper, DSP_MODULATION_PSK, 4, 0.0f,
+                                       7500, 0x5fff));
+    ASSERT_EQ(mapper.num_points, 4);
+    for (size_t m = 0; m < 4; ++m) {
+        EXPECT_EQ(abs(mapper.constellation[m].i), 7500);
+        EXPECT_EQ(abs(mapper.constellation[m].q), 7500);
+    }
+
+    // The frequency of each point of a shaped constellation follows its
+    // probability, and the mean energy is 2 scale^2.
+    for (float shaping : {0.0f, 1.0f}) {
+        ASSERT_TRUE(dsp_symbol_mapper_init(&mapper, DSP_MODULATION_QAM, 64,
+                                           shaping, 5000, 0x7fff));
+        rng_state_t rng;
+        dsp_rng_init(&rng, 5000, 0x7fff, false, 3, 0);
+        const size_t num_symbols = 1 << 20;
+        vector<iq_sample_t> out(num_symbols);
+        dsp_symbol_mapper_process(&mapper, &rng, out.data(), num_symbols);
+
+        vector<size_t> count(mapper.num_points);
+        double energy = 0.0;
+        for (const iq_sample_t& s : out) {
+            size_t m = 0;
+            while (m < mapper.num_points &&
+                   (mapper.constellation[m].i != s.i ||
+                    mapper.constellation[m].q != s.q)) {
+                ++m;
+            }
+            ASSERT_LT(m, mapper.num_points);
+            ++count[m];
+            energy += double(s.i) * s.i + double(s.q) * s.q;
+        }
+        for (size_t m = 0; m < mapper.num_points; ++m) {
+            double expected = mapper.probability[m] * num_symbols;
+            EXPECT_NEAR(count[m], expected, 5.0 * sqrt(expected) + 1.0)
+                << shaping << " " << m;
+        }
+        EXPECT_NEAR(energy / num_symbols / (2.0 * 5000 * 5000), 1.0, 0.01);
+    }
+}
+
+TEST(HalfBandTest, InterpolatesByTwo) {
+    half_band_state_t half_band;
+    dsp_half_band_init(&half_band, 0.1f, HALF_BAND_ATTENUATION_DB);
+    ASSERT_GE(half_band.num_pairs, 2);
+    ASSERT_LE(half_band.num_pairs, HALF_BAND_MAX_PAIRS);
+
+    // Even outputs: the inputs, delayed by num_pairs. Odd outputs of a
+    // constant: the constant.
+    const size_t num_inputs = 700;
+    vector<iq_sample_t> in(num_inputs);
+    for (size_t n = 0; n < num_inputs; ++n) {
+        in[n] = {sample_t(n < 300 ? 10000 : (n * 7919) % 20001 - 10000),
+                 sample_t(n < 300 ? -10000 : (n * 104729) % 20001 - 10000)};
+    }
+    vector<iq_sample_t> out(2 * num_inputs);
+    EXPECT_EQ(dsp_half_band_process(&half_band, in.data(), out.data(),
+                                    out.size()),
+              num_inputs);
+    const size_t delay = half_band.num_pairs;
+    for (size_t n = delay; n < num_inputs; ++n) {
+        ASSERT_EQ(out[2 * n].i, in[n - delay].i);
+        ASSERT_EQ(out[2 * n].q, in[n - delay].q);
+    }
+    for (size_t n = 2 * delay; n < 250; ++n) {
+        ASSERT_NEAR(out[2 * n + 1].i, 10000, 10);
+        ASSERT_NEAR(out[2 * n + 1].q, -10000, 10);
+    }
+
+    // Same samples by blocks of any size, and on planar buffers.
+    dsp_half_band_reset(&half_band);
+    vector<iq_sample_t> blocks(out.size());
+    size_t consumed = 0;
+    size_t produced = 0;
+    for (size_t size : {1, 1, 3, 600, 2, 5, 788}) {
+        ASSERT_EQ(dsp_half_band_num_inputs(&half_band, size),
+                  (produced + size + 1) / 2 - (produced + 1) / 2);
+        consumed += dsp_half_band_process(&half_band, &in[consumed],
+                                          &blocks[produced], size);
+        produced += size;
+    }
+    ASSERT_EQ(produced, out.size());
+    CheckArray(blocks, out, 0);
+
+    dsp_half_band_reset(&half_band);
+    vector<sample_t> in_i(num_inputs), in_q(num_inputs);
+    vector<sample_t> out_i(out.size()), out_q(out.size());
+    dsp_planar_deinterleave(in.data(), in_i.data(), in_q.data(), num_inputs);
+    dsp_half_band_process_planar(&half_band, in_i.data(), in_q.data(),
+                                 out_i.data(), out_q.data(), out.size());
+    vector<iq_sample_t> planar(out.size());
+    dsp_planar_interleave(out_i.data(), out_q.data(), planar.data(),
+                          planar.size());
+    CheckArray(planar, out, 0);
+}
+
+TEST(InterpolatorTest, StagesAndCost) {
+    interpolator_state_t interpolator;
+    EXPECT_TRUE(dsp_interpolator_init(&interpolator, 0, 0.3f, 100000000,
+                                      2000000000));
+    EXPECT_EQ(dsp_interpolator_delay(&interpolator), 0);
+    EXPECT_EQ(dsp_interpolator_multiplies(&interpolator),
+              LUT_RRC_NUM_SYMBOLS);
+
+    // 2 GS/s >> 4 is below twice the symbol rate; 1999999999 is odd.
+    EXPECT_FALSE(dsp_interpolator_init(&interpolator, 4, 0.3f, 100000000,
+                                       2000000000));
+    EXPECT_FALSE(dsp_interpolator_init(&interpolator, 1, 0.3f, 100000000,
+                                       1999999999));
+
+    // The later stages, at higher rates, are shorter.
+    ASSERT_TRUE(dsp_interpolator_init(&interpolator, 3, 0.3f, 100000000,
+                                      2000000000));
+    EXPECT_GE(interpolator.stage[0].num_pairs,
+              interpolator.stage[1].num_pairs);
+    EXPECT_GE(interpolator.stage[1].num_pairs,
+              interpolator.stage[2].num_pairs);
+    EXPECT_LT(dsp_interpolator_multiplies(&interpolator),
+              LUT_RRC_NUM_SYMBOLS / 2.0f);
+
+    // The RRC filter at the lower rate gives every 8th sample of the direct
+    // one.
+    const sample_t* lut = dsp_lut_registry_acquire_rrc(0.3f);
+    rrc_filter_state_t direct;
+    dsp_rrc_filter_init_with_lut(&direct, lut, 100000000, 2000000000);
+    rrc_filter_state_t decimated;
+    dsp_interpolator_init_rrc(&interpolator, &decimated, lut, 100000000,
+                              2000000000);
+    vector<iq_sample_t> symbols(200);
+    for (size_t n = 0; n < symbols.size(); ++n) {
+        symbols[n] = {sample_t((n * 7919) % 15001 - 7500),
+                      sample_t((n * 104729) % 15001 - 7500)};
+    }
+    vector<iq_sample_t> direct_out(8 * 400);
+    vector<iq_sample_t> decimated_out(400);
+    dsp_rrc_filter_process(&direct, symbols.data(), direct_out.data(),
+                           direct_out.size());
+    dsp_rrc_filter_process(&decimated, symbols.data(), decimated_out.data(),
+                           decimated_out.size());
+    for (size_t n = 0; n < decimated_out.size(); ++n) {
+        ASSERT_EQ(decimated_out[n].i, direct_out[8 * n].i);
+        ASSERT_EQ(decimated_out[n].q, direct_out[8 * n].q);
+    }
+    dsp_lut_registry_release(lut);
+}
+
+TEST(LutRegistryTest, SharesTablesAcrossThreads) {
+    // A roll-off without a precomputed table.
+    const float roll_off = 0.23f;
+    const size_t initial_size = dsp_lut_registry_size();
+
+    const size_t num_threads = 8;
+    vector<const iq_sample_t*> phasor(num_threads);
+    vector<const sample_t*> rrc(num_threads);
+    vector<thread> threads;
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back([i, roll_off, &phasor, &rrc] {
+            phasor[i] = dsp_lut_registry_acquire_phasor();
+            rrc[i] = dsp_lut_registry_acquire_rrc(roll_off);
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        ASSERT_EQ(phasor[i], phasor[0]);
+        ASSERT_EQ(rrc[i], rrc[0]);
+    }
+    ASSERT_NE(phasor[0], nullptr);
+    ASSERT_NE(rrc[0], nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(rrc[0]) % DSP_LUT_ALIGNMENT, 0);
+    EXPECT_EQ(dsp_lut_registry_size(), initial_size + 2);
+
+    vector<iq_sample_t> lut_phasor(LUT_PHASOR_SIZE, iq_sample_t{0, 0});
+    dsp_phasor_bank_fill_lut(lut_phasor.data());
+    CheckArray(vector<iq_sample_t>(phasor[0], phasor[0] + LUT_PHASOR_SIZE),
+               lut_phasor, 0);
+    vector<sample_t> lut_rrc(LUT_RRC_SIZE);
+    dsp_rrc_filter_fill_lut(lut_rrc.data(), roll_off);
+    EXPECT_EQ(vector<sample_t>(rrc[0], rrc[0] + LUT_RRC_SIZE), lut_rrc);
+
+    // Freed with the last reference, and rebuilt on the next acquisition.
+    for (size_t i = 0; i < num_threads; ++i) {
+        dsp_lut_registry_release(phasor[i]);
+        dsp_lut_registry_release(rrc[i]);
+    }
+    EXPECT_EQ(dsp_lut_registry_size(), initial_size);
+    const sample_t* again = dsp_lut_registry_acquire_rrc(roll_off);
+    EXPECT_EQ(vector<sample_t>(again, again + LUT_RRC_SIZE), lut_rrc);
+    dsp_lut_registry_release(again);
+    EXPECT_EQ(dsp_lut_registry_size(), initial_size);
+}
+
+#ifdef DSP_PRECOMPUTED_LUTS
+
+TEST(PrecomputedLUTsTest, MatchRuntimeComputation) {
+    vector<iq_sample_t> lut_phasor(LUT_PHASOR_SIZE, iq_sample_t{0, 0});
+    dsp_phasor_bank_fill_lut(lut_phasor.data());
+    EXPECT_EQ(dsp_phasor_bank_get_lut(NULL), lut_phasor_precomputed);
+    vector<iq_sample_t> precomputed(lut_phasor_precomputed,
+                                    lut_phasor_precomputed + LUT_PHASOR_SIZE);
+    CheckArray(precomputed, lut_phasor, 0);
+
+    for (size_t i = 0; i < lut_rrc_precomputed_count; ++i) {
+        float roll_off = lut_rrc_precomputed_roll_off[i];
+        sample_t lut_rrc[LUT_RRC_SIZE];
+        dsp_rrc_filter_fill_lut(lut_rrc, roll_off);
+        EXPECT_EQ(dsp_rrc_filter_get_lut(NULL, roll_off),
+                  lut_rrc_precomputed[i]);
+        // Also for a roll-off differing in its last bits.
+        EXPECT_EQ(dsp_rrc_filter_get_lut(NULL, nextafterf(roll_off, 1.0f)),
+                  lut_rrc_precomputed[i]);
+        for (size_t j = 0; j < LUT_RRC_SIZE; ++j) {
+            EXPECT_EQ(lut_rrc_precomputed[i][j], lut_rrc[j])
+                << "Mismatch at index " << j << " (roll-off " << roll_off
+                << ")";
+        }
+    }
+}
+
+#endif  // DSP_PRECOMPUTED_LUTS
+
+#ifdef DSP_STATISTICS
+
+dsp_signal_statistics_t ComputeSignalStatistics(
+    const vector<iq_sample_t>& samples) {
+    dsp_signal_statistics_t statistics;
+    dsp_signal_statistics_reset(&statistics);
+    for (const iq_sample_t& s : samples) {
+        dsp_signal_statistics_add(&statistics, s.i, s.q);
+    }
+    return statistics;
+}
+
+TEST(StatisticsTest, RngRejectionsAndClamps) {
+    const size_t num_symbols = 20000;
+    const int32_t max_magnitude = 12000;
+    vector<iq_sample_t> symbols(num_symbols);
+    rng_state_t state;
+    dsp_rng_init(&state, 7500, max_magnitude, false, 1, 0);
+    dsp_rng_generate_icdf(&state, symbols.data(), num_symbols);
+    EXPECT_GT(state.statistics.num_rejected, 0);
+    EXPECT_EQ(state.statistics.num_clamped, 0);
+
+    dsp_symbol_statistics_t expected;
+    dsp_symbol_statistics_reset(&expected);
+    for (const iq_sample_t& s : symbols) {
+        dsp_symbol_statistics_add(&expected, s.i, s.q);
+    }
+    EXPECT_EQ(state.statistics.num_symbols, num_symbols);
+    for (int c = 0; c < 2; ++c) {
+        EXPECT_EQ(state.statistics.sum[c], expected.sum[c]);
+        EXPECT_EQ(state.statistics.sum_squares[c], expected.sum_squares[c]);
+        EXPECT_GT(dsp_symbol_statistics_variance(&state.statistics, c), 0.0);
+    }
+
+    dsp_rng_init(&state, 7500, max_magnitude, true, 1, 0);
+    dsp_rng_generate_icdf(&state, symbols.data(), num_symbols);
+    size_t saturated = 0;
+    for (const iq_sample_t& s : symbols) {
+        saturated += abs(s.i) == max_magnitude;
+        saturated += abs(s.q) == max_magnitude;
+    }
+    EXPECT_EQ(state.statistics.num_rejected, 0);
+    EXPECT_GT(state.statistics.num_clamped, 0);
+    EXPECT_LE(state.statistics.num_clamped, saturated);
+
+    dsp_rng_reset(&state, 1, 0);
+    EXPECT_EQ(state.statistics.num_symbols, 0);
+}
+
+TEST(StatisticsTest, PhasorBankOutputAndWraps) {
+    const iq_sample_t* lut_phasor = PhasorLut();
+    const size_t num_samples = 4096;
+    vector<iq_sample_t> in(num_samples);
+    for (size_t n = 0; n < num_samples; ++n) {
+        in[n].i = static_cast<sample_t>((n * 7919) % 65536 - 32768);
+        in[n].q = static_cast<sample_t>((n * 104729) % 65536 - 32768);
+    }
+
+    // With and without the pilot cache.
+    for (uint32_t sample_rate : {8, 1000003}) {
+        uint32_t f[3] = {1, 2, 4};
+        auto process = [&](float shift, float pilots, vector<iq_sample_t> x,
+                           phasor_bank_state_t* state) {
+            float amplitude[3] = {shift, pilots, pilots};
+            dsp_phasor_bank_init(state, lut_phasor,
+                                 PHASOR_BANK_ALGORITHM_SHIFT_TWO_PILOTS, f,
+                                 amplitude, sample_rate);
+            dsp_phasor_bank_process(state, x.data(), 1000);
+            dsp_phasor_bank_process(state, &x[1000], num_samples - 1000);
+            return x;
+        };
+        phasor_bank_state_t state;
+        vector<iq_sample_t> shifted = process(0.9f, 0.0f, in, &state);
+        EXPECT_EQ(state.num_wrapped, 0);
+        vector<iq_sample_t> pilots =
+            process(0.0f, 0.3f, vector<iq_sample_t>(num_samples), &state);
+        vector<iq_sample_t> out = process(0.9f, 0.3f, in, &state);
+
+        size_t wrapped = 0;
+        for (size_t n = 0; n < num_samples; ++n) {
+            int32_t i = shifted[n].i + pilots[n].i;
+            int32_t q = shifted[n].q + pilots[n].q;
+            wrapped += i != static_cast<sample_t>(i) ||
+                       q != static_cast<sample_t>(q);
+        }
+        EXPECT_GT(wrapped, 0);
+        EXPECT_EQ(state.num_wrapped, wrapped) << "Sample rate " << sample_rate;
+
+        dsp_signal_statistics_t expected = ComputeSignalStatistics(out);
+        EXPECT_EQ(state.statistics.num_samples, num_samples);
+        EXPECT_EQ(state.statistics.energy, expected.energy);
+        EXPECT_EQ(state.statistics.peak, expected.peak);
+    }
+}
+
+#endif  // DSP_STATISTICS
+
+// Statically allocated working set for a streaming pipeline.
+const size_t kPlanBlockSize = 1000;
+alignas(DSP_PLAN_ALIGNMENT) static uint8_t plan_memory[
+    DSP_PLAN_STREAMING_BYTES(kPlanBlockSize, 100000000, 2000000000)];
+
+TEST(MemoryPlanTest, StreamingPlanIsExact) {
+    dsp_parameter_t parameters = {};
+    parameters.sample_rate = 2000000000;
+    parameters.symbol_rate = 100000000;
+    parameters.zc_rate = 50000000;
+    parameters.zc_length = 3989;
+    parameters.num_symbols = 1000;
+    parameters.num_null_symbols = 10;
+    parameters.rrc_roll_off = 0.123f;
+
+    dsp_memory_plan_t plan;
+    dsp_memory_plan_streaming(&plan, &parameters, kPlanBlockSize);
+    EXPECT_EQ(plan.num_samples_zc, 3989 * 40);
+    EXPECT_EQ(plan.num_samples, 3989 * 40 + 1010 * 20);
+    EXPECT_EQ(plan.symbols_per_block, 50);
+    EXPECT_EQ(plan.total_bytes, sizeof(plan_memory));
+
+    dsp_memory_t regions;
+    dsp_memory_plan_assign(&plan, plan_memory, &regions);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(regions.samples) %
+                  DSP_PLAN_ALIGNMENT, 0);
+    EXPECT_LE(reinterpret_cast<uint8_t*>(regions.samples + kPlanBlockSize),
+              plan_memory + sizeof(plan_memory));
+
+    // The RRC filter never consumes more symbols than planned.
+    dsp_rrc_filter_init(regions.rrc_filter, regions.lut_rrc,
+                        parameters.rrc_roll_off, 3, 64);
+    parameters.symbol_rate = 3;
+    parameters.sample_rate = 64;
+    dsp_memory_plan_streaming(&plan, &parameters, 100);
+    size_t max_consumed = 0;
+    for (size_t i = 0; i < 64; ++i) {
+        size_t consumed = dsp_rrc_filter_process(
+            regions.rrc_filter, regions.symbols, regions.samples, 100);
+        EXPECT_LE(consumed, plan.symbols_per_block);
+        max_consumed = max(max_consumed, consumed);
+    }
+    EXPECT_EQ(max_consumed, plan.symbols_per_block);
+}
@@ -0,0 +1,235 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// C API tests.
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "embedded_alice.h"
+#include "frame_buffer_arena.h"
+#include "frame_generator.h"
+
+using namespace std;
+
+namespace {
+
+ea_parameters_t SmallFrameParameters() {
+    ea_parameters_t parameters;
+    ea_parameters_init(&parameters);
+    parameters.num_symbols = 1000;
+    parameters.shift_frequency = 12345678;
+    parameters.rrc_roll_off = 0.25f;
+    parameters.seed = 3;
+    return parameters;
+}
+
+// The same frame, generated by the command line tool.
+Frame GenerateReferenceFrame(const ea_parameters_t& parameters,
+                             LutCache* luts, FrameBufferArena* arena) {
+    FrameConfig config;
+    dsp_parameter_t& p = config.parameters;
+    p.sample_rate = parameters.sample_rate;
+    p.symbol_rate = parameters.symbol_rate;
+    p.zc_rate = parameters.zc_rate;
+    p.num_symbols = parameters.num_symbols;
+    p.num_null_symbols = parameters.num_null_symbols;
+    p.zc_length = parameters.zc_length;
+    p.zc_root = parameters.zc_root;
+    p.zc_shift = parameters.zc_shift;
+    p.shift_frequency = parameters.shift_frequency;
+    p.symbol_scale = parameters.symbol_scale;
+    p.symbol_max_value = parameters.symbol_max_value;
+    p.symbol_clamp = parameters.symbol_clamp;
+    for (int i = 0; i < 2; ++i) {
+        p.pilot_frequency[i] = parameters.pilot_frequency[i];
+        p.pilot_amplitude[i] = parameters.pilot_amplitude[i];
+    }
+    p.rrc_roll_off = parameters.rrc_roll_off;
+    config.seed = parameters.seed;
+    return GenerateFrame(config, luts, arena, false);
+}
+
+}  // namespace
+
+TEST(EmbeddedAliceTest, WholeFrame) {
+    EXPECT_EQ(ea_api_version(), EA_API_VERSION);
+    ea_parameters_t parameters = SmallFrameParameters();
+    ea_frame_layout_t layout;
+    ASSERT_EQ(ea_frame_layout(&parameters, &layout), EA_OK);
+    EXPECT_EQ(layout.num_samples_zc, 3989 * 40);
+    EXPECT_EQ(layout.num_samples, 3989 * 40 + 1010 * 20);
+    EXPECT_EQ(layout.num_symbols, 1011);
+
+    vector<int16_t> samples(2 * layout.num_samples);
+    vector<int16_t> symbols(2 * layout.num_symbols);
+    EXPECT_EQ(ea_generate_frame(&parameters, samples.data(),
+                                layout.num_samples - 1, nullptr, 0),
+              EA_ERROR_BUFFER_TOO_SMALL);
+    ASSERT_EQ(ea_generate_frame(&parameters, samples.data(),
+                                layout.num_samples, symbols.data(),
+                                layout.num_symbols),
+              EA_OK);
+
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    Frame frame = GenerateReferenceFrame(parameters, &luts, &arena);
+    EXPECT_EQ(memcmp(samples.data(), frame.samples,
+                     samples.size() * sizeof(int16_t)), 0);
+    EXPECT_EQ(memcmp(symbols.data(), frame.symbols,
+                     symbols.size() * sizeof(int16_t)), 0);
+}
+
+TEST(EmbeddedAliceTest, Stream) {
+    ea_parameters_t parameters = SmallFrameParameters();
+    ea_frame_layout_t layout;
+    ASSERT_EQ(ea_frame_layout(&parameters, &layout), EA_OK);
+    vector<int16_t> frame(2 * layout.num_samples);
+    ASSERT_EQ(ea_generate_frame(&parameters, frame.data(), layout.num_samples,
+                                nullptr, 0),
+              EA_OK);
+
+    ea_stream_t* stream;
+    ASSERT_EQ(ea_stream_create(&parameters, 1000, &stream), EA_OK);
+    for (int pass = 0; pass < 2; ++pass) {
+        vector<int16_t> samples(2 * layout.num_samples);
+        size_t position = 0;
+        while (position < layout.num_samples) {
+            size_t size = min<size_t>(7777, layout.num_samples - position);
+            ASSERT_EQ(ea_stream_read(stream, &samples[2 * position], size),
+                      size);
+            position += size;
+            EXPECT_EQ(ea_stream_position(stream), position);
+        }
+        EXPECT_EQ(ea_stream_read(stream, samples.data(), 1), 0);
+        EXPECT_EQ(position, layout.num_samples);
+        EXPECT_EQ(samples, frame);
+        ea_stream_rewind(stream);
+    }
+    ea_stream_destroy(stream);
+}
+
+TEST(EmbeddedAliceTest, StreamRetune) {
+    ea_parameters_t parameters = SmallFrameParameters();
+    ea_frame_layout_t layout;
+    ASSERT_EQ(ea_frame_layout(&parameters, &layout), EA_OK);
+    const size_t n = layout.num_samples;
+    vector<int16_t> frame(2 * n);
+    ASSERT_EQ(ea_generate_frame(&parameters, frame.data(), n, nullptr, 0),
+              EA_OK);
+
+    ea_stream_t* stream;
+    ASSERT_EQ(ea_stream_create(&parameters, 1000, &stream), EA_OK);
+
+    // Retuning to the same settings leaves the samples unchanged.
+    vector<int16_t> samples(2 * n);
+    const size_t position = layout.num_samples_zc + 5000;
+    EXPECT_EQ(ea_stream_retune(stream, parameters.shift_frequency,
+                               parameters.pilot_frequency,
+                               parameters.pilot_amplitude, position, 100),
+              EA_OK);
+    ASSERT_EQ(ea_stream_read(stream, samples.data(), n), n);
+    EXPECT_EQ(samples, frame);
+
+    // Louder pilots, from position on.
+    ea_stream_rewind(stream);
+    float louder[2] = {2 * parameters.pilot_amplitude[0],
+                       2 * parameters.pilot_amplitude[1]};
+    ASSERT_EQ(ea_stream_read(stream, samples.data(), 1000), 1000);
+    EXPECT_EQ(ea_stream_retune(stream, parameters.shift_frequency,
+                               parameters.pilot_frequency, louder, position,
+                               0),
+              EA_OK);
+    ASSERT_EQ(ea_stream_read(stream, &samples[2000], n - 1000), n - 1000);
+    EXPECT_TRUE(equal(samples.begin(), samples.begin() + 2 * position,
+                      frame.begin()));
+    EXPECT_FALSE(equal(samples.begin() + 2 * position, samples.end(),
+                       frame.begin() + 2 * position));
+
+    EXPECT_EQ(ea_stream_retune(stream, 0, nullptr, louder, 0, 0),
+              EA_ERROR_INVALID_ARGUMENT);
+    ea_stream_destroy(stream);
+}
+
+TEST(EmbeddedAliceTest, Batch) {
+    // Channels with different seeds, symbol distributions and tones.
+    vector<ea_parameters_t> parameters(3, SmallFrameParameters());
+    parameters[1].seed = 11;
+    parameters[1].shift_frequency = 0;
+    parameters[1].pilot_amplitude[1] = 0.0f;
+    parameters[1].symbol_clamp = 1;
+    parameters[1].symbol_max_value = 8000;
+    parameters[2].seed = 12;
+    parameters[2].symbol_scale = 5000;
+    parameters[2].pilot_frequency[0] = 150000000;
+    const size_t num_channels = parameters.size();
+
+    ea_frame_layout_t layout;
+    ASSERT_EQ(ea_frame_layout(&parameters[0], &layout), EA_OK);
+    vector<vector<int16_t>> frames(num_channels);
+    for (size_t c = 0; c < num_channels; ++c) {
+        frames[c].resize(2 * layout.num_samples);
+        ASSERT_EQ(ea_generate_frame(&parameters[c], frames[c].data(),
+                                    layout.num_samples, nullptr, 0),
+                  EA_OK);
+    }
+
+    ea_batch_t* batch;
+    ASSERT_EQ(ea_batch_create(parameters.data(), num_channels, 1000, &batch),
+              EA_OK);
+    vector<int16_t> samples(2 * num_channels * layout.num_samples);
+    size_t position = 0;
+    while (position < layout.num_samples) {
+        size_t size = min<size_t>(7777, layout.num_samples - position);
+        ASSERT_EQ(ea_batch_read(batch, &samples[2 * num_channels * position],
+                                size),
+                  size);
+        position += size;
+        EXPECT_EQ(ea_batch_position(batch), position);
+    }
+    EXPECT_EQ(ea_batch_read(batch, samples.data(), 1), 0);
+    ea_batch_destroy(batch);
+
+    for (size_t c = 0; c < num_channels; ++c) {
+        for (size_t i = 0; i < layout.num_samples; ++i) {
+            size_t index = 2 * (i * num_channels + c);
+            ASSERT_EQ(samples[index], frames[c][2 * i]) << c << " " << i;
+            ASSERT_EQ(samples[index + 1], frames[c][2 * i + 1])
+                << c << " " << i;
+        }
+    }
+
+    // Channels with different layouts can't be batched.
+    parameters[2].num_symbols = 999;
+    EXPECT_EQ(ea_batch_create(parameters.data(), num_channels, 1000, &batch),
+              EA_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(ea_batch_create(parameters.data(), EA_BATCH_MAX_CHANNELS + 1,
+                              1000, &batch),
+              EA_ERROR_INVALID_ARGUMENT);
+}
+
+TEST(EmbeddedAliceTest, InvalidParameters) {
+    ea_parameters_t parameters = SmallFrameParameters();
+    ea_frame_layout_t layout;
+    ea_stream_t* stream;
+
+    parameters.symbol_rate = 0;
+    EXPECT_EQ(ea_frame_layout(&parameters, &layout),
+              EA_ERROR_INVALID_ARGUMENT);
+
+    parameters = SmallFrameParameters();
+    parameters.struct_size = 4;
+    EXPECT_EQ(ea_stream_create(&parameters, 1024, &stream),
+              EA_ERROR_INVALID_ARGUMENT);
+
+    parameters = SmallFrameParameters();
+    EXPECT_EQ(ea_stream_create(&parameters, 0, &stream),
+              EA_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(ea_generate_frame(&parameters, nullptr, 0, nullptr, 0),
+              EA_ERROR_INVALID_ARGUMENT);
+}
@@ -0,0 +1,125 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Execution plan and wisdom tests.
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "execution_plan.h"
+#include "frame_fixtures.h"
+#include "frame_generator.h"
+
+using namespace std;
+
+TEST(ExecutionPlanTest, RejectInvalidParameters) {
+    LutCache luts;
+    string error;
+    dsp_parameter_t p = SmallFrameParameters(2000);
+    p.symbol_rate = 0;
+    EXPECT_EQ(ExecutionPlan::Create(p, &luts, &error), nullptr);
+    EXPECT_EQ(error, "null rate");
+
+    p = SmallFrameParameters(2000);
+    p.rrc_roll_off = 1.5f;
+    EXPECT_EQ(ExecutionPlan::Create(p, &luts, &error), nullptr);
+    EXPECT_EQ(error, "RRC roll-off factor outside of ]0, 1]");
+
+    // 2^32 samples of quantum data, computed on 64 bits.
+    p = SmallFrameParameters(0x80000000);
+    p.sample_rate = 2;
+    p.symbol_rate = 1;
+    p.zc_rate = 1;
+    unique_ptr<ExecutionPlan> plan = ExecutionPlan::Create(p, &luts, &error);
+    ASSERT_NE(plan, nullptr) << error;
+    EXPECT_EQ(plan->frame_plan().num_samples_qd, size_t(1) << 32);
+
+    p.num_symbols = 0xffffffff;
+    p.zc_length = 0xffffffff;
+    p.num_null_symbols = 0xffffffff;
+    p.sample_rate = 0xffffffff;
+    EXPECT_EQ(ExecutionPlan::Create(p, &luts, &error), nullptr);
+    EXPECT_EQ(error, "frame too long");
+}
+
+TEST(ExecutionPlanTest, DerivedConstants) {
+    LutCache luts;
+    string error;
+    dsp_parameter_t p = SmallFrameParameters(2000);
+    unique_ptr<ExecutionPlan> plan = ExecutionPlan::Create(p, &luts, &error);
+    ASSERT_NE(plan, nullptr) << error;
+    EXPECT_EQ(plan->samples_per_symbol(), 20);
+    EXPECT_EQ(plan->frame_plan().num_samples_qd, 2000 * 20);
+    EXPECT_EQ(plan->lut_rrc(), luts.rrc(0.3f));
+    EXPECT_EQ(plan->phasor_bank_algorithm(),
+              PHASOR_BANK_ALGORITHM_SCALE_PILOTS);
+    EXPECT_EQ(plan->pilot_cache_period(), 100);
+    EXPECT_EQ(plan->wisdom_key(), "sps=20,tones=scale_pilots,pilot_cache=1");
+    EXPECT_FALSE(plan->tuned());
+
+    // The roll-off and the length of the frame do not change the key.
+    p.rrc_roll_off = 0.2f;
+    p.num_symbols = 10;
+    EXPECT_EQ(ExecutionPlan::Create(p, &luts, &error)->wisdom_key(),
+              plan->wisdom_key());
+
+    p.shift_frequency = 12345678;
+    p.symbol_rate = 200000000;
+    EXPECT_EQ(ExecutionPlan::Create(p, &luts, &error)->wisdom_key(),
+              "sps=10,tones=shift_pilots,pilot_cache=1");
+}
+
+TEST(ExecutionPlanTest, TuneAndReuseWisdom) {
+    const string file_name = testing::TempDir() + "wisdom.txt";
+    remove(file_name.c_str());
+    LutCache luts;
+    string error;
+
+    Wisdom wisdom;
+    ASSERT_TRUE(wisdom.Load(file_name, &error));
+    EXPECT_EQ(wisdom.size(), 0);
+
+    unique_ptr<ExecutionPlan> plan =
+        ExecutionPlan::Create(SmallFrameParameters(2000), &luts, &error);
+    EXPECT_FALSE(plan->ApplyWisdom(wisdom));
+    TuneOptions options;
+    options.repetitions = 1;
+    options.chunk_sizes = {333, 2048};
+    options.block_sizes = {64, 1024};
+    plan->Tune(options, &wisdom);
+    EXPECT_TRUE(plan->tuned());
+    EXPECT_TRUE(plan->choices().chunk_size == 333 ||
+                plan->choices().chunk_size == 2048);
+    EXPECT_TRUE(plan->choices().block_size == 64 ||
+                plan->choices().block_size == 1024);
+    EXPECT_EQ(plan->streaming_plan().block_size, plan->choices().block_size);
+    ASSERT_TRUE(wisdom.Save(file_name));
+
+    Wisdom loaded;
+    ASSERT_TRUE(loaded.Load(file_name, &error)) << error;
+    dsp_parameter_t p = SmallFrameParameters(2000);
+    p.rrc_roll_off = 0.2f;
+    unique_ptr<ExecutionPlan> other = ExecutionPlan::Create(p, &luts, &error);
+    ASSERT_TRUE(other->ApplyWisdom(loaded));
+    EXPECT_EQ(other->choices().planar, plan->choices().planar);
+    EXPECT_EQ(other->choices().chunk_size, plan->choices().chunk_size);
+    EXPECT_EQ(other->choices().block_size, plan->choices().block_size);
+
+    FrameConfig config;
+    config.parameters = p;
+    other->Apply(&config);
+    EXPECT_EQ(config.planar, plan->choices().planar);
+    EXPECT_EQ(config.chunk_size, plan->choices().chunk_size);
+
+    ofstream(file_name) << "# Comment\n\n"
+                        << "sps=20,tones=pilots planar=1 block_size=0\n";
+    EXPECT_FALSE(loaded.Load(file_name, &error));
+    EXPECT_EQ(error, file_name + ": line 3: invalid setting \"block_size=0\"");
+    remove(file_name.c_str());
+}
@@ -0,0 +1,51 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// FFT tests.
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+
+#include <complex>
+#include <vector>
+
+#include "fft.h"
+
+using namespace std;
+
+TEST(FftTest, MatchesDft) {
+    const size_t size = 64;
+    vector<complex<float>> x(size);
+    for (size_t n = 0; n < size; ++n) {
+        x[n] = complex<float>(sinf(0.3f * n) + 0.1f * n, cosf(1.7f * n));
+    }
+    vector<complex<float>> y = x;
+    Fft fft(size);
+    fft.Forward(y.data());
+
+    for (size_t k = 0; k < size; ++k) {
+        complex<double> expected = 0.0;
+        for (size_t n = 0; n < size; ++n) {
+            double t = -2.0 * M_PI * static_cast<double>(k * n) / size;
+            expected += complex<double>(x[n].real(), x[n].imag()) *
+                        complex<double>(cos(t), sin(t));
+        }
+        EXPECT_NEAR(y[k].real(), expected.real(), 1e-3) << k;
+        EXPECT_NEAR(y[k].imag(), expected.imag(), 1e-3) << k;
+    }
+
+    fft.Inverse(y.data());
+    for (size_t n = 0; n < size; ++n) {
+        EXPECT_NEAR(y[n].real(), x[n].real(), 1e-5) << n;
+        EXPECT_NEAR(y[n].imag(), x[n].imag(), 1e-5) << n;
+    }
+}
+
+TEST(FftTest, SizeFor) {
+    EXPECT_EQ(Fft::SizeFor(1), 1);
+    EXPECT_EQ(Fft::SizeFor(5), 8);
+    EXPECT_EQ(Fft::SizeFor(4096), 4096);
+    EXPECT_EQ(Fft::SizeFor(163656), 262144);
+}
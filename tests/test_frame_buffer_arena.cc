@@ -0,0 +1,48 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Frame buffer arena tests.
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "frame_buffer_arena.h"
+
+TEST(FrameBufferArenaTest, AlignedAndReused) {
+    FrameBufferArena arena(HugePages::kTransparent, true);
+    uint8_t* a = arena.Get<uint8_t>(0, 1000);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % FrameBufferArena::kAlignment,
+              0);
+    memset(a, 0x5a, 1000);
+
+    int16_t* b = arena.Get<int16_t>(2, 3 << 20);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % FrameBufferArena::kAlignment,
+              0);
+    b[(3 << 20) - 1] = 1;
+    EXPECT_GE(arena.capacity(), 1000 + (6 << 20));
+
+    // Smaller requests reuse the buffer and preserve its content.
+    EXPECT_EQ(arena.Get<uint8_t>(0, 500), a);
+    EXPECT_EQ(a[999], 0x5a);
+
+    arena.Release();
+    EXPECT_EQ(arena.capacity(), 0);
+}
+
+TEST(FrameBufferArenaTest, ParseHugePages) {
+    HugePages huge_pages;
+    EXPECT_TRUE(ParseHugePages("explicit", &huge_pages));
+    EXPECT_EQ(huge_pages, HugePages::kExplicit);
+    EXPECT_TRUE(ParseHugePages("none", &huge_pages));
+    EXPECT_EQ(huge_pages, HugePages::kNone);
+    EXPECT_FALSE(ParseHugePages("always", &huge_pages));
+}
+
+TEST(FrameBufferArenaTest, ExplicitHugePagesFallback) {
+    FrameBufferArena arena(HugePages::kExplicit, false);
+    char* data = arena.Get<char>(0, 4096);
+    ASSERT_NE(data, nullptr);
+    data[4095] = 1;
+}
@@ -0,0 +1,146 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Multi-frame container tests.
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "frame_buffer_arena.h"
+#include "frame_container.h"
+#include "frame_fixtures.h"
+#include "frame_generator.h"
+
+using namespace std;
+
+namespace {
+
+// The parameters are stored in the index: distinct pilot amplitudes and a
+// set flag check their order.
+FrameConfig NamedFrameConfig(const string& name, uint32_t seed,
+                             float roll_off) {
+    FrameConfig config = SmallFrameConfig(1000, seed);
+    config.parameters.symbol_clamp = true;
+    config.parameters.pilot_amplitude[1] = 0.12f;
+    config.parameters.rrc_roll_off = roll_off;
+    config.name = name;
+    return config;
+}
+
+string ReadFile(const string& file_name) {
+    ifstream in(file_name, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void WriteFile(const string& file_name, const string& data) {
+    ofstream out(file_name, ios::binary | ios::trunc);
+    out.write(data.data(), data.size());
+}
+
+}  // namespace
+
+TEST(FrameContainerTest, RoundTrip) {
+    const string file_name = testing::TempDir() + "frames.eaf";
+    vector<FrameConfig> configs = {NamedFrameConfig("first", 3, 0.3f),
+                                   NamedFrameConfig("second", 4, 0.2f)};
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+
+    FrameContainerWriter writer;
+    ASSERT_TRUE(writer.Open(file_name));
+    for (const FrameConfig& config : configs) {
+        Frame frame = GenerateFrame(config, &luts, &arena, false);
+        ASSERT_TRUE(writer.Append(config, frame));
+    }
+    ASSERT_TRUE(writer.Close());
+
+    FrameContainerReader reader;
+    string error;
+    ASSERT_TRUE(reader.Open(file_name, &error)) << error;
+    ASSERT_EQ(reader.num_frames(), configs.size());
+
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const FrameConfig& config = configs[i];
+        const FrameContainerEntry& entry = reader.frame(i);
+        EXPECT_EQ(entry.name, config.name);
+        EXPECT_EQ(entry.seed, config.seed);
+        EXPECT_EQ(memcmp(&entry.parameters, &config.parameters,
+                         sizeof(dsp_parameter_t)),
+                  0);
+
+        Frame frame = GenerateFrame(config, &luts, &arena, false);
+        EXPECT_EQ(reader.num_samples(i), frame.plan.num_samples);
+        vector<int16_t> samples(2 * reader.num_samples(i));
+        reader.CopySamples(i, samples.data());
+        for (size_t j = 0; j < frame.plan.num_samples; ++j) {
+            ASSERT_EQ(samples[2 * j], frame.samples[j].i) << j;
+            ASSERT_EQ(samples[2 * j + 1], frame.samples[j].q) << j;
+        }
+
+        size_t size;
+        const int16_t* qd = reader.Region(i, FrameRegion::kQuantumData, &size);
+        EXPECT_EQ(size, frame.plan.num_samples_qd);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(qd) % 64, 0);
+        EXPECT_EQ(qd[0], frame.samples[frame.plan.num_samples_zc].i);
+
+        const int16_t* symbols =
+            reader.Region(i, FrameRegion::kSymbols, &size);
+        ASSERT_EQ(size, frame.plan.num_symbols);
+        for (size_t j = 0; j < size; ++j) {
+            ASSERT_EQ(symbols[2 * j], frame.symbols[j].i) << j;
+            ASSERT_EQ(symbols[2 * j + 1], frame.symbols[j].q) << j;
+        }
+    }
+    reader.Close();
+    remove(file_name.c_str());
+}
+
+TEST(FrameContainerTest, RejectCorruptedFiles) {
+    const string file_name = testing::TempDir() + "corrupted.eaf";
+    FrameConfig config = NamedFrameConfig("frame", 1, 0.3f);
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    {
+        FrameContainerWriter writer;
+        ASSERT_TRUE(writer.Open(file_name));
+        ASSERT_TRUE(
+            writer.Append(config, GenerateFrame(config, &luts, &arena, false)));
+    }
+    const string data = ReadFile(file_name);
+
+    FrameContainerReader reader;
+    string error;
+    ASSERT_TRUE(reader.Open(file_name, &error)) << error;
+
+    EXPECT_FALSE(reader.Open(file_name + ".missing", &error));
+
+    WriteFile(file_name, data.substr(0, 32));
+    EXPECT_FALSE(reader.Open(file_name, &error));
+    EXPECT_EQ(error, "truncated header");
+
+    string bad_magic = data;
+    bad_magic[0] = 'X';
+    WriteFile(file_name, bad_magic);
+    EXPECT_FALSE(reader.Open(file_name, &error));
+    EXPECT_EQ(error, "not a frame container");
+
+    WriteFile(file_name, data.substr(0, data.size() - 1));
+    EXPECT_FALSE(reader.Open(file_name, &error));
+    EXPECT_EQ(error, "truncated index");
+
+    // Misaligned quantum data region.
+    string misaligned = data;
+    misaligned[data.size() - 256 + 144] ^= 2;
+    WriteFile(file_name, misaligned);
+    EXPECT_FALSE(reader.Open(file_name, &error));
+    EXPECT_EQ(error, "invalid region in frame 0");
+
+    remove(file_name.c_str());
+}
@@ -0,0 +1,132 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Frame service tests.
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_buffer_arena.h"
+#include "frame_fixtures.h"
+#include "frame_generator.h"
+#include "frame_service.h"
+
+using namespace std;
+
+namespace {
+
+// The parameters are serialized in the requests: distinct pilot amplitudes
+// and a set flag check their order.
+dsp_parameter_t RequestParameters() {
+    dsp_parameter_t p = SmallFrameParameters();
+    p.symbol_clamp = true;
+    p.pilot_amplitude[1] = 0.12f;
+    return p;
+}
+
+}  // namespace
+
+TEST(FrameServiceTest, ServesGeneratedFrames) {
+    const string socket_path = testing::TempDir() + "frame_service.sock";
+    FrameService service(HugePages::kNone, false);
+    string error;
+    ASSERT_TRUE(service.Listen(socket_path, &error)) << error;
+    thread server([&service] { service.Serve(); });
+
+    FrameServiceClient client;
+    ASSERT_TRUE(client.Connect(socket_path, &error)) << error;
+
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    FrameConfig config;
+    config.parameters = RequestParameters();
+
+    // Several requests on the same connection, each one checked against a
+    // frame generated locally.
+    const dsp_sample_format_t formats[3] = {DSP_SAMPLE_FORMAT_INT16,
+                                            DSP_SAMPLE_FORMAT_PACKED14,
+                                            DSP_SAMPLE_FORMAT_INT16};
+    for (uint32_t seed = 1; seed <= 3; ++seed) {
+        FrameRequest request;
+        request.parameters = config.parameters;
+        request.seed = seed;
+        request.output_format.format = formats[seed - 1];
+        request.symbols = seed != 2;
+        ServedFrame served;
+        ASSERT_TRUE(client.Generate(request, &served, &error)) << error;
+
+        config.seed = seed;
+        Frame frame = GenerateFrame(config, &luts, &arena, false);
+        EXPECT_EQ(served.plan().num_samples, frame.plan.num_samples);
+        EXPECT_EQ(served.plan().num_samples_zc, frame.plan.num_samples_zc);
+        EXPECT_EQ(served.plan().num_samples_qd, frame.plan.num_samples_qd);
+        EXPECT_EQ(served.plan().num_samples_tail,
+                  frame.plan.num_samples_tail);
+        ASSERT_EQ(served.plan().num_symbols, frame.plan.num_symbols);
+
+        sample_format_state_t format;
+        dsp_sample_format_init(&format, request.output_format.format, 1.0f,
+                               SAMPLE_FORMAT_NO_SATURATION);
+        vector<uint8_t> expected(dsp_sample_format_size(
+            request.output_format.format, frame.plan.num_samples));
+        dsp_sample_format_process(&format, frame.samples, expected.data(),
+                                  frame.plan.num_samples);
+        ASSERT_EQ(served.samples_size(), expected.size());
+        EXPECT_EQ(memcmp(served.samples(), expected.data(), expected.size()),
+                  0);
+
+        if (request.symbols) {
+            ASSERT_NE(served.symbols(), nullptr);
+            EXPECT_EQ(memcmp(served.symbols(), frame.symbols,
+                             frame.plan.num_symbols * sizeof(iq_sample_t)),
+                      0);
+        } else {
+            EXPECT_EQ(served.symbols(), nullptr);
+        }
+    }
+
+    // An invalid request is rejected, and the connection stays usable.
+    FrameRequest request;
+    request.parameters = RequestParameters();
+    request.parameters.zc_length = 0;
+    ServedFrame served;
+    FrameServiceStatus status = FrameServiceStatus::kOk;
+    EXPECT_FALSE(client.Generate(request, &served, &error, &status));
+    EXPECT_EQ(status, FrameServiceStatus::kInvalidParameters);
+    EXPECT_FALSE(error.empty());
+
+    // So is a frame larger than the limit of the service.
+    request.parameters = RequestParameters();
+    request.parameters.num_symbols = 0xffffffff;
+    EXPECT_FALSE(client.Generate(request, &served, &error, &status));
+    EXPECT_EQ(status, FrameServiceStatus::kInvalidParameters);
+    EXPECT_NE(error.find("limit"), string::npos) << error;
+
+    // Including when the number of samples would wrap on 32 bits: 2^31
+    // symbols of 2 samples.
+    request.parameters = RequestParameters();
+    request.parameters.sample_rate = 2;
+    request.parameters.symbol_rate = 1;
+    request.parameters.zc_rate = 1;
+    request.parameters.zc_length = 1;
+    request.parameters.num_null_symbols = 0;
+    request.parameters.num_symbols = 0x80000000;
+    EXPECT_FALSE(client.Generate(request, &served, &error, &status));
+    EXPECT_EQ(status, FrameServiceStatus::kInvalidParameters);
+    EXPECT_NE(error.find("limit"), string::npos) << error;
+
+    request.parameters = RequestParameters();
+    EXPECT_TRUE(client.Generate(request, &served, &error, &status)) << error;
+    EXPECT_EQ(status, FrameServiceStatus::kOk);
+
+    service.Stop();
+    server.join();
+    EXPECT_EQ(service.num_requests(), 7);
+    EXPECT_FALSE(client.Generate(request, &served, &error));
+}
@@ -0,0 +1,141 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Loopback frame verifier tests.
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <vector>
+
+#include "frame_buffer_arena.h"
+#include "frame_fixtures.h"
+#include "frame_generator.h"
+#include "frame_verifier.h"
+
+using namespace std;
+
+TEST(FrameVerifierTest, GeneratedFramesPass) {
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    for (uint32_t shift : {0u, 12345678u}) {
+        for (float roll_off : {0.2f, 0.5f}) {
+            FrameConfig config = SmallFrameConfig(20000);
+            config.parameters.shift_frequency = shift;
+            config.parameters.rrc_roll_off = roll_off;
+            Frame frame = GenerateFrame(config, &luts, &arena, false);
+            VerifyReport report = VerifyFrame(
+                config.parameters, frame.samples, frame.plan.num_samples,
+                frame.symbols, frame.plan.num_symbols, &luts,
+                VerifyOptions());
+            EXPECT_TRUE(report.passed) << shift << " " << roll_off;
+            EXPECT_EQ(report.zc_offset, 0);
+            EXPECT_GT(report.zc_peak, 0.99);
+            EXPECT_GT(report.num_symbols, 19900);
+            EXPECT_GT(report.correlation, 0.999);
+            EXPECT_LT(report.evm, 0.05);
+        }
+    }
+}
+
+TEST(FrameVerifierTest, DiscreteModulationsPass) {
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    FrameBufferArena planar_arena(HugePages::kNone, false);
+    const Modulation modulations[3] = {{DSP_MODULATION_PSK, 4, 0.0f},
+                                       {DSP_MODULATION_PSK, 8, 0.0f},
+                                       {DSP_MODULATION_QAM, 64, 0.8f}};
+    for (const Modulation& modulation : modulations) {
+        FrameConfig config = SmallFrameConfig(20000);
+        config.modulation = modulation;
+        Frame frame = GenerateFrame(config, &luts, &arena, false);
+        VerifyReport report = VerifyFrame(
+            config.parameters, frame.samples, frame.plan.num_samples,
+            frame.symbols, frame.plan.num_symbols, &luts, VerifyOptions());
+        EXPECT_TRUE(report.passed) << modulation.order;
+        EXPECT_GT(report.correlation, 0.999);
+
+        // Same samples on the planar chain.
+        config.planar = true;
+        Frame planar = GenerateFrame(config, &luts, &planar_arena, false);
+        EXPECT_EQ(memcmp(planar.samples, frame.samples,
+                         frame.plan.num_samples * sizeof(iq_sample_t)),
+                  0);
+    }
+}
+
+TEST(FrameVerifierTest, MultistageInterpolation) {
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    FrameBufferArena planar_arena(HugePages::kNone, false);
+    for (size_t num_stages = 1; num_stages <= 3; ++num_stages) {
+        FrameConfig config = SmallFrameConfig(20000);
+        config.interpolation_stages = num_stages;
+        config.chunk_size = 1000;
+        Frame frame = GenerateFrame(config, &luts, &arena, false);
+        VerifyReport report = VerifyFrame(
+            config.parameters, frame.samples, frame.plan.num_samples,
+            frame.symbols, frame.plan.num_symbols, &luts, VerifyOptions());
+        EXPECT_TRUE(report.passed) << num_stages;
+        EXPECT_EQ(report.symbol_delay, 0);
+        EXPECT_GT(report.correlation, 0.999);
+
+        config.planar = true;
+        Frame planar = GenerateFrame(config, &luts, &planar_arena, false);
+        EXPECT_EQ(memcmp(planar.samples, frame.samples,
+                         frame.plan.num_samples * sizeof(iq_sample_t)),
+                  0);
+
+        InterpolationReport interpolation =
+            MeasureInterpolation(config, &luts);
+        EXPECT_EQ(interpolation.num_stages, num_stages);
+        EXPECT_LT(interpolation.multiplies, interpolation.direct_multiplies);
+        EXPECT_LT(interpolation.error_db, -40.0);
+        EXPECT_LT(interpolation.spectral_error_db, -45.0);
+    }
+}
+
+TEST(FrameVerifierTest, DetectMisplacedPreamble) {
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    FrameConfig config = SmallFrameConfig(20000);
+    Frame frame = GenerateFrame(config, &luts, &arena, false);
+
+    // The frame starts 1000 samples late: the symbols are still recovered.
+    vector<iq_sample_t> samples(1000, iq_sample_t{0, 0});
+    samples.insert(samples.end(), frame.samples,
+                   frame.samples + frame.plan.num_samples);
+    VerifyReport report = VerifyFrame(
+        config.parameters, samples.data(), samples.size(), frame.symbols,
+        frame.plan.num_symbols, &luts, VerifyOptions());
+    EXPECT_EQ(report.zc_offset, 1000);
+    EXPECT_GT(report.correlation, 0.999);
+    EXPECT_FALSE(report.passed);
+
+    VerifyOptions options;
+    options.expected_zc_offset = 1000;
+    EXPECT_TRUE(VerifyFrame(config.parameters, samples.data(),
+                            samples.size(), frame.symbols,
+                            frame.plan.num_symbols, &luts, options)
+                    .passed);
+}
+
+TEST(FrameVerifierTest, DetectWrongSymbols) {
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    FrameConfig config = SmallFrameConfig(20000);
+    Frame frame = GenerateFrame(config, &luts, &arena, false);
+    vector<iq_sample_t> samples(frame.samples,
+                                frame.samples + frame.plan.num_samples);
+
+    config.seed = 8;
+    frame = GenerateFrame(config, &luts, &arena, false);
+    VerifyReport report = VerifyFrame(
+        config.parameters, samples.data(), samples.size(), frame.symbols,
+        frame.plan.num_symbols, &luts, VerifyOptions());
+    EXPECT_EQ(report.zc_offset, 0);
+    EXPECT_LT(report.correlation, 0.1);
+    EXPECT_FALSE(report.passed);
+}
@@ -0,0 +1,498 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Golden-digest regression suite: full-size frames of a matrix of
+// configurations are generated by every chain (dataflow graph, pipelined
+// graph, planar, streaming and batched generators), and streaming hashes of
+// their signals, per stage and per region, are checked against the digests
+// committed in testdata/golden_digests.tsv. All the chains must give the
+// digests of the configuration: any change of a single bit of a kernel is
+// caught, in seconds, without storing the frames.
+//
+// After an intended change of the samples, regenerate the file by running
+// test_all with --gtest_also_run_disabled_tests and
+// --gtest_filter=GoldenDigestTest.DISABLED_Update.
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "dsp/dsp_batch_generator.h"
+#include "dsp/dsp_frame_generator.h"
+#include "dsp/dsp_memory_plan.h"
+#include "dsp/dsp_sample_format.h"
+}
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "frame_buffer_arena.h"
+#include "frame_fixtures.h"
+#include "frame_generator.h"
+#include "sweep.h"
+#include "testdata_path.h"
+
+using namespace std;
+
+namespace {
+
+const char kDigestFile[] = "golden_digests.tsv";
+
+// Full-size frames, with the defaults of the command line tool.
+const uint32_t kNumSymbols = 1000000;
+
+// Sweep file syntax (see sweep.h). Configurations with the Gaussian symbols
+// and the direct RRC filter also run through the streaming and batched
+// generators; the compatible ones are batched together.
+const char* const kConfigurations[] = {
+    "name=default",
+    "name=roll_off_0.2 rrc_roll_off=0.2 seed=3",
+    // Not precomputed: the RRC LUT is computed at runtime.
+    "name=roll_off_0.15 rrc_roll_off=0.15 seed=4 zc_root=7 zc_shift=11",
+    "name=8_samples_per_symbol symbol_rate=250e6 seed=5",
+    "name=1_gsps sample_rate=1e9 symbol_rate=50e6 zc_rate=25e6 "
+    "shift_frequency=1e6 symbol_clamp=true seed=6",
+    "name=shifted shift_frequency=12345678 pilot_1_freq=150e6 "
+    "pilot_2_amplitude=0.1 symbol_scale=9000 seed=7",
+    "name=qam16 modulation=qam modulation_order=16 shaping=0.5 seed=8",
+    "name=psk8 modulation=psk modulation_order=8 seed=9",
+    "name=interpolated interpolation_stages=3 seed=10",
+    "name=packed14 output_format=packed14 output_scale=1.5 seed=11",
+    "name=packed12 output_format=packed12 output_saturation=20000 seed=12",
+    "name=cf32 output_format=cf32 seed=13",
+    "name=cf16 output_format=cf16 output_scale=2 seed=14",
+};
+
+enum DigestStage {
+    DIGEST_SYMBOLS,
+    DIGEST_RRC,
+    DIGEST_ZC,
+    DIGEST_QD,
+    DIGEST_TAIL,
+    DIGEST_OUTPUT,
+    NUM_DIGEST_STAGES
+};
+
+const char* const kStageNames[NUM_DIGEST_STAGES] = {
+    "symbols", "rrc", "zc", "qd", "tail", "output"};
+
+// The streaming and batched generators only produce the samples.
+const uint32_t kAllStages = (1 << NUM_DIGEST_STAGES) - 1;
+const uint32_t kSampleStages =
+    (1 << DIGEST_ZC) | (1 << DIGEST_QD) | (1 << DIGEST_TAIL) |
+    (1 << DIGEST_OUTPUT);
+
+struct FrameDigest {
+    uint64_t stage[NUM_DIGEST_STAGES] = {0};
+};
+
+// 64-bit hash of a byte stream, independent of the way it is split: each
+// 8-byte word goes through a multiply-xorshift round, and the length is
+// mixed in at the end. Not cryptographic, but any change of the data
+// changes the digest with overwhelming probability.
+class StreamHash {
+   public:
+    void Update(const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        length_ += size;
+        if (num_pending_) {
+            const size_t n = std::min(size, 8 - num_pending_);
+            memcpy(&pending_[num_pending_], p, n);
+            num_pending_ += n;
+            p += n;
+            size -= n;
+            if (num_pending_ < 8) {
+                return;
+            }
+            Round(pending_);
+            num_pending_ = 0;
+        }
+        for (; size >= 8; p += 8, size -= 8) {
+            Round(p);
+        }
+        memcpy(pending_, p, size);
+        num_pending_ = size;
+    }
+
+    uint64_t Digest() const {
+        uint8_t last[8] = {0};
+        memcpy(last, pending_, num_pending_);
+        StreamHash h = *this;
+        h.Round(last);
+        uint64_t x = h.state_ ^ length_;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+   private:
+    void Round(const uint8_t* p) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        state_ = (state_ ^ word) * 0x9e3779b97f4a7c15ULL;
+        state_ ^= state_ >> 32;
+    }
+
+    uint64_t state_ = 0x243f6a8885a308d3ULL;
+    uint64_t length_ = 0;
+    uint8_t pending_[8];
+    size_t num_pending_ = 0;
+};
+
+// Hashes the stages of a frame as they are produced. The samples, given in
+// order in blocks of any size, are split between the regions, and converted
+// to the output format by chunks.
+class FrameDigester {
+   public:
+    FrameDigester(const dsp_memory_plan_t& plan, const SampleFormat& format)
+        : plan_(plan),
+          format_(format.format),
+          chunk_(new iq_sample_t[kChunkSize]),
+          bytes_(new char[dsp_sample_format_size(format.format,
+                                                 kChunkSize)]) {
+        dsp_sample_format_init(&converter_, format.format, format.scale,
+                               format.saturation);
+    }
+
+    void AddSymbols(const iq_sample_t* symbols, size_t size) {
+        hash_[DIGEST_SYMBOLS].Update(symbols, size * sizeof(iq_sample_t));
+    }
+
+    void AddRrc(const iq_sample_t* samples, size_t size) {
+        hash_[DIGEST_RRC].Update(samples, size * sizeof(iq_sample_t));
+    }
+
+    void AddSamples(const iq_sample_t* samples, size_t size) {
+        const size_t boundary[3] = {
+            plan_.num_samples_zc, plan_.num_samples_zc + plan_.num_samples_qd,
+            plan_.num_samples};
+        size_t offset = 0;
+        while (offset < size) {
+            size_t region = 0;
+            while (position_ >= boundary[region]) {
+                ++region;
+            }
+            size_t n = std::min(size - offset, boundary[region] - position_);
+            hash_[DIGEST_ZC + region].Update(&samples[offset],
+                                             n * sizeof(iq_sample_t));
+            position_ += n;
+            offset += n;
+        }
+        for (offset = 0; offset < size;) {
+            size_t n = std::min(size - offset, kChunkSize - chunk_size_);
+            memcpy(&chunk_[chunk_size_], &samples[offset],
+                   n * sizeof(iq_sample_t));
+            chunk_size_ += n;
+            offset += n;
+            if (chunk_size_ == kChunkSize) {
+                Convert();
+            }
+        }
+    }
+
+    FrameDigest Finish() {
+        Convert();
+        FrameDigest digest;
+        for (size_t s = 0; s < NUM_DIGEST_STAGES; ++s) {
+            digest.stage[s] = hash_[s].Digest();
+        }
+        return digest;
+    }
+
+   private:
+    // Even, for PACKED14.
+    static const size_t kChunkSize = 4096;
+
+    void Convert() {
+        dsp_sample_format_process(&converter_, chunk_.get(), bytes_.get(),
+                                  chunk_size_);
+        hash_[DIGEST_OUTPUT].Update(
+            bytes_.get(), dsp_sample_format_size(format_, chunk_size_));
+        chunk_size_ = 0;
+    }
+
+    dsp_memory_plan_t plan_;
+    dsp_sample_format_t format_;
+    sample_format_state_t converter_;
+    std::unique_ptr<iq_sample_t[]> chunk_;
+    std::unique_ptr<char[]> bytes_;
+    size_t chunk_size_ = 0;
+    size_t position_ = 0;
+    StreamHash hash_[NUM_DIGEST_STAGES];
+};
+
+vector<FrameConfig> Configurations() {
+    FrameConfig base = SmallFrameConfig(kNumSymbols, 1);
+    base.probes = 1 << static_cast<int>(ProbePoint::kRrc);
+
+    string text;
+    for (const char* line : kConfigurations) {
+        text += string(line) + "\n";
+    }
+    istringstream in(text);
+    vector<FrameConfig> configs;
+    string error;
+    EXPECT_TRUE(ParseSweep(in, base, ".", &configs, &error)) << error;
+    return configs;
+}
+
+bool Streamable(const FrameConfig& config) {
+    return config.modulation.type == DSP_MODULATION_GAUSSIAN &&
+           !config.interpolation_stages;
+}
+
+FrameDigest DigestFrame(const FrameConfig& config, const Frame& frame) {
+    FrameDigester digester(frame.plan, config.output_format);
+    digester.AddSymbols(frame.symbols, frame.plan.num_symbols);
+    if (frame.rrc_samples) {
+        digester.AddRrc(frame.rrc_samples, frame.plan.num_samples_qd);
+    }
+    digester.AddSamples(frame.samples, frame.plan.num_samples);
+    return digester.Finish();
+}
+
+FrameDigest DigestWholeFrame(FrameConfig config, bool planar, bool pipeline,
+                             size_t chunk_size, LutCache* luts,
+                             FrameBufferArena* arena) {
+    config.planar = planar;
+    config.pipeline = pipeline;
+    config.chunk_size = chunk_size;
+    return DigestFrame(config, GenerateFrame(config, luts, arena, false));
+}
+
+string FormatDigests(const string& name, const FrameDigest& digest) {
+    string line = name;
+    for (size_t s = 0; s < NUM_DIGEST_STAGES; ++s) {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016" PRIx64, digest.stage[s]);
+        line += string("\t") + hex;
+    }
+    return line;
+}
+
+map<string, FrameDigest> LoadGoldenDigests() {
+    map<string, FrameDigest> digests;
+    ifstream in(string(TESTDATA_DIR) + "/" + kDigestFile);
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        istringstream fields(line);
+        string name;
+        FrameDigest digest;
+        fields >> name;
+        for (size_t s = 0; s < NUM_DIGEST_STAGES; ++s) {
+            string hex;
+            fields >> hex;
+            digest.stage[s] = strtoull(hex.c_str(), nullptr, 16);
+        }
+        digests[name] = digest;
+    }
+    return digests;
+}
+
+void ExpectGoldenDigests(const map<string, FrameDigest>& golden,
+                         const string& name, const FrameDigest& digest,
+                         uint32_t stages, const string& chain) {
+    auto it = golden.find(name);
+    ASSERT_NE(it, golden.end()) << name << ": no golden digests";
+    for (size_t s = 0; s < NUM_DIGEST_STAGES; ++s) {
+        if (stages & (1 << s)) {
+            EXPECT_EQ(digest.stage[s], it->second.stage[s])
+                << name << ", " << chain << ": " << kStageNames[s]
+                << " differs";
+        }
+    }
+}
+
+// Whole-frame generation, with the execution choices of a chain.
+void CheckWholeFrames(bool planar, bool pipeline, size_t chunk_size,
+                      const string& chain) {
+    const map<string, FrameDigest> golden = LoadGoldenDigests();
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    for (const FrameConfig& config : Configurations()) {
+        ExpectGoldenDigests(golden, config.name,
+                            DigestWholeFrame(config, planar, pipeline,
+                                             chunk_size, &luts, &arena),
+                            kAllStages, chain);
+    }
+}
+
+}  // namespace
+
+TEST(GoldenDigestTest, Graph) {
+    CheckWholeFrames(false, false, DSP_GRAPH_DEFAULT_CHUNK_SIZE, "graph");
+}
+
+TEST(GoldenDigestTest, PipelinedGraph) {
+    CheckWholeFrames(false, true, 333, "pipelined graph");
+}
+
+TEST(GoldenDigestTest, Planar) {
+    CheckWholeFrames(true, false, DSP_GRAPH_DEFAULT_CHUNK_SIZE, "planar");
+}
+
+TEST(GoldenDigestTest, StreamingGenerator) {
+    const map<string, FrameDigest> golden = LoadGoldenDigests();
+    LutCache luts;
+    const size_t block_size = 1000;
+    vector<iq_sample_t> out(4093);
+    for (const FrameConfig& config : Configurations()) {
+        if (!Streamable(config)) {
+            continue;
+        }
+        dsp_memory_plan_t plan;
+        dsp_memory_plan_frame(&plan, &config.parameters);
+        dsp_memory_plan_t streaming;
+        dsp_memory_plan_streaming(&streaming, &config.parameters,
+                                  block_size);
+        vector<iq_sample_t> symbols(streaming.symbols_per_block);
+        frame_generator_state_t state;
+        dsp_frame_generator_init(
+            &state, &config.parameters, config.seed, luts.phasor(),
+            luts.rrc(config.parameters.rrc_roll_off), symbols.data(),
+            block_size);
+        FrameDigester digester(plan, config.output_format);
+        while (size_t n = dsp_frame_generator_process(&state, out.data(),
+                                                      out.size())) {
+            digester.AddSamples(out.data(), n);
+        }
+        ExpectGoldenDigests(golden, config.name, digester.Finish(),
+                            kSampleStages, "streaming generator");
+    }
+}
+
+TEST(GoldenDigestTest, BatchGenerator) {
+    const map<string, FrameDigest> golden = LoadGoldenDigests();
+    LutCache luts;
+    const size_t block_size = 2048;
+    vector<FrameConfig> configs;
+    for (const FrameConfig& config : Configurations()) {
+        if (Streamable(config)) {
+            configs.push_back(config);
+        }
+    }
+
+    // Each configuration is batched with the following compatible ones.
+    vector<bool> done(configs.size(), false);
+    size_t num_batched = 0;
+    for (size_t first = 0; first < configs.size(); ++first) {
+        if (done[first]) {
+            continue;
+        }
+        vector<size_t> channels;
+        for (size_t c = first; c < configs.size() &&
+                               channels.size() < DSP_BATCH_MAX_CHANNELS;
+             ++c) {
+            if (!done[c] && dsp_batch_generator_compatible(
+                                &configs[first].parameters,
+                                &configs[c].parameters)) {
+                channels.push_back(c);
+                done[c] = true;
+            }
+        }
+        num_batched += channels.size() > 1 ? channels.size() : 0;
+
+        const size_t num_channels = channels.size();
+        vector<dsp_parameter_t> parameters;
+        vector<uint32_t> seeds;
+        for (size_t c : channels) {
+            parameters.push_back(configs[c].parameters);
+            seeds.push_back(configs[c].seed);
+        }
+        const dsp_parameter_t& p = parameters[0];
+        dsp_memory_plan_t plan;
+        dsp_memory_plan_frame(&plan, &p);
+        vector<iq_sample_t> symbols(
+            num_channels *
+            DSP_PLAN_SYMBOLS_PER_BLOCK(block_size, p.symbol_rate,
+                                       p.sample_rate));
+        batch_generator_state_t state;
+        dsp_batch_generator_init(
+            &state, parameters.data(), seeds.data(), num_channels,
+            luts.phasor(), luts.rrc(p.rrc_roll_off), symbols.data(),
+            block_size);
+
+        vector<unique_ptr<FrameDigester>> digesters;
+        for (size_t c : channels) {
+            digesters.emplace_back(
+                new FrameDigester(plan, configs[c].output_format));
+        }
+        vector<iq_sample_t> out(num_channels * block_size);
+        vector<iq_sample_t> channel(block_size);
+        while (size_t n = dsp_batch_generator_process(&state, out.data(),
+                                                      block_size)) {
+            for (size_t c = 0; c < num_channels; ++c) {
+                for (size_t i = 0; i < n; ++i) {
+                    channel[i] = out[i * num_channels + c];
+                }
+                digesters[c]->AddSamples(channel.data(), n);
+            }
+        }
+        for (size_t c = 0; c < num_channels; ++c) {
+            ExpectGoldenDigests(golden, configs[channels[c]].name,
+                                digesters[c]->Finish(), kSampleStages,
+                                "batch generator");
+        }
+    }
+    EXPECT_GT(num_batched, 1u);
+}
+
+// Any split of the stream gives the same digest.
+TEST(GoldenDigestTest, StreamHashIgnoresBlockBoundaries) {
+    vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 37 + (i >> 3));
+    }
+    StreamHash whole;
+    whole.Update(data.data(), data.size());
+    for (size_t block : {1, 3, 7, 8, 13, 999}) {
+        StreamHash split;
+        for (size_t i = 0; i < data.size(); i += block) {
+            split.Update(&data[i], std::min(block, data.size() - i));
+        }
+        EXPECT_EQ(split.Digest(), whole.Digest()) << block;
+    }
+    data[500] ^= 1;
+    StreamHash changed;
+    changed.Update(data.data(), data.size());
+    EXPECT_NE(changed.Digest(), whole.Digest());
+    StreamHash shorter;
+    shorter.Update(data.data(), data.size() - 1);
+    EXPECT_NE(shorter.Digest(), changed.Digest());
+}
+
+TEST(GoldenDigestTest, DISABLED_Update) {
+    const string file_name = string(TESTDATA_DIR) + "/" + kDigestFile;
+    ofstream out(file_name);
+    out << "# Golden digests of the frames of tests/test_golden_digests.cc.\n"
+           "# Regenerate after an intended change of the samples with:\n"
+           "#   test_all --gtest_also_run_disabled_tests "
+           "--gtest_filter=GoldenDigestTest.DISABLED_Update\n"
+           "# name";
+    for (const char* stage : kStageNames) {
+        out << '\t' << stage;
+    }
+    out << '\n';
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    for (const FrameConfig& config : Configurations()) {
+        out << FormatDigests(config.name,
+                             DigestWholeFrame(config, false, false,
+                                              DSP_GRAPH_DEFAULT_CHUNK_SIZE,
+                                              &luts, &arena))
+            << '\n';
+    }
+    ASSERT_TRUE(out.flush()) << "Failed to write " << file_name;
+}
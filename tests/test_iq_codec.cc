@@ -0,0 +1,187 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Lossless codec tests.
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+
+#include <string>
+#include <vector>
+
+#include "iq_codec.h"
+
+using namespace std;
+
+namespace {
+
+string RoundTrip(const string& data, IqCodecStream stream,
+                 const IqCodecOptions& options, size_t* compressed_size) {
+    string compressed =
+        IqCodecCompress(data.data(), data.size(), stream, options);
+    *compressed_size = compressed.size();
+    string restored, error;
+    EXPECT_TRUE(IqCodecDecompress(compressed, 4, &restored, &error)) << error;
+    return restored;
+}
+
+// Oversampled tone, as a stand-in for a pulse-shaped signal.
+string SmoothIq(size_t num_samples) {
+    vector<int16_t> samples(2 * num_samples);
+    for (size_t i = 0; i < num_samples; ++i) {
+        double t = 2.0 * M_PI * i / 40.0;
+        samples[2 * i] = static_cast<int16_t>(lrint(20000.0 * cos(t)));
+        samples[2 * i + 1] = static_cast<int16_t>(lrint(20000.0 * sin(t)));
+    }
+    return string(reinterpret_cast<const char*>(samples.data()),
+                  samples.size() * sizeof(int16_t));
+}
+
+// LSB-first, as the partitions.
+void AppendBits(uint32_t value, int bits, string* bit_string) {
+    for (int i = 0; i < bits; ++i) {
+        bit_string->push_back((value >> i) & 1 ? '1' : '0');
+    }
+}
+
+string PackBits(string bit_string) {
+    bit_string.resize((bit_string.size() + 7) / 8 * 8, '0');
+    string bytes;
+    for (size_t i = 0; i < bit_string.size(); i += 8) {
+        int byte = 0;
+        for (int j = 0; j < 8; ++j) {
+            byte |= (bit_string[i + j] == '1') << j;
+        }
+        bytes.push_back(static_cast<char>(byte));
+    }
+    return bytes;
+}
+
+string LittleEndian(uint64_t value, size_t size) {
+    string bytes;
+    for (size_t i = 0; i < size; ++i) {
+        bytes.push_back(static_cast<char>(value >> (8 * i)));
+    }
+    return bytes;
+}
+
+}  // namespace
+
+TEST(IqCodecTest, IqRoundTrip) {
+    IqCodecOptions options;
+    options.iq_block_size = 10000;  // Not a multiple of the partition size.
+    string data = SmoothIq(100003);
+    size_t compressed_size;
+    EXPECT_EQ(RoundTrip(data, IqCodecStream::kIq, options, &compressed_size),
+              data);
+    EXPECT_LT(compressed_size * 2, data.size());
+
+    // Extremes, predicted with the largest residuals.
+    string extremes;
+    for (int i = 0; i < 1000; ++i) {
+        int16_t value = (i / 3) % 2 ? 32767 : -32768;
+        extremes.append(reinterpret_cast<const char*>(&value), 2);
+    }
+    EXPECT_EQ(RoundTrip(extremes, IqCodecStream::kIq, options,
+                        &compressed_size),
+              extremes);
+
+    // Incomplete pair: stored.
+    string odd = data.substr(0, 4 * 1000 + 3);
+    EXPECT_EQ(RoundTrip(odd, IqCodecStream::kIq, options, &compressed_size),
+              odd);
+
+    string empty;
+    EXPECT_EQ(RoundTrip(empty, IqCodecStream::kIq, options, &compressed_size),
+              empty);
+}
+
+TEST(IqCodecTest, SymbolsRoundTrip) {
+    IqCodecOptions options;
+    options.symbols_block_size = 1000;
+    string text;
+    for (int i = 0; i < 5000; ++i) {
+        text += to_string((i * 7919) % 30001 - 15000) + "\t" +
+                to_string((i * 104729) % 30001 - 15000) + "\n";
+    }
+    size_t compressed_size;
+    EXPECT_EQ(RoundTrip(text, IqCodecStream::kSymbols, options,
+                        &compressed_size),
+              text);
+    EXPECT_LT(compressed_size * 2, text.size());
+
+    // Text which doesn't print back identically is stored.
+    string unusual = "1\t2\n-0\t3\n+4\t5\n007\t1\n4\t5";
+    EXPECT_EQ(RoundTrip(unusual, IqCodecStream::kSymbols, options,
+                        &compressed_size),
+              unusual);
+    string floats = "0.5\t-0.25\n";
+    EXPECT_EQ(RoundTrip(floats, IqCodecStream::kSymbols, options,
+                        &compressed_size),
+              floats);
+}
+
+TEST(IqCodecTest, RejectCorruptedInput) {
+    IqCodecOptions options;
+    string data = SmoothIq(10000);
+    string compressed = IqCodecCompress(data.data(), data.size(),
+                                        IqCodecStream::kIq, options);
+    string restored, error;
+
+    EXPECT_FALSE(IqCodecDecompress("hello", 1, &restored, &error));
+    EXPECT_FALSE(IqCodecDecompress(
+        compressed.substr(0, compressed.size() - 1), 1, &restored, &error));
+
+    string corrupted = compressed;
+    corrupted[compressed.size() / 2] ^= 0x5a;
+    // Either detected, or decoded to different data: never a crash.
+    if (IqCodecDecompress(corrupted, 1, &restored, &error)) {
+        EXPECT_EQ(restored.size(), data.size());
+    }
+}
+
+TEST(IqCodecTest, RejectOutOfRangeResidual) {
+    // One coded block of 2 pairs, in one partition: I predicted by
+    // x[n] = x[n - 1], with residuals on width bits; Q predicted by 0, with
+    // null residuals.
+    auto stream = [](int width, const string& bits) {
+        string block = string("\x01") + LittleEndian(2, 4) +
+                       string("\x00\x01\x00\x00\x00\x00\x00\x00\x00", 9) +
+                       string(9, '\0') + static_cast<char>(width) +
+                       string(1, '\0') + PackBits(bits) + string(8, '\0');
+        return string("EAZ2\x01\x00\x00\x00", 8) + LittleEndian(8, 8) +
+               LittleEndian(1, 4) + LittleEndian(block.size(), 4) +
+               LittleEndian(8, 4) + block;
+    };
+    // I starts at 32767...
+    string bits;
+    AppendBits(65534, 17, &bits);
+    const string first_sample = bits;
+
+    // ...followed by a residual of 1.
+    AppendBits(2, 17, &bits);
+    bits.resize(32 * 17, '0');
+    string restored, error;
+    EXPECT_FALSE(IqCodecDecompress(stream(17, bits), 1, &restored, &error));
+
+    // Residuals wider than the difference of two int16.
+    EXPECT_FALSE(IqCodecDecompress(stream(18, bits + string(32, '0')), 1,
+                                   &restored, &error));
+
+    // ...followed by a null residual.
+    bits = first_sample;
+    bits.resize(32 * 17, '0');
+    ASSERT_TRUE(IqCodecDecompress(stream(17, bits), 1, &restored, &error))
+        << error;
+    const int16_t expected[4] = {32767, 0, 32767, 0};
+    EXPECT_EQ(restored, string(reinterpret_cast<const char*>(expected), 8));
+}
+
+TEST(IqCodecTest, StreamFromFileName) {
+    EXPECT_EQ(IqCodecStreamFromFileName("out_iq.bin"), IqCodecStream::kIq);
+    EXPECT_EQ(IqCodecStreamFromFileName("a/out_symbols.tsv"),
+              IqCodecStream::kSymbols);
+    EXPECT_EQ(IqCodecStreamFromFileName("notes.txt"), IqCodecStream::kRaw);
+}
@@ -0,0 +1,335 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Streaming frame generator and paced streaming tests.
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "dsp/dsp_frame_generator.h"
+#include "dsp/dsp_statistics.h"
+}
+
+#include <string.h>
+
+#include <vector>
+
+#include "frame_buffer_arena.h"
+#include "frame_fixtures.h"
+#include "frame_generator.h"
+#include "paced_stream.h"
+
+using namespace std;
+
+namespace {
+
+// Shifted, to exercise the full phasor bank.
+FrameConfig ShiftedFrameConfig() {
+    FrameConfig config = SmallFrameConfig();
+    config.parameters.shift_frequency = 12345678;
+    return config;
+}
+
+}  // namespace
+
+TEST(FrameGeneratorTest, StreamingMatchesWholeFrame) {
+    FrameConfig config = ShiftedFrameConfig();
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    Frame frame = GenerateFrame(config, &luts, &arena, false);
+    const size_t num_samples = frame.plan.num_samples;
+
+    for (size_t block_size : {1, 37, 4096}) {
+        dsp_memory_plan_t plan;
+        dsp_memory_plan_streaming(&plan, &config.parameters, block_size);
+        vector<iq_sample_t> symbols(plan.symbols_per_block);
+
+        frame_generator_state_t state;
+        dsp_frame_generator_init(
+            &state, &config.parameters, config.seed, luts.phasor(),
+            luts.rrc(config.parameters.rrc_roll_off), symbols.data(),
+            block_size);
+        ASSERT_EQ(state.num_samples, num_samples);
+
+        // Requests of irregular sizes, crossing the region boundaries.
+        vector<iq_sample_t> out(num_samples + 100);
+        size_t position = 0;
+        for (size_t i = 0; position < num_samples; ++i) {
+            size_t size = 1 + (i * 7919) % 10007;
+            position += dsp_frame_generator_process(
+                &state, &out[position], size);
+        }
+        EXPECT_EQ(position, num_samples);
+        EXPECT_EQ(dsp_frame_generator_process(&state, &out[position], 100),
+                  0);
+        EXPECT_EQ(memcmp(out.data(), frame.samples,
+                         num_samples * sizeof(iq_sample_t)), 0)
+            << "Block size " << block_size;
+    }
+}
+
+TEST(FrameGeneratorTest, PlanarMatchesInterleaved) {
+    FrameConfig config = ShiftedFrameConfig();
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    Frame frame = GenerateFrame(config, &luts, &arena, false);
+    vector<iq_sample_t> samples(frame.samples,
+                                frame.samples + frame.plan.num_samples);
+    vector<iq_sample_t> symbols(frame.symbols,
+                                frame.symbols + frame.plan.num_symbols);
+
+    config.planar = true;
+    Frame planar = GenerateFrame(config, &luts, &arena, false);
+    ASSERT_EQ(planar.plan.num_samples, samples.size());
+    EXPECT_EQ(memcmp(planar.samples, samples.data(),
+                     samples.size() * sizeof(iq_sample_t)), 0);
+    EXPECT_EQ(memcmp(planar.symbols, symbols.data(),
+                     symbols.size() * sizeof(iq_sample_t)), 0);
+}
+
+TEST(FrameGeneratorTest, GraphMatchesBlockByBlockGeneration) {
+    FrameConfig config = ShiftedFrameConfig();
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+
+    // The planar chain runs each block over the whole frame in turn.
+    config.planar = true;
+    Frame frame = GenerateFrame(config, &luts, &arena, false);
+    vector<iq_sample_t> samples(frame.samples,
+                                frame.samples + frame.plan.num_samples);
+    vector<iq_sample_t> symbols(frame.symbols,
+                                frame.symbols + frame.plan.num_symbols);
+
+    config.planar = false;
+    for (bool pipeline : {false, true}) {
+        for (size_t chunk_size : {1, 333, 65536}) {
+            config.pipeline = pipeline;
+            config.chunk_size = chunk_size;
+            Frame graph = GenerateFrame(config, &luts, &arena, false);
+            EXPECT_EQ(memcmp(graph.samples, samples.data(),
+                             samples.size() * sizeof(iq_sample_t)), 0)
+                << "Chunk size " << chunk_size << ", pipeline " << pipeline;
+            EXPECT_EQ(memcmp(graph.symbols, symbols.data(),
+                             symbols.size() * sizeof(iq_sample_t)), 0);
+        }
+    }
+}
+
+TEST(FrameGeneratorTest, SnapshotResumesFrame) {
+    FrameConfig config = ShiftedFrameConfig();
+    LutCache luts;
+    const size_t block_size = 1000;
+    dsp_memory_plan_t plan;
+    dsp_memory_plan_streaming(&plan, &config.parameters, block_size);
+    vector<iq_sample_t> symbols(plan.symbols_per_block);
+    auto init = [&](frame_generator_state_t* state, iq_sample_t* symbols,
+                    size_t block_size) {
+        dsp_frame_generator_init(
+            state, &config.parameters, config.seed, luts.phasor(),
+            luts.rrc(config.parameters.rrc_roll_off), symbols, block_size);
+    };
+
+    // Saved in the middle of the quantum data, with a retune pending.
+    frame_generator_state_t state;
+    init(&state, symbols.data(), block_size);
+    const size_t num_samples = state.num_samples;
+    vector<iq_sample_t> out(num_samples);
+    size_t position = dsp_frame_generator_process(&state, out.data(), 54321);
+    const uint32_t pilot_frequency[2] = {150000000, 250000000};
+    const float pilot_amplitude[2] = {0.1f, 0.2f};
+    dsp_frame_generator_retune(&state, 33333333, pilot_frequency,
+                               pilot_amplitude, 60000, 1000);
+    vector<uint8_t> snapshot(dsp_frame_generator_snapshot_size());
+    dsp_frame_generator_save(&state, snapshot.data());
+    dsp_frame_generator_process(&state, &out[position],
+                                num_samples - position);
+
+    vector<iq_sample_t> other_symbols(plan.symbols_per_block);
+    frame_generator_state_t resumed;
+    init(&resumed, other_symbols.data(), block_size);
+    ASSERT_TRUE(dsp_frame_generator_restore(&resumed, snapshot.data()));
+    EXPECT_EQ(resumed.position, position);
+    EXPECT_EQ(resumed.symbols, other_symbols.data());
+    vector<iq_sample_t> rest(num_samples - position);
+    EXPECT_EQ(dsp_frame_generator_process(&resumed, rest.data(), rest.size()),
+              rest.size());
+    EXPECT_EQ(memcmp(rest.data(), &out[position],
+                     rest.size() * sizeof(iq_sample_t)), 0);
+
+    // Another block size, or a damaged snapshot, is rejected.
+    frame_generator_state_t other;
+    init(&other, other_symbols.data(), block_size / 2);
+    EXPECT_FALSE(dsp_frame_generator_restore(&other, snapshot.data()));
+    snapshot[0] ^= 1;
+    init(&other, other_symbols.data(), block_size);
+    EXPECT_FALSE(dsp_frame_generator_restore(&other, snapshot.data()));
+    EXPECT_EQ(other.position, 0u);
+}
+
+#ifdef DSP_STATISTICS
+
+TEST(FrameGeneratorTest, Statistics) {
+    FrameConfig config = ShiftedFrameConfig();
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    Frame frame = GenerateFrame(config, &luts, &arena, false);
+    const dsp_memory_plan_t& plan = frame.plan;
+    const dsp_frame_statistics_t& statistics = frame.statistics;
+
+    EXPECT_EQ(statistics.symbols.num_symbols, config.parameters.num_symbols);
+    int64_t sum_i = 0;
+    for (size_t n = 0; n < config.parameters.num_symbols; ++n) {
+        sum_i += frame.symbols[n].i;
+    }
+    EXPECT_EQ(statistics.symbols.sum[0], sum_i);
+
+    const size_t region_end[DSP_FRAME_NUM_REGIONS] = {
+        plan.num_samples_zc, plan.num_samples_zc + plan.num_samples_qd,
+        plan.num_samples};
+    size_t begin = 0;
+    for (size_t r = 0; r < DSP_FRAME_NUM_REGIONS; ++r) {
+        dsp_signal_statistics_t expected;
+        dsp_signal_statistics_reset(&expected);
+        for (size_t n = begin; n < region_end[r]; ++n) {
+            dsp_signal_statistics_add(&expected, frame.samples[n].i,
+                                      frame.samples[n].q);
+        }
+        EXPECT_EQ(statistics.region[r].num_samples, expected.num_samples);
+        EXPECT_EQ(statistics.region[r].energy, expected.energy);
+        EXPECT_EQ(statistics.region[r].peak, expected.peak);
+        begin = region_end[r];
+    }
+    // The ZC sequence is at full scale, the pilots at 0.16 each.
+    EXPECT_NEAR(dsp_signal_statistics_mean_power(
+                    &statistics.region[DSP_FRAME_REGION_ZC]),
+                1.0, 1e-3);
+    EXPECT_NEAR(dsp_signal_statistics_mean_power(
+                    &statistics.region[DSP_FRAME_REGION_TAIL]),
+                2 * 0.16 * 0.16, 1e-3);
+    EXPECT_EQ(statistics.num_wrapped, 0);
+
+    // The streaming generator reaches the same figures.
+    dsp_memory_plan_t streaming;
+    dsp_memory_plan_streaming(&streaming, &config.parameters, 37);
+    vector<iq_sample_t> symbols(streaming.symbols_per_block);
+    vector<iq_sample_t> block(37);
+    frame_generator_state_t state;
+    dsp_frame_generator_init(
+        &state, &config.parameters, config.seed, luts.phasor(),
+        luts.rrc(config.parameters.rrc_roll_off), symbols.data(), 37);
+    while (dsp_frame_generator_process(&state, block.data(), 37)) {
+    }
+    dsp_frame_statistics_t streamed;
+    dsp_frame_generator_get_statistics(&state, &streamed);
+    EXPECT_EQ(streamed.symbols.num_symbols, statistics.symbols.num_symbols);
+    EXPECT_EQ(streamed.symbols.sum_squares[1],
+              statistics.symbols.sum_squares[1]);
+    for (size_t r = 0; r < DSP_FRAME_NUM_REGIONS; ++r) {
+        EXPECT_EQ(streamed.region[r].num_samples,
+                  statistics.region[r].num_samples);
+        EXPECT_EQ(streamed.region[r].energy, statistics.region[r].energy);
+        EXPECT_EQ(streamed.region[r].peak, statistics.region[r].peak);
+    }
+    EXPECT_EQ(streamed.num_wrapped, statistics.num_wrapped);
+}
+
+#endif  // DSP_STATISTICS
+
+TEST(PacedStreamTest, LatencyPercentiles) {
+    vector<double> durations;
+    for (int i = 1000; i >= 1; --i) {
+        durations.push_back(i * 1e-6);
+    }
+    LatencyStats stats = ComputeLatencyStats(durations);
+    EXPECT_DOUBLE_EQ(stats.p50, 501e-6);
+    EXPECT_DOUBLE_EQ(stats.p90, 900e-6);
+    EXPECT_DOUBLE_EQ(stats.p99, 990e-6);
+    EXPECT_DOUBLE_EQ(stats.wcet, 1000e-6);
+}
+
+// Simulated timeline at 1000 samples/s, with times chosen so that the
+// arithmetic is exact.
+TEST(PacedStreamTest, PlaybackSchedule) {
+    PlaybackSchedule schedule(1000.0, 10000);
+
+    EXPECT_EQ(schedule.Advance(0.0, 5000), 0);
+    EXPECT_EQ(schedule.Advance(1.0, 5000), 1000);
+    EXPECT_EQ(schedule.position(), 1000);
+    EXPECT_EQ(schedule.underruns(), 0);
+
+    // Only 500 of the 1000 samples due are available: 500 samples of silence
+    // delay the rest of the stream by 0.5 s.
+    EXPECT_EQ(schedule.Advance(2.0, 500), 500);
+    EXPECT_EQ(schedule.underruns(), 1);
+    EXPECT_EQ(schedule.underrun_samples(), 500);
+    EXPECT_EQ(schedule.Advance(2.25, 1000), 250);
+    EXPECT_EQ(schedule.position(), 1750);
+
+    // A second underrun, lasting over two calls, counts as one event.
+    EXPECT_EQ(schedule.Advance(2.5, 0), 0);
+    EXPECT_EQ(schedule.Advance(2.625, 0), 0);
+    EXPECT_EQ(schedule.underruns(), 2);
+    EXPECT_EQ(schedule.underrun_samples(), 875);
+    EXPECT_EQ(schedule.position(), 1750);
+
+    // The delay is 0.875 s.
+    EXPECT_EQ(schedule.Advance(3.625, 10000), 1000);
+    EXPECT_EQ(schedule.position(), 2750);
+    EXPECT_EQ(schedule.underruns(), 2);
+
+    // Never past the end of the stream.
+    EXPECT_FALSE(schedule.done());
+    EXPECT_EQ(schedule.Advance(100.0, 10000), 7250);
+    EXPECT_TRUE(schedule.done());
+    EXPECT_EQ(schedule.Advance(200.0, 10000), 0);
+}
+
+TEST(PacedStreamTest, PlaybackScheduleDeadlines) {
+    PlaybackSchedule schedule(1000.0, 10000);
+    EXPECT_FALSE(schedule.Late(1.0, 1000));
+    EXPECT_TRUE(schedule.Late(1.125, 1000));
+
+    // Silence delays the deadlines of the samples which follow.
+    schedule.Advance(1.0, 500);
+    EXPECT_FALSE(schedule.Late(1.5, 1000));
+    EXPECT_TRUE(schedule.Late(1.625, 1000));
+}
+
+// Depends on the load of the machine: a benchmark, run manually with test_all
+// --gtest_also_run_disabled_tests
+// --gtest_filter=PacedStreamTest.DISABLED_SustainedRate.
+TEST(PacedStreamTest, DISABLED_SustainedRate) {
+    FrameConfig config = ShiftedFrameConfig();
+    LutCache luts;
+    PacedStreamOptions options;
+    options.block_size = 1024;
+    options.buffer_size = 65536;
+    options.rate = 1e6;
+    PacedStreamReport report = RunPacedStream(config, &luts, options);
+
+    EXPECT_EQ(report.num_samples, 3989 * 40 + 1010 * 20);
+    EXPECT_EQ(report.num_blocks, (report.num_samples + 1023) / 1024);
+    EXPECT_EQ(report.underruns, 0);
+    EXPECT_EQ(report.deadline_misses, 0);
+    // Paced: the samples after the prefill are played at the requested rate.
+    EXPECT_GE(report.elapsed,
+              (report.num_samples - report.buffer_size) / options.rate);
+    EXPECT_GT(report.sustainable_rate, options.rate);
+}
+
+TEST(PacedStreamTest, UnsustainableRate) {
+    FrameConfig config = ShiftedFrameConfig();
+    LutCache luts;
+    PacedStreamOptions options;
+    options.block_size = 4096;
+    options.buffer_size = 8192;
+    options.rate = 1e12;
+    options.num_frames = 2;
+    PacedStreamReport report = RunPacedStream(config, &luts, options);
+
+    EXPECT_EQ(report.num_samples, 2 * (3989 * 40 + 1010 * 20));
+    EXPECT_GT(report.underruns, 0);
+    EXPECT_GT(report.underrun_samples, 0);
+    EXPECT_GT(report.deadline_misses, 0);
+}
@@ -0,0 +1,167 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Probe export tests.
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "frame_buffer_arena.h"
+#include "frame_fixtures.h"
+#include "frame_generator.h"
+#include "probe_export.h"
+
+using namespace std;
+
+namespace {
+
+// Shifted, to exercise the full phasor bank.
+FrameConfig ShiftedFrameConfig() {
+    FrameConfig config = SmallFrameConfig(10000);
+    config.parameters.shift_frequency = 12345678;
+    return config;
+}
+
+string ReadFile(const string& file_name) {
+    ifstream in(file_name, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+string Format(ProbeFormat format, const vector<iq_sample_t>& samples) {
+    string text(samples.size() * kMaxProbeLineSize, '\0');
+    text.resize(FormatProbe(format, samples.data(), samples.size(), &text[0]));
+    return text;
+}
+
+}  // namespace
+
+TEST(ProbeExportTest, Formats) {
+    const vector<iq_sample_t> samples = {
+        {0, -1}, {-32768, 32767}, {1234, -5678}};
+    EXPECT_EQ(Format(ProbeFormat::kHex, samples),
+              "0000ffff\n80007fff\n04d2e9d2\n");
+    EXPECT_EQ(Format(ProbeFormat::kTsv, samples),
+              "0\t-1\n-32768\t32767\n1234\t-5678\n");
+    EXPECT_EQ(Format(ProbeFormat::kBinary, samples),
+              string(reinterpret_cast<const char*>(samples.data()),
+                     samples.size() * sizeof(iq_sample_t)));
+
+    uint32_t points;
+    ASSERT_TRUE(ParseProbePoints("rrc,zc", &points));
+    EXPECT_EQ(points, (1u << static_cast<int>(ProbePoint::kRrc)) |
+                          (1u << static_cast<int>(ProbePoint::kZc)));
+    ASSERT_TRUE(ParseProbePoints("all", &points));
+    EXPECT_EQ(points, 15u);
+    ASSERT_TRUE(ParseProbePoints("", &points));
+    EXPECT_EQ(points, 0u);
+    EXPECT_FALSE(ParseProbePoints("rrc,dac", &points));
+    ProbeFormat format;
+    EXPECT_TRUE(ParseProbeFormat("hex", &format));
+    EXPECT_EQ(format, ProbeFormat::kHex);
+    EXPECT_FALSE(ParseProbeFormat("csv", &format));
+}
+
+TEST(ProbeExportTest, ProbesDoNotChangeTheFrame) {
+    FrameConfig config = ShiftedFrameConfig();
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    Frame frame = GenerateFrame(config, &luts, &arena, false);
+    EXPECT_EQ(frame.rrc_samples, nullptr);
+    const vector<iq_sample_t> samples(frame.samples,
+                                      frame.samples + frame.plan.num_samples);
+
+    // The same pulse-shaped samples in all the chains.
+    config.probes = 1 << static_cast<int>(ProbePoint::kRrc);
+    vector<iq_sample_t> rrc;
+    for (int chain = 0; chain < 3; ++chain) {
+        config.planar = chain == 1;
+        config.pipeline = chain == 2;
+        FrameBufferArena probe_arena(HugePages::kNone, false);
+        Frame probed = GenerateFrame(config, &luts, &probe_arena, false);
+        ASSERT_NE(probed.rrc_samples, nullptr);
+        EXPECT_EQ(memcmp(probed.samples, samples.data(),
+                         samples.size() * sizeof(iq_sample_t)), 0)
+            << "Chain " << chain;
+        const vector<iq_sample_t> probe(
+            probed.rrc_samples,
+            probed.rrc_samples + probed.plan.num_samples_qd);
+        if (rrc.empty()) {
+            rrc = probe;
+        }
+        EXPECT_EQ(memcmp(probe.data(), rrc.data(),
+                         rrc.size() * sizeof(iq_sample_t)), 0)
+            << "Chain " << chain;
+    }
+
+    // The quantum data, before the tones are added.
+    size_t nonzero = 0;
+    for (const iq_sample_t& s : rrc) {
+        nonzero += s.i != 0 || s.q != 0;
+    }
+    EXPECT_GT(nonzero, rrc.size() / 2);
+}
+
+TEST(ProbeExportTest, WritesProbeFiles) {
+    FrameConfig config = ShiftedFrameConfig();
+    config.probes = (1 << kNumProbePoints) - 1;
+    config.probe_prefix = testing::TempDir() + "probe_";
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    Frame frame = GenerateFrame(config, &luts, &arena, false);
+    const dsp_memory_plan_t& plan = frame.plan;
+
+    config.probe_format = ProbeFormat::kTsv;
+    ASSERT_TRUE(WriteProbes(config, frame, 3));
+    ostringstream symbols;
+    for (size_t i = 0; i < plan.num_symbols; ++i) {
+        symbols << frame.symbols[i].i << '\t' << frame.symbols[i].q << '\n';
+    }
+    EXPECT_TRUE(ReadFile(ProbeFileName(config.probe_prefix,
+                                       ProbePoint::kSymbols,
+                                       config.probe_format)) ==
+                symbols.str());
+
+    // Several batches of chunks.
+    config.probe_format = ProbeFormat::kHex;
+    ASSERT_TRUE(WriteProbes(config, frame, 1));
+    const string hex = ReadFile(ProbeFileName(
+        config.probe_prefix, ProbePoint::kPhasorBank, config.probe_format));
+    const size_t num_samples = plan.num_samples - plan.num_samples_zc;
+    ASSERT_EQ(hex.size(), 9 * num_samples);
+    bool match = true;
+    for (size_t n = 0; n < num_samples; n += 997) {
+        unsigned int i, q;
+        ASSERT_EQ(sscanf(&hex[9 * n], "%4x%4x", &i, &q), 2);
+        const iq_sample_t& s = frame.samples[plan.num_samples_zc + n];
+        match &= static_cast<sample_t>(i) == s.i &&
+                 static_cast<sample_t>(q) == s.q;
+    }
+    EXPECT_TRUE(match);
+
+    config.probe_format = ProbeFormat::kBinary;
+    ASSERT_TRUE(WriteProbes(config, frame, 2));
+    EXPECT_TRUE(ReadFile(ProbeFileName(config.probe_prefix, ProbePoint::kZc,
+                                       config.probe_format)) ==
+                string(reinterpret_cast<const char*>(frame.samples),
+                       plan.num_samples_zc * sizeof(iq_sample_t)));
+    EXPECT_TRUE(ReadFile(ProbeFileName(config.probe_prefix, ProbePoint::kRrc,
+                                       config.probe_format)) ==
+                string(reinterpret_cast<const char*>(frame.rrc_samples),
+                       plan.num_samples_qd * sizeof(iq_sample_t)));
+    for (size_t i = 0; i < kNumProbePoints; ++i) {
+        for (ProbeFormat format : {ProbeFormat::kBinary, ProbeFormat::kHex,
+                                   ProbeFormat::kTsv}) {
+            remove(ProbeFileName(config.probe_prefix,
+                                 static_cast<ProbePoint>(i), format)
+                       .c_str());
+        }
+    }
+}
@@ -0,0 +1,139 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Stream capture and checkpoint tests.
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "frame_buffer_arena.h"
+#include "frame_fixtures.h"
+#include "frame_generator.h"
+#include "stream_capture.h"
+
+using namespace std;
+
+namespace {
+
+// Shifted, to exercise the full phasor bank.
+FrameConfig ShiftedFrameConfig(const string& output) {
+    FrameConfig config = SmallFrameConfig();
+    config.parameters.shift_frequency = 12345678;
+    config.output = output;
+    return config;
+}
+
+// Name of a temporary file of the current test: ctest runs the tests in
+// parallel processes.
+string TempFileName(const string& suffix) {
+    return testing::TempDir() +
+           testing::UnitTest::GetInstance()->current_test_info()->name() +
+           suffix;
+}
+
+string ReadFile(const string& file_name) {
+    ifstream in(file_name, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST(StreamCaptureTest, CapturesFramesBackToBack) {
+    FrameConfig config = ShiftedFrameConfig(TempFileName(".bin"));
+    LutCache luts;
+    FrameBufferArena arena(HugePages::kNone, false);
+    Frame frame = GenerateFrame(config, &luts, &arena, false);
+    const string samples(reinterpret_cast<const char*>(frame.samples),
+                         frame.plan.num_samples * sizeof(iq_sample_t));
+
+    StreamCaptureOptions options;
+    options.block_size = 1000;
+    options.num_frames = 3;
+    StreamCaptureReport report;
+    string error;
+    ASSERT_TRUE(CaptureStream(config, &luts, options, &report, &error))
+        << error;
+    EXPECT_TRUE(report.complete);
+    EXPECT_EQ(report.num_samples, 3 * frame.plan.num_samples);
+    EXPECT_EQ(report.num_checkpoints, 0u);
+    EXPECT_TRUE(ReadFile(config.output) == samples + samples + samples);
+}
+
+TEST(StreamCaptureTest, ResumesInterruptedCapture) {
+    for (const char* format : {"int16", "packed12"}) {
+        FrameConfig config = ShiftedFrameConfig(TempFileName(".bin"));
+        ASSERT_TRUE(ParseSampleFormat(format, &config.output_format.format));
+        LutCache luts;
+
+        StreamCaptureOptions options;
+        options.block_size = 1000;
+        options.num_frames = 2;
+        StreamCaptureReport report;
+        string error;
+        ASSERT_TRUE(CaptureStream(config, &luts, options, &report, &error))
+            << error;
+        const string expected = ReadFile(config.output);
+
+        // Interrupted after block 37, 2 blocks after its last checkpoint,
+        // with some bytes of the next block written.
+        options.checkpoint = TempFileName(".checkpoint");
+        options.checkpoint_interval = 5;
+        options.max_blocks = 37;
+        ASSERT_TRUE(CaptureStream(config, &luts, options, &report, &error))
+            << error;
+        EXPECT_FALSE(report.complete);
+        EXPECT_EQ(report.num_checkpoints, 8u);
+        {
+            ofstream out(config.output, ios::binary | ios::app);
+            out << "partial block";
+        }
+
+        options.max_blocks = 0;
+        options.resume = true;
+        ASSERT_TRUE(CaptureStream(config, &luts, options, &report, &error))
+            << error;
+        EXPECT_TRUE(report.complete) << format;
+        EXPECT_EQ(report.resumed_samples, 35000u);
+        EXPECT_TRUE(ReadFile(config.output) == expected) << format;
+
+        // A complete capture has nothing left to do.
+        ASSERT_TRUE(CaptureStream(config, &luts, options, &report, &error))
+            << error;
+        EXPECT_EQ(report.num_blocks, 0u);
+        EXPECT_TRUE(ReadFile(config.output) == expected) << format;
+        remove(options.checkpoint.c_str());
+    }
+}
+
+TEST(StreamCaptureTest, RejectsOtherConfiguration) {
+    FrameConfig config = ShiftedFrameConfig(TempFileName(".bin"));
+    LutCache luts;
+    StreamCaptureOptions options;
+    options.block_size = 1000;
+    options.checkpoint = TempFileName(".checkpoint");
+    options.max_blocks = 10;
+    StreamCaptureReport report;
+    string error;
+    ASSERT_TRUE(CaptureStream(config, &luts, options, &report, &error))
+        << error;
+
+    options.resume = true;
+    config.seed = 8;
+    EXPECT_FALSE(CaptureStream(config, &luts, options, &report, &error));
+    EXPECT_NE(error.find("another configuration"), string::npos) << error;
+
+    config.seed = 7;
+    options.block_size = 500;
+    EXPECT_FALSE(CaptureStream(config, &luts, options, &report, &error));
+
+    options.block_size = 1000;
+    remove(options.checkpoint.c_str());
+    EXPECT_FALSE(CaptureStream(config, &luts, options, &report, &error));
+}
@@ -0,0 +1,93 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Parameter sweep and thread pool tests.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sweep.h"
+#include "work_stealing_pool.h"
+
+using namespace std;
+
+TEST(SweepTest, ParseConfigurations) {
+    FrameConfig base;
+    base.parameters = dsp_parameter_t{};
+    base.parameters.rrc_roll_off = 0.3f;
+    base.parameters.pilot_frequency[0] = 200000000;
+
+    istringstream in(
+        "# Roll-off sweep\n"
+        "\n"
+        "rrc_roll_off=0.2 seed=3\n"
+        "  name=pilot pilot_1_freq=210e6 symbol_clamp=true\n"
+        "output_format=packed14 output_scale=0.5 output_saturation=30000\n");
+    vector<FrameConfig> configs;
+    string error;
+    ASSERT_TRUE(ParseSweep(in, base, "out", &configs, &error)) << error;
+    ASSERT_EQ(configs.size(), 3);
+
+    EXPECT_EQ(configs[0].name, "frame_0");
+    EXPECT_EQ(configs[0].seed, 3);
+    EXPECT_EQ(configs[0].parameters.rrc_roll_off, 0.2f);
+    EXPECT_EQ(configs[0].output, "out/frame_0_iq.bin");
+    EXPECT_EQ(configs[0].output_symbols, "out/frame_0_symbols.tsv");
+
+    EXPECT_EQ(configs[1].name, "pilot");
+    EXPECT_EQ(configs[1].seed, 1);
+    EXPECT_EQ(configs[1].parameters.rrc_roll_off, 0.3f);
+    EXPECT_EQ(configs[1].parameters.pilot_frequency[0], 210000000);
+    EXPECT_TRUE(configs[1].parameters.symbol_clamp);
+    EXPECT_EQ(configs[1].output_format.format, DSP_SAMPLE_FORMAT_INT16);
+
+    EXPECT_EQ(configs[2].output_format.format, DSP_SAMPLE_FORMAT_PACKED14);
+    EXPECT_EQ(configs[2].output_format.scale, 0.5f);
+    EXPECT_EQ(configs[2].output_format.saturation, 30000);
+}
+
+TEST(SweepTest, RejectInvalidConfigurations) {
+    FrameConfig base;
+    base.parameters = dsp_parameter_t{};
+    vector<FrameConfig> configs;
+    string error;
+
+    istringstream unknown_key("zc_root=5 roll_off=0.2\n");
+    EXPECT_FALSE(ParseSweep(unknown_key, base, ".", &configs, &error));
+    EXPECT_EQ(error, "line 1: invalid setting \"roll_off=0.2\"");
+
+    istringstream duplicate("name=a\nname=a seed=2\n");
+    configs.clear();
+    EXPECT_FALSE(ParseSweep(duplicate, base, ".", &configs, &error));
+    EXPECT_EQ(error, "line 2: duplicate name \"a\"");
+
+    istringstream modulation("modulation=qam modulation_order=8\n");
+    configs.clear();
+    EXPECT_FALSE(ParseSweep(modulation, base, ".", &configs, &error));
+    EXPECT_EQ(error, "line 1: invalid modulation");
+}
+
+TEST(WorkStealingPoolTest, RunsAllTasks) {
+    WorkStealingPool pool(4);
+    EXPECT_EQ(pool.num_threads(), 4);
+
+    const size_t num_tasks = 1000;
+    vector<atomic<int>> runs(num_tasks);
+    atomic<bool> valid_workers(true);
+    for (size_t i = 0; i < num_tasks; ++i) {
+        pool.Submit([&, i](size_t worker) {
+            if (worker >= 4) valid_workers = false;
+            ++runs[i];
+        });
+    }
+    pool.Wait();
+    EXPECT_TRUE(valid_workers);
+    for (size_t i = 0; i < num_tasks; ++i) {
+        EXPECT_EQ(runs[i], 1) << "Task " << i;
+    }
+}
@@ -0,0 +1,92 @@
+// Author: Emilie Gillet (emilie.gillet@etu.sorbonne-universite.fr)
+//
+// -----------------------------------------------------------------------------
+//
+// Build-time generator for the phasor and RRC LUTs. The tables are computed
+// with the very same code as the runtime initialization, and written as a C
+// source file with const (read-only) arrays.
+//
+// Usage: dsp_lut_generator <output.c> [roll_off...]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dsp/dsp_phasor_bank.h"
+#include "dsp/dsp_rrc_filter.h"
+#include "dsp/dsp_types.h"
+
+#ifdef FIXED_POINT
+    #define LUT_FMT_STRING "%6d"
+#else
+    #define LUT_FMT_STRING "%.9ef"
+#endif  // FIXED_POINT
+
+static iq_sample_t lut_phasor[LUT_PHASOR_SIZE];
+static sample_t lut_rrc[LUT_RRC_SIZE];
+
+static void write_samples(FILE* f, const sample_t* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        fprintf(f, i % 8 == 0 ? "    " : " ");
+        fprintf(f, LUT_FMT_STRING ",", data[i]);
+        if (i % 8 == 7 || i == size - 1) {
+            fprintf(f, "\n");
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <output.c> [roll_off...]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* f = fopen(argv[1], "w");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    size_t num_roll_offs = argc - 2;
+    float* roll_off = malloc((num_roll_offs + 1) * sizeof(float));
+    for (size_t i = 0; i < num_roll_offs; ++i) {
+        roll_off[i] = strtof(argv[i + 2], NULL);
+    }
+
+    fprintf(f, "// Generated by tools/dsp_lut_generator.c. Do not edit.\n\n");
+    fprintf(f, "#include \"dsp/dsp_luts.h\"\n\n");
+
+    dsp_phasor_bank_fill_lut(lut_phasor);
+    fprintf(f, "const iq_sample_t lut_phasor_precomputed[LUT_PHASOR_SIZE] = "
+               "{\n");
+    for (size_t i = 0; i < LUT_PHASOR_SIZE; ++i) {
+        fprintf(f, i % 4 == 0 ? "    " : " ");
+        fprintf(f, "{ " LUT_FMT_STRING ", " LUT_FMT_STRING " },",
+                lut_phasor[i].i, lut_phasor[i].q);
+        if (i % 4 == 3) {
+            fprintf(f, "\n");
+        }
+    }
+    fprintf(f, "};\n\n");
+
+    fprintf(f, "const size_t lut_rrc_precomputed_count = %zu;\n\n",
+            num_roll_offs);
+
+    // Avoid zero-sized arrays when no roll-off is configured.
+    fprintf(f, "const float lut_rrc_precomputed_roll_off[] = {\n");
+    for (size_t i = 0; i < num_roll_offs; ++i) {
+        fprintf(f, "    %.9ef,\n", roll_off[i]);
+    }
+    fprintf(f, num_roll_offs ? "};\n\n" : "    -1.0f\n};\n\n");
+
+    fprintf(f, "const sample_t lut_rrc_precomputed[][LUT_RRC_SIZE] = {\n");
+    for (size_t i = 0; i < num_roll_offs; ++i) {
+        dsp_rrc_filter_fill_lut(lut_rrc, roll_off[i]);
+        fprintf(f, "  {\n");
+        write_samples(f, lut_rrc, LUT_RRC_SIZE);
+        fprintf(f, "  },\n");
+    }
+    fprintf(f, num_roll_offs ? "};\n" : "  { 0 }\n};\n");
+
+    free(roll_off);
+    return fclose(f) == 0 ? 0 : 1;
+}
@@ -0,0 +1,363 @@
+"""Python bindings of the shared library (libembedded_alice), with ctypes.
+
+The frames are generated in place into numpy int16 arrays of shape (n, 2)
+holding the I/Q samples (or symbols), without files nor copies.
+
+    import embedded_alice as ea
+
+    params = ea.Parameters(num_symbols=100000, seed=3)
+    samples, symbols = ea.generate_frame(params)
+
+    stream = ea.Stream(params, block_size=4096)
+    block = np.empty((65536, 2), dtype=np.int16)
+    while (n := stream.read(block)):
+        consume(block[:n])
+
+    with ea.Service("/tmp/embedded_alice.sock") as service:
+        samples, symbols = service.generate(params)
+"""
+
+import array
+import ctypes
+import ctypes.util
+import mmap
+import os
+import socket
+import struct
+
+import numpy as np
+
+API_VERSION = 1
+
+OK = 0
+ERROR_INVALID_ARGUMENT = -1
+ERROR_BUFFER_TOO_SMALL = -2
+ERROR_OUT_OF_MEMORY = -3
+
+
+class Parameters(ctypes.Structure):
+    """Frame parameters (ea_parameters_t), with the command line defaults."""
+
+    _fields_ = [
+        ("struct_size", ctypes.c_uint32),
+        ("sample_rate", ctypes.c_uint32),
+        ("symbol_rate", ctypes.c_uint32),
+        ("zc_rate", ctypes.c_uint32),
+        ("num_symbols", ctypes.c_uint32),
+        ("num_null_symbols", ctypes.c_uint32),
+        ("zc_length", ctypes.c_uint32),
+        ("zc_root", ctypes.c_uint32),
+        ("zc_shift", ctypes.c_uint32),
+        ("shift_frequency", ctypes.c_uint32),
+        ("symbol_scale", ctypes.c_uint32),
+        ("symbol_max_value", ctypes.c_uint32),
+        ("symbol_clamp", ctypes.c_uint32),
+        ("pilot_frequency", ctypes.c_uint32 * 2),
+        ("pilot_amplitude", ctypes.c_float * 2),
+        ("rrc_roll_off", ctypes.c_float),
+        ("seed", ctypes.c_uint32),
+    ]
+
+    def __init__(self, **kwargs):
+        super().__init__()
+        _lib.ea_parameters_init(ctypes.byref(self))
+        for key, value in kwargs.items():
+            if key in ("pilot_frequency", "pilot_amplitude"):
+                getattr(self, key)[:] = value
+            else:
+                setattr(self, key, value)
+
+
+class FrameLayout(ctypes.Structure):
+    """Frame layout (ea_frame_layout_t), in samples and symbols."""
+
+    _fields_ = [
+        ("num_samples_zc", ctypes.c_uint64),
+        ("num_samples_qd", ctypes.c_uint64),
+        ("num_samples_tail", ctypes.c_uint64),
+        ("num_samples", ctypes.c_uint64),
+        ("num_symbols", ctypes.c_uint64),
+    ]
+
+
+class Error(Exception):
+    pass
+
+
+def _load_library():
+    path = os.environ.get("EMBEDDED_ALICE_LIBRARY")
+    if not path:
+        here = os.path.dirname(os.path.abspath(__file__))
+        for candidate in ("build", "_build"):
+            p = os.path.join(here, "..", candidate, "libembedded_alice.so")
+            if os.path.exists(p):
+                path = p
+                break
+    lib = ctypes.CDLL(path or ctypes.util.find_library("embedded_alice"))
+
+    int16_p = ctypes.POINTER(ctypes.c_int16)
+    lib.ea_api_version.restype = ctypes.c_uint32
+    lib.ea_api_version.argtypes = []
+    lib.ea_parameters_init.restype = None
+    lib.ea_parameters_init.argtypes = [ctypes.POINTER(Parameters)]
+    lib.ea_frame_layout.restype = ctypes.c_int
+    lib.ea_frame_layout.argtypes = [
+        ctypes.POINTER(Parameters), ctypes.POINTER(FrameLayout)]
+    lib.ea_generate_frame.restype = ctypes.c_int
+    lib.ea_generate_frame.argtypes = [
+        ctypes.POINTER(Parameters), int16_p, ctypes.c_size_t, int16_p,
+        ctypes.c_size_t]
+    lib.ea_stream_create.restype = ctypes.c_int
+    lib.ea_stream_create.argtypes = [
+        ctypes.POINTER(Parameters), ctypes.c_size_t,
+        ctypes.POINTER(ctypes.c_void_p)]
+    lib.ea_stream_read.restype = ctypes.c_size_t
+    lib.ea_stream_read.argtypes = [ctypes.c_void_p, int16_p, ctypes.c_size_t]
+    lib.ea_stream_position.restype = ctypes.c_uint64
+    lib.ea_stream_position.argtypes = [ctypes.c_void_p]
+    lib.ea_stream_retune.restype = ctypes.c_int
+    lib.ea_stream_retune.argtypes = [
+        ctypes.c_void_p, ctypes.c_uint32, ctypes.POINTER(ctypes.c_uint32),
+        ctypes.POINTER(ctypes.c_float), ctypes.c_uint64, ctypes.c_uint32]
+    lib.ea_stream_rewind.restype = None
+    lib.ea_stream_rewind.argtypes = [ctypes.c_void_p]
+    lib.ea_stream_destroy.restype = None
+    lib.ea_stream_destroy.argtypes = [ctypes.c_void_p]
+    lib.ea_batch_create.restype = ctypes.c_int
+    lib.ea_batch_create.argtypes = [
+        ctypes.POINTER(Parameters), ctypes.c_size_t, ctypes.c_size_t,
+        ctypes.POINTER(ctypes.c_void_p)]
+    lib.ea_batch_read.restype = ctypes.c_size_t
+    lib.ea_batch_read.argtypes = [ctypes.c_void_p, int16_p, ctypes.c_size_t]
+    lib.ea_batch_position.restype = ctypes.c_uint64
+    lib.ea_batch_position.argtypes = [ctypes.c_void_p]
+    lib.ea_batch_destroy.restype = None
+    lib.ea_batch_destroy.argtypes = [ctypes.c_void_p]
+
+    if lib.ea_api_version() != API_VERSION:
+        raise Error("libembedded_alice API version %d, expected %d" % (
+            lib.ea_api_version(), API_VERSION))
+    return lib
+
+
+_lib = _load_library()
+
+
+def _check(status):
+    if status != OK:
+        raise Error({
+            ERROR_INVALID_ARGUMENT: "invalid argument",
+            ERROR_BUFFER_TOO_SMALL: "buffer too small",
+            ERROR_OUT_OF_MEMORY: "out of memory",
+        }.get(status, "error %d" % status))
+
+
+def _pairs(array):
+    """Pointer to a C-contiguous int16 array of shape (n, 2), and n."""
+    if (array.dtype != np.int16 or array.ndim != 2 or array.shape[1] != 2
+            or not array.flags.c_contiguous or not array.flags.writeable):
+        raise ValueError("expected a writable C-contiguous int16 array of "
+                         "shape (n, 2)")
+    return array.ctypes.data_as(ctypes.POINTER(ctypes.c_int16)), len(array)
+
+
+def frame_layout(params):
+    layout = FrameLayout()
+    _check(_lib.ea_frame_layout(ctypes.byref(params), ctypes.byref(layout)))
+    return layout
+
+
+def generate_frame(params, samples=None, symbols=None):
+    """Generates a frame into samples and symbols (allocated if None).
+
+    Returns the samples and symbols arrays, trimmed to the frame length.
+    """
+    layout = frame_layout(params)
+    if samples is None:
+        samples = np.empty((layout.num_samples, 2), dtype=np.int16)
+    if symbols is None:
+        symbols = np.empty((layout.num_symbols, 2), dtype=np.int16)
+    samples_p, num_samples = _pairs(samples)
+    symbols_p, num_symbols = _pairs(symbols)
+    _check(_lib.ea_generate_frame(ctypes.byref(params), samples_p,
+                                  num_samples, symbols_p, num_symbols))
+    return samples[:layout.num_samples], symbols[:layout.num_symbols]
+
+
+class Stream:
+    """Streaming generation of a frame, by blocks of any size."""
+
+    def __init__(self, params, block_size=4096):
+        self._handle = ctypes.c_void_p()
+        _check(_lib.ea_stream_create(ctypes.byref(params), block_size,
+                                     ctypes.byref(self._handle)))
+
+    def read(self, samples):
+        """Fills samples in place; returns the number of samples written."""
+        samples_p, n = _pairs(samples)
+        return _lib.ea_stream_read(self._handle, samples_p, n)
+
+    @property
+    def position(self):
+        return _lib.ea_stream_position(self._handle)
+
+    def retune(self, shift_frequency, pilot_frequency, pilot_amplitude,
+               position=None, ramp_size=0):
+        """Changes the shift and pilots at a sample of the frame (by default,
+        the current position), keeping the tones continuous."""
+        if position is None:
+            position = self.position
+        _check(_lib.ea_stream_retune(
+            self._handle, shift_frequency,
+            (ctypes.c_uint32 * 2)(*pilot_frequency),
+            (ctypes.c_float * 2)(*pilot_amplitude), position, ramp_size))
+
+    def rewind(self):
+        _lib.ea_stream_rewind(self._handle)
+
+    def close(self):
+        if self._handle:
+            _lib.ea_stream_destroy(self._handle)
+            self._handle = ctypes.c_void_p()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+class Batch:
+    """Streaming generation of the frames of several channels at once.
+
+    The channels may only differ in their seed, symbol distribution, shift
+    frequency and pilots.
+    """
+
+    def __init__(self, params_list, block_size=4096):
+        self.num_channels = len(params_list)
+        params = (Parameters * self.num_channels)(*params_list)
+        self._handle = ctypes.c_void_p()
+        _check(_lib.ea_batch_create(params, self.num_channels, block_size,
+                                    ctypes.byref(self._handle)))
+
+    def read(self, samples):
+        """Fills samples, of shape (n, num_channels, 2), in place; returns
+        the number of samples written per channel."""
+        if (samples.dtype != np.int16 or samples.ndim != 3
+                or samples.shape[1:] != (self.num_channels, 2)
+                or not samples.flags.c_contiguous
+                or not samples.flags.writeable):
+            raise ValueError("expected a writable C-contiguous int16 array "
+                             "of shape (n, %d, 2)" % self.num_channels)
+        return _lib.ea_batch_read(
+            self._handle, samples.ctypes.data_as(
+                ctypes.POINTER(ctypes.c_int16)), len(samples))
+
+    @property
+    def position(self):
+        return _lib.ea_batch_position(self._handle)
+
+    def close(self):
+        if self._handle:
+            _lib.ea_batch_destroy(self._handle)
+            self._handle = ctypes.c_void_p()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+class Service:
+    """Client of a frame service (embedded_alice --serve=socket_path).
+
+    The frames are generated by the service, which keeps its LUTs and
+    buffers warm, and mapped from the memfd it returns.
+    """
+
+    _FORMATS = {
+        "int16": (np.int16, 2),
+        "packed14": (np.uint8, 1),
+        "packed12": (np.uint8, 1),
+        "cf32": (np.float32, 2),
+        "cf16": (np.float16, 2),
+    }
+    _REQUEST_SIZE = 128
+    _RESPONSE_SIZE = 128
+
+    def __init__(self, socket_path):
+        self._socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self._socket.connect(socket_path)
+
+    def generate(self, params, output_format="int16", output_scale=1.0,
+                 output_saturation=32768, symbols=True):
+        """Returns the samples (an array of shape (n, 2), or the bytes of
+        the packed formats) and the symbols (None if not requested), as
+        read-only arrays backed by the mapped frame."""
+        names = list(self._FORMATS)
+        # The fields of the parameters after struct_size, up to the seed,
+        # are in the serialized order.
+        serialized = bytes(params)[4:72]
+        request = struct.pack("<8sIIIfII", b"EAFRMREQ", 1, params.seed,
+                              names.index(output_format), output_scale,
+                              output_saturation, 1 if symbols else 0)
+        request += serialized
+        request += bytes(self._REQUEST_SIZE - len(request))
+        self._socket.sendall(request)
+
+        response, fds = self._receive()
+        try:
+            magic, status = struct.unpack_from("<8sI", response)
+            if magic != b"EAFRMRSP":
+                raise Error("invalid response")
+            if status:
+                raise Error(response[72:].rstrip(b"\0").decode())
+            (num_samples, num_symbols, _, _, _, samples_size,
+             symbols_offset) = struct.unpack_from("<7Q", response, 16)
+            size = (symbols_offset + 4 * num_symbols if symbols
+                    else samples_size)
+            frame = mmap.mmap(fds[0], size, prot=mmap.PROT_READ)
+        finally:
+            for fd in fds:
+                os.close(fd)
+        dtype, width = self._FORMATS[output_format]
+        samples = np.frombuffer(frame, dtype=dtype,
+                                count=samples_size // np.dtype(dtype).itemsize)
+        if width == 2:
+            samples = samples.reshape(num_samples, 2)
+        if not symbols:
+            return samples, None
+        return samples, np.frombuffer(
+            frame, dtype=np.int16, count=2 * num_symbols,
+            offset=symbols_offset).reshape(num_symbols, 2)
+
+    def _receive(self):
+        fds = array.array("i")
+        data, ancillary, _, _ = self._socket.recvmsg(
+            self._RESPONSE_SIZE, socket.CMSG_SPACE(fds.itemsize))
+        for level, kind, payload in ancillary:
+            if level == socket.SOL_SOCKET and kind == socket.SCM_RIGHTS:
+                fds.frombytes(payload[:fds.itemsize])
+        while len(data) < self._RESPONSE_SIZE:
+            chunk = self._socket.recv(self._RESPONSE_SIZE - len(data))
+            if not chunk:
+                raise Error("connection closed")
+            data += chunk
+        return data, list(fds)
+
+    def close(self):
+        self._socket.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()